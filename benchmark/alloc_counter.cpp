@@ -0,0 +1,43 @@
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#if __cplusplus >= 201103L
+#define BM_THROW_BAD_ALLOC
+#define BM_NOEXCEPT noexcept
+#else
+#define BM_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define BM_NOEXCEPT throw()
+#endif
+
+namespace {
+std::size_t allocation_count = 0;
+}  // namespace
+
+void *operator new(std::size_t size) BM_THROW_BAD_ALLOC {
+  ++allocation_count;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) BM_NOEXCEPT {
+  std::free(p);
+}
+
+std::size_t get_allocation_count() {
+  return allocation_count;
+}
+
+AllocationCounter::AllocationCounter()
+    : start_count_(get_allocation_count()) {}
+
+AllocationCounter::~AllocationCounter() {
+  std::cout << "Allocations: " << get_allocation_count() - start_count_
+            << "\n"
+            << std::endl;
+}
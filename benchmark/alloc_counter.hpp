@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_ALLOC_COUNTER_H_
+#define BENCHMARK_ALLOC_COUNTER_H_
+
+#include <cstddef>
+
+// グローバルな operator new が呼ばれた回数を返す.
+// (alloc_counter.cpp で operator new を置き換えて数えている)
+std::size_t get_allocation_count();
+
+// 生成されてから破棄されるまでの間の operator new の呼び出し回数を
+// 破棄時に表示する. TIMER() より前に宣言すると計測時間の後に表示される.
+class AllocationCounter {
+ public:
+  AllocationCounter();
+  ~AllocationCounter();
+
+ private:
+  const std::size_t start_count_;
+
+  AllocationCounter(const AllocationCounter &other);
+  AllocationCounter &operator=(const AllocationCounter &other);
+};
+
+#endif
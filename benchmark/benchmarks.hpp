@@ -2,8 +2,11 @@
 #define BENCHMARK_BENCHMARKS_H_
 
 void measure_vector();
+void measure_small_vector();
 void measure_stack();
 void measure_map();
 void measure_set();
+void measure_btree();
+void measure_flat_map();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "benchmarks.hpp"
+#include "btree_map.hpp"
+#include "map.hpp"
+#include "timer.hpp"
+
+namespace {
+
+// 小さい木でも測れるように, 各操作の回数は要素数に依らずこれくらいにする.
+const int kOperationCount = 200000;
+
+long sink;
+
+template <class Map>
+void insert_keys(const std::vector<int> &keys, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    Map m;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      m.insert(typename Map::value_type(keys[i], keys[i]));
+    }
+  }
+}
+
+template <class Map>
+void find_keys(const Map &m, const std::vector<int> &keys, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      sink += (*m.find(keys[i])).second;
+    }
+  }
+}
+
+template <class Map>
+void scan_map(const Map &m, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    for (typename Map::const_iterator it = m.begin(); it != m.end(); ++it) {
+      sink += (*it).second;
+    }
+  }
+}
+
+template <class Map>
+void build_map(Map &m, const std::vector<int> &keys) {
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    m.insert(typename Map::value_type(keys[i], keys[i]));
+  }
+}
+
+void measure_btree_map(const int size);
+
+}  // namespace
+
+// 赤黒木はノード1つに値1つなので, 探索で辿る log2(n) 個のノードが
+// それぞれキャッシュミスになり得る. B 木は1つのノードに値を詰めるので
+// 辿るノードが log_B(n) 個になり, 走査も連続した領域を読む.
+void measure_btree() {
+  measure_btree_map(1000);
+  measure_btree_map(100000);
+  measure_btree_map(1000000);
+}
+
+namespace {
+
+void measure_btree_map(const int size) {
+  HEADER("measure_btree_map (size: " << size << ")");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::btree_map<int, int> ft_btree_map_type;
+
+  const int rounds = std::max(1, kOperationCount / size);
+  std::vector<int> keys;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(rand());
+  }
+
+  {
+    TIMER("std::map<int, int> insert (random)");
+    insert_keys<std_map_type>(keys, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> insert (random)");
+    insert_keys<ft_map_type>(keys, rounds);
+  }
+  {
+    TIMER("ft::btree_map<int, int> insert (random)");
+    insert_keys<ft_btree_map_type>(keys, rounds);
+  }
+
+  std_map_type std_map;
+  ft_map_type ft_map;
+  ft_btree_map_type ft_btree_map;
+  build_map(std_map, keys);
+  build_map(ft_map, keys);
+  build_map(ft_btree_map, keys);
+  std::random_shuffle(keys.begin(), keys.end());
+
+  {
+    TIMER("std::map<int, int> find");
+    find_keys(std_map, keys, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> find");
+    find_keys(ft_map, keys, rounds);
+  }
+  {
+    TIMER("ft::btree_map<int, int> find");
+    find_keys(ft_btree_map, keys, rounds);
+  }
+
+  {
+    TIMER("std::map<int, int> scan");
+    scan_map(std_map, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> scan");
+    scan_map(ft_map, rounds);
+  }
+  {
+    TIMER("ft::btree_map<int, int> scan");
+    scan_map(ft_btree_map, rounds);
+  }
+}
+
+}  // namespace
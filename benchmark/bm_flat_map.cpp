@@ -0,0 +1,172 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmarks.hpp"
+#include "flat_map.hpp"
+#include "map.hpp"
+#include "pair.hpp"
+#include "timer.hpp"
+
+namespace {
+
+// 小さい map でも測れるように, 各操作の回数は要素数に依らずこれくらいにする.
+const int kOperationCount = 200000;
+
+long sink;
+
+template <class Map, class Value>
+void build_from_range(const std::vector<Value> &values, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    Map m(values.begin(), values.end());
+    sink += m.size();
+  }
+}
+
+template <class Map>
+void find_keys(const Map &m, const std::vector<int> &keys, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      sink += (*m.find(keys[i])).first;
+    }
+  }
+}
+
+template <class Map>
+void scan_map(const Map &m, const int rounds) {
+  for (int round = 0; round < rounds; ++round) {
+    for (typename Map::const_iterator it = m.begin(); it != m.end(); ++it) {
+      sink += (*it).second;
+    }
+  }
+}
+
+void measure_flat_map_int(const int size);
+void measure_flat_map_split(const int size);
+
+}  // namespace
+
+// 整列した配列は探索で読む領域が連続していて, 木のようにポインタを辿らない.
+// 挿入は O(n) なので, 範囲でまとめて作る場合と比べる.
+void measure_flat_map() {
+  measure_flat_map_int(1000);
+  measure_flat_map_int(100000);
+  measure_flat_map_int(1000000);
+  measure_flat_map_split(1000000);
+}
+
+namespace {
+
+void measure_flat_map_int(const int size) {
+  HEADER("measure_flat_map (size: " << size << ")");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::flat_map<int, int> ft_flat_map_type;
+
+  const int rounds = std::max(1, kOperationCount / size);
+  std::vector<int> keys;
+  std::vector<std::pair<int, int> > std_values;
+  std::vector<ft::pair<int, int> > ft_values;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(rand());
+    std_values.push_back(std::make_pair(keys.back(), i));
+    ft_values.push_back(ft::make_pair(keys.back(), i));
+  }
+
+  {
+    TIMER("std::map<int, int> range constructor (random)");
+    build_from_range<std_map_type>(std_values, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> range constructor (random)");
+    build_from_range<ft_map_type>(ft_values, rounds);
+  }
+  {
+    TIMER("ft::flat_map<int, int> range constructor (random)");
+    build_from_range<ft_flat_map_type>(ft_values, rounds);
+  }
+
+  std::sort(std_values.begin(), std_values.end());
+  std::sort(ft_values.begin(), ft_values.end());
+  {
+    TIMER("std::map<int, int> range constructor (sorted)");
+    build_from_range<std_map_type>(std_values, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> range constructor (sorted)");
+    build_from_range<ft_map_type>(ft_values, rounds);
+  }
+  {
+    TIMER("ft::flat_map<int, int> range constructor (sorted)");
+    build_from_range<ft_flat_map_type>(ft_values, rounds);
+  }
+
+  const std_map_type std_map(std_values.begin(), std_values.end());
+  const ft_map_type ft_map(ft_values.begin(), ft_values.end());
+  const ft_flat_map_type ft_flat_map(ft_values.begin(), ft_values.end());
+  std::random_shuffle(keys.begin(), keys.end());
+
+  {
+    TIMER("std::map<int, int> find");
+    find_keys(std_map, keys, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> find");
+    find_keys(ft_map, keys, rounds);
+  }
+  {
+    TIMER("ft::flat_map<int, int> find");
+    find_keys(ft_flat_map, keys, rounds);
+  }
+
+  {
+    TIMER("std::map<int, int> scan");
+    scan_map(std_map, rounds);
+  }
+  {
+    TIMER("ft::map<int, int> scan");
+    scan_map(ft_map, rounds);
+  }
+  {
+    TIMER("ft::flat_map<int, int> scan");
+    scan_map(ft_flat_map, rounds);
+  }
+}
+
+// 値が大きい時は, キーと値を分けて並べると二分探索で触る領域が狭くなる.
+void measure_flat_map_split(const int size) {
+  HEADER("measure_flat_map_split (size: " << size << ")");
+
+  typedef ft::flat_map<int, std::string> ft_pair_map_type;
+  typedef ft::flat_map<int, std::string, std::less<int>,
+                       std::allocator<ft::pair<int, std::string> >,
+                       ft::flat_map_split_storage_policy>
+      ft_split_map_type;
+
+  const int rounds = std::max(1, kOperationCount / size);
+  std::vector<int> keys;
+  std::vector<ft::pair<int, std::string> > values;
+  for (int i = 0; i < size; ++i) {
+    keys.push_back(rand());
+    values.push_back(ft::make_pair(keys.back(), std::string("value")));
+  }
+  const ft_pair_map_type ft_pair_map(values.begin(), values.end());
+  const ft_split_map_type ft_split_map(values.begin(), values.end());
+  std::random_shuffle(keys.begin(), keys.end());
+
+  {
+    TIMER("ft::flat_map<int, std::string> find (pair storage)");
+    find_keys(ft_pair_map, keys, rounds);
+  }
+  {
+    TIMER("ft::flat_map<int, std::string> find (split storage)");
+    find_keys(ft_split_map, keys, rounds);
+  }
+}
+
+}  // namespace
@@ -4,8 +4,11 @@
 
 int main() {
   measure_vector();
+  measure_small_vector();
   measure_stack();
   measure_map();
   measure_set();
+  measure_btree();
+  measure_flat_map();
   return 0;
 }
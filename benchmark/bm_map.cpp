@@ -1,11 +1,21 @@
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <map>
+#include <sstream>
+#include <string>
+#include <vector>
 
+#include "alloc_counter.hpp"
+#include "arena_allocator.hpp"
 #include "benchmarks.hpp"
+#include "interval_map.hpp"
 #include "map.hpp"
+#include "node_pool_allocator.hpp"
 #include "timer.hpp"
+#include "utils/Student.hpp"
 
 namespace {
 
@@ -23,6 +33,16 @@ void measure_map_capacity();
 void measure_map_insert();
 void measure_map_modifiers();
 void measure_map_lookup();
+void measure_map_string();
+void measure_map_key_lookup();
+void measure_map_large_value();
+void measure_map_node_pool();
+void measure_map_arena();
+void measure_map_threaded_iteration();
+void measure_map_order_statistic();
+void measure_map_range_aggregate();
+void measure_map_freeze();
+void measure_map_batched_lookup(const int size);
 }  // namespace
 
 void measure_map() {
@@ -32,6 +52,17 @@ void measure_map() {
   measure_map_insert();
   measure_map_modifiers();
   measure_map_lookup();
+  measure_map_string();
+  measure_map_key_lookup();
+  measure_map_large_value();
+  measure_map_node_pool();
+  measure_map_arena();
+  measure_map_threaded_iteration();
+  measure_map_order_statistic();
+  measure_map_range_aggregate();
+  measure_map_freeze();
+  measure_map_batched_lookup(100000);
+  measure_map_batched_lookup(4000000);
 }
 
 namespace {
@@ -58,6 +89,21 @@ void measure_map_constructor_and_assignation() {
     ft_map_type tmp;
   }
 
+  std::vector<std::pair<int, int> > std_sorted;
+  std::vector<ft::pair<int, int> > ft_sorted;
+  for (int i = 0; i < max_size; ++i) {
+    std_sorted.push_back(std::make_pair(i, i));
+    ft_sorted.push_back(ft::make_pair(i, i));
+  }
+  {
+    TIMER("std::map range constructor (sorted)");
+    std_map_type tmp(std_sorted.begin(), std_sorted.end());
+  }
+  {
+    TIMER("ft::map range constructor (sorted)");
+    ft_map_type tmp(ft_sorted.begin(), ft_sorted.end());
+  }
+
   {
     TIMER("std::map copy constructor");
     std_map_type tmp(std_map_for_copy);
@@ -77,6 +123,29 @@ void measure_map_constructor_and_assignation() {
     ft_map_type tmp;
     tmp = ft_map_for_copy;
   }
+
+  // 同じ大きさの map への代入. ノードを使い回せる場合.
+  {
+    std_map_type tmp(std_map_for_copy);
+    TIMER("std::map assignation (non-empty)");
+    tmp = std_map_for_copy;
+  }
+  {
+    ft_map_type tmp(ft_map_for_copy);
+    TIMER("ft::map assignation (non-empty)");
+    tmp = ft_map_for_copy;
+  }
+
+  {
+    std_map_type tmp(std_map_for_copy);
+    TIMER("std::map destructor");
+    std_map_type().swap(tmp);
+  }
+  {
+    ft_map_type tmp(ft_map_for_copy);
+    TIMER("ft::map destructor");
+    ft_map_type().swap(tmp);
+  }
 }
 
 void measure_map_element_access_and_iterator() {
@@ -213,6 +282,23 @@ void measure_map_insert() {
       ft_map[rand()] = rand();
     }
   }
+
+  // 時系列データのように増加するキーを end() を hint にして追加する
+  {
+    TIMER("std::map insert with hint end() (increasing keys)");
+    std_map_type std_sequential;
+    for (int j = 0; j < max_size; ++j) {
+      std_sequential.insert(std_sequential.end(),
+                            std_map_type::value_type(j, j));
+    }
+  }
+  {
+    TIMER("ft::map insert with hint end() (increasing keys)");
+    ft_map_type ft_sequential;
+    for (int j = 0; j < max_size; ++j) {
+      ft_sequential.insert(ft_sequential.end(), ft_map_type::value_type(j, j));
+    }
+  }
 }
 
 void measure_map_modifiers() {
@@ -341,4 +427,607 @@ void measure_map_lookup() {
   }
 }
 
-}  // namespace
\ No newline at end of file
+// SSO に収まらない長さのキーを作る
+std::vector<std::string> make_long_keys(const int size) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < size; ++i) {
+    std::ostringstream oss;
+    oss << "this key is longer than the SSO buffer: " << i;
+    keys.push_back(oss.str());
+  }
+  return keys;
+}
+
+template <class Map>
+Map make_string_map(const std::vector<std::string> &keys) {
+  Map m;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    m.insert(typename Map::value_type(keys[i], keys[i]));
+  }
+  return m;
+}
+
+// C++11 でビルドした場合は一時オブジェクトの挿入と代入がムーブになるので
+// C++98 の場合との差を見る.
+void measure_map_string() {
+  HEADER("measure_map_string");
+
+  typedef std::map<std::string, std::string> std_map_type;
+  typedef ft::map<std::string, std::string> ft_map_type;
+
+  const std::vector<std::string> keys = make_long_keys(100000);
+
+  {
+    TIMER("std::map<std::string, std::string> insert");
+    std_map_type std_map = make_string_map<std_map_type>(keys);
+  }
+  {
+    TIMER("ft::map<std::string, std::string> insert");
+    ft_map_type ft_map = make_string_map<ft_map_type>(keys);
+  }
+
+  std_map_type std_map;
+  ft_map_type ft_map;
+  {
+    TIMER("std::map<std::string, std::string> rebuild");
+    for (int i = 0; i < 5; ++i) {
+      std_map = make_string_map<std_map_type>(keys);
+    }
+  }
+  {
+    TIMER("ft::map<std::string, std::string> rebuild");
+    for (int i = 0; i < 5; ++i) {
+      ft_map = make_string_map<ft_map_type>(keys);
+    }
+  }
+}
+
+template <class Map, class KeyContainer>
+void find_all_keys(const Map &m, const KeyContainer &keys) {
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    m.find(keys[i]);
+    m.lower_bound(keys[i]);
+    m.upper_bound(keys[i]);
+  }
+}
+
+// キーのコピーにヒープ確保が伴う型で探索する.
+// キーを参照のまま比較していれば探索中の確保は 0 回になる.
+void measure_map_key_lookup() {
+  HEADER("measure_map_key_lookup");
+
+  typedef std::map<std::string, int> std_map_type;
+  typedef ft::map<std::string, int> ft_map_type;
+  typedef ft::test::Student student_type;
+  typedef std::map<student_type, int, student_type::Compare>
+      std_student_map_type;
+  typedef ft::map<student_type, int, student_type::Compare>
+      ft_student_map_type;
+
+  const std::vector<std::string> keys = make_long_keys(100000);
+  std::vector<student_type> students;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    students.push_back(student_type(keys[i], static_cast<uint8_t>(i)));
+  }
+
+  std_map_type std_map;
+  ft_map_type ft_map;
+  std_student_map_type std_student_map;
+  ft_student_map_type ft_student_map;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    std_map.insert(std_map_type::value_type(keys[i], 0));
+    ft_map.insert(ft_map_type::value_type(keys[i], 0));
+    std_student_map.insert(std_student_map_type::value_type(students[i], 0));
+    ft_student_map.insert(ft_student_map_type::value_type(students[i], 0));
+  }
+
+  {
+    AllocationCounter counter;
+    TIMER("std::map<std::string, int> find/lower_bound/upper_bound");
+    find_all_keys(std_map, keys);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map<std::string, int> find/lower_bound/upper_bound");
+    find_all_keys(ft_map, keys);
+  }
+
+  // ネットワークのバッファなどから得た const char* のままで探す.
+  // 比較関数が透過的でなければ1回ごとに std::string の一時オブジェクトを作る.
+  typedef ft::map<std::string, int, ft::less<> > ft_transparent_map_type;
+  ft_transparent_map_type ft_transparent_map(ft_map.begin(), ft_map.end());
+  std::vector<const char *> raw_keys;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    raw_keys.push_back(keys[i].c_str());
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map<std::string, int> find(const char *)");
+    for (std::size_t i = 0; i < raw_keys.size(); ++i) {
+      ft_map.find(raw_keys[i]);
+    }
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map<std::string, int, ft::less<> > find(const char *)");
+    for (std::size_t i = 0; i < raw_keys.size(); ++i) {
+      ft_transparent_map.find(raw_keys[i]);
+    }
+  }
+
+  {
+    AllocationCounter counter;
+    TIMER("std::map<Student, int> find/lower_bound/upper_bound");
+    find_all_keys(std_student_map, students);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map<Student, int> find/lower_bound/upper_bound");
+    find_all_keys(ft_student_map, students);
+  }
+}
+
+// コピーが重い値. 挿入時に何回コピーされるかが時間に出る.
+struct LargeValue {
+  int data[64];
+
+  LargeValue() {
+    for (int i = 0; i < 64; ++i) {
+      data[i] = i;
+    }
+  }
+};
+
+void measure_map_large_value() {
+  HEADER("measure_map_large_value");
+
+  typedef std::map<int, LargeValue> std_map_type;
+  typedef ft::map<int, LargeValue> ft_map_type;
+
+  const int max_size = 200000;
+  const LargeValue value;
+
+  {
+    TIMER("std::map<int, LargeValue> operator[]");
+    std_map_type std_map;
+    for (int i = 0; i < max_size; ++i) {
+      std_map[i];
+    }
+  }
+  {
+    TIMER("ft::map<int, LargeValue> operator[]");
+    ft_map_type ft_map;
+    for (int i = 0; i < max_size; ++i) {
+      ft_map[i];
+    }
+  }
+
+  {
+    TIMER("std::map<int, LargeValue> insert");
+    std_map_type std_map;
+    for (int i = 0; i < max_size; ++i) {
+      std_map.insert(std_map_type::value_type(i, value));
+    }
+  }
+  {
+    TIMER("ft::map<int, LargeValue> insert");
+    ft_map_type ft_map;
+    for (int i = 0; i < max_size; ++i) {
+      ft_map.insert(ft_map_type::value_type(i, value));
+    }
+  }
+  {
+    TIMER("ft::map<int, LargeValue> insert_or_assign");
+    ft_map_type ft_map;
+    for (int i = 0; i < max_size; ++i) {
+      ft_map.insert_or_assign(i, value);
+    }
+  }
+
+#if __cplusplus >= 201103L
+  {
+    TIMER("std::map<int, LargeValue> emplace");
+    std_map_type std_map;
+    for (int i = 0; i < max_size; ++i) {
+      std_map.emplace(i, value);
+    }
+  }
+  {
+    TIMER("ft::map<int, LargeValue> try_emplace");
+    ft_map_type ft_map;
+    for (int i = 0; i < max_size; ++i) {
+      ft_map.try_emplace(i, value);
+    }
+  }
+#endif
+}
+
+// 挿入と削除を繰り返してノードの確保と解放を測る.
+// 半分のキーを消しては入れ直すので, 木の大きさはほぼ一定に保たれる.
+template <class Map>
+void churn_map(const std::vector<int> &keys, const int rounds) {
+  Map m;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    m.insert(typename Map::value_type(keys[i], keys[i]));
+  }
+  for (int round = 0; round < rounds; ++round) {
+    for (std::size_t i = round % 2; i < keys.size(); i += 2) {
+      m.erase(keys[i]);
+    }
+    for (std::size_t i = round % 2; i < keys.size(); i += 2) {
+      m.insert(typename Map::value_type(keys[i], keys[i]));
+    }
+  }
+}
+
+void measure_map_node_pool() {
+  HEADER("measure_map_node_pool");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::map<int, int, std::less<int>,
+                  ft::node_pool_allocator<ft::pair<const int, int> > >
+      ft_pool_map_type;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 100000; ++i) {
+    keys.push_back(rand());
+  }
+  const int rounds = 10;
+
+  {
+    AllocationCounter counter;
+    TIMER("std::map insert/erase churn");
+    churn_map<std_map_type>(keys, rounds);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map insert/erase churn");
+    churn_map<ft_map_type>(keys, rounds);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::map<node_pool_allocator> insert/erase churn");
+    churn_map<ft_pool_map_type>(keys, rounds);
+  }
+}
+
+// リクエストごとに作って捨てる map を想定して, 挿入と破棄を別々に測る.
+template <class Map>
+void build_and_tear_down_map(const std::vector<int> &keys,
+                             const std::string &name) {
+  Map m;
+  {
+    TIMER(name + " insert");
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      m.insert(typename Map::value_type(keys[i], keys[i]));
+    }
+  }
+  {
+    AllocationCounter counter;
+    TIMER(name + " teardown");
+    Map().swap(m);
+  }
+}
+
+void measure_map_arena() {
+  HEADER("measure_map_arena");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::map<int, int, std::less<int>,
+                  ft::arena_allocator<ft::pair<const int, int> > >
+      ft_arena_map_type;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 500000; ++i) {
+    keys.push_back(rand());
+  }
+
+  build_and_tear_down_map<std_map_type>(keys, "std::map");
+  build_and_tear_down_map<ft_map_type>(keys, "ft::map");
+  build_and_tear_down_map<ft_arena_map_type>(keys,
+                                             "ft::map<arena_allocator>");
+}
+
+
+// 全要素を前から, 後ろから何度も辿る.
+template <class Map>
+long iterate_map(const Map &m, const int rounds) {
+  long sum = 0;
+  for (int round = 0; round < rounds; ++round) {
+    for (typename Map::const_iterator it = m.begin(); it != m.end(); ++it) {
+      sum += it->second;
+    }
+    for (typename Map::const_reverse_iterator it = m.rbegin(); it != m.rend();
+         ++it) {
+      sum -= it->second;
+    }
+  }
+  return sum;
+}
+
+void measure_map_threaded_iteration() {
+  HEADER("measure_map_threaded_iteration");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::map<int, int, std::less<int>,
+                  std::allocator<ft::pair<const int, int> >,
+                  ft::rbtree_threaded_node_policy>
+      ft_threaded_map_type;
+
+  std_map_type std_map;
+  ft_map_type ft_map;
+  ft_threaded_map_type ft_threaded_map;
+  for (int i = 0; i < 200000; ++i) {
+    const int key = rand();
+    std_map[key] = i;
+    ft_map[key] = i;
+    ft_threaded_map[key] = i;
+  }
+  const int rounds = 10;
+
+  {
+    TIMER("std::map iterate forward and backward");
+    if (iterate_map(std_map, rounds) != 0) {
+      std::abort();
+    }
+  }
+  {
+    TIMER("ft::map iterate forward and backward");
+    if (iterate_map(ft_map, rounds) != 0) {
+      std::abort();
+    }
+  }
+  {
+    TIMER("ft::map<threaded> iterate forward and backward");
+    if (iterate_map(ft_threaded_map, rounds) != 0) {
+      std::abort();
+    }
+  }
+}
+
+
+void measure_map_order_statistic() {
+  HEADER("measure_map_order_statistic");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int> ft_map_type;
+  typedef ft::map<int, int, std::less<int>,
+                  std::allocator<ft::pair<const int, int> >,
+                  ft::rbtree_order_statistic_node_policy<> >
+      ft_os_map_type;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 100000; ++i) {
+    keys.push_back(rand());
+  }
+  std_map_type std_map;
+  ft_map_type ft_map;
+  ft_os_map_type ft_os_map;
+
+  {
+    TIMER("ft::map insert");
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      ft_map[keys[i]] = keys[i];
+    }
+  }
+  {
+    TIMER("ft::map<order_statistic> insert");
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      ft_os_map[keys[i]] = keys[i];
+    }
+  }
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    std_map[keys[i]] = keys[i];
+  }
+
+  const std::size_t n = std_map.size();
+  const int queries = 100;
+  {
+    TIMER("std::map k-th element and rank (linear walk)");
+    long sum = 0;
+    for (int i = 0; i < queries; ++i) {
+      std_map_type::iterator it = std_map.begin();
+      std::advance(it, rand() % n);
+      sum += std::distance(std_map.begin(), std_map.lower_bound(it->first));
+    }
+    (void)sum;
+  }
+  {
+    TIMER("ft::map<order_statistic> nth and rank");
+    long sum = 0;
+    for (int i = 0; i < queries; ++i) {
+      ft_os_map_type::iterator it = ft_os_map.nth(rand() % n);
+      sum += ft_os_map.rank(it->first);
+    }
+    (void)sum;
+  }
+}
+
+
+// 値の合計を集計する.
+struct MappedSum {
+  typedef long result_type;
+
+  static result_type identity() {
+    return 0;
+  }
+  static result_type value(const ft::pair<const int, int> &v) {
+    return v.second;
+  }
+  static result_type combine(result_type lhs, result_type rhs) {
+    return lhs + rhs;
+  }
+};
+
+void measure_map_range_aggregate() {
+  HEADER("measure_map_range_aggregate");
+
+  typedef std::map<int, int> std_map_type;
+  typedef ft::map<int, int, std::less<int>,
+                  std::allocator<ft::pair<const int, int> >,
+                  ft::rbtree_augmented_node_policy<MappedSum> >
+      ft_sum_map_type;
+  typedef std::map<std::pair<int, int>, int> std_interval_map_type;
+  typedef ft::interval_map<int, int> ft_interval_map_type;
+
+  const int n = 100000;
+  const int queries = 100;
+  std_map_type std_map;
+  ft_sum_map_type ft_sum_map;
+  std_interval_map_type std_intervals;
+  ft_interval_map_type ft_intervals;
+  for (int i = 0; i < n; ++i) {
+    const int key = rand() % (n * 10);
+    std_map[key] = i;
+    ft_sum_map[key] = i;
+    std_intervals[std::make_pair(key, key + 1 + rand() % 100)] = i;
+    ft_intervals.insert(key, key + 1 + rand() % 100, i);
+  }
+
+  {
+    TIMER("std::map range sum (linear scan)");
+    long sum = 0;
+    for (int i = 0; i < queries; ++i) {
+      const int lo = rand() % (n * 10);
+      std_map_type::iterator last = std_map.lower_bound(lo + n);
+      for (std_map_type::iterator it = std_map.lower_bound(lo); it != last;
+           ++it) {
+        sum += it->second;
+      }
+    }
+    (void)sum;
+  }
+  {
+    TIMER("ft::map<augmented> range_aggregate");
+    long sum = 0;
+    for (int i = 0; i < queries; ++i) {
+      const int lo = rand() % (n * 10);
+      sum += ft_sum_map.range_aggregate(lo, lo + n);
+    }
+    (void)sum;
+  }
+  {
+    TIMER("std::map overlapping intervals (linear scan)");
+    std::size_t count = 0;
+    for (int i = 0; i < queries; ++i) {
+      const int lo = rand() % (n * 10);
+      for (std_interval_map_type::iterator it = std_intervals.begin();
+           it != std_intervals.end() && it->first.first < lo + 10; ++it) {
+        count += lo < it->first.second;
+      }
+    }
+    (void)count;
+  }
+  {
+    TIMER("ft::interval_map overlapping intervals");
+    std::vector<ft_interval_map_type::const_iterator> found;
+    for (int i = 0; i < queries; ++i) {
+      const int lo = rand() % (n * 10);
+      found.clear();
+      ft_intervals.overlapping(lo, lo + 10, std::back_inserter(found));
+    }
+  }
+}
+
+// freeze() したスナップショットは配列を k, 2k, ... と辿るだけなので, 木が
+// キャッシュに乗らない大きさでも探索でポインタを追う待ち時間が無い.
+void measure_map_freeze() {
+  const int n = 1000000;
+  HEADER("measure_map_freeze (size: " << n << ")");
+
+  typedef ft::map<int, int> ft_map_type;
+
+  ft_map_type ft_map;
+  std::vector<int> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(rand());
+    ft_map[keys.back()] = i;
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+
+  ft_map_type::frozen_type frozen;
+  {
+    TIMER("ft::map freeze");
+    frozen = ft_map.freeze();
+  }
+  {
+    TIMER("ft::map find");
+    long sum = 0;
+    for (int i = 0; i < n; ++i) {
+      sum += ft_map.find(keys[i])->second;
+    }
+    (void)sum;
+  }
+  {
+    TIMER("ft::map::frozen_type find");
+    long sum = 0;
+    for (int i = 0; i < n; ++i) {
+      sum += frozen.find(keys[i])->second;
+    }
+    (void)sum;
+  }
+  {
+    TIMER("ft::map lower_bound");
+    long sum = 0;
+    for (int i = 0; i < n; ++i) {
+      const ft_map_type::const_iterator it = ft_map.lower_bound(rand());
+      sum += it == ft_map.end() ? 0 : it->second;
+    }
+    (void)sum;
+  }
+  {
+    TIMER("ft::map::frozen_type lower_bound");
+    long sum = 0;
+    for (int i = 0; i < n; ++i) {
+      const ft_map_type::frozen_type::const_iterator it =
+          frozen.lower_bound(rand());
+      sum += it == frozen.end() ? 0 : it->second;
+    }
+    (void)sum;
+  }
+}
+
+// find_many は複数の探索を交互に進めて, 次のノードを先読みする.
+// 木が L3 キャッシュより大きいと1つずつの探索は毎段メモリを待つので差が出る.
+void measure_map_batched_lookup(const int size) {
+  HEADER("measure_map_batched_lookup (size: " << size << ")");
+
+  typedef ft::map<int, int> ft_map_type;
+
+  const int probes = 1000000;
+  ft_map_type ft_map;
+  for (int i = 0; i < size; ++i) {
+    ft_map[rand()] = i;
+  }
+  std::vector<int> keys;
+  for (int i = 0; i < probes; ++i) {
+    keys.push_back(rand());
+  }
+  std::vector<ft_map_type::iterator> results(probes);
+
+  {
+    TIMER("ft::map find");
+    for (int i = 0; i < probes; ++i) {
+      results[i] = ft_map.find(keys[i]);
+    }
+  }
+  {
+    TIMER("ft::map find_many");
+    ft_map.find_many(keys.begin(), keys.end(), results.begin());
+  }
+  {
+    TIMER("ft::map lower_bound");
+    for (int i = 0; i < probes; ++i) {
+      results[i] = ft_map.lower_bound(keys[i]);
+    }
+  }
+  {
+    TIMER("ft::map lower_bound_many");
+    ft_map.lower_bound_many(keys.begin(), keys.end(), results.begin());
+  }
+}
+
+}  // namespace
@@ -1,9 +1,15 @@
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <iterator>
 #include <set>
+#include <vector>
 
+#include "alloc_counter.hpp"
 #include "benchmarks.hpp"
+#include "fork_join.hpp"
+#include "node_pool_allocator.hpp"
 #include "set.hpp"
 #include "timer.hpp"
 
@@ -22,6 +28,9 @@ void measure_set_iterator();
 void measure_set_capacity();
 void measure_set_modifiers();
 void measure_set_lookup();
+void measure_set_node_pool();
+void measure_set_algebra();
+void measure_set_parallel_algebra();
 
 }  // namespace
 
@@ -31,6 +40,9 @@ void measure_set() {
   measure_set_capacity();
   measure_set_modifiers();
   measure_set_lookup();
+  measure_set_node_pool();
+  measure_set_algebra();
+  measure_set_parallel_algebra();
 }
 
 namespace {
@@ -292,4 +304,167 @@ void measure_set_lookup() {
   }
 }
 
-}  // namespace
\ No newline at end of file
+// 挿入と削除を繰り返してノードの確保と解放を測る.
+template <class Set>
+void churn_set(const std::vector<int> &keys, const int rounds) {
+  Set s;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    s.insert(keys[i]);
+  }
+  for (int round = 0; round < rounds; ++round) {
+    for (std::size_t i = round % 2; i < keys.size(); i += 2) {
+      s.erase(keys[i]);
+    }
+    for (std::size_t i = round % 2; i < keys.size(); i += 2) {
+      s.insert(keys[i]);
+    }
+  }
+}
+
+void measure_set_node_pool() {
+  HEADER("measure_set_node_pool");
+
+  typedef std::set<int> std_set_type;
+  typedef ft::set<int> ft_set_type;
+  typedef ft::set<int, std::less<int>, ft::node_pool_allocator<int> >
+      ft_pool_set_type;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 100000; ++i) {
+    keys.push_back(rand());
+  }
+  const int rounds = 10;
+
+  {
+    AllocationCounter counter;
+    TIMER("std::set insert/erase churn");
+    churn_set<std_set_type>(keys, rounds);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::set insert/erase churn");
+    churn_set<ft_set_type>(keys, rounds);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::set<node_pool_allocator> insert/erase churn");
+    churn_set<ft_pool_set_type>(keys, rounds);
+  }
+}
+
+
+// large_size 個と small_size 個の集合の和, 積, 差を測る.
+// std::set は要素ごとの挿入, 削除と std::set_intersection で求める.
+void measure_set_algebra_with_sizes(const int large_size,
+                                    const int small_size) {
+  typedef std::set<int> std_set_type;
+  typedef ft::set<int> ft_set_type;
+
+  std::vector<int> large_keys;
+  std::vector<int> small_keys;
+  for (int i = 0; i < large_size; ++i) {
+    large_keys.push_back(rand());
+  }
+  for (int i = 0; i < small_size; ++i) {
+    small_keys.push_back(i % 2 == 0 && i < large_size ? large_keys[i] : rand());
+  }
+  const std_set_type std_large(large_keys.begin(), large_keys.end());
+  const std_set_type std_small(small_keys.begin(), small_keys.end());
+  const ft_set_type ft_large(large_keys.begin(), large_keys.end());
+  const ft_set_type ft_small(small_keys.begin(), small_keys.end());
+
+  {
+    std_set_type result(std_large);
+    TIMER("std::set union by insert");
+    result.insert(std_small.begin(), std_small.end());
+  }
+  {
+    ft_set_type result(ft_large);
+    ft_set_type other(ft_small);
+    TIMER("ft::set unite");
+    result.unite(other);
+  }
+
+  {
+    std_set_type result;
+    TIMER("std::set_intersection");
+    std::set_intersection(std_large.begin(), std_large.end(),
+                          std_small.begin(), std_small.end(),
+                          std::inserter(result, result.end()));
+  }
+  {
+    ft_set_type result(ft_small);
+    TIMER("ft::set intersect");
+    result.intersect(ft_large);
+  }
+
+  {
+    std_set_type result(std_large);
+    TIMER("std::set difference by erase");
+    for (std_set_type::const_iterator it = std_small.begin();
+         it != std_small.end(); ++it) {
+      result.erase(*it);
+    }
+  }
+  {
+    ft_set_type result(ft_large);
+    TIMER("ft::set subtract");
+    result.subtract(ft_small);
+  }
+}
+
+void measure_set_algebra() {
+  HEADER("measure_set_algebra (skewed: 200000 and 200)");
+  measure_set_algebra_with_sizes(200000, 200);
+
+  HEADER("measure_set_algebra (balanced: 100000 and 100000)");
+  measure_set_algebra_with_sizes(100000, 100000);
+}
+
+
+// スレッド数を変えて, 同じ大きさの集合の和, 積, 差と一括挿入を測る.
+void measure_set_parallel_algebra() {
+  typedef ft::set<int> ft_set_type;
+
+  const int set_size = 300000;
+  std::vector<int> keys1;
+  std::vector<int> keys2;
+  for (int i = 0; i < set_size; ++i) {
+    keys1.push_back(rand());
+    keys2.push_back(rand());
+  }
+  const ft_set_type set1(keys1.begin(), keys1.end());
+  const ft_set_type set2(keys2.begin(), keys2.end());
+
+  const unsigned int thread_counts[] = {1, 2, 4, 8};
+  for (std::size_t i = 0; i < sizeof(thread_counts) / sizeof(unsigned int);
+       ++i) {
+    const ft::fork_join_executor executor(thread_counts[i]);
+    std::cout << "threads: " << executor.thread_count() << " (hardware: "
+              << ft::fork_join_executor::hardware_concurrency() << ")"
+              << std::endl;
+    {
+      ft_set_type result(set1);
+      ft_set_type other(set2);
+      TIMER("ft::set parallel unite");
+      result.unite(other, executor);
+    }
+    {
+      ft_set_type result(set1);
+      TIMER("ft::set parallel intersect");
+      result.intersect(set2, executor);
+    }
+    {
+      ft_set_type result(set1);
+      TIMER("ft::set parallel subtract");
+      result.subtract(set2, executor);
+    }
+    {
+      ft_set_type result(set1);
+      TIMER("ft::set parallel insert range");
+      result.insert(keys2.begin(), keys2.end(), executor);
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,100 @@
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "benchmarks.hpp"
+#include "small_vector.hpp"
+#include "timer.hpp"
+#include "vector.hpp"
+
+namespace {
+
+const int kInlineCapacity = 16;
+const int kLoopCount = 100000;
+
+// 要素数 size のコンテナを kLoopCount 回作って捨てる.
+template <class Vector>
+void build_vectors(const int size) {
+  for (int loop = 0; loop < kLoopCount; ++loop) {
+    Vector vec;
+    for (int i = 0; i < size; ++i) {
+      vec.push_back(i);
+    }
+  }
+}
+
+template <class Vector>
+void copy_vectors(const int size) {
+  Vector src;
+  for (int i = 0; i < size; ++i) {
+    src.push_back(i);
+  }
+  for (int loop = 0; loop < kLoopCount; ++loop) {
+    Vector copy(src);
+  }
+}
+
+void measure_small_vector_build(const int size);
+void measure_small_vector_copy(const int size);
+
+}  // namespace
+
+void measure_small_vector() {
+  measure_small_vector_build(0);
+  measure_small_vector_build(4);
+  measure_small_vector_build(16);
+  measure_small_vector_build(64);
+  measure_small_vector_copy(4);
+  measure_small_vector_copy(64);
+}
+
+namespace {
+
+void measure_small_vector_build(const int size) {
+  HEADER("measure_small_vector_build (size: " << size << ")");
+
+  typedef std::vector<int> std_vector_type;
+  typedef ft::vector<int> ft_vector_type;
+  typedef ft::small_vector<int, kInlineCapacity> ft_small_vector_type;
+
+  {
+    AllocationCounter counter;
+    TIMER("std::vector<int> push_back");
+    build_vectors<std_vector_type>(size);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::vector<int> push_back");
+    build_vectors<ft_vector_type>(size);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::small_vector<int, 16> push_back");
+    build_vectors<ft_small_vector_type>(size);
+  }
+}
+
+void measure_small_vector_copy(const int size) {
+  HEADER("measure_small_vector_copy (size: " << size << ")");
+
+  typedef std::vector<int> std_vector_type;
+  typedef ft::vector<int> ft_vector_type;
+  typedef ft::small_vector<int, kInlineCapacity> ft_small_vector_type;
+
+  {
+    AllocationCounter counter;
+    TIMER("std::vector<int> copy constructor");
+    copy_vectors<std_vector_type>(size);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::vector<int> copy constructor");
+    copy_vectors<ft_vector_type>(size);
+  }
+  {
+    AllocationCounter counter;
+    TIMER("ft::small_vector<int, 16> copy constructor");
+    copy_vectors<ft_small_vector_type>(size);
+  }
+}
+
+}  // namespace
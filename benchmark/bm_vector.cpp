@@ -1,13 +1,21 @@
 #include <unistd.h>
 
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include "arena_allocator.hpp"
 #include "benchmarks.hpp"
 #include "timer.hpp"
 #include "vector.hpp"
 
 namespace {
 
+struct Buffer {
+  int idx;
+  char buff[4096];
+};
+
 template <class T>
 inline void add_nums_into_vector(std::vector<T>& std_vec, ft::vector<T>& ft_vec,
                                  const int default_vec_size) {
@@ -24,9 +32,12 @@ namespace {
 void measure_vector_constructors();
 void measure_vector_assignation();
 void measure_vector_modifiers();
+void measure_vector_trivial_type();
+void measure_vector_string();
 void measure_vector_element_access();
 void measure_vector_iterator();
 void measure_vector_capacity();
+void measure_vector_arena();
 
 }  // namespace
 
@@ -34,9 +45,12 @@ void measure_vector() {
   measure_vector_constructors();
   measure_vector_assignation();
   measure_vector_modifiers();
+  measure_vector_trivial_type();
+  measure_vector_string();
   measure_vector_element_access();
   measure_vector_iterator();
   measure_vector_capacity();
+  measure_vector_arena();
 }
 
 namespace {
@@ -146,6 +160,28 @@ void measure_vector_modifiers() {
     }
   }
 
+  {
+    std_vector_type std_vec;
+    ft_vector_type ft_vec;
+
+    add_nums_into_vector(std_vec, ft_vec, default_vec_size / 100);
+    std_vec.reserve(default_vec_size / 50);
+    ft_vec.reserve(default_vec_size / 50);
+
+    {
+      TIMER("std::vector.insert(middle) within capacity");
+      for (int i = 0; i < default_vec_size / 100; ++i) {
+        std_vec.insert(std_vec.begin() + std_vec.size() / 2, i);
+      }
+    }
+    {
+      TIMER("ft::vector.insert(middle) within capacity");
+      for (int i = 0; i < default_vec_size / 100; ++i) {
+        ft_vec.insert(ft_vec.begin() + ft_vec.size() / 2, i);
+      }
+    }
+  }
+
   {
     std_vector_type std_vec;
     ft_vector_type ft_vec;
@@ -163,6 +199,133 @@ void measure_vector_modifiers() {
   }
 }
 
+void measure_vector_trivial_type() {
+  HEADER("measure_vector_trivial_type");
+
+  typedef std::vector<Buffer> std_vector_type;
+  typedef ft::vector<Buffer> ft_vector_type;
+
+  const int default_vec_size = 10000;
+
+  std_vector_type std_vec;
+  ft_vector_type ft_vec;
+  Buffer buffer = Buffer();
+
+  {
+    TIMER("std::vector<Buffer>.push_back");
+    for (int i = 0; i < default_vec_size; ++i) {
+      std_vec.push_back(buffer);
+    }
+  }
+  {
+    TIMER("ft::vector<Buffer>.push_back");
+    for (int i = 0; i < default_vec_size; ++i) {
+      ft_vec.push_back(buffer);
+    }
+  }
+
+  {
+    TIMER("std::vector<Buffer>.insert");
+    std_vec.insert(std_vec.begin() + std_vec.size() / 2, 100, buffer);
+  }
+  {
+    TIMER("ft::vector<Buffer>.insert");
+    ft_vec.insert(ft_vec.begin() + ft_vec.size() / 2, 100, buffer);
+  }
+
+  {
+    TIMER("std::vector<Buffer>.erase");
+    std_vec.erase(std_vec.begin(), std_vec.begin() + 100);
+  }
+  {
+    TIMER("ft::vector<Buffer>.erase");
+    ft_vec.erase(ft_vec.begin(), ft_vec.begin() + 100);
+  }
+}
+
+// SSO に収まらない長さの文字列を作る
+std::string make_long_string(int i) {
+  std::ostringstream oss;
+  oss << "this string is longer than the SSO buffer: " << i;
+  return oss.str();
+}
+
+template <class Vector>
+Vector make_string_vector(const int size) {
+  Vector vec;
+  for (int i = 0; i < size; ++i) {
+    vec.push_back(make_long_string(i));
+  }
+  return vec;
+}
+
+// C++11 でビルドした場合は再確保, 挿入, 削除, 一時オブジェクトの代入で
+// 要素がムーブされるので C++98 の場合との差を見る.
+void measure_vector_string() {
+  HEADER("measure_vector_string");
+
+  typedef std::vector<std::string> std_vector_type;
+  typedef ft::vector<std::string> ft_vector_type;
+
+  const int default_vec_size = 100000;
+
+  std_vector_type std_vec;
+  ft_vector_type ft_vec;
+
+  {
+    TIMER("std::vector<std::string>.push_back");
+    for (int i = 0; i < default_vec_size; ++i) {
+      std_vec.push_back(make_long_string(i));
+    }
+  }
+  {
+    TIMER("ft::vector<std::string>.push_back");
+    for (int i = 0; i < default_vec_size; ++i) {
+      ft_vec.push_back(make_long_string(i));
+    }
+  }
+
+  const std::string value = make_long_string(-1);
+  {
+    TIMER("std::vector<std::string>.insert(begin)");
+    for (int i = 0; i < 100; ++i) {
+      std_vec.insert(std_vec.begin(), value);
+    }
+  }
+  {
+    TIMER("ft::vector<std::string>.insert(begin)");
+    for (int i = 0; i < 100; ++i) {
+      ft_vec.insert(ft_vec.begin(), value);
+    }
+  }
+
+  {
+    TIMER("std::vector<std::string>.erase(begin)");
+    for (int i = 0; i < 100; ++i) {
+      std_vec.erase(std_vec.begin());
+    }
+  }
+  {
+    TIMER("ft::vector<std::string>.erase(begin)");
+    for (int i = 0; i < 100; ++i) {
+      ft_vec.erase(ft_vec.begin());
+    }
+  }
+
+  {
+    TIMER("std::vector<std::string> rebuild");
+    for (int i = 0; i < 10; ++i) {
+      std_vec = make_string_vector<std_vector_type>(default_vec_size / 10);
+    }
+  }
+  {
+    TIMER("ft::vector<std::string> rebuild");
+    for (int i = 0; i < 10; ++i) {
+      ft_vec = make_string_vector<ft_vector_type>(default_vec_size / 10);
+    }
+  }
+}
+
 void measure_vector_element_access() {
   HEADER("measure_vector_element_access");
 
@@ -331,4 +494,48 @@ void measure_vector_capacity() {
   }
 }
 
+// リクエストの間だけ使う小さな vector を繰り返し作る.
+// arena_allocator では末尾の領域をその場で広げるので伸ばす度の再確保と
+// 要素のコピーが無くなり, 破棄すると領域が arena に戻って次の vector が使う.
+void measure_vector_arena() {
+  HEADER("measure_vector_arena");
+
+  typedef std::vector<int> std_vector_type;
+  typedef ft::vector<int> ft_vector_type;
+  typedef ft::arena_allocator<int> arena_type;
+  typedef ft::vector<int, arena_type> ft_arena_vector_type;
+
+  const int num_vectors = 10000;
+  const int vec_size = 100;
+
+  {
+    TIMER("std::vector<int>.push_back");
+    for (int n = 0; n < num_vectors; ++n) {
+      std_vector_type vec;
+      for (int i = 0; i < vec_size; ++i) {
+        vec.push_back(i);
+      }
+    }
+  }
+  {
+    TIMER("ft::vector<int>.push_back");
+    for (int n = 0; n < num_vectors; ++n) {
+      ft_vector_type vec;
+      for (int i = 0; i < vec_size; ++i) {
+        vec.push_back(i);
+      }
+    }
+  }
+  {
+    TIMER("ft::vector<int, arena_allocator>.push_back");
+    arena_type arena;
+    for (int n = 0; n < num_vectors; ++n) {
+      ft_arena_vector_type vec(arena);
+      for (int i = 0; i < vec_size; ++i) {
+        vec.push_back(i);
+      }
+    }
+  }
+}
+
 }  // namespace
\ No newline at end of file
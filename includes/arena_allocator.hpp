@@ -0,0 +1,306 @@
+#ifndef ARENA_ALLOCATOR_H_
+#define ARENA_ALLOCATOR_H_
+#include <stdint.h>
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#if __cplusplus >= 201103L
+#include <utility>
+#endif
+
+namespace ft {
+
+// 大きな塊(チャンク)の先頭から順に切り出して配るだけの単調なアリーナ.
+// 個々の領域は解放せず, arena を共有する全てのアロケータが無くなった時に
+// チャンクをまとめて解放する.
+// ただし最後に配った領域だけは, 解放すれば再利用し, 広げることも出来る.
+class __arena {
+ public:
+  explicit __arena(std::size_t chunk_size)
+      : current_(NULL),
+        end_(NULL),
+        chunks_(NULL),
+        next_chunk_size_(chunk_size),
+        ref_count_(1) {
+    if (next_chunk_size_ < kMinChunkSize) {
+      next_chunk_size_ = kMinChunkSize;
+    }
+  }
+
+  ~__arena() {
+    while (chunks_) {
+      __chunk_header *next = chunks_->next_;
+      ::operator delete(static_cast<void *>(chunks_));
+      chunks_ = next;
+    }
+  }
+
+  // alignment は 2 の冪であること.
+  // チャンクの先頭は最も厳しいアラインメントに揃っているので,
+  // 新しいチャンクからはそのまま切り出せる.
+  void *allocate(std::size_t bytes, std::size_t alignment) {
+    if (current_) {
+      char *p = __align_up(current_, alignment);
+      if (p <= end_ && bytes <= static_cast<std::size_t>(end_ - p)) {
+        current_ = p + bytes;
+        return p;
+      }
+    }
+    __allocate_chunk(bytes);
+    char *p = current_;
+    current_ += bytes;
+    return p;
+  }
+
+  // 最後に配った領域なら切り出す前に戻す. それ以外は何もしない.
+  void deallocate(void *p, std::size_t bytes) {
+    if (static_cast<char *>(p) + bytes == current_) {
+      current_ = static_cast<char *>(p);
+    }
+  }
+
+  // 最後に配った領域で, チャンクに空きがあれば new_bytes に広げる.
+  bool extend(void *p, std::size_t old_bytes, std::size_t new_bytes) {
+    char *start = static_cast<char *>(p);
+    if (start + old_bytes != current_ ||
+        new_bytes > static_cast<std::size_t>(end_ - start)) {
+      return false;
+    }
+    current_ = start + new_bytes;
+    return true;
+  }
+
+  void retain() {
+    ++ref_count_;
+  }
+
+  // 参照が無くなったら arena を解放する.
+  static void release(__arena *arena) {
+    if (--arena->ref_count_ == 0) {
+      delete arena;
+    }
+  }
+
+ private:
+  enum { kMinChunkSize = 1024, kMaxChunkSize = 16 * 1024 * 1024 };
+
+  // 切り出す領域が最も厳しいアラインメントで始まるように,
+  // チャンクの先頭に置くヘッダの大きさを基本型で揃えておく.
+  union __chunk_header {
+    __chunk_header *next_;
+    long double ld_;
+    long long ll_;
+    double d_;
+    void *p_;
+  };
+
+  static char *__align_up(char *p, std::size_t alignment) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    return p + ((alignment - address % alignment) % alignment);
+  }
+
+  // 使い切ったチャンクの次は倍の大きさのチャンクを確保する.
+  // bytes がそれより大きい場合は, 伸びていく vector が次もその場で
+  // 広げられるように bytes の倍の大きさにする.
+  void __allocate_chunk(std::size_t bytes) {
+    std::size_t size = next_chunk_size_;
+    if (size < bytes) {
+      size = bytes > kMaxChunkSize ? bytes : bytes * 2;
+    }
+    char *raw =
+        static_cast<char *>(::operator new(sizeof(__chunk_header) + size));
+    __chunk_header *chunk = reinterpret_cast<__chunk_header *>(raw);
+    chunk->next_ = chunks_;
+    chunks_ = chunk;
+    current_ = raw + sizeof(__chunk_header);
+    end_ = current_ + size;
+    if (next_chunk_size_ < kMaxChunkSize) {
+      next_chunk_size_ *= 2;
+    }
+  }
+
+  // 現在のチャンクのうちまだ配っていない範囲
+  char *current_;
+  char *end_;
+  __chunk_header *chunks_;
+  std::size_t next_chunk_size_;
+  std::size_t ref_count_;
+
+  // コピーは参照カウントで共有するので禁止
+  __arena(const __arena &);
+  __arena &operator=(const __arena &);
+};
+
+// T のアラインメント. C++98 には alignof が無いので,
+// char の直後に T を置いた構造体の大きさから求める.
+template <class T>
+struct __alignment_of {
+ private:
+  struct __probe {
+    char c;
+    T t;
+  };
+
+ public:
+  static const std::size_t value = sizeof(__probe) - sizeof(T);
+};
+
+// リクエストの間だけ使う map や vector のための単調なアロケータ.
+// 確保は __arena から数命令で行い, deallocate() は最後に確保した領域を
+// 戻す以外は何もしない. 領域はアロケータのコピーが全て無くなった時に
+// チャンクごとまとめて解放する.
+//
+// is_monotonic を持つので, 要素のデストラクタが何もしない場合は
+// RedBlackTree の clear() とデストラクタはノードを辿らずに手放し,
+// vector は末尾の領域をその場で広げて再確保を省く.
+//
+// コピーしたアロケータも rebind したアロケータも arena を共有する.
+// arena は最初にコピーか確保をした時に作るので, 空のコンテナは何も確保しない.
+template <class T>
+class arena_allocator {
+ public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef void is_monotonic;
+
+  template <class U>
+  struct rebind {
+    typedef arena_allocator<U> other;
+  };
+
+  template <class U>
+  friend class arena_allocator;
+
+  arena_allocator() : arena_(NULL), chunk_size_(kDefaultChunkSize) {}
+
+  // 最初のチャンクの大きさ(バイト数)を指定する.
+  explicit arena_allocator(std::size_t chunk_size)
+      : arena_(NULL), chunk_size_(chunk_size) {}
+
+  arena_allocator(const arena_allocator &other)
+      : arena_(other.__get_arena()), chunk_size_(other.chunk_size_) {
+    arena_->retain();
+  }
+
+  template <class U>
+  arena_allocator(const arena_allocator<U> &other)
+      : arena_(other.__get_arena()), chunk_size_(other.chunk_size_) {
+    arena_->retain();
+  }
+
+  arena_allocator &operator=(const arena_allocator &rhs) {
+    if (this != &rhs) {
+      __arena *arena = rhs.__get_arena();
+      arena->retain();
+      __release_arena();
+      arena_ = arena;
+      chunk_size_ = rhs.chunk_size_;
+    }
+    return *this;
+  }
+
+  ~arena_allocator() {
+    __release_arena();
+  }
+
+  pointer address(reference x) const {
+    return &x;
+  }
+
+  const_pointer address(const_reference x) const {
+    return &x;
+  }
+
+  pointer allocate(size_type n, const void *hint = 0) {
+    (void)hint;
+    if (n > max_size()) {
+      throw std::bad_alloc();
+    }
+    return static_cast<pointer>(
+        __get_arena()->allocate(n * sizeof(T), __alignment_of<T>::value));
+  }
+
+  void deallocate(pointer p, size_type n) {
+    arena_->deallocate(p, n * sizeof(T));
+  }
+
+  // p から n 個の領域が最後に確保したものなら, 移さずに new_n 個に広げる.
+  bool extend(pointer p, size_type n, size_type new_n) {
+    if (new_n > max_size()) {
+      return false;
+    }
+    return arena_->extend(p, n * sizeof(T), new_n * sizeof(T));
+  }
+
+  size_type max_size() const {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+
+  void construct(pointer p, const_reference val) {
+    new (static_cast<void *>(p)) T(val);
+  }
+
+#if __cplusplus >= 201103L
+  template <class U, class... Args>
+  void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+#endif
+
+  void destroy(pointer p) {
+    p->~T();
+  }
+
+  // 互いに確保した領域を解放出来るのは arena を共有している時だけ.
+  template <class U>
+  bool operator==(const arena_allocator<U> &rhs) const {
+    return __get_arena() == rhs.__get_arena();
+  }
+
+  template <class U>
+  bool operator!=(const arena_allocator<U> &rhs) const {
+    return !(*this == rhs);
+  }
+
+  // arena を付け替えるだけなので, コピーと違って arena を作らない.
+  friend void swap(arena_allocator &lhs, arena_allocator &rhs) {
+    __arena *tmp = lhs.arena_;
+    lhs.arena_ = rhs.arena_;
+    rhs.arena_ = tmp;
+    const std::size_t tmp_size = lhs.chunk_size_;
+    lhs.chunk_size_ = rhs.chunk_size_;
+    rhs.chunk_size_ = tmp_size;
+  }
+
+ private:
+  enum { kDefaultChunkSize = 64 * 1024 };
+
+  // コピー元とも arena を共有するために, const なアロケータからも arena を作る.
+  __arena *__get_arena() const {
+    if (arena_ == NULL) {
+      arena_ = new __arena(chunk_size_);
+    }
+    return arena_;
+  }
+
+  void __release_arena() {
+    if (arena_) {
+      __arena::release(arena_);
+      arena_ = NULL;
+    }
+  }
+
+  mutable __arena *arena_;
+  std::size_t chunk_size_;
+};
+
+}  // namespace ft
+
+#endif
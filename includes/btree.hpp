@@ -0,0 +1,1600 @@
+#ifndef BTREE_H_
+#define BTREE_H_
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+
+#include "equal.hpp"
+#include "functional.hpp"
+#include "iterator_traits.hpp"
+#include "lexicographical_compare.hpp"
+#include "pair.hpp"
+#include "reverse_iterator.hpp"
+#include "type_traits.hpp"
+
+namespace ft {
+
+template <class Value, std::size_t NodeSize>
+struct BTreeInternalNode;
+
+// B 木のノード.
+// 葉は値だけを持ち, 内部ノード(BTreeInternalNode)は更に子へのポインタを持つ.
+// 値は NodeSize バイトに収まるだけ1つのノードに詰めるので, 探索で辿るノードの
+// 数(キャッシュミスの数)が赤黒木の log2(n) から log_B(n) に減る.
+//
+// 値の領域は値を構築せずに確保しておき, 先頭から count_ 個だけを構築する.
+template <class Value, std::size_t NodeSize>
+struct BTreeNode {
+  typedef BTreeInternalNode<Value, NodeSize> internal_node_type;
+
+  // parent_ から leaf_ までの大きさ.
+  static const std::size_t kHeaderSize = 2 * sizeof(void *);
+  // 1つのノードに入れる値の数. 分けた後の両方に値が残るように3つ以上にする.
+  static const std::size_t kSlots =
+      NodeSize >= kHeaderSize + 3 * sizeof(Value)
+          ? (NodeSize - kHeaderSize) / sizeof(Value)
+          : 3;
+
+  BTreeNode *parent_;
+  // 親の子の中で何番目か
+  unsigned short position_;
+  unsigned short count_;
+  bool leaf_;
+  // 値を最も厳しいアラインメントで置けるように, 基本型と共用体にしておく.
+  union {
+    char bytes_[sizeof(Value) * kSlots];
+    long double ld_;
+    long long ll_;
+    void *p_;
+  } storage_;
+
+  Value *value(std::size_t i) {
+    return reinterpret_cast<Value *>(storage_.bytes_) + i;
+  }
+
+  const Value *value(std::size_t i) const {
+    return reinterpret_cast<const Value *>(storage_.bytes_) + i;
+  }
+
+  // 内部ノードの i 番目の子. 値 i の前(左)の部分木である.
+  BTreeNode *child(std::size_t i) const;
+
+  // i 番目の子を c にして, c の親と位置を合わせる.
+  void set_child(std::size_t i, BTreeNode *c);
+};
+
+template <class Value, std::size_t NodeSize>
+struct BTreeInternalNode : public BTreeNode<Value, NodeSize> {
+  typedef BTreeNode<Value, NodeSize> node_type;
+
+  node_type *children_[node_type::kSlots + 1];
+};
+
+template <class Value, std::size_t NodeSize>
+inline BTreeNode<Value, NodeSize> *BTreeNode<Value, NodeSize>::child(
+    std::size_t i) const {
+  return static_cast<const internal_node_type *>(this)->children_[i];
+}
+
+template <class Value, std::size_t NodeSize>
+inline void BTreeNode<Value, NodeSize>::set_child(std::size_t i,
+                                                 BTreeNode *c) {
+  static_cast<internal_node_type *>(this)->children_[i] = c;
+  c->parent_ = this;
+  c->position_ = static_cast<unsigned short>(i);
+}
+
+// (node, position) を中間順で次の値の位置に進める.
+// 最後の値の次は, 最も右の葉の count_ 番目(end)になる.
+template <class NodePointer>
+void btree_next_position(NodePointer &node, std::size_t &position) {
+  if (!node->leaf_) {
+    node = node->child(position + 1);
+    while (!node->leaf_) {
+      node = node->child(0);
+    }
+    position = 0;
+    return;
+  }
+  if (++position < node->count_) {
+    return;
+  }
+  // 葉の末尾を過ぎたので, 祖先で次の値を探す. 無ければ end に戻す.
+  NodePointer last_leaf = node;
+  while (position == node->count_ && node->parent_) {
+    position = node->position_;
+    node = node->parent_;
+  }
+  if (position == node->count_) {
+    node = last_leaf;
+    position = last_leaf->count_;
+  }
+}
+
+// (node, position) を中間順で前の値の位置に戻す. end からは最後の値に戻る.
+template <class NodePointer>
+void btree_prev_position(NodePointer &node, std::size_t &position) {
+  if (!node->leaf_) {
+    node = node->child(position);
+    while (!node->leaf_) {
+      node = node->child(node->count_);
+    }
+    position = node->count_ - 1;
+    return;
+  }
+  while (position == 0 && node->parent_) {
+    position = node->position_;
+    node = node->parent_;
+  }
+  --position;
+}
+
+// 値の位置はノードとノード内の添字で表す.
+// 挿入と削除では値がノードの間を移るので, 木を変更すると全てのイテレータが
+// 無効になる. (ft::map と違い, 変更していない要素を指すものも無効になる)
+template <class Value, std::size_t NodeSize>
+struct btree_iterator {
+  typedef Value value_type;
+  typedef Value &reference;
+  typedef Value *pointer;
+
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef std::ptrdiff_t difference_type;
+
+  typedef btree_iterator<Value, NodeSize> self_type;
+  typedef BTreeNode<Value, NodeSize> node_type;
+  typedef node_type *node_pointer;
+
+  node_pointer node_;
+  std::size_t position_;
+
+  btree_iterator() : node_(), position_(0) {}
+
+  btree_iterator(node_pointer node, std::size_t position)
+      : node_(node), position_(position) {}
+
+  btree_iterator(const self_type &other)
+      : node_(other.node_), position_(other.position_) {}
+
+  self_type &operator=(const self_type &other) {
+    if (this != &other) {
+      node_ = other.node_;
+      position_ = other.position_;
+    }
+    return *this;
+  }
+
+  ~btree_iterator() {}
+
+  reference operator*() const {
+    return *node_->value(position_);
+  }
+
+  pointer operator->() const {
+    return node_->value(position_);
+  }
+
+  self_type &operator++() {
+    btree_next_position(node_, position_);
+    return *this;
+  }
+
+  self_type operator++(int) {
+    self_type tmp = *this;
+    btree_next_position(node_, position_);
+    return tmp;
+  }
+
+  self_type &operator--() {
+    btree_prev_position(node_, position_);
+    return *this;
+  }
+
+  self_type operator--(int) {
+    self_type tmp = *this;
+    btree_prev_position(node_, position_);
+    return tmp;
+  }
+
+  friend bool operator==(const self_type &lhs, const self_type &rhs) {
+    return lhs.node_ == rhs.node_ && lhs.position_ == rhs.position_;
+  }
+
+  friend bool operator!=(const self_type &lhs, const self_type &rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+template <class Value, std::size_t NodeSize>
+struct btree_const_iterator {
+  typedef Value value_type;
+  typedef const Value &reference;
+  typedef const Value *pointer;
+
+  typedef btree_iterator<Value, NodeSize> iterator;
+
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef std::ptrdiff_t difference_type;
+
+  typedef btree_const_iterator<Value, NodeSize> self_type;
+  typedef BTreeNode<Value, NodeSize> node_type;
+  typedef const node_type *node_pointer;
+
+  node_pointer node_;
+  std::size_t position_;
+
+  btree_const_iterator() : node_(), position_(0) {}
+
+  btree_const_iterator(node_pointer node, std::size_t position)
+      : node_(node), position_(position) {}
+
+  btree_const_iterator(const self_type &other)
+      : node_(other.node_), position_(other.position_) {}
+
+  btree_const_iterator(const iterator &it)
+      : node_(it.node_), position_(it.position_) {}
+
+  self_type &operator=(const self_type &other) {
+    if (this != &other) {
+      node_ = other.node_;
+      position_ = other.position_;
+    }
+    return *this;
+  }
+
+  ~btree_const_iterator() {}
+
+  iterator cast_nonconst() const {
+    return iterator(const_cast<typename iterator::node_pointer>(node_),
+                    position_);
+  }
+
+  reference operator*() const {
+    return *node_->value(position_);
+  }
+
+  pointer operator->() const {
+    return node_->value(position_);
+  }
+
+  self_type &operator++() {
+    btree_next_position(node_, position_);
+    return *this;
+  }
+
+  self_type operator++(int) {
+    self_type tmp = *this;
+    btree_next_position(node_, position_);
+    return tmp;
+  }
+
+  self_type &operator--() {
+    btree_prev_position(node_, position_);
+    return *this;
+  }
+
+  self_type operator--(int) {
+    self_type tmp = *this;
+    btree_prev_position(node_, position_);
+    return tmp;
+  }
+
+  friend bool operator==(const self_type &lhs, const self_type &rhs) {
+    return lhs.node_ == rhs.node_ && lhs.position_ == rhs.position_;
+  }
+
+  friend bool operator!=(const self_type &lhs, const self_type &rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+// ノードの間で値を移す時に値として扱う型.
+// btree_map の pair<const Key, T> はキーが const なのでムーブしてもキーは
+// コピーになり, std::string のようなキーでは例外を投げうる.
+// ノード内では const を外した pair<Key, T> として構築, ムーブし,
+// pair<const Key, T> としてはイテレータを通してだけ見せる.
+template <class Value>
+struct __btree_slot_value {
+  typedef Value type;
+};
+
+template <class Key, class T>
+struct __btree_slot_value<ft::pair<const Key, T> > {
+  typedef ft::pair<Key, T> type;
+};
+
+// B Tree
+//
+// 全ての葉は同じ深さにあり, 内部ノードは値の数 + 1 個の子を持つ.
+// 子 i の部分木の値は, 値 i - 1 より大きく値 i より小さい.
+// 根以外のノードは削除で kMinSlots 個より少なくなると兄弟と併合するか,
+// 兄弟から値を借りる.
+//
+// テンプレートパラメータは RedBlackTree と同じで, NodeSize は1つの葉の
+// おおよそのバイト数. 内部ノードは子へのポインタの分だけ大きくなる.
+//
+// 値は分割, 併合の度にノードの間をムーブ(C++98 ではコピー)で移すので,
+// 値のムーブ(コピー)は例外を投げないこと. pair<const Key, T> のキーも
+// ムーブする. (__btree_slot_value)
+template <class Key, class Value, class KeyOfValue,
+          class Compare = std::less<Key>, class Alloc = std::allocator<Value>,
+          std::size_t NodeSize = 256>
+class BTree {
+ public:
+  typedef BTreeNode<Value, NodeSize> node_type;
+  typedef BTreeInternalNode<Value, NodeSize> internal_node_type;
+  typedef typename Alloc::template rebind<node_type>::other leaf_allocator;
+  typedef typename Alloc::template rebind<internal_node_type>::other
+      internal_allocator;
+
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Alloc allocator_type;
+
+  typedef btree_iterator<value_type, NodeSize> iterator;
+  typedef btree_const_iterator<value_type, NodeSize> const_iterator;
+  typedef ft::reverse_iterator<iterator> reverse_iterator;
+  typedef ft::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  static const size_type kNodeSlots = node_type::kSlots;
+  static const size_type kMinSlots = kNodeSlots / 2;
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  // 整数のキーはノード内を先頭から比較の回数を数えて探す.
+  // 分岐が無いのでコンパイラがベクトル化でき, 二分探索より速い.
+  typedef typename is_integral<key_type>::type __linear_search;
+  // ノード内の値は全てこの型で構築する.
+  typedef typename __btree_slot_value<value_type>::type slot_value_type;
+
+  // Members
+  node_type *root_;
+  // 最小の値と最大の値を持つ葉. begin() と end() を O(1) で求めるために持つ.
+  // end() は rightmost_ の count_ 番目の位置で表す. 空の木では共に NULL.
+  node_type *leftmost_;
+  node_type *rightmost_;
+  size_type size_;
+  Compare key_comp_;
+  leaf_allocator leaf_allocator_;
+  // 内部ノード用に rebind したアロケータ. 確保の度に作ると, アロケータが
+  // 状態(pool など)を持つ場合に確保した領域がその一時オブジェクトと共に
+  // 失われるので, 木と同じ寿命で持つ.
+  internal_allocator internal_allocator_;
+
+ public:
+  // Constructor, Descructor
+  // 空の木はノードを1つも確保しない.
+
+  BTree()
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        key_comp_(Compare()),
+        leaf_allocator_(),
+        internal_allocator_() {}
+
+  explicit BTree(const Compare &comp, const Alloc &alloc = Alloc())
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        key_comp_(comp),
+        leaf_allocator_(leaf_allocator(alloc)),
+        internal_allocator_(internal_allocator(alloc)) {}
+
+  template <class InputIt>
+  BTree(InputIt first, InputIt last, const Compare &comp = Compare(),
+        const Alloc &alloc = Alloc())
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        key_comp_(comp),
+        leaf_allocator_(leaf_allocator(alloc)),
+        internal_allocator_(internal_allocator(alloc)) {
+    insert_range_unique(first, last);
+  }
+
+  BTree(const BTree &other)
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        key_comp_(other.key_comp_),
+        leaf_allocator_(other.leaf_allocator_),
+        internal_allocator_(other.internal_allocator_) {
+    __copy_from(other);
+  }
+
+  // 要素のコピーが例外を投げた場合は空の木になる.
+  BTree &operator=(const BTree &rhs) {
+    if (&rhs != this) {
+      clear();
+      key_comp_ = rhs.key_comp_;
+      __copy_from(rhs);
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  // ノードは付け替えるだけで要素のコピーもムーブもしない.
+  BTree(BTree &&other) noexcept
+      : root_(NULL),
+        leftmost_(NULL),
+        rightmost_(NULL),
+        size_(0),
+        key_comp_(other.key_comp_),
+        leaf_allocator_(other.leaf_allocator_),
+        internal_allocator_(other.internal_allocator_) {
+    swap(other);
+  }
+
+  BTree &operator=(BTree &&rhs) noexcept {
+    if (&rhs != this) {
+      clear();
+      swap(rhs);
+    }
+    return *this;
+  }
+#endif
+
+  ~BTree() {
+    clear();
+  }
+
+  /********** Insert **********/
+
+  ft::pair<iterator, bool> insert_unique(const value_type &value) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(__get_key_of_value(value), node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(__emplace_at(node, position, value), true);
+  }
+
+  iterator insert_unique(const_iterator hint, const value_type &value) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(hint, __get_key_of_value(value), node,
+                               position)) {
+      return iterator(node, position);
+    }
+    return __emplace_at(node, position, value);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert_unique(value_type &&value) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(__get_key_of_value(value), node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(
+        __emplace_at(node, position, std::move(value)), true);
+  }
+
+  iterator insert_unique(const_iterator hint, value_type &&value) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(hint, __get_key_of_value(value), node,
+                               position)) {
+      return iterator(node, position);
+    }
+    return __emplace_at(node, position, std::move(value));
+  }
+
+  // キーは構築した値からしか取り出せないので, 一時オブジェクトを作ってから
+  // 挿入位置を探し, ノードにはムーブする.
+  template <class... Args>
+  ft::pair<iterator, bool> emplace_unique(Args &&...args) {
+    return insert_unique(value_type(std::forward<Args>(args)...));
+  }
+
+  template <class... Args>
+  iterator emplace_hint_unique(const_iterator hint, Args &&...args) {
+    return insert_unique(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  // key で挿入位置を一度だけ探し, 無い場合だけ args からノード内に値を構築する.
+  // btree_map の try_emplace, insert_or_assign, operator[] で使う.
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              Args &&...args) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(key, node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(
+        __emplace_at(node, position, std::forward<Args>(args)...), true);
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   Args &&...args) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(hint, key, node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(
+        __emplace_at(node, position, std::forward<Args>(args)...), true);
+  }
+#else
+  // C++98 では可変長引数が使えないので, 値のコンストラクタに渡す引数は2つに限る.
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              const Arg1 &arg1,
+                                              const Arg2 &arg2) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(key, node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(__emplace_at(node, position, arg1, arg2),
+                                    true);
+  }
+
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   const Arg1 &arg1,
+                                                   const Arg2 &arg2) {
+    node_type *node;
+    size_type position;
+    if (__find_insert_position(hint, key, node, position)) {
+      return ft::pair<iterator, bool>(iterator(node, position), false);
+    }
+    return ft::pair<iterator, bool>(__emplace_at(node, position, arg1, arg2),
+                                    true);
+  }
+#endif
+
+  // 末尾を hint にして1つずつ挿入する. ソート済みの範囲なら探索せずに
+  // 最も右の葉に追加していく.
+  template <class InputIt>
+  void insert_range_unique(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert_unique(end(), *first);
+    }
+  }
+
+  allocator_type get_allocator() const {
+    return allocator_type(leaf_allocator_);
+  }
+
+  /********** Iterators **********/
+
+  iterator begin() {
+    return iterator(leftmost_, 0);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(leftmost_, 0);
+  }
+
+  iterator end() {
+    return iterator(rightmost_, rightmost_ ? rightmost_->count_ : 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(rightmost_, rightmost_ ? rightmost_->count_ : 0);
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  /********** Capacity **********/
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  size_type max_size() const {
+    return static_cast<size_type>(
+               std::numeric_limits<difference_type>::max()) /
+           sizeof(value_type);
+  }
+
+  /********** Modifiers **********/
+
+  void clear() {
+    if (root_) {
+      __delete_subtree(root_);
+    }
+    root_ = NULL;
+    leftmost_ = NULL;
+    rightmost_ = NULL;
+    size_ = 0;
+  }
+
+  void swap(BTree &other) {
+    using std::swap;
+    swap(leaf_allocator_, other.leaf_allocator_);
+    swap(internal_allocator_, other.internal_allocator_);
+    std::swap(root_, other.root_);
+    std::swap(leftmost_, other.leftmost_);
+    std::swap(rightmost_, other.rightmost_);
+    std::swap(size_, other.size_);
+    std::swap(key_comp_, other.key_comp_);
+  }
+
+  void erase(iterator pos) {
+    __erase_at(pos.node_, pos.position_);
+  }
+
+  void erase(const_iterator pos) {
+    __erase_at(const_cast<node_type *>(pos.node_), pos.position_);
+  }
+
+  void erase(const_iterator first, const_iterator last);
+
+  size_type erase(const key_type &key) {
+    iterator it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    erase(it);
+    return 1;
+  }
+
+  /********** Lookup **********/
+
+  template <class K>
+  iterator find(const K &key) {
+    return __find(key);
+  }
+
+  template <class K>
+  const_iterator find(const K &key) const {
+    return __find(key);
+  }
+
+  template <class K>
+  size_type count(const K &key) const {
+    return __find(key) == end() ? 0 : 1;
+  }
+
+  template <class K>
+  iterator lower_bound(const K &key) {
+    return __lower_bound(key);
+  }
+
+  template <class K>
+  const_iterator lower_bound(const K &key) const {
+    return __lower_bound(key);
+  }
+
+  template <class K>
+  iterator upper_bound(const K &key) {
+    return __upper_bound(key);
+  }
+
+  template <class K>
+  const_iterator upper_bound(const K &key) const {
+    return __upper_bound(key);
+  }
+
+  template <class K>
+  ft::pair<iterator, iterator> equal_range(const K &key) {
+    return __equal_range(key);
+  }
+
+  template <class K>
+  ft::pair<const_iterator, const_iterator> equal_range(const K &key) const {
+    ft::pair<iterator, iterator> range = __equal_range(key);
+    return ft::pair<const_iterator, const_iterator>(range.first, range.second);
+  }
+
+  /********** Observers **********/
+
+  Compare key_comp() const {
+    return key_comp_;
+  }
+
+  // 根から葉までのノードの数. 空の木では 0.
+  size_type height() const {
+    size_type h = 0;
+    for (const node_type *node = root_; node; ++h) {
+      node = node->leaf_ ? NULL : node->child(0);
+    }
+    return h;
+  }
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  /********** Search **********/
+  template <class K>
+  iterator __find(const K &key) const;
+  template <class K>
+  iterator __lower_bound(const K &key) const;
+  template <class K>
+  iterator __upper_bound(const K &key) const;
+  template <class K>
+  ft::pair<iterator, iterator> __equal_range(const K &key) const;
+  template <class K>
+  size_type __lower_bound_in_node(const node_type *node, const K &key) const;
+  template <class K>
+  size_type __lower_bound_in_node(const node_type *node, const K &key,
+                                  true_type) const;
+  template <class K>
+  size_type __lower_bound_in_node(const node_type *node, const K &key,
+                                  false_type) const;
+  template <class K>
+  size_type __upper_bound_in_node(const node_type *node, const K &key) const;
+  template <class K>
+  size_type __upper_bound_in_node(const node_type *node, const K &key,
+                                  true_type) const;
+  template <class K>
+  size_type __upper_bound_in_node(const node_type *node, const K &key,
+                                  false_type) const;
+  iterator __make_iterator(node_type *node, size_type position) const;
+  template <class K>
+  bool __find_insert_position(const K &key, node_type *&node,
+                              size_type &position) const;
+  template <class K>
+  bool __find_insert_position(const_iterator hint, const K &key,
+                              node_type *&node, size_type &position) const;
+
+  /********** Insert **********/
+#if __cplusplus >= 201103L
+  template <class... Args>
+  iterator __emplace_at(node_type *node, size_type position, Args &&...args);
+#else
+  template <class Arg>
+  iterator __emplace_at(node_type *node, size_type position, const Arg &arg);
+  template <class Arg1, class Arg2>
+  iterator __emplace_at(node_type *node, size_type position, const Arg1 &arg1,
+                        const Arg2 &arg2);
+#endif
+  void __open_slot(node_type *&node, size_type &position);
+  void __close_slot(node_type *node, size_type position);
+  void __split_node(node_type *&node, size_type &position);
+  void __insert_into_parent(node_type *parent, size_type position,
+                            value_type *separator, node_type *right);
+
+  /********** Erase **********/
+  iterator __erase_at(node_type *node, size_type position);
+  void __rebalance(node_type *node, node_type *&next,
+                   size_type &next_position);
+  void __merge_nodes(node_type *left, node_type *right, node_type *&next,
+                     size_type &next_position);
+  void __rotate_right(node_type *left, node_type *node, size_type n,
+                      node_type *&next, size_type &next_position);
+  void __rotate_left(node_type *node, node_type *right, size_type n,
+                     node_type *&next, size_type &next_position);
+
+  /********** Node operations **********/
+  node_type *__allocate_node(bool leaf);
+  void __deallocate_node(node_type *node);
+  void __delete_subtree(node_type *node);
+  void __copy_from(const BTree &other);
+  node_type *__copy_subtree(const node_type *src);
+  static void __move_value(value_type *dst, value_type *src);
+  static void __destroy_value(value_type *value);
+  static slot_value_type *__as_slot(value_type *value) {
+    return reinterpret_cast<slot_value_type *>(value);
+  }
+
+  /********** Comparisons **********/
+  const key_type &__get_key_of_value(const value_type &value) const {
+    return KeyOfValue()(value);
+  }
+
+  const key_type &__key_at(const node_type *node, size_type i) const {
+    return __get_key_of_value(*node->value(i));
+  }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+bool operator==(
+    const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize> &lhs,
+    const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize> &rhs) {
+  return lhs.size() == rhs.size() &&
+         ft::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+bool operator<(
+    const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize> &lhs,
+    const BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize> &rhs) {
+  typedef BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize> tree_type;
+  typedef typename tree_type::const_iterator const_iterator;
+
+  return ft::lexicographical_compare<const_iterator, const_iterator>(
+      lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+// 値を消すと他の値がノードの間を移ってイテレータが無効になるが,
+// __erase_at() が次の値の位置を返すので, 探し直さずにそこから消し続ける.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::erase(
+    const_iterator first, const_iterator last) {
+  if (first == begin() && last == end()) {
+    clear();
+    return;
+  }
+  size_type n = std::distance(first, last);
+  iterator it = first.cast_nonconst();
+  for (; n > 0; --n) {
+    it = __erase_at(it.node_, it.position_);
+  }
+}
+
+/********** Search **********/
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__find(
+    const K &key) const {
+  node_type *node = root_;
+  while (node) {
+    const size_type i = __lower_bound_in_node(node, key);
+    if (i < node->count_ && !key_comp_(key, __key_at(node, i))) {
+      return iterator(node, i);
+    }
+    node = node->leaf_ ? NULL : node->child(i);
+  }
+  return iterator(rightmost_, rightmost_ ? rightmost_->count_ : 0);
+}
+
+// 内部ノードでは一致を調べずに葉まで降りる. 葉の末尾を過ぎた場合は
+// __make_iterator() が祖先の値に移す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__lower_bound(
+    const K &key) const {
+  node_type *node = root_;
+  if (node == NULL) {
+    return iterator(NULL, 0);
+  }
+  for (;;) {
+    const size_type i = __lower_bound_in_node(node, key);
+    if (node->leaf_) {
+      return __make_iterator(node, i);
+    }
+    node = node->child(i);
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__upper_bound(
+    const K &key) const {
+  node_type *node = root_;
+  if (node == NULL) {
+    return iterator(NULL, 0);
+  }
+  for (;;) {
+    const size_type i = __upper_bound_in_node(node, key);
+    if (node->leaf_) {
+      return __make_iterator(node, i);
+    }
+    node = node->child(i);
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+ft::pair<typename BTree<Key, Value, KeyOfValue, Compare, Alloc,
+                        NodeSize>::iterator,
+         typename BTree<Key, Value, KeyOfValue, Compare, Alloc,
+                        NodeSize>::iterator>
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__equal_range(
+    const K &key) const {
+  iterator first = __lower_bound(key);
+  iterator last = first;
+  if (last != iterator(rightmost_, rightmost_ ? rightmost_->count_ : 0) &&
+      !key_comp_(key, __get_key_of_value(*last))) {
+    ++last;
+  }
+  return ft::pair<iterator, iterator>(first, last);
+}
+
+// node の中で key 以上の最初の値の位置. 無ければ count_.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__lower_bound_in_node(
+    const node_type *node, const K &key) const {
+  return __lower_bound_in_node(node, key, __linear_search());
+}
+
+// 値はソートされているので, key より小さい値の数がそのまま位置になる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__lower_bound_in_node(
+    const node_type *node, const K &key, true_type) const {
+  const size_type count = node->count_;
+  size_type less = 0;
+  for (size_type i = 0; i < count; ++i) {
+    less += key_comp_(__key_at(node, i), key);
+  }
+  return less;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__lower_bound_in_node(
+    const node_type *node, const K &key, false_type) const {
+  size_type lo = 0;
+  size_type hi = node->count_;
+  while (lo < hi) {
+    const size_type mid = lo + (hi - lo) / 2;
+    if (key_comp_(__key_at(node, mid), key)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// node の中で key より大きい最初の値の位置. 無ければ count_.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__upper_bound_in_node(
+    const node_type *node, const K &key) const {
+  return __upper_bound_in_node(node, key, __linear_search());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__upper_bound_in_node(
+    const node_type *node, const K &key, true_type) const {
+  const size_type count = node->count_;
+  size_type not_greater = 0;
+  for (size_type i = 0; i < count; ++i) {
+    not_greater += !key_comp_(key, __key_at(node, i));
+  }
+  return not_greater;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::size_type
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__upper_bound_in_node(
+    const node_type *node, const K &key, false_type) const {
+  size_type lo = 0;
+  size_type hi = node->count_;
+  while (lo < hi) {
+    const size_type mid = lo + (hi - lo) / 2;
+    if (key_comp_(key, __key_at(node, mid))) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+// 葉の末尾(count_ 番目)を指す位置は, 次の値を持つ祖先の位置に直す.
+// 最も右の葉の末尾はそのまま end() になる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__make_iterator(
+    node_type *node, size_type position) const {
+  if (position < node->count_ || node == rightmost_) {
+    return iterator(node, position);
+  }
+  while (position == node->count_) {
+    position = node->position_;
+    node = node->parent_;
+  }
+  return iterator(node, position);
+}
+
+// key が既にあれば node と position にその位置を入れて true を返す.
+// 無ければ挿入する葉と位置を入れて false を返す. 空の木では node は NULL.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+bool BTree<Key, Value, KeyOfValue, Compare, Alloc,
+           NodeSize>::__find_insert_position(const K &key, node_type *&node,
+                                             size_type &position) const {
+  node = root_;
+  position = 0;
+  if (node == NULL) {
+    return false;
+  }
+  for (;;) {
+    position = __lower_bound_in_node(node, key);
+    if (position < node->count_ && !key_comp_(key, __key_at(node, position))) {
+      return true;
+    }
+    if (node->leaf_) {
+      return false;
+    }
+    node = node->child(position);
+  }
+}
+
+// key が hint の直前に入るなら探索せずに位置を決める.
+// hint が内部ノードを指す場合は, 直前の値(葉にある)の後ろに入れる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class K>
+bool BTree<Key, Value, KeyOfValue, Compare, Alloc,
+           NodeSize>::__find_insert_position(const_iterator hint, const K &key,
+                                             node_type *&node,
+                                             size_type &position) const {
+  const const_iterator first(leftmost_, 0);
+  const const_iterator last(rightmost_, rightmost_ ? rightmost_->count_ : 0);
+  if (root_ == NULL ||
+      (hint != last && !key_comp_(key, __get_key_of_value(*hint)))) {
+    return __find_insert_position(key, node, position);
+  }
+  const_iterator prev = hint;
+  if (hint != first && !key_comp_(__get_key_of_value(*--prev), key)) {
+    return __find_insert_position(key, node, position);
+  }
+  if (hint.node_->leaf_) {
+    node = const_cast<node_type *>(hint.node_);
+    position = hint.position_;
+  } else {
+    node = const_cast<node_type *>(prev.node_);
+    position = prev.position_ + 1;
+  }
+  return false;
+}
+
+/********** Insert **********/
+
+#if __cplusplus >= 201103L
+// 葉 node の position に args から値を構築する. node が NULL なら根を作る.
+// 値の構築が例外を投げた場合は値を元の位置に戻す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class... Args>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__emplace_at(
+    node_type *node, size_type position, Args &&...args) {
+  __open_slot(node, position);
+  try {
+    std::allocator_traits<leaf_allocator>::construct(
+        leaf_allocator_, __as_slot(node->value(position)),
+        std::forward<Args>(args)...);
+  } catch (...) {
+    __close_slot(node, position);
+    throw;
+  }
+  ++node->count_;
+  ++size_;
+  return iterator(node, position);
+}
+#else
+// C++98 のアロケータの construct はノード型しか受け取らないので,
+// 値は配置 new で直接構築する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class Arg>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__emplace_at(
+    node_type *node, size_type position, const Arg &arg) {
+  __open_slot(node, position);
+  try {
+    ::new (static_cast<void *>(node->value(position))) slot_value_type(arg);
+  } catch (...) {
+    __close_slot(node, position);
+    throw;
+  }
+  ++node->count_;
+  ++size_;
+  return iterator(node, position);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+template <class Arg1, class Arg2>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__emplace_at(
+    node_type *node, size_type position, const Arg1 &arg1, const Arg2 &arg2) {
+  __open_slot(node, position);
+  try {
+    ::new (static_cast<void *>(node->value(position)))
+        slot_value_type(arg1, arg2);
+  } catch (...) {
+    __close_slot(node, position);
+    throw;
+  }
+  ++node->count_;
+  ++size_;
+  return iterator(node, position);
+}
+#endif
+
+// 葉 node の position を未構築の空きにする. count_ はまだ増やさない.
+// node が満杯なら先に分け, node と position を値が入る先に書き換える.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__open_slot(
+    node_type *&node, size_type &position) {
+  if (node == NULL) {
+    node = __allocate_node(true);
+    root_ = node;
+    leftmost_ = node;
+    rightmost_ = node;
+    position = 0;
+    return;
+  }
+  if (node->count_ == kNodeSlots) {
+    __split_node(node, position);
+  }
+  for (size_type i = node->count_; i > position; --i) {
+    __move_value(node->value(i), node->value(i - 1));
+  }
+}
+
+// __open_slot() で空けた position を詰め直す.
+// 空の木に作った根だけが空になるので, その場合は木を空に戻す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__close_slot(
+    node_type *node, size_type position) {
+  for (size_type i = position; i < node->count_; ++i) {
+    __move_value(node->value(i), node->value(i + 1));
+  }
+  if (node->count_ == 0) {
+    __deallocate_node(node);
+    root_ = NULL;
+    leftmost_ = NULL;
+    rightmost_ = NULL;
+  }
+}
+
+// 満杯の node を2つに分け, 後ろ側を新しい右の兄弟に移して, 間の値を親に上げる.
+// 親も満杯なら先に親を分ける. position は node に挿入しようとしている位置で,
+// 分けた後にその位置があるノードと位置に書き換える.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__split_node(
+    node_type *&node, size_type &position) {
+  if (node->parent_ == NULL) {
+    node_type *new_root = __allocate_node(false);
+    new_root->set_child(0, node);
+    root_ = new_root;
+  } else if (node->parent_->count_ == kNodeSlots) {
+    node_type *parent = node->parent_;
+    size_type parent_position = node->position_;
+    __split_node(parent, parent_position);
+  }
+  // 末尾への挿入が続く場合(ソート済みの入力)は左がほぼ満杯のまま残るように,
+  // 先頭への挿入が続く場合は右がほぼ満杯になるように偏らせて分ける.
+  // どちらの場合も両方に値を1つ以上残す.
+  size_type to_move;
+  if (position == kNodeSlots) {
+    to_move = 1;
+  } else if (position == 0) {
+    to_move = kNodeSlots - 2;
+  } else {
+    to_move = kNodeSlots / 2;
+  }
+  const size_type left_count = kNodeSlots - to_move - 1;
+
+  node_type *sibling = __allocate_node(node->leaf_);
+  for (size_type i = 0; i < to_move; ++i) {
+    __move_value(sibling->value(i), node->value(left_count + 1 + i));
+  }
+  if (!node->leaf_) {
+    for (size_type i = 0; i <= to_move; ++i) {
+      sibling->set_child(i, node->child(left_count + 1 + i));
+    }
+  }
+  sibling->count_ = static_cast<unsigned short>(to_move);
+  node->count_ = static_cast<unsigned short>(left_count);
+  __insert_into_parent(node->parent_, node->position_,
+                       node->value(left_count), sibling);
+  if (node == rightmost_) {
+    rightmost_ = sibling;
+  }
+  if (position > left_count) {
+    node = sibling;
+    position -= left_count + 1;
+  }
+}
+
+// 空きのある parent の position に separator をムーブし,
+// その右の子を right にする.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc,
+           NodeSize>::__insert_into_parent(node_type *parent,
+                                           size_type position,
+                                           value_type *separator,
+                                           node_type *right) {
+  for (size_type i = parent->count_; i > position; --i) {
+    __move_value(parent->value(i), parent->value(i - 1));
+    parent->set_child(i + 1, parent->child(i));
+  }
+  __move_value(parent->value(position), separator);
+  parent->set_child(position + 1, right);
+  ++parent->count_;
+}
+
+/********** Erase **********/
+
+// 内部ノードの値は左の部分木の最大の値(葉にある)と入れ替えて, 葉から取り除く.
+// 消した値の次の値の位置を返す.
+//
+// 次の値は葉 next の next_position 番目の位置として追いかける.
+// next_position が葉の末尾(count_)なら, 次の値はその葉の後ろの祖先の値.
+// 直す間に値がノードの間を移っても, 葉の中の位置で持っていれば,
+// 移し替えをする関数の中だけで直せる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::iterator
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__erase_at(
+    node_type *node, size_type position) {
+  node_type *next;
+  size_type next_position;
+  __destroy_value(node->value(position));
+  if (node->leaf_) {
+    for (size_type i = position + 1; i < node->count_; ++i) {
+      __move_value(node->value(i - 1), node->value(i));
+    }
+    next = node;
+    next_position = position;
+  } else {
+    // 次の値は右の部分木の最小の値
+    next = node->child(position + 1);
+    while (!next->leaf_) {
+      next = next->child(0);
+    }
+    next_position = 0;
+    node_type *leaf = node->child(position);
+    while (!leaf->leaf_) {
+      leaf = leaf->child(leaf->count_);
+    }
+    __move_value(node->value(position), leaf->value(leaf->count_ - 1));
+    node = leaf;
+  }
+  --node->count_;
+  --size_;
+  __rebalance(node, next, next_position);
+  if (root_ == NULL) {
+    return iterator(NULL, 0);
+  }
+  return __make_iterator(next, next_position);
+}
+
+// 値が減った node を兄弟と併合するか, 兄弟から値を借りて直す.
+// 併合すると親の値が1つ減るので, 親についても繰り返す.
+// 根が空になったら唯一の子を根にする. 葉の根が空になったら木が空になる.
+// 葉 next の next_position 番目の位置は, 値が移っても同じ値を指すように直す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__rebalance(
+    node_type *node, node_type *&next, size_type &next_position) {
+  while (node != root_ && node->count_ < kMinSlots) {
+    node_type *parent = node->parent_;
+    const size_type position = node->position_;
+    node_type *left = position > 0 ? parent->child(position - 1) : NULL;
+    node_type *right =
+        position < parent->count_ ? parent->child(position + 1) : NULL;
+    if (left && left->count_ + node->count_ < kNodeSlots) {
+      __merge_nodes(left, node, next, next_position);
+      node = parent;
+    } else if (right && node->count_ + right->count_ < kNodeSlots) {
+      __merge_nodes(node, right, next, next_position);
+      node = parent;
+    } else if (left && (right == NULL || left->count_ >= right->count_)) {
+      __rotate_right(left, node, (left->count_ - node->count_ + 1) / 2, next,
+                     next_position);
+      break;
+    } else {
+      __rotate_left(node, right, (right->count_ - node->count_ + 1) / 2, next,
+                    next_position);
+      break;
+    }
+  }
+  if (root_->count_ > 0) {
+    return;
+  }
+  node_type *old_root = root_;
+  if (old_root->leaf_) {
+    root_ = NULL;
+    leftmost_ = NULL;
+    rightmost_ = NULL;
+  } else {
+    root_ = old_root->child(0);
+    root_->parent_ = NULL;
+    root_->position_ = 0;
+  }
+  __deallocate_node(old_root);
+}
+
+// right を左隣の left に併合し, 間の値を親から下ろす.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__merge_nodes(
+    node_type *left, node_type *right, node_type *&next,
+    size_type &next_position) {
+  node_type *parent = left->parent_;
+  const size_type position = left->position_;
+  const size_type left_count = left->count_;
+  if (next == right) {
+    next = left;
+    next_position += left_count + 1;
+  }
+
+  __move_value(left->value(left_count), parent->value(position));
+  for (size_type i = 0; i < right->count_; ++i) {
+    __move_value(left->value(left_count + 1 + i), right->value(i));
+  }
+  if (!left->leaf_) {
+    for (size_type i = 0; i <= right->count_; ++i) {
+      left->set_child(left_count + 1 + i, right->child(i));
+    }
+  }
+  left->count_ = static_cast<unsigned short>(left_count + 1 + right->count_);
+
+  for (size_type i = position + 1; i < parent->count_; ++i) {
+    __move_value(parent->value(i - 1), parent->value(i));
+    parent->set_child(i, parent->child(i + 1));
+  }
+  --parent->count_;
+  if (right == rightmost_) {
+    rightmost_ = left;
+  }
+  __deallocate_node(right);
+}
+
+// 左隣の left から末尾の n 個を親を通して node の先頭に移す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__rotate_right(
+    node_type *left, node_type *node, size_type n, node_type *&next,
+    size_type &next_position) {
+  node_type *parent = node->parent_;
+  const size_type separator = node->position_ - 1;
+  const size_type left_count = left->count_;
+  if (next == node) {
+    next_position += n;
+  } else if (next == left && next_position > left_count - n) {
+    // 親に上がる値より後ろ(と親の値)は node の先頭に移る
+    next = node;
+    next_position -= left_count - n + 1;
+  }
+
+  for (size_type i = node->count_; i > 0; --i) {
+    __move_value(node->value(i - 1 + n), node->value(i - 1));
+  }
+  if (!node->leaf_) {
+    for (size_type i = node->count_ + 1; i > 0; --i) {
+      node->set_child(i - 1 + n, node->child(i - 1));
+    }
+  }
+  __move_value(node->value(n - 1), parent->value(separator));
+  for (size_type i = 0; i + 1 < n; ++i) {
+    __move_value(node->value(i), left->value(left_count - n + 1 + i));
+  }
+  __move_value(parent->value(separator), left->value(left_count - n));
+  if (!node->leaf_) {
+    for (size_type i = 0; i < n; ++i) {
+      node->set_child(i, left->child(left_count - n + 1 + i));
+    }
+  }
+  left->count_ = static_cast<unsigned short>(left_count - n);
+  node->count_ = static_cast<unsigned short>(node->count_ + n);
+}
+
+// 右隣の right から先頭の n 個を親を通して node の末尾に移す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__rotate_left(
+    node_type *node, node_type *right, size_type n, node_type *&next,
+    size_type &next_position) {
+  node_type *parent = node->parent_;
+  const size_type separator = node->position_;
+  const size_type node_count = node->count_;
+  if (next == right) {
+    if (next_position < n) {
+      // 親に上がる値とその前は node の末尾(とその後ろの親の値)に移る
+      next = node;
+      next_position += node_count + 1;
+    } else {
+      next_position -= n;
+    }
+  }
+
+  __move_value(node->value(node_count), parent->value(separator));
+  for (size_type i = 0; i + 1 < n; ++i) {
+    __move_value(node->value(node_count + 1 + i), right->value(i));
+  }
+  __move_value(parent->value(separator), right->value(n - 1));
+  if (!node->leaf_) {
+    for (size_type i = 0; i < n; ++i) {
+      node->set_child(node_count + 1 + i, right->child(i));
+    }
+  }
+  for (size_type i = n; i < right->count_; ++i) {
+    __move_value(right->value(i - n), right->value(i));
+  }
+  if (!right->leaf_) {
+    for (size_type i = n; i <= right->count_; ++i) {
+      right->set_child(i - n, right->child(i));
+    }
+  }
+  node->count_ = static_cast<unsigned short>(node_count + n);
+  right->count_ = static_cast<unsigned short>(right->count_ - n);
+}
+
+/********** Node operations **********/
+
+// ノードのヘッダだけを初期化する. 値と子は呼び出し側で設定する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::node_type *
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__allocate_node(
+    bool leaf) {
+  node_type *node;
+  if (leaf) {
+    node = leaf_allocator_.allocate(1);
+  } else {
+    node = internal_allocator_.allocate(1);
+  }
+  node->parent_ = NULL;
+  node->position_ = 0;
+  node->count_ = 0;
+  node->leaf_ = leaf;
+  return node;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__deallocate_node(
+    node_type *node) {
+  if (node->leaf_) {
+    leaf_allocator_.deallocate(node, 1);
+  } else {
+    internal_allocator_.deallocate(static_cast<internal_node_type *>(node), 1);
+  }
+}
+
+// 木の高さは log_B(n) なので再帰で辿る.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__delete_subtree(
+    node_type *node) {
+  if (!node->leaf_) {
+    for (size_type i = 0; i <= node->count_; ++i) {
+      __delete_subtree(node->child(i));
+    }
+  }
+  for (size_type i = 0; i < node->count_; ++i) {
+    __destroy_value(node->value(i));
+  }
+  __deallocate_node(node);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__copy_from(
+    const BTree &other) {
+  if (other.root_ == NULL) {
+    return;
+  }
+  root_ = __copy_subtree(other.root_);
+  size_ = other.size_;
+  leftmost_ = root_;
+  while (!leftmost_->leaf_) {
+    leftmost_ = leftmost_->child(0);
+  }
+  rightmost_ = root_;
+  while (!rightmost_->leaf_) {
+    rightmost_ = rightmost_->child(rightmost_->count_);
+  }
+}
+
+// src と同じ形の部分木を作る. 途中で例外が起きたら作った部分を解放する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+typename BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::node_type *
+BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__copy_subtree(
+    const node_type *src) {
+  node_type *node = __allocate_node(src->leaf_);
+  size_type copied_children = 0;
+  try {
+    for (; node->count_ < src->count_; ++node->count_) {
+      ::new (static_cast<void *>(node->value(node->count_)))
+          slot_value_type(*src->value(node->count_));
+    }
+    if (!src->leaf_) {
+      for (; copied_children <= src->count_; ++copied_children) {
+        node->set_child(copied_children,
+                        __copy_subtree(src->child(copied_children)));
+      }
+    }
+  } catch (...) {
+    for (size_type i = 0; i < copied_children; ++i) {
+      __delete_subtree(node->child(i));
+    }
+    for (size_type i = 0; i < node->count_; ++i) {
+      __destroy_value(node->value(i));
+    }
+    __deallocate_node(node);
+    throw;
+  }
+  return node;
+}
+
+// src の値を未構築の dst に移し, src を破棄する.
+// slot_value_type として移すので, pair のキーもムーブされる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__move_value(
+    value_type *dst, value_type *src) {
+  slot_value_type *from = __as_slot(src);
+#if __cplusplus >= 201103L
+  ::new (static_cast<void *>(dst)) slot_value_type(std::move(*from));
+#else
+  ::new (static_cast<void *>(dst)) slot_value_type(*from);
+#endif
+  from->~slot_value_type();
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          std::size_t NodeSize>
+void BTree<Key, Value, KeyOfValue, Compare, Alloc, NodeSize>::__destroy_value(
+    value_type *value) {
+  __as_slot(value)->~slot_value_type();
+}
+
+}  // namespace ft
+
+#endif
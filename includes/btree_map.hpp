@@ -0,0 +1,505 @@
+#ifndef BTREE_MAP_H_
+#define BTREE_MAP_H_
+
+#include <functional>
+#include <stdexcept>
+
+#include "btree.hpp"
+#include "map.hpp"
+#include "pair.hpp"
+
+namespace ft {
+
+// B 木で実装した map. 1つのノードに複数の要素を詰めるので, 探索と走査で
+// 触るキャッシュラインが ft::map より少ない.
+// NodeSize は1つの葉のおおよそのバイト数. 256 から 512 くらいが良い.
+//
+// ft::map と同じインターフェースを持つが, 要素を挿入, 削除すると全ての
+// イテレータ, 要素への参照が無効になる. また値のムーブ(C++98 ではコピー)は
+// 例外を投げないこと.
+template <class Key, class Val, class Compare = std::less<Key>,
+          class Allocator = std::allocator<ft::pair<const Key, Val> >,
+          std::size_t NodeSize = 256>
+class btree_map {
+ public:
+  typedef Key key_type;
+  typedef Val mapped_type;
+  typedef ft::pair<const Key, Val> value_type;
+  typedef Compare key_compare;
+  typedef Allocator allocator_type;
+
+ private:
+  typedef
+      typename Allocator::template rebind<value_type>::other pair_alloc_type;
+  typedef BTree<key_type, value_type, Select1st<value_type>, key_compare,
+                pair_alloc_type, NodeSize>
+      RepType;
+
+  RepType btree_;
+
+ public:
+  typedef typename pair_alloc_type::reference reference;
+  typedef typename pair_alloc_type::const_reference const_reference;
+  typedef typename pair_alloc_type::pointer pointer;
+  typedef typename pair_alloc_type::const_pointer const_pointer;
+  typedef typename RepType::size_type size_type;
+  typedef typename RepType::difference_type difference_type;
+  typedef typename RepType::iterator iterator;
+  typedef typename RepType::const_iterator const_iterator;
+  typedef typename RepType::reverse_iterator reverse_iterator;
+  typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+
+  class value_compare {
+    friend class btree_map<Key, Val, Compare, Allocator, NodeSize>;
+
+   public:
+    typedef value_type first_argument_type;
+    typedef value_type second_argument_type;
+    typedef bool result_type;
+
+    bool operator()(const value_type& lhs, const value_type& rhs) const {
+      return comp(lhs.first, rhs.first);
+    }
+
+   protected:
+    Compare comp;
+
+    value_compare(Compare c) : comp(c) {}
+  };
+
+  /********** Constructor and Assignation **********/
+  btree_map() : btree_() {}
+
+  explicit btree_map(const Compare& comp, const Allocator& alloc = Allocator())
+      : btree_(comp, alloc) {}
+
+  template <class InputIt>
+  btree_map(InputIt first, InputIt last, const Compare& comp = Compare(),
+            const Allocator& alloc = Allocator())
+      : btree_(first, last, comp, alloc) {}
+
+  btree_map(const btree_map& other) : btree_(other.btree_) {}
+
+  btree_map& operator=(const btree_map& other) {
+    if (this != &other) {
+      btree_ = other.btree_;
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  btree_map(btree_map&& other) noexcept : btree_(std::move(other.btree_)) {}
+
+  btree_map& operator=(btree_map&& other) noexcept {
+    btree_ = std::move(other.btree_);
+    return *this;
+  }
+#endif
+
+  /********** Destructor **********/
+  ~btree_map() {}
+
+  allocator_type get_allocator() const {
+    return allocator_type(btree_.get_allocator());
+  }
+
+  /********** Element access **********/
+  // キーが無い場合は mapped_type をノード内で直接値初期化する.
+  mapped_type& operator[](const key_type& key) {
+    return (*btree_.try_emplace_unique(key, __emplace_second_tag(), key).first)
+        .second;
+  }
+
+#if __cplusplus >= 201103L
+  mapped_type& operator[](key_type&& key) {
+    return (*btree_
+                 .try_emplace_unique(key, __emplace_second_tag(),
+                                     std::move(key))
+                 .first)
+        .second;
+  }
+#endif
+
+  mapped_type& at(const key_type& key) {
+    iterator it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("btree_map::at");
+    }
+    return (*it).second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    const_iterator it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("btree_map::at");
+    }
+    return (*it).second;
+  }
+
+  /********** Iterators **********/
+  iterator begin() {
+    return btree_.begin();
+  }
+
+  const_iterator begin() const {
+    return btree_.begin();
+  }
+
+  iterator end() {
+    return btree_.end();
+  }
+
+  const_iterator end() const {
+    return btree_.end();
+  }
+
+  reverse_iterator rbegin() {
+    return btree_.rbegin();
+  }
+
+  const_reverse_iterator rbegin() const {
+    return btree_.rbegin();
+  }
+
+  reverse_iterator rend() {
+    return btree_.rend();
+  }
+
+  const_reverse_iterator rend() const {
+    return btree_.rend();
+  }
+
+  /********** Capacity **********/
+
+  bool empty() const {
+    return btree_.empty();
+  }
+
+  size_type size() const {
+    return btree_.size();
+  }
+
+  size_type max_size() const {
+    return btree_.max_size();
+  }
+
+  /********** Modifiers **********/
+
+  void clear() {
+    btree_.clear();
+  }
+
+  ft::pair<iterator, bool> insert(const value_type& value) {
+    return btree_.insert_unique(value);
+  }
+
+  iterator insert(iterator hint, const value_type& value) {
+    return btree_.insert_unique(hint, value);
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    btree_.insert_range_unique(first, last);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    return btree_.insert_unique(std::move(value));
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return btree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    return btree_.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return btree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+
+  /* key が無い場合だけ, args から mapped_type をノード内に直接構築する.
+   * key が既にある場合は args に触れない. (ムーブされない)
+   */
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return btree_.try_emplace_unique(key, __emplace_second_tag(), key,
+                                     std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return btree_.try_emplace_unique(key, __emplace_second_tag(),
+                                     std::move(key),
+                                     std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, const key_type& key, Args&&... args) {
+    return btree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(), key,
+                                 std::forward<Args>(args)...)
+        .first;
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, key_type&& key, Args&&... args) {
+    return btree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(),
+                                 std::move(key), std::forward<Args>(args)...)
+        .first;
+  }
+
+  // key が既にある場合は値を代入し, 無い場合はノード内に直接構築する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        btree_.try_emplace_unique(key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res;
+  }
+
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        btree_.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        btree_.try_emplace_hint_unique(hint, key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res.first;
+  }
+#else
+  // C++98 では mapped_type は obj からコピーで構築する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key,
+                                            const M& obj) {
+    ft::pair<iterator, bool> res = btree_.try_emplace_unique(key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, const M& obj) {
+    ft::pair<iterator, bool> res =
+        btree_.try_emplace_hint_unique(hint, key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+    }
+    return res.first;
+  }
+#endif
+
+  void erase(iterator pos) {
+    btree_.erase(pos);
+  }
+
+  size_type erase(const key_type& key) {
+    return btree_.erase(key);
+  }
+
+  void erase(iterator first, iterator last) {
+    btree_.erase(first, last);
+  }
+
+  void swap(btree_map& other) {
+    btree_.swap(other.btree_);
+  }
+
+  /********** Lookup **********/
+
+  iterator find(const key_type& key) {
+    return btree_.find(key);
+  }
+
+  const_iterator find(const key_type& key) const {
+    return btree_.find(key);
+  }
+
+  size_type count(const key_type& key) const {
+    return btree_.count(key);
+  }
+
+  ft::pair<iterator, iterator> equal_range(const key_type& key) {
+    return btree_.equal_range(key);
+  }
+
+  ft::pair<const_iterator, const_iterator> equal_range(
+      const key_type& key) const {
+    return btree_.equal_range(key);
+  }
+
+  iterator lower_bound(const key_type& key) {
+    return btree_.lower_bound(key);
+  }
+
+  const_iterator lower_bound(const key_type& key) const {
+    return btree_.lower_bound(key);
+  }
+
+  iterator upper_bound(const key_type& key) {
+    return btree_.upper_bound(key);
+  }
+
+  const_iterator upper_bound(const key_type& key) const {
+    return btree_.upper_bound(key);
+  }
+
+  /* key_compare が is_transparent を持つ場合は, key_type と比較出来る任意の型で
+   * 探索する.
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return btree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) {
+    return btree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type find(
+      const K& key) const {
+    return btree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) {
+    return btree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      key_compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K& key) const {
+    return btree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) {
+    return btree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  lower_bound(const K& key) const {
+    return btree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) {
+    return btree_.upper_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  upper_bound(const K& key) const {
+    return btree_.upper_bound(key);
+  }
+
+  /********** Observers **********/
+
+  key_compare key_comp() const {
+    return btree_.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare(btree_.key_comp());
+  }
+
+  /********** Basic comparison operators **********/
+  template <typename K1, typename T1, typename C1, typename A,
+            std::size_t S>
+  friend bool operator==(const btree_map<K1, T1, C1, A, S>&,
+                         const btree_map<K1, T1, C1, A, S>&);
+
+  template <typename K1, typename T1, typename C1, typename A,
+            std::size_t S>
+  friend bool operator<(const btree_map<K1, T1, C1, A, S>&,
+                        const btree_map<K1, T1, C1, A, S>&);
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator==(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return lhs.btree_ == rhs.btree_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator<(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return lhs.btree_ < rhs.btree_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator!=(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator>(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator<=(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline bool operator>=(
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+    const btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+// specializes the std::swap algorithm
+namespace std {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          std::size_t NodeSize>
+inline void swap(ft::btree_map<Key, Value, Compare, Alloc, NodeSize>& lhs,
+                 ft::btree_map<Key, Value, Compare, Alloc, NodeSize>& rhs) {
+  lhs.swap(rhs);
+}
+}  // namespace std
+
+#endif
@@ -0,0 +1,291 @@
+#ifndef BTREE_SET_H_
+#define BTREE_SET_H_
+
+#include <functional>
+#include <memory>
+
+#include "btree.hpp"
+#include "pair.hpp"
+#include "set.hpp"
+
+namespace ft {
+
+// B 木で実装した set. btree_map と同様に, 要素を挿入, 削除すると全ての
+// イテレータが無効になる.
+template <class Key, class Compare = std::less<Key>,
+          class Allocator = std::allocator<Key>, std::size_t NodeSize = 256>
+class btree_set {
+ public:
+  typedef Key key_type;
+  typedef Key value_type;
+  typedef Compare key_compare;
+  typedef Compare value_compare;
+  typedef Allocator allocator_type;
+
+ private:
+  typedef typename Allocator::template rebind<value_type>::other key_alloc_type;
+  typedef BTree<key_type, value_type, Identity<value_type>, key_compare,
+                key_alloc_type, NodeSize>
+      RepType;
+
+  RepType btree_;
+
+ public:
+  typedef typename key_alloc_type::reference reference;
+  typedef typename key_alloc_type::const_reference const_reference;
+  typedef typename key_alloc_type::pointer pointer;
+  typedef typename key_alloc_type::const_pointer const_pointer;
+  typedef typename RepType::size_type size_type;
+  typedef typename RepType::difference_type difference_type;
+  typedef typename RepType::const_iterator iterator;
+  typedef typename RepType::const_iterator const_iterator;
+  typedef typename RepType::const_reverse_iterator reverse_iterator;
+  typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+
+  /********** Constructor, Assignation and Destructor **********/
+  btree_set() : btree_() {}
+
+  explicit btree_set(const Compare& comp, const Allocator& alloc = Allocator())
+      : btree_(comp, alloc) {}
+
+  template <class InputIt>
+  btree_set(InputIt first, InputIt last, const Compare& comp = Compare(),
+            const Allocator& alloc = Allocator())
+      : btree_(first, last, comp, alloc) {}
+
+  btree_set(const btree_set& other) : btree_(other.btree_) {}
+
+  btree_set& operator=(const btree_set& other) {
+    if (this != &other) {
+      btree_ = other.btree_;
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  btree_set(btree_set&& other) noexcept : btree_(std::move(other.btree_)) {}
+
+  btree_set& operator=(btree_set&& other) noexcept {
+    btree_ = std::move(other.btree_);
+    return *this;
+  }
+#endif
+
+  ~btree_set() {}
+
+  /********** Get allocator **********/
+  allocator_type get_allocator() const {
+    return allocator_type(btree_.get_allocator());
+  }
+
+  /********** Iterators **********/
+  iterator begin() const {
+    return btree_.begin();
+  }
+
+  iterator end() const {
+    return btree_.end();
+  }
+
+  reverse_iterator rbegin() const {
+    return btree_.rbegin();
+  }
+
+  reverse_iterator rend() const {
+    return btree_.rend();
+  }
+
+  /********** Capacity **********/
+  bool empty() const {
+    return btree_.empty();
+  }
+
+  size_type size() const {
+    return btree_.size();
+  }
+
+  size_type max_size() const {
+    return btree_.max_size();
+  }
+
+  /********** Modifiers **********/
+  void clear() {
+    btree_.clear();
+  }
+
+  ft::pair<iterator, bool> insert(const value_type& value) {
+    ft::pair<typename RepType::iterator, bool> res =
+        btree_.insert_unique(value);
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  iterator insert(iterator hint, const value_type& value) {
+    return btree_.insert_unique(hint, value);
+  }
+
+  template <class InputIt>
+  void insert(InputIt first, InputIt last) {
+    btree_.insert_range_unique(first, last);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    ft::pair<typename RepType::iterator, bool> res =
+        btree_.insert_unique(std::move(value));
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return btree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    ft::pair<typename RepType::iterator, bool> res =
+        btree_.emplace_unique(std::forward<Args>(args)...);
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return btree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+#endif
+
+  void erase(iterator pos) {
+    btree_.erase(pos);
+  }
+
+  void erase(iterator first, iterator last) {
+    btree_.erase(first, last);
+  }
+
+  size_type erase(const Key& key) {
+    return btree_.erase(key);
+  }
+
+  void swap(btree_set& other) {
+    btree_.swap(other.btree_);
+  }
+
+  /********** Lookup **********/
+  size_type count(const Key& key) const {
+    return btree_.count(key);
+  }
+
+  iterator find(const Key& key) const {
+    return btree_.find(key);
+  }
+
+  ft::pair<iterator, iterator> equal_range(const Key& key) const {
+    return btree_.equal_range(key);
+  }
+
+  iterator lower_bound(const Key& key) const {
+    return btree_.lower_bound(key);
+  }
+
+  iterator upper_bound(const Key& key) const {
+    return btree_.upper_bound(key);
+  }
+
+  /* key_compare が is_transparent を持つ場合は, Key と比較出来る任意の型で
+   * 探索する.
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return btree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) const {
+    return btree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) const {
+    return btree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) const {
+    return btree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) const {
+    return btree_.upper_bound(key);
+  }
+
+  /********** Observers **********/
+  key_compare key_comp() const {
+    return btree_.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare(btree_.key_comp());
+  }
+
+  /********** Basic comparison operators **********/
+  template <typename K1, typename C1, typename A, std::size_t S>
+  friend bool operator==(const btree_set<K1, C1, A, S>&,
+                         const btree_set<K1, C1, A, S>&);
+
+  template <typename K1, typename C1, typename A, std::size_t S>
+  friend bool operator<(const btree_set<K1, C1, A, S>&,
+                        const btree_set<K1, C1, A, S>&);
+};
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator==(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                       const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return lhs.btree_ == rhs.btree_;
+}
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator<(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                      const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return lhs.btree_ < rhs.btree_;
+}
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator!=(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                       const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator>(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                      const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator<=(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                       const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline bool operator>=(const btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                       const btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+namespace std {  // specializes the std::swap algorithm
+template <typename Key, typename Compare, typename Alloc, std::size_t NodeSize>
+inline void swap(ft::btree_set<Key, Compare, Alloc, NodeSize>& lhs,
+                 ft::btree_set<Key, Compare, Alloc, NodeSize>& rhs) {
+  lhs.swap(rhs);
+}
+}  // namespace std
+
+#endif
@@ -0,0 +1,546 @@
+#ifndef EYTZINGER_TREE_H_
+#define EYTZINGER_TREE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+
+#include "equal.hpp"
+#include "functional.hpp"
+#include "lexicographical_compare.hpp"
+#include "pair.hpp"
+#include "red_black_tree.hpp"
+#include "reverse_iterator.hpp"
+
+namespace ft {
+
+/* Eytzinger 配置(幅優先順)の添字の操作.
+ *
+ * 完全二分木を幅優先順に配列に並べ, 根を 1, k の子を 2k と 2k + 1 とする.
+ * 0 は end を表す. n は要素数.
+ */
+
+// 中間順で最初の添字. 根から左の子を辿る.
+inline std::size_t eytzinger_first_index(std::size_t n) {
+  if (n == 0) {
+    return 0;
+  }
+  std::size_t k = 1;
+  while (2 * k <= n) {
+    k = 2 * k;
+  }
+  return k;
+}
+
+// 中間順で最後の添字. 根から右の子を辿る.
+inline std::size_t eytzinger_last_index(std::size_t n) {
+  if (n == 0) {
+    return 0;
+  }
+  std::size_t k = 1;
+  while (2 * k + 1 <= n) {
+    k = 2 * k + 1;
+  }
+  return k;
+}
+
+// 中間順で k の次の添字. 最後の次は 0 になる.
+// 右の部分木が無ければ, 左の子である祖先まで登ってその親に行く.
+inline std::size_t eytzinger_next_index(std::size_t k, std::size_t n) {
+  if (2 * k + 1 <= n) {
+    k = 2 * k + 1;
+    while (2 * k <= n) {
+      k = 2 * k;
+    }
+    return k;
+  }
+  while (k & 1) {
+    k >>= 1;
+  }
+  return k >> 1;
+}
+
+// 中間順で k の前の添字. 0(end)の前は最後の添字になる.
+inline std::size_t eytzinger_prev_index(std::size_t k, std::size_t n) {
+  if (k == 0) {
+    return eytzinger_last_index(n);
+  }
+  if (2 * k <= n) {
+    k = 2 * k;
+    while (2 * k + 1 <= n) {
+      k = 2 * k + 1;
+    }
+    return k;
+  }
+  while (k != 0 && !(k & 1)) {
+    k >>= 1;
+  }
+  return k >> 1;
+}
+
+// EytzingerTree の要素を中間順に辿るイテレータ. 要素は書き換えられない.
+template <class Value>
+struct eytzinger_iterator {
+  typedef std::bidirectional_iterator_tag iterator_category;
+  typedef Value value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef const Value *pointer;
+  typedef const Value &reference;
+
+  typedef eytzinger_iterator<Value> self_type;
+
+  // values_[k - 1] が添字 k の要素
+  const Value *values_;
+  std::size_t size_;
+  std::size_t index_;
+
+  eytzinger_iterator() : values_(), size_(0), index_(0) {}
+
+  eytzinger_iterator(const Value *values, std::size_t size, std::size_t index)
+      : values_(values), size_(size), index_(index) {}
+
+  eytzinger_iterator(const self_type &other)
+      : values_(other.values_), size_(other.size_), index_(other.index_) {}
+
+  self_type &operator=(const self_type &other) {
+    values_ = other.values_;
+    size_ = other.size_;
+    index_ = other.index_;
+    return *this;
+  }
+
+  reference operator*() const {
+    return values_[index_ - 1];
+  }
+
+  pointer operator->() const {
+    return values_ + (index_ - 1);
+  }
+
+  self_type &operator++() {
+    index_ = eytzinger_next_index(index_, size_);
+    return *this;
+  }
+
+  self_type operator++(int) {
+    self_type tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  self_type &operator--() {
+    index_ = eytzinger_prev_index(index_, size_);
+    return *this;
+  }
+
+  self_type operator--(int) {
+    self_type tmp = *this;
+    --*this;
+    return tmp;
+  }
+
+  friend bool operator==(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ != rhs.index_;
+  }
+};
+
+// 整列済みの要素を Eytzinger 配置で1つの配列に並べた, 変更できない探索木.
+// ft::map, ft::set の freeze() が返す.
+//
+// 探索で辿る添字は k, 2k, 4k, ... と決まっているので, ポインタを読まずに
+// 孫の位置を計算して先読みでき, 比較の結果で 2k か 2k + 1 を選ぶだけなので
+// 分岐も無い. 木の上の方は全ての探索で共有されるのでキャッシュに残る.
+//
+// テンプレートパラメータは RedBlackTree と同じ.
+template <class Key, class Value, class KeyOfValue,
+          class Compare = std::less<Key>, class Alloc = std::allocator<Value> >
+class EytzingerTree {
+ public:
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef const value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef const value_type &reference;
+  typedef const value_type &const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef Alloc allocator_type;
+
+  typedef eytzinger_iterator<value_type> iterator;
+  typedef eytzinger_iterator<value_type> const_iterator;
+  typedef ft::reverse_iterator<const_iterator> reverse_iterator;
+  typedef ft::reverse_iterator<const_iterator> const_reverse_iterator;
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  typedef typename Alloc::template rebind<value_type>::other value_allocator;
+
+  // Members
+  // values_[k - 1] が添字 k の要素. 空の場合は NULL.
+  value_type *values_;
+  size_type size_;
+  Compare key_comp_;
+  value_allocator allocator_;
+
+ public:
+  EytzingerTree()
+      : values_(NULL), size_(0), key_comp_(Compare()), allocator_() {}
+
+  /* first から始まる n 個の, キーの順に並んだ重複の無い値から作る.
+   * 値を中間順に読みながら, 中間順の次の添字に置いていくので O(n).
+   * 値のコピーが例外を投げた場合は, コピーした値を破棄して投げ直す.
+   */
+  template <class InputIt>
+  EytzingerTree(InputIt first, size_type n, const Compare &comp = Compare(),
+                const Alloc &alloc = Alloc())
+      : values_(NULL), size_(0), key_comp_(comp), allocator_(alloc) {
+    __build(first, n);
+  }
+
+  EytzingerTree(const EytzingerTree &other)
+      : values_(NULL),
+        size_(0),
+        key_comp_(other.key_comp_),
+        allocator_(other.allocator_) {
+    __copy_from(other);
+  }
+
+  EytzingerTree &operator=(const EytzingerTree &rhs) {
+    if (&rhs != this) {
+      EytzingerTree tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  EytzingerTree(EytzingerTree &&other) noexcept
+      : values_(NULL),
+        size_(0),
+        key_comp_(other.key_comp_),
+        allocator_(other.allocator_) {
+    swap(other);
+  }
+
+  EytzingerTree &operator=(EytzingerTree &&rhs) noexcept {
+    if (&rhs != this) {
+      __destroy();
+      swap(rhs);
+    }
+    return *this;
+  }
+#endif
+
+  ~EytzingerTree() {
+    __destroy();
+  }
+
+  allocator_type get_allocator() const {
+    return allocator_type(allocator_);
+  }
+
+  /********** Iterators **********/
+
+  const_iterator begin() const {
+    return const_iterator(values_, size_, eytzinger_first_index(size_));
+  }
+
+  const_iterator end() const {
+    return const_iterator(values_, size_, 0);
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  /********** Capacity **********/
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+
+  size_type max_size() const {
+    return allocator_.max_size();
+  }
+
+  /********** Modifiers **********/
+
+  void swap(EytzingerTree &other) {
+    std::swap(values_, other.values_);
+    std::swap(size_, other.size_);
+    std::swap(key_comp_, other.key_comp_);
+    std::swap(allocator_, other.allocator_);
+  }
+
+  /********** Lookup **********/
+
+  const_iterator find(const key_type &key) const {
+    return __make_iterator(__find_index(key));
+  }
+
+  size_type count(const key_type &key) const {
+    return __find_index(key) != 0;
+  }
+
+  const_iterator lower_bound(const key_type &key) const {
+    return __make_iterator(__lower_bound_index(key));
+  }
+
+  const_iterator upper_bound(const key_type &key) const {
+    return __make_iterator(__upper_bound_index(key));
+  }
+
+  ft::pair<const_iterator, const_iterator> equal_range(
+      const key_type &key) const {
+    return __equal_range(key);
+  }
+
+  /* Compare が is_transparent を持つ場合は, key_type と比較出来る任意の型で
+   * 探索する.
+   */
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type find(
+      const K &key) const {
+    return __make_iterator(__find_index(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, size_type>::type count(
+      const K &key) const {
+    return __find_index(key) != 0;
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type
+  lower_bound(const K &key) const {
+    return __make_iterator(__lower_bound_index(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type
+  upper_bound(const K &key) const {
+    return __make_iterator(__upper_bound_index(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      Compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K &key) const {
+    return __equal_range(key);
+  }
+
+  /********** Observers **********/
+
+  Compare key_comp() const {
+    return key_comp_;
+  }
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  /* 分岐の無い探索. 比較の結果を足して 2k か 2k + 1 に進み, 葉の外に出るまで
+   * 降りる. 答えは最後に左(2k)へ進んだ位置なので, k の末尾に続く 1 のビット
+   * (右へ進んだ回数)と, その前の 0 のビットを取り除けば求まる.
+   * 全て右へ進んだ場合は 0(end)になる.
+   *
+   * 孫の4つの添字 4k から 4k + 3 は連続しているので, 2段先を先読みしておく.
+   * 配列の外は指さないように末尾で止める.
+   */
+  template <class K>
+  size_type __lower_bound_index(const K &key) const {
+    size_type k = 1;
+    while (k <= size_) {
+      FT_PREFETCH(values_ + std::min(4 * k - 1, size_));
+      k = 2 * k + key_comp_(__key_at(k), key);
+    }
+    return k >> (__trailing_ones(k) + 1);
+  }
+
+  template <class K>
+  size_type __upper_bound_index(const K &key) const {
+    size_type k = 1;
+    while (k <= size_) {
+      FT_PREFETCH(values_ + std::min(4 * k - 1, size_));
+      k = 2 * k + !key_comp_(key, __key_at(k));
+    }
+    return k >> (__trailing_ones(k) + 1);
+  }
+
+  // key の要素の添字. 無ければ 0.
+  template <class K>
+  size_type __find_index(const K &key) const {
+    const size_type k = __lower_bound_index(key);
+    return k != 0 && !key_comp_(key, __key_at(k)) ? k : 0;
+  }
+
+  template <class K>
+  ft::pair<const_iterator, const_iterator> __equal_range(const K &key) const {
+    const size_type first = __lower_bound_index(key);
+    if (first != 0 && !key_comp_(key, __key_at(first))) {
+      return ft::pair<const_iterator, const_iterator>(
+          __make_iterator(first),
+          __make_iterator(eytzinger_next_index(first, size_)));
+    }
+    return ft::pair<const_iterator, const_iterator>(__make_iterator(first),
+                                                    __make_iterator(first));
+  }
+
+  static size_type __trailing_ones(size_type k) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(~static_cast<unsigned long long>(k));
+#else
+    size_type count = 0;
+    for (; k & 1; k >>= 1) {
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  const key_type &__key_at(size_type k) const {
+    return KeyOfValue()(values_[k - 1]);
+  }
+
+  const_iterator __make_iterator(size_type k) const {
+    return const_iterator(values_, size_, k);
+  }
+
+  template <class InputIt>
+  void __build(InputIt first, size_type n);
+  void __copy_from(const EytzingerTree &other);
+  void __destroy();
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+template <class InputIt>
+void EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc>::__build(
+    InputIt first, size_type n) {
+  if (n == 0) {
+    return;
+  }
+  values_ = allocator_.allocate(n);
+  size_type k = eytzinger_first_index(n);
+  size_type built = 0;
+  try {
+    for (; built < n; ++built, ++first) {
+      allocator_.construct(values_ + (k - 1), *first);
+      k = eytzinger_next_index(k, n);
+    }
+  } catch (...) {
+    // 置いた順に辿り直して破棄する.
+    k = eytzinger_first_index(n);
+    for (size_type i = 0; i < built; ++i) {
+      allocator_.destroy(values_ + (k - 1));
+      k = eytzinger_next_index(k, n);
+    }
+    allocator_.deallocate(values_, n);
+    values_ = NULL;
+    throw;
+  }
+  size_ = n;
+}
+
+// 配置は同じなので, 配列の先頭から順にコピーする.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc>::__copy_from(
+    const EytzingerTree &other) {
+  if (other.size_ == 0) {
+    return;
+  }
+  values_ = allocator_.allocate(other.size_);
+  size_type i = 0;
+  try {
+    for (; i < other.size_; ++i) {
+      allocator_.construct(values_ + i, other.values_[i]);
+    }
+  } catch (...) {
+    while (i > 0) {
+      allocator_.destroy(values_ + --i);
+    }
+    allocator_.deallocate(values_, other.size_);
+    values_ = NULL;
+    throw;
+  }
+  size_ = other.size_;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+void EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc>::__destroy() {
+  if (values_ == NULL) {
+    return;
+  }
+  for (size_type i = 0; i < size_; ++i) {
+    allocator_.destroy(values_ + i);
+  }
+  allocator_.deallocate(values_, size_);
+  values_ = NULL;
+  size_ = 0;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator==(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  return lhs.size() == rhs.size() &&
+         ft::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator<(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  typedef typename EytzingerTree<Key, Value, KeyOfValue, Compare,
+                                 Alloc>::const_iterator const_iterator;
+  return ft::lexicographical_compare<const_iterator, const_iterator>(
+      lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator!=(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  return !(lhs == rhs);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator>(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  return rhs < lhs;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator<=(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  return !(rhs < lhs);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+inline bool operator>=(
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
+    const EytzingerTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+#endif
@@ -0,0 +1,537 @@
+#ifndef FLAT_MAP_H_
+#define FLAT_MAP_H_
+
+#include <functional>
+#include <stdexcept>
+
+#include "flat_tree.hpp"
+#include "map.hpp"
+#include "pair.hpp"
+
+namespace ft {
+
+// flat_map の要素の並べ方を決めるポリシー.
+// キーと値の組を1つの配列に並べる. 要素を丸ごと読む走査に向く.
+struct flat_map_pair_storage_policy {
+  template <class Key, class Val, class Allocator>
+  struct storage {
+    typedef ft::pair<Key, Val> value_type;
+    typedef flat_vector_storage<
+        value_type, Select1st<value_type>,
+        typename Allocator::template rebind<value_type>::other>
+        type;
+  };
+};
+
+// キーと値を別々の配列に並べる. 探索はキーの配列だけを読むので, 値が
+// 大きい時に速い. 要素の参照は flat_split_reference になり, 値を
+// 書き換えるには (*it).second か it->second を使う.
+struct flat_map_split_storage_policy {
+  template <class Key, class Val, class Allocator>
+  struct storage {
+    typedef flat_split_storage<Key, Val, Allocator> type;
+  };
+};
+
+// 整列した配列で実装した map. 探索は分岐の無い二分探索で, 走査は配列を
+// 先頭から読むだけなので ft::map より速い. 挿入, 削除は O(n) なので,
+// 多くの要素は範囲の insert でまとめて入れる.
+//
+// ft::map と同じインターフェースを持つが, 次の点が異なる.
+// - value_type は ft::pair<Key, Val> で, キーを書き換えてはいけない.
+// - 要素を挿入, 削除すると全てのイテレータ, 要素への参照が無効になる.
+template <class Key, class Val, class Compare = std::less<Key>,
+          class Allocator = std::allocator<ft::pair<Key, Val> >,
+          class StoragePolicy = flat_map_pair_storage_policy>
+class flat_map {
+ public:
+  typedef Key key_type;
+  typedef Val mapped_type;
+  typedef ft::pair<Key, Val> value_type;
+  typedef Compare key_compare;
+  typedef Allocator allocator_type;
+
+ private:
+  typedef typename StoragePolicy::template storage<Key, Val, Allocator>::type
+      storage_type;
+  typedef FlatTree<key_type, value_type, Select1st<value_type>, key_compare,
+                   storage_type>
+      RepType;
+
+  RepType tree_;
+
+ public:
+  typedef typename RepType::reference reference;
+  typedef typename RepType::const_reference const_reference;
+  typedef typename RepType::pointer pointer;
+  typedef typename RepType::const_pointer const_pointer;
+  typedef typename RepType::size_type size_type;
+  typedef typename RepType::difference_type difference_type;
+  typedef typename RepType::iterator iterator;
+  typedef typename RepType::const_iterator const_iterator;
+  typedef typename RepType::reverse_iterator reverse_iterator;
+  typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+
+  class value_compare {
+    friend class flat_map<Key, Val, Compare, Allocator, StoragePolicy>;
+
+   public:
+    typedef value_type first_argument_type;
+    typedef value_type second_argument_type;
+    typedef bool result_type;
+
+    bool operator()(const value_type& lhs, const value_type& rhs) const {
+      return comp(lhs.first, rhs.first);
+    }
+
+   protected:
+    Compare comp;
+
+    value_compare(Compare c) : comp(c) {}
+  };
+
+  /********** Constructor and Assignation **********/
+  flat_map() : tree_() {}
+
+  explicit flat_map(const Compare& comp, const Allocator& alloc = Allocator())
+      : tree_(comp, alloc) {}
+
+  template <class InputIt>
+  flat_map(InputIt first, InputIt last, const Compare& comp = Compare(),
+           const Allocator& alloc = Allocator())
+      : tree_(first, last, comp, alloc) {}
+
+  flat_map(const flat_map& other) : tree_(other.tree_) {}
+
+  flat_map& operator=(const flat_map& other) {
+    if (this != &other) {
+      tree_ = other.tree_;
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  flat_map(flat_map&& other) noexcept : tree_(std::move(other.tree_)) {}
+
+  flat_map& operator=(flat_map&& other) noexcept {
+    tree_ = std::move(other.tree_);
+    return *this;
+  }
+#endif
+
+  /********** Destructor **********/
+  ~flat_map() {}
+
+  allocator_type get_allocator() const {
+    return allocator_type(tree_.get_allocator());
+  }
+
+  /********** Element access **********/
+  // キーが無い場合は mapped_type を値初期化して挿入する.
+  mapped_type& operator[](const key_type& key) {
+    return (*tree_.try_emplace_unique(key, __emplace_second_tag(), key).first)
+        .second;
+  }
+
+#if __cplusplus >= 201103L
+  mapped_type& operator[](key_type&& key) {
+    return (*tree_
+                 .try_emplace_unique(key, __emplace_second_tag(),
+                                     std::move(key))
+                 .first)
+        .second;
+  }
+#endif
+
+  mapped_type& at(const key_type& key) {
+    iterator it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("flat_map::at");
+    }
+    return (*it).second;
+  }
+
+  const mapped_type& at(const key_type& key) const {
+    const_iterator it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("flat_map::at");
+    }
+    return (*it).second;
+  }
+
+  /********** Iterators **********/
+  iterator begin() {
+    return tree_.begin();
+  }
+
+  const_iterator begin() const {
+    return tree_.begin();
+  }
+
+  iterator end() {
+    return tree_.end();
+  }
+
+  const_iterator end() const {
+    return tree_.end();
+  }
+
+  reverse_iterator rbegin() {
+    return tree_.rbegin();
+  }
+
+  const_reverse_iterator rbegin() const {
+    return tree_.rbegin();
+  }
+
+  reverse_iterator rend() {
+    return tree_.rend();
+  }
+
+  const_reverse_iterator rend() const {
+    return tree_.rend();
+  }
+
+  /********** Capacity **********/
+
+  bool empty() const {
+    return tree_.empty();
+  }
+
+  size_type size() const {
+    return tree_.size();
+  }
+
+  size_type max_size() const {
+    return tree_.max_size();
+  }
+
+  size_type capacity() const {
+    return tree_.capacity();
+  }
+
+  // 配列の領域を確保しておく. 挿入で再確保が起きなくなる.
+  void reserve(size_type n) {
+    tree_.reserve(n);
+  }
+
+  /********** Modifiers **********/
+
+  void clear() {
+    tree_.clear();
+  }
+
+  ft::pair<iterator, bool> insert(const value_type& value) {
+    return tree_.insert_unique(value);
+  }
+
+  iterator insert(iterator hint, const value_type& value) {
+    return tree_.insert_unique(hint, value);
+  }
+
+  // 末尾に追加してからまとめて整列するので, 1つずつ挿入するより速い.
+  // 整列済みで既存の要素より後ろに並ぶ範囲なら O(n) で済む.
+  template <typename InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    tree_.insert_range_unique(first, last);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    return tree_.insert_unique(std::move(value));
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return tree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    return tree_.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+
+  /* key が無い場合だけ, args から mapped_type を構築して挿入する.
+   * key が既にある場合は args に触れない. (ムーブされない)
+   */
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return tree_.try_emplace_unique(key, __emplace_second_tag(), key,
+                                    std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return tree_.try_emplace_unique(key, __emplace_second_tag(),
+                                    std::move(key),
+                                    std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, const key_type& key, Args&&... args) {
+    return tree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(), key,
+                                 std::forward<Args>(args)...)
+        .first;
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, key_type&& key, Args&&... args) {
+    return tree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(),
+                                 std::move(key), std::forward<Args>(args)...)
+        .first;
+  }
+
+  // key が既にある場合は値を代入し, 無い場合は挿入する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        tree_.try_emplace_unique(key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res;
+  }
+
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        tree_.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        tree_.try_emplace_hint_unique(hint, key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+    }
+    return res.first;
+  }
+#else
+  // C++98 では mapped_type は obj からコピーで構築する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key,
+                                            const M& obj) {
+    ft::pair<iterator, bool> res = tree_.try_emplace_unique(key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, const M& obj) {
+    ft::pair<iterator, bool> res =
+        tree_.try_emplace_hint_unique(hint, key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+    }
+    return res.first;
+  }
+#endif
+
+  void erase(iterator pos) {
+    tree_.erase(pos);
+  }
+
+  size_type erase(const key_type& key) {
+    return tree_.erase(key);
+  }
+
+  void erase(iterator first, iterator last) {
+    tree_.erase(first, last);
+  }
+
+  void swap(flat_map& other) {
+    tree_.swap(other.tree_);
+  }
+
+  /********** Lookup **********/
+
+  iterator find(const key_type& key) {
+    return tree_.find(key);
+  }
+
+  const_iterator find(const key_type& key) const {
+    return tree_.find(key);
+  }
+
+  size_type count(const key_type& key) const {
+    return tree_.count(key);
+  }
+
+  ft::pair<iterator, iterator> equal_range(const key_type& key) {
+    return tree_.equal_range(key);
+  }
+
+  ft::pair<const_iterator, const_iterator> equal_range(
+      const key_type& key) const {
+    return tree_.equal_range(key);
+  }
+
+  iterator lower_bound(const key_type& key) {
+    return tree_.lower_bound(key);
+  }
+
+  const_iterator lower_bound(const key_type& key) const {
+    return tree_.lower_bound(key);
+  }
+
+  iterator upper_bound(const key_type& key) {
+    return tree_.upper_bound(key);
+  }
+
+  const_iterator upper_bound(const key_type& key) const {
+    return tree_.upper_bound(key);
+  }
+
+  /* key_compare が is_transparent を持つ場合は, key_type と比較出来る任意の型で
+   * 探索する.
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return tree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) {
+    return tree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type find(
+      const K& key) const {
+    return tree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) {
+    return tree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      key_compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K& key) const {
+    return tree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) {
+    return tree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  lower_bound(const K& key) const {
+    return tree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) {
+    return tree_.upper_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  upper_bound(const K& key) const {
+    return tree_.upper_bound(key);
+  }
+
+  /********** Observers **********/
+
+  key_compare key_comp() const {
+    return tree_.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare(tree_.key_comp());
+  }
+
+  /********** Basic comparison operators **********/
+  template <typename K1, typename T1, typename C1, typename A, class S>
+  friend bool operator==(const flat_map<K1, T1, C1, A, S>&,
+                         const flat_map<K1, T1, C1, A, S>&);
+
+  template <typename K1, typename T1, typename C1, typename A, class S>
+  friend bool operator<(const flat_map<K1, T1, C1, A, S>&,
+                        const flat_map<K1, T1, C1, A, S>&);
+};
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator==(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return lhs.tree_ == rhs.tree_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator<(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return lhs.tree_ < rhs.tree_;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator!=(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator>(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator<=(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline bool operator>=(
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+    const flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+// specializes the std::swap algorithm
+namespace std {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          class StoragePolicy>
+inline void swap(ft::flat_map<Key, Value, Compare, Alloc, StoragePolicy>& lhs,
+                 ft::flat_map<Key, Value, Compare, Alloc, StoragePolicy>& rhs) {
+  lhs.swap(rhs);
+}
+}  // namespace std
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef FLAT_SET_H_
+#define FLAT_SET_H_
+
+#include <functional>
+#include <memory>
+
+#include "flat_tree.hpp"
+#include "pair.hpp"
+#include "set.hpp"
+
+namespace ft {
+
+// 整列した配列で実装した set. flat_map と同様に, 挿入, 削除は O(n) で,
+// 要素を挿入, 削除すると全てのイテレータが無効になる.
+template <class Key, class Compare = std::less<Key>,
+          class Allocator = std::allocator<Key> >
+class flat_set {
+ public:
+  typedef Key key_type;
+  typedef Key value_type;
+  typedef Compare key_compare;
+  typedef Compare value_compare;
+  typedef Allocator allocator_type;
+
+ private:
+  typedef typename Allocator::template rebind<value_type>::other key_alloc_type;
+  typedef FlatTree<key_type, value_type, Identity<value_type>, key_compare,
+                   flat_vector_storage<value_type, Identity<value_type>,
+                                       key_alloc_type> >
+      RepType;
+
+  RepType tree_;
+
+ public:
+  typedef typename key_alloc_type::reference reference;
+  typedef typename key_alloc_type::const_reference const_reference;
+  typedef typename key_alloc_type::pointer pointer;
+  typedef typename key_alloc_type::const_pointer const_pointer;
+  typedef typename RepType::size_type size_type;
+  typedef typename RepType::difference_type difference_type;
+  typedef typename RepType::const_iterator iterator;
+  typedef typename RepType::const_iterator const_iterator;
+  typedef typename RepType::const_reverse_iterator reverse_iterator;
+  typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+
+  /********** Constructor, Assignation and Destructor **********/
+  flat_set() : tree_() {}
+
+  explicit flat_set(const Compare& comp, const Allocator& alloc = Allocator())
+      : tree_(comp, alloc) {}
+
+  template <class InputIt>
+  flat_set(InputIt first, InputIt last, const Compare& comp = Compare(),
+           const Allocator& alloc = Allocator())
+      : tree_(first, last, comp, alloc) {}
+
+  flat_set(const flat_set& other) : tree_(other.tree_) {}
+
+  flat_set& operator=(const flat_set& other) {
+    if (this != &other) {
+      tree_ = other.tree_;
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  flat_set(flat_set&& other) noexcept : tree_(std::move(other.tree_)) {}
+
+  flat_set& operator=(flat_set&& other) noexcept {
+    tree_ = std::move(other.tree_);
+    return *this;
+  }
+#endif
+
+  ~flat_set() {}
+
+  /********** Get allocator **********/
+  allocator_type get_allocator() const {
+    return allocator_type(tree_.get_allocator());
+  }
+
+  /********** Iterators **********/
+  iterator begin() const {
+    return tree_.begin();
+  }
+
+  iterator end() const {
+    return tree_.end();
+  }
+
+  reverse_iterator rbegin() const {
+    return tree_.rbegin();
+  }
+
+  reverse_iterator rend() const {
+    return tree_.rend();
+  }
+
+  /********** Capacity **********/
+  bool empty() const {
+    return tree_.empty();
+  }
+
+  size_type size() const {
+    return tree_.size();
+  }
+
+  size_type max_size() const {
+    return tree_.max_size();
+  }
+
+  size_type capacity() const {
+    return tree_.capacity();
+  }
+
+  void reserve(size_type n) {
+    tree_.reserve(n);
+  }
+
+  /********** Modifiers **********/
+  void clear() {
+    tree_.clear();
+  }
+
+  ft::pair<iterator, bool> insert(const value_type& value) {
+    ft::pair<typename RepType::iterator, bool> res =
+        tree_.insert_unique(value);
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  iterator insert(iterator hint, const value_type& value) {
+    return tree_.insert_unique(hint, value);
+  }
+
+  // 末尾に追加してからまとめて整列する.
+  template <class InputIt>
+  void insert(InputIt first, InputIt last) {
+    tree_.insert_range_unique(first, last);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    ft::pair<typename RepType::iterator, bool> res =
+        tree_.insert_unique(std::move(value));
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return tree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    ft::pair<typename RepType::iterator, bool> res =
+        tree_.emplace_unique(std::forward<Args>(args)...);
+    return ft::pair<iterator, bool>(res.first, res.second);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return tree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+#endif
+
+  void erase(iterator pos) {
+    tree_.erase(pos);
+  }
+
+  void erase(iterator first, iterator last) {
+    tree_.erase(first, last);
+  }
+
+  size_type erase(const Key& key) {
+    return tree_.erase(key);
+  }
+
+  void swap(flat_set& other) {
+    tree_.swap(other.tree_);
+  }
+
+  /********** Lookup **********/
+  size_type count(const Key& key) const {
+    return tree_.count(key);
+  }
+
+  iterator find(const Key& key) const {
+    return tree_.find(key);
+  }
+
+  ft::pair<iterator, iterator> equal_range(const Key& key) const {
+    return tree_.equal_range(key);
+  }
+
+  iterator lower_bound(const Key& key) const {
+    return tree_.lower_bound(key);
+  }
+
+  iterator upper_bound(const Key& key) const {
+    return tree_.upper_bound(key);
+  }
+
+  /* key_compare が is_transparent を持つ場合は, Key と比較出来る任意の型で
+   * 探索する.
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return tree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) const {
+    return tree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) const {
+    return tree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) const {
+    return tree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) const {
+    return tree_.upper_bound(key);
+  }
+
+  /********** Observers **********/
+  key_compare key_comp() const {
+    return tree_.key_comp();
+  }
+
+  value_compare value_comp() const {
+    return value_compare(tree_.key_comp());
+  }
+
+  /********** Basic comparison operators **********/
+  template <typename K1, typename C1, typename A>
+  friend bool operator==(const flat_set<K1, C1, A>&,
+                         const flat_set<K1, C1, A>&);
+
+  template <typename K1, typename C1, typename A>
+  friend bool operator<(const flat_set<K1, C1, A>&,
+                        const flat_set<K1, C1, A>&);
+};
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator==(const flat_set<Key, Compare, Alloc>& lhs,
+                       const flat_set<Key, Compare, Alloc>& rhs) {
+  return lhs.tree_ == rhs.tree_;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<(const flat_set<Key, Compare, Alloc>& lhs,
+                      const flat_set<Key, Compare, Alloc>& rhs) {
+  return lhs.tree_ < rhs.tree_;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator!=(const flat_set<Key, Compare, Alloc>& lhs,
+                       const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>(const flat_set<Key, Compare, Alloc>& lhs,
+                      const flat_set<Key, Compare, Alloc>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator<=(const flat_set<Key, Compare, Alloc>& lhs,
+                       const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename Key, typename Compare, typename Alloc>
+inline bool operator>=(const flat_set<Key, Compare, Alloc>& lhs,
+                       const flat_set<Key, Compare, Alloc>& rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+namespace std {  // specializes the std::swap algorithm
+template <typename Key, typename Compare, typename Alloc>
+inline void swap(ft::flat_set<Key, Compare, Alloc>& lhs,
+                 ft::flat_set<Key, Compare, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+}  // namespace std
+
+#endif
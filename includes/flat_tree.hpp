@@ -0,0 +1,1181 @@
+#ifndef FLAT_TREE_H_
+#define FLAT_TREE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+
+#include "equal.hpp"
+#include "functional.hpp"
+#include "iterator_traits.hpp"
+#include "lexicographical_compare.hpp"
+#include "pair.hpp"
+#include "reverse_iterator.hpp"
+#include "type_traits.hpp"
+#include "uninitialized.hpp"
+#include "vector.hpp"
+
+namespace ft {
+
+/* 整列した配列で実装する flat_map, flat_set の要素の置き場所.
+ *
+ * FlatTree は要素を添字で扱い, 置き場所には次の操作を求める.
+ *   key(i)         i 番目の要素のキー
+ *   operator[](i)  i 番目の要素への reference
+ *   address(i)     i 番目の要素を指す pointer (イテレータの -> で使う)
+ *   insert(i, v)   v を i 番目に挿入する. C++11 では emplace(i, args...) も
+ *   erase(i, j)    [i, j) 番目の要素を削除する
+ *   push_back(v), reserve(n), capacity(), clear(), swap(other)
+ *   merge_unique(n, comp)
+ *                  整列済みの [0, n) と, その後ろに追加した要素を併合する.
+ *                  キーが同じ要素は先にあった方だけを残す.
+ *                  comp が例外を投げた場合も [0, n) は元のまま残す.
+ */
+
+// 整列済みの [0, sorted_size) に, 追加した要素を整列した順に並べた添字 added を
+// 併合する位置を決める. 残す追加した要素の添字を kept に, それぞれを既存の
+// 要素の何番目の前に入れるかを positions に順に入れる. キーが同じ要素は
+// 先にあった方だけを残す. 比較するだけで要素は動かさないので,
+// comp が例外を投げても storage は変わらない.
+template <class Storage, class IndexVector, class Compare>
+void __flat_merge_positions(const Storage &storage, std::size_t sorted_size,
+                            const IndexVector &added, const Compare &comp,
+                            IndexVector &kept, IndexVector &positions) {
+  kept.reserve(added.size());
+  positions.reserve(added.size());
+  std::size_t i = 0;
+  for (std::size_t j = 0; j < added.size(); ++j) {
+    const typename Storage::key_type &key = storage.key(added[j]);
+    while (i < sorted_size && comp(storage.key(i), key)) {
+      ++i;
+    }
+    // 既存の要素か, 直前に残した追加した要素と同じキーなら捨てる.
+    if ((i < sorted_size && !comp(key, storage.key(i))) ||
+        (!kept.empty() && !comp(storage.key(kept.back()), key))) {
+      continue;
+    }
+    kept.push_back(added[j]);
+    positions.push_back(i);
+  }
+}
+
+// 要素を1つの ft::vector に並べる. flat_set と flat_map の既定の置き場所.
+template <class Value, class KeyOfValue, class Alloc>
+class flat_vector_storage {
+ public:
+  typedef typename KeyOfValue::result_type key_type;
+  typedef Value value_type;
+  typedef value_type &reference;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef std::size_t size_type;
+  typedef Alloc allocator_type;
+
+ private:
+  typedef ft::vector<value_type, allocator_type> container_type;
+  typedef typename Alloc::template rebind<size_type>::other index_allocator;
+  typedef ft::vector<size_type, index_allocator> index_vector;
+
+  // std::stable_sort などに渡す, 要素をキーで比べる関数オブジェクト.
+  template <class Compare>
+  struct __value_compare {
+    Compare comp;
+
+    explicit __value_compare(const Compare &c) : comp(c) {}
+
+    bool operator()(const value_type &lhs, const value_type &rhs) const {
+      return comp(KeyOfValue()(lhs), KeyOfValue()(rhs));
+    }
+  };
+
+  // 整列済みの範囲で lhs が rhs より前にある時に, 同じキーかどうか.
+  template <class Compare>
+  struct __value_equivalent {
+    Compare comp;
+
+    explicit __value_equivalent(const Compare &c) : comp(c) {}
+
+    bool operator()(const value_type &lhs, const value_type &rhs) const {
+      return !comp(KeyOfValue()(lhs), KeyOfValue()(rhs));
+    }
+  };
+
+  container_type values_;
+
+ public:
+  explicit flat_vector_storage(const allocator_type &alloc = allocator_type())
+      : values_(alloc) {}
+
+  allocator_type get_allocator() const {
+    return values_.get_allocator();
+  }
+
+  size_type size() const {
+    return values_.size();
+  }
+
+  size_type max_size() const {
+    return values_.max_size();
+  }
+
+  size_type capacity() const {
+    return values_.capacity();
+  }
+
+  void reserve(size_type n) {
+    values_.reserve(n);
+  }
+
+  const key_type &key(size_type i) const {
+    return KeyOfValue()(values_[i]);
+  }
+
+  reference operator[](size_type i) {
+    return values_[i];
+  }
+
+  const_reference operator[](size_type i) const {
+    return values_[i];
+  }
+
+  pointer address(size_type i) {
+    return &values_[i];
+  }
+
+  const_pointer address(size_type i) const {
+    return &values_[i];
+  }
+
+  void insert(size_type i, const value_type &value) {
+    values_.insert(values_.begin() + i, value);
+  }
+
+  void push_back(const value_type &value) {
+    values_.push_back(value);
+  }
+
+#if __cplusplus >= 201103L
+  void insert(size_type i, value_type &&value) {
+    values_.insert(values_.begin() + i, std::move(value));
+  }
+
+  template <class... Args>
+  void emplace(size_type i, Args &&...args) {
+    values_.emplace(values_.begin() + i, std::forward<Args>(args)...);
+  }
+
+  void push_back(value_type &&value) {
+    values_.push_back(std::move(value));
+  }
+#endif
+
+  void erase(size_type first, size_type last) {
+    values_.erase(values_.begin() + first, values_.begin() + last);
+  }
+
+  void clear() {
+    values_.clear();
+  }
+
+  void swap(flat_vector_storage &other) {
+    values_.swap(other.values_);
+  }
+
+  // 追加した範囲だけをその場で安定に整列し, 各要素を入れる位置を先に
+  // 全て決めてから, 後ろから既存の要素をずらしながら入れる. 比較は要素を
+  // 動かす前に済ませるので, 比較が例外を投げても既存の要素は変わらない.
+  // 既存の要素が無ければその場で重複を取り除く.
+  // 要素のムーブ (C++98 ではコピー) が例外を投げると要素が失われ得る.
+  template <class Compare>
+  void merge_unique(size_type sorted_size, const Compare &comp) {
+    const size_type n = values_.size();
+    std::stable_sort(values_.begin() + sorted_size, values_.end(),
+                     __value_compare<Compare>(comp));
+    if (sorted_size == 0) {
+      values_.erase(std::unique(values_.begin(), values_.end(),
+                                __value_equivalent<Compare>(comp)),
+                    values_.end());
+      return;
+    }
+    const index_allocator index_alloc(values_.get_allocator());
+    index_vector added(index_alloc);
+    added.reserve(n - sorted_size);
+    for (size_type i = sorted_size; i < n; ++i) {
+      added.push_back(i);
+    }
+    index_vector kept(index_alloc);
+    index_vector positions(index_alloc);
+    __flat_merge_positions(*this, sorted_size, added, comp, kept, positions);
+
+    // 追加した範囲は上書きするので, 残す要素を別の配列に移しておく.
+    container_type kept_values(values_.get_allocator());
+    kept_values.reserve(kept.size());
+    for (size_type i = 0; i < kept.size(); ++i) {
+#if __cplusplus >= 201103L
+      kept_values.push_back(std::move(values_[kept[i]]));
+#else
+      kept_values.push_back(values_[kept[i]]);
+#endif
+    }
+    values_.erase(values_.begin() + sorted_size + kept.size(), values_.end());
+
+    value_type *first = &values_[0];
+    value_type *d_last = first + values_.size();
+    size_type last = sorted_size;
+    for (size_type i = kept.size(); i-- > 0;) {
+      d_last = __move_backward_within(first + positions[i], first + last,
+                                      d_last);
+#if __cplusplus >= 201103L
+      *--d_last = std::move(kept_values[i]);
+#else
+      *--d_last = kept_values[i];
+#endif
+      last = positions[i];
+    }
+  }
+};
+
+// flat_split_storage の要素への参照. キーと値をそれぞれ参照で持つ.
+// T が const の場合は const_reference になる.
+template <class Key, class T>
+struct flat_split_reference {
+  typedef Key first_type;
+  typedef T second_type;
+
+  const Key &first;
+  T &second;
+
+  flat_split_reference(const Key &key, T &mapped)
+      : first(key), second(mapped) {}
+
+  // reference から const_reference への変換
+  template <class U>
+  flat_split_reference(const flat_split_reference<Key, U> &other)
+      : first(other.first), second(other.second) {}
+
+  // 要素のコピーを作る.
+  operator ft::pair<Key, typename remove_const<T>::type>() const {
+    return ft::pair<Key, typename remove_const<T>::type>(first, second);
+  }
+};
+
+template <class Key, class T>
+bool operator==(const flat_split_reference<Key, T> &lhs,
+                const flat_split_reference<Key, T> &rhs) {
+  return lhs.first == rhs.first && lhs.second == rhs.second;
+}
+
+template <class Key, class T>
+bool operator<(const flat_split_reference<Key, T> &lhs,
+               const flat_split_reference<Key, T> &rhs) {
+  if (lhs.first < rhs.first) {
+    return true;
+  }
+  if (rhs.first < lhs.first) {
+    return false;
+  }
+  return lhs.second < rhs.second;
+}
+
+// 実体の無い参照に -> を使えるように, 参照を値で持って指す.
+template <class Reference>
+class flat_arrow_proxy {
+ public:
+  explicit flat_arrow_proxy(const Reference &ref) : ref_(ref) {}
+
+  Reference *operator->() {
+    return &ref_;
+  }
+
+ private:
+  Reference ref_;
+};
+
+// キーと値を別々の ft::vector に並べる. 二分探索はキーの配列だけを読むので,
+// 値が大きくても1つのキャッシュラインに多くのキーが載る.
+// 要素の参照は flat_split_reference になる.
+template <class Key, class T, class Alloc>
+class flat_split_storage {
+ public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef ft::pair<Key, T> value_type;
+  typedef flat_split_reference<Key, T> reference;
+  typedef flat_split_reference<Key, const T> const_reference;
+  typedef flat_arrow_proxy<reference> pointer;
+  typedef flat_arrow_proxy<const_reference> const_pointer;
+  typedef std::size_t size_type;
+  typedef Alloc allocator_type;
+
+ private:
+  typedef typename Alloc::template rebind<Key>::other key_allocator;
+  typedef typename Alloc::template rebind<T>::other mapped_allocator;
+  typedef typename Alloc::template rebind<size_type>::other index_allocator;
+
+  // 添字の配列を std::stable_sort で整列する時に, 添字の指すキーで比べる.
+  template <class Compare>
+  struct __index_compare {
+    const ft::vector<Key, key_allocator> *keys;
+    Compare comp;
+
+    __index_compare(const ft::vector<Key, key_allocator> &k, const Compare &c)
+        : keys(&k), comp(c) {}
+
+    bool operator()(size_type lhs, size_type rhs) const {
+      return comp((*keys)[lhs], (*keys)[rhs]);
+    }
+  };
+
+  // 2つの配列の長さは常に同じにしておく.
+  ft::vector<Key, key_allocator> keys_;
+  ft::vector<T, mapped_allocator> mapped_;
+
+ public:
+  explicit flat_split_storage(const allocator_type &alloc = allocator_type())
+      : keys_(key_allocator(alloc)), mapped_(mapped_allocator(alloc)) {}
+
+  flat_split_storage(const flat_split_storage &other)
+      : keys_(other.keys_), mapped_(other.mapped_) {}
+
+  // 片方の配列のコピーだけが失敗しないように, コピーしてから入れ替える.
+  flat_split_storage &operator=(const flat_split_storage &rhs) {
+    if (this != &rhs) {
+      flat_split_storage tmp(rhs);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  flat_split_storage(flat_split_storage &&other) noexcept
+      : keys_(std::move(other.keys_)), mapped_(std::move(other.mapped_)) {}
+
+  flat_split_storage &operator=(flat_split_storage &&rhs) noexcept {
+    keys_ = std::move(rhs.keys_);
+    mapped_ = std::move(rhs.mapped_);
+    return *this;
+  }
+#endif
+
+  allocator_type get_allocator() const {
+    return allocator_type(keys_.get_allocator());
+  }
+
+  size_type size() const {
+    return keys_.size();
+  }
+
+  size_type max_size() const {
+    return std::min(keys_.max_size(), mapped_.max_size());
+  }
+
+  size_type capacity() const {
+    return keys_.capacity();
+  }
+
+  void reserve(size_type n) {
+    keys_.reserve(n);
+    mapped_.reserve(n);
+  }
+
+  const key_type &key(size_type i) const {
+    return keys_[i];
+  }
+
+  reference operator[](size_type i) {
+    return reference(keys_[i], mapped_[i]);
+  }
+
+  const_reference operator[](size_type i) const {
+    return const_reference(keys_[i], mapped_[i]);
+  }
+
+  pointer address(size_type i) {
+    return pointer((*this)[i]);
+  }
+
+  const_pointer address(size_type i) const {
+    return const_pointer((*this)[i]);
+  }
+
+  // 値の挿入が例外を投げた場合は, 先に挿入したキーを取り除く.
+  void insert(size_type i, const value_type &value) {
+    keys_.insert(keys_.begin() + i, value.first);
+    try {
+      mapped_.insert(mapped_.begin() + i, value.second);
+    } catch (...) {
+      keys_.erase(keys_.begin() + i);
+      throw;
+    }
+  }
+
+  void push_back(const value_type &value) {
+    keys_.push_back(value.first);
+    try {
+      mapped_.push_back(value.second);
+    } catch (...) {
+      keys_.pop_back();
+      throw;
+    }
+  }
+
+#if __cplusplus >= 201103L
+  void insert(size_type i, value_type &&value) {
+    keys_.insert(keys_.begin() + i, std::move(value.first));
+    try {
+      mapped_.insert(mapped_.begin() + i, std::move(value.second));
+    } catch (...) {
+      keys_.erase(keys_.begin() + i);
+      throw;
+    }
+  }
+
+  // キーと値を別々に構築する手段が無いので, 一度組を作ってからムーブする.
+  template <class... Args>
+  void emplace(size_type i, Args &&...args) {
+    insert(i, value_type(std::forward<Args>(args)...));
+  }
+
+  void push_back(value_type &&value) {
+    keys_.push_back(std::move(value.first));
+    try {
+      mapped_.push_back(std::move(value.second));
+    } catch (...) {
+      keys_.pop_back();
+      throw;
+    }
+  }
+#endif
+
+  void erase(size_type first, size_type last) {
+    keys_.erase(keys_.begin() + first, keys_.begin() + last);
+    mapped_.erase(mapped_.begin() + first, mapped_.begin() + last);
+  }
+
+  void clear() {
+    keys_.clear();
+    mapped_.clear();
+  }
+
+  void swap(flat_split_storage &other) {
+    keys_.swap(other.keys_);
+    mapped_.swap(other.mapped_);
+  }
+
+  // 2つの配列を揃えて並べ替えることは出来ないので, 追加した要素の添字を
+  // 整列し, 各要素を入れる位置を先に全て決めてから新しい配列に移す.
+  // 比較は要素を移す前に済ませるので, 比較が例外を投げても要素は変わらない.
+  // C++11 では要素をムーブするので, ムーブが例外を投げると要素が失われ得る.
+  template <class Compare>
+  void merge_unique(size_type sorted_size, const Compare &comp) {
+    const size_type n = keys_.size();
+    const index_allocator index_alloc(keys_.get_allocator());
+    ft::vector<size_type, index_allocator> added(index_alloc);
+    added.reserve(n - sorted_size);
+    for (size_type i = sorted_size; i < n; ++i) {
+      added.push_back(i);
+    }
+    std::stable_sort(added.begin(), added.end(),
+                     __index_compare<Compare>(keys_, comp));
+    ft::vector<size_type, index_allocator> kept(index_alloc);
+    ft::vector<size_type, index_allocator> positions(index_alloc);
+    __flat_merge_positions(*this, sorted_size, added, comp, kept, positions);
+
+    flat_split_storage merged(get_allocator());
+    merged.reserve(sorted_size + kept.size());
+    size_type i = 0;
+    for (size_type j = 0; j <= kept.size(); ++j) {
+      const size_type until = j < kept.size() ? positions[j] : sorted_size;
+      for (; i < until; ++i) {
+        merged.__push_back_from(*this, i);
+      }
+      if (j < kept.size()) {
+        merged.__push_back_from(*this, kept[j]);
+      }
+    }
+    swap(merged);
+  }
+
+ private:
+  // other の i 番目の要素を末尾に移す.
+  void __push_back_from(flat_split_storage &other, size_type i) {
+#if __cplusplus >= 201103L
+    keys_.push_back(std::move(other.keys_[i]));
+    mapped_.push_back(std::move(other.mapped_[i]));
+#else
+    keys_.push_back(other.keys_[i]);
+    mapped_.push_back(other.mapped_[i]);
+#endif
+  }
+};
+
+// 添字で要素を指すランダムアクセスイテレータ.
+template <class Storage>
+struct flat_iterator {
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef typename Storage::value_type value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef typename Storage::pointer pointer;
+  typedef typename Storage::reference reference;
+
+  typedef flat_iterator<Storage> self_type;
+
+  Storage *storage_;
+  std::size_t index_;
+
+  flat_iterator() : storage_(), index_(0) {}
+
+  flat_iterator(Storage *storage, std::size_t index)
+      : storage_(storage), index_(index) {}
+
+  flat_iterator(const self_type &other)
+      : storage_(other.storage_), index_(other.index_) {}
+
+  self_type &operator=(const self_type &other) {
+    storage_ = other.storage_;
+    index_ = other.index_;
+    return *this;
+  }
+
+  reference operator*() const {
+    return (*storage_)[index_];
+  }
+
+  pointer operator->() const {
+    return storage_->address(index_);
+  }
+
+  reference operator[](difference_type n) const {
+    return (*storage_)[index_ + n];
+  }
+
+  self_type &operator++() {
+    ++index_;
+    return *this;
+  }
+
+  self_type operator++(int) {
+    self_type tmp = *this;
+    ++index_;
+    return tmp;
+  }
+
+  self_type &operator--() {
+    --index_;
+    return *this;
+  }
+
+  self_type operator--(int) {
+    self_type tmp = *this;
+    --index_;
+    return tmp;
+  }
+
+  self_type &operator+=(difference_type n) {
+    index_ += n;
+    return *this;
+  }
+
+  self_type &operator-=(difference_type n) {
+    index_ -= n;
+    return *this;
+  }
+
+  friend self_type operator+(self_type it, difference_type n) {
+    return it += n;
+  }
+
+  friend self_type operator+(difference_type n, self_type it) {
+    return it += n;
+  }
+
+  friend self_type operator-(self_type it, difference_type n) {
+    return it -= n;
+  }
+
+  friend difference_type operator-(const self_type &lhs,
+                                   const self_type &rhs) {
+    return static_cast<difference_type>(lhs.index_ - rhs.index_);
+  }
+
+  friend bool operator==(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ != rhs.index_;
+  }
+
+  friend bool operator<(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ < rhs.index_;
+  }
+
+  friend bool operator>(const self_type &lhs, const self_type &rhs) {
+    return rhs.index_ < lhs.index_;
+  }
+
+  friend bool operator<=(const self_type &lhs, const self_type &rhs) {
+    return !(rhs.index_ < lhs.index_);
+  }
+
+  friend bool operator>=(const self_type &lhs, const self_type &rhs) {
+    return !(lhs.index_ < rhs.index_);
+  }
+};
+
+template <class Storage>
+struct flat_const_iterator {
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef typename Storage::value_type value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef typename Storage::const_pointer pointer;
+  typedef typename Storage::const_reference reference;
+
+  typedef flat_const_iterator<Storage> self_type;
+  typedef flat_iterator<Storage> iterator;
+
+  const Storage *storage_;
+  std::size_t index_;
+
+  flat_const_iterator() : storage_(), index_(0) {}
+
+  flat_const_iterator(const Storage *storage, std::size_t index)
+      : storage_(storage), index_(index) {}
+
+  flat_const_iterator(const self_type &other)
+      : storage_(other.storage_), index_(other.index_) {}
+
+  flat_const_iterator(const iterator &it)
+      : storage_(it.storage_), index_(it.index_) {}
+
+  self_type &operator=(const self_type &other) {
+    storage_ = other.storage_;
+    index_ = other.index_;
+    return *this;
+  }
+
+  iterator cast_nonconst() const {
+    return iterator(const_cast<Storage *>(storage_), index_);
+  }
+
+  reference operator*() const {
+    return (*storage_)[index_];
+  }
+
+  pointer operator->() const {
+    return storage_->address(index_);
+  }
+
+  reference operator[](difference_type n) const {
+    return (*storage_)[index_ + n];
+  }
+
+  self_type &operator++() {
+    ++index_;
+    return *this;
+  }
+
+  self_type operator++(int) {
+    self_type tmp = *this;
+    ++index_;
+    return tmp;
+  }
+
+  self_type &operator--() {
+    --index_;
+    return *this;
+  }
+
+  self_type operator--(int) {
+    self_type tmp = *this;
+    --index_;
+    return tmp;
+  }
+
+  self_type &operator+=(difference_type n) {
+    index_ += n;
+    return *this;
+  }
+
+  self_type &operator-=(difference_type n) {
+    index_ -= n;
+    return *this;
+  }
+
+  friend self_type operator+(self_type it, difference_type n) {
+    return it += n;
+  }
+
+  friend self_type operator+(difference_type n, self_type it) {
+    return it += n;
+  }
+
+  friend self_type operator-(self_type it, difference_type n) {
+    return it -= n;
+  }
+
+  friend difference_type operator-(const self_type &lhs,
+                                   const self_type &rhs) {
+    return static_cast<difference_type>(lhs.index_ - rhs.index_);
+  }
+
+  friend bool operator==(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ == rhs.index_;
+  }
+
+  friend bool operator!=(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ != rhs.index_;
+  }
+
+  friend bool operator<(const self_type &lhs, const self_type &rhs) {
+    return lhs.index_ < rhs.index_;
+  }
+
+  friend bool operator>(const self_type &lhs, const self_type &rhs) {
+    return rhs.index_ < lhs.index_;
+  }
+
+  friend bool operator<=(const self_type &lhs, const self_type &rhs) {
+    return !(rhs.index_ < lhs.index_);
+  }
+
+  friend bool operator>=(const self_type &lhs, const self_type &rhs) {
+    return !(lhs.index_ < rhs.index_);
+  }
+};
+
+// 要素をキーの順に配列に並べ, 二分探索で探す連想コンテナ.
+// テンプレートパラメータは RedBlackTree と同じで, Storage は要素の置き場所.
+//
+// 探索と走査は連続した領域だけを読むので木より速いが, 挿入と削除は
+// 後ろの要素をずらすので O(n) かかる. 多くの要素はまとめて
+// insert_range_unique で入れると O(n log n) で済む.
+// 挿入, 削除, swap をすると全てのイテレータが無効になる.
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Storage>
+class FlatTree {
+ public:
+  typedef Storage storage_type;
+  typedef Key key_type;
+  typedef Value value_type;
+  typedef typename Storage::pointer pointer;
+  typedef typename Storage::const_pointer const_pointer;
+  typedef typename Storage::reference reference;
+  typedef typename Storage::const_reference const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef typename Storage::allocator_type allocator_type;
+
+  typedef flat_iterator<Storage> iterator;
+  typedef flat_const_iterator<Storage> const_iterator;
+  typedef ft::reverse_iterator<iterator> reverse_iterator;
+  typedef ft::reverse_iterator<const_iterator> const_reverse_iterator;
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  // Members
+  Storage storage_;
+  Compare key_comp_;
+
+ public:
+  // Constructor
+  // コピー, ムーブ, 代入は Storage のものをそのまま使う.
+
+  FlatTree() : storage_(), key_comp_(Compare()) {}
+
+  explicit FlatTree(const Compare &comp,
+                    const allocator_type &alloc = allocator_type())
+      : storage_(alloc), key_comp_(comp) {}
+
+  template <class InputIt>
+  FlatTree(InputIt first, InputIt last, const Compare &comp = Compare(),
+           const allocator_type &alloc = allocator_type())
+      : storage_(alloc), key_comp_(comp) {
+    insert_range_unique(first, last);
+  }
+
+  /********** Insert **********/
+
+  ft::pair<iterator, bool> insert_unique(const value_type &value) {
+    size_type position;
+    if (__find_insert_position(KeyOfValue()(value), position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.insert(position, value);
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+
+  iterator insert_unique(const_iterator hint, const value_type &value) {
+    size_type position;
+    if (!__find_insert_position(hint, KeyOfValue()(value), position)) {
+      storage_.insert(position, value);
+    }
+    return __make_iterator(position);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert_unique(value_type &&value) {
+    size_type position;
+    if (__find_insert_position(KeyOfValue()(value), position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.insert(position, std::move(value));
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+
+  iterator insert_unique(const_iterator hint, value_type &&value) {
+    size_type position;
+    if (!__find_insert_position(hint, KeyOfValue()(value), position)) {
+      storage_.insert(position, std::move(value));
+    }
+    return __make_iterator(position);
+  }
+
+  // キーは構築した値からしか取り出せないので, 一時オブジェクトを作ってから
+  // 挿入位置を探し, 配列にはムーブする.
+  template <class... Args>
+  ft::pair<iterator, bool> emplace_unique(Args &&...args) {
+    return insert_unique(value_type(std::forward<Args>(args)...));
+  }
+
+  template <class... Args>
+  iterator emplace_hint_unique(const_iterator hint, Args &&...args) {
+    return insert_unique(hint, value_type(std::forward<Args>(args)...));
+  }
+
+  // key で挿入位置を一度だけ探し, 無い場合だけ args から値を構築する.
+  // flat_map の try_emplace, insert_or_assign, operator[] で使う.
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              Args &&...args) {
+    size_type position;
+    if (__find_insert_position(key, position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.emplace(position, std::forward<Args>(args)...);
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   Args &&...args) {
+    size_type position;
+    if (__find_insert_position(hint, key, position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.emplace(position, std::forward<Args>(args)...);
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+#else
+  // C++98 では可変長引数が使えないので, 値の構築に渡す引数は2つに限る.
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              const Arg1 &arg1,
+                                              const Arg2 &arg2) {
+    size_type position;
+    if (__find_insert_position(key, position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.insert(position, value_type(arg1, arg2));
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   const Arg1 &arg1,
+                                                   const Arg2 &arg2) {
+    size_type position;
+    if (__find_insert_position(hint, key, position)) {
+      return ft::pair<iterator, bool>(__make_iterator(position), false);
+    }
+    storage_.insert(position, value_type(arg1, arg2));
+    return ft::pair<iterator, bool>(__make_iterator(position), true);
+  }
+#endif
+
+  // 全て末尾に追加してから, まとめて整列して併合する. O((n + m) log m)
+  // 追加した範囲が整列済みで既存の要素より後ろなら整列しないので O(m).
+  // 追加や比較の途中で例外が起きた場合は, 追加した要素を取り除いて元に戻す.
+  template <class InputIt>
+  void insert_range_unique(InputIt first, InputIt last) {
+    const size_type sorted_size = storage_.size();
+    try {
+      for (; first != last; ++first) {
+        storage_.push_back(*first);
+      }
+      if (!__is_strictly_sorted(sorted_size == 0 ? 0 : sorted_size - 1)) {
+        storage_.merge_unique(sorted_size, key_comp_);
+      }
+    } catch (...) {
+      storage_.erase(sorted_size, storage_.size());
+      throw;
+    }
+  }
+
+  allocator_type get_allocator() const {
+    return storage_.get_allocator();
+  }
+
+  /********** Iterators **********/
+
+  iterator begin() {
+    return iterator(&storage_, 0);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(&storage_, 0);
+  }
+
+  iterator end() {
+    return iterator(&storage_, storage_.size());
+  }
+
+  const_iterator end() const {
+    return const_iterator(&storage_, storage_.size());
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  /********** Capacity **********/
+
+  bool empty() const {
+    return storage_.size() == 0;
+  }
+
+  size_type size() const {
+    return storage_.size();
+  }
+
+  size_type max_size() const {
+    return storage_.max_size();
+  }
+
+  size_type capacity() const {
+    return storage_.capacity();
+  }
+
+  void reserve(size_type n) {
+    storage_.reserve(n);
+  }
+
+  /********** Modifiers **********/
+
+  void clear() {
+    storage_.clear();
+  }
+
+  void swap(FlatTree &other) {
+    storage_.swap(other.storage_);
+    std::swap(key_comp_, other.key_comp_);
+  }
+
+  iterator erase(const_iterator pos) {
+    storage_.erase(pos.index_, pos.index_ + 1);
+    return __make_iterator(pos.index_);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    storage_.erase(first.index_, last.index_);
+    return __make_iterator(first.index_);
+  }
+
+  size_type erase(const key_type &key) {
+    const size_type position = __find_index(key);
+    if (position == storage_.size()) {
+      return 0;
+    }
+    storage_.erase(position, position + 1);
+    return 1;
+  }
+
+  /********** Lookup **********/
+
+  template <class K>
+  iterator find(const K &key) {
+    return __make_iterator(__find_index(key));
+  }
+
+  template <class K>
+  const_iterator find(const K &key) const {
+    return const_iterator(&storage_, __find_index(key));
+  }
+
+  template <class K>
+  size_type count(const K &key) const {
+    return __find_index(key) != storage_.size();
+  }
+
+  template <class K>
+  iterator lower_bound(const K &key) {
+    return __make_iterator(__lower_bound_index(key));
+  }
+
+  template <class K>
+  const_iterator lower_bound(const K &key) const {
+    return const_iterator(&storage_, __lower_bound_index(key));
+  }
+
+  template <class K>
+  iterator upper_bound(const K &key) {
+    return __make_iterator(__upper_bound_index(key));
+  }
+
+  template <class K>
+  const_iterator upper_bound(const K &key) const {
+    return const_iterator(&storage_, __upper_bound_index(key));
+  }
+
+  template <class K>
+  ft::pair<iterator, iterator> equal_range(const K &key) {
+    const size_type first = __lower_bound_index(key);
+    const size_type last = first + __matches_at(first, key);
+    return ft::pair<iterator, iterator>(__make_iterator(first),
+                                        __make_iterator(last));
+  }
+
+  template <class K>
+  ft::pair<const_iterator, const_iterator> equal_range(const K &key) const {
+    const size_type first = __lower_bound_index(key);
+    const size_type last = first + __matches_at(first, key);
+    return ft::pair<const_iterator, const_iterator>(
+        const_iterator(&storage_, first), const_iterator(&storage_, last));
+  }
+
+  /********** Observers **********/
+
+  Compare key_comp() const {
+    return key_comp_;
+  }
+
+#ifdef DEBUG
+ public:
+#else
+ private:
+#endif
+  // 分岐の無い二分探索. 比較の結果で範囲の先頭を進めるかどうかを選ぶだけ
+  // なので条件付き移動になり, 分岐予測の失敗が起きない.
+  // 範囲の長さは結果に依らず半分ずつになる.
+  template <class K>
+  size_type __lower_bound_index(const K &key) const {
+    size_type n = storage_.size();
+    if (n == 0) {
+      return 0;
+    }
+    size_type first = 0;
+    while (n > 1) {
+      const size_type half = n / 2;
+      first = key_comp_(storage_.key(first + half), key) ? first + half : first;
+      n -= half;
+    }
+    return first + key_comp_(storage_.key(first), key);
+  }
+
+  template <class K>
+  size_type __upper_bound_index(const K &key) const {
+    size_type n = storage_.size();
+    if (n == 0) {
+      return 0;
+    }
+    size_type first = 0;
+    while (n > 1) {
+      const size_type half = n / 2;
+      first = key_comp_(key, storage_.key(first + half)) ? first : first + half;
+      n -= half;
+    }
+    return first + !key_comp_(key, storage_.key(first));
+  }
+
+  // position の要素のキーが key と同じなら 1, 違うか末尾なら 0.
+  template <class K>
+  size_type __matches_at(size_type position, const K &key) const {
+    return position != storage_.size() &&
+           !key_comp_(key, storage_.key(position));
+  }
+
+  // key の要素の位置. 無ければ size().
+  template <class K>
+  size_type __find_index(const K &key) const {
+    const size_type position = __lower_bound_index(key);
+    return __matches_at(position, key) ? position : storage_.size();
+  }
+
+  // key を挿入する位置を position に入れる. 既にある場合は true を返す.
+  bool __find_insert_position(const key_type &key, size_type &position) const {
+    position = __lower_bound_index(key);
+    return __matches_at(position, key);
+  }
+
+  // hint の直前に入る場合は探索しない. 整列済みの範囲を末尾に足していく時は
+  // 比較1回で位置が決まる.
+  bool __find_insert_position(const_iterator hint, const key_type &key,
+                              size_type &position) const {
+    const size_type h = hint.index_;
+    if ((h == storage_.size() || key_comp_(key, storage_.key(h))) &&
+        (h == 0 || key_comp_(storage_.key(h - 1), key))) {
+      position = h;
+      return false;
+    }
+    return __find_insert_position(key, position);
+  }
+
+  // from 番目以降のキーが狭義単調増加かどうか.
+  bool __is_strictly_sorted(size_type from) const {
+    const size_type n = storage_.size();
+    for (size_type i = from + 1; i < n; ++i) {
+      if (!key_comp_(storage_.key(i - 1), storage_.key(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  iterator __make_iterator(size_type position) {
+    return iterator(&storage_, position);
+  }
+};
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Storage>
+inline bool operator==(
+    const FlatTree<Key, Value, KeyOfValue, Compare, Storage> &lhs,
+    const FlatTree<Key, Value, KeyOfValue, Compare, Storage> &rhs) {
+  return lhs.size() == rhs.size() &&
+         ft::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare,
+          class Storage>
+inline bool operator<(
+    const FlatTree<Key, Value, KeyOfValue, Compare, Storage> &lhs,
+    const FlatTree<Key, Value, KeyOfValue, Compare, Storage> &rhs) {
+  typedef typename FlatTree<Key, Value, KeyOfValue, Compare,
+                            Storage>::const_iterator const_iterator;
+  return ft::lexicographical_compare<const_iterator, const_iterator>(
+      lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+}  // namespace ft
+
+#endif
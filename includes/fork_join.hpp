@@ -0,0 +1,113 @@
+#ifndef FORK_JOIN_H_
+#define FORK_JOIN_H_
+#include <pthread.h>
+#include <unistd.h>
+
+#include <cstddef>
+
+namespace ft {
+
+// pthread を使った fork-join の実行器.
+// fork_join() は2つのタスクの片方を新しいスレッドで, もう片方を呼び出した
+// スレッドで実行し, 両方が終わるまで待つ. 同時に動くスレッドの数は
+// thread_count() 以下に抑え, 空きが無い時は両方を呼び出したスレッドで順に
+// 実行する. タスクの中から更に fork_join() を呼んでも良い.
+//
+// 別のスレッドで実行したタスクが例外を投げると std::terminate() が呼ばれる.
+class fork_join_executor {
+ public:
+  // grain_size はタスクを分けるかどうかを決める目安の要素数.
+  // これより小さい仕事は分けずにそのまま実行する.
+  explicit fork_join_executor(
+      unsigned int thread_count = hardware_concurrency(),
+      std::size_t grain_size = kDefaultGrainSize)
+      : thread_count_(thread_count == 0 ? 1 : thread_count),
+        grain_size_(grain_size == 0 ? 1 : grain_size),
+        idle_threads_(thread_count_ - 1) {
+    pthread_mutex_init(&mutex_, NULL);
+  }
+
+  ~fork_join_executor() {
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  // オンラインの CPU の数. 分からなければ 1.
+  static unsigned int hardware_concurrency() {
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<unsigned int>(count) : 1;
+  }
+
+  unsigned int thread_count() const {
+    return thread_count_;
+  }
+
+  std::size_t grain_size() const {
+    return grain_size_;
+  }
+
+  // task1() と task2() を並行に実行する. どちらも引数無しで呼べること.
+  template <class Task1, class Task2>
+  void fork_join(Task1 &task1, Task2 &task2) const {
+    pthread_t thread;
+    if (!__acquire_thread()) {
+      task1();
+      task2();
+      return;
+    }
+    if (pthread_create(&thread, NULL, &__run_task<Task1>, &task1) != 0) {
+      __release_thread();
+      task1();
+      task2();
+      return;
+    }
+    try {
+      task2();
+    } catch (...) {
+      // task1 は呼び出し側のスタックを参照しているので, 先に終わらせる.
+      pthread_join(thread, NULL);
+      __release_thread();
+      throw;
+    }
+    pthread_join(thread, NULL);
+    __release_thread();
+  }
+
+ private:
+  static const std::size_t kDefaultGrainSize = 4096;
+
+  unsigned int thread_count_;
+  std::size_t grain_size_;
+  // 呼び出したスレッドの他に, 新しく作って良いスレッドの数.
+  mutable unsigned int idle_threads_;
+  mutable pthread_mutex_t mutex_;
+
+  // pthread_mutex_t はコピー出来ないので, 実行器もコピーさせない.
+  fork_join_executor(const fork_join_executor &other);
+  fork_join_executor &operator=(const fork_join_executor &other);
+
+  bool __acquire_thread() const {
+    pthread_mutex_lock(&mutex_);
+    const bool acquired = idle_threads_ > 0;
+    if (acquired) {
+      --idle_threads_;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return acquired;
+  }
+
+  void __release_thread() const {
+    pthread_mutex_lock(&mutex_);
+    ++idle_threads_;
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  template <class Task>
+  static void *__run_task(void *task) {
+    (*static_cast<Task *>(task))();
+    return NULL;
+  }
+};
+
+}  // namespace ft
+
+#endif
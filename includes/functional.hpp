@@ -0,0 +1,115 @@
+#ifndef FUNCTIONAL_H_
+#define FUNCTIONAL_H_
+#include <functional>
+#include <string>
+
+#include "type_traits.hpp"
+
+namespace ft {
+
+// 比較関数 Compare がキー Key を三方比較出来るかどうかを表す特性クラス.
+//
+// value が true の場合は static な compare(comp, lhs, rhs) を持ち,
+// lhs が前なら負, 同じなら 0, lhs が後ろなら正の値を返す.
+// 文字列のように比較が重いキーは, これを使うと木を辿る時に
+// 1回の比較で左右と一致の3方向に分岐出来る.
+//
+// 独自の比較関数でも, この特性クラスを特殊化すれば RedBlackTree に使われる.
+template <class Compare, class Key>
+struct three_way_compare_traits : public false_type {};
+
+template <class CharT, class Traits, class Alloc>
+struct three_way_compare_traits<
+    std::less<std::basic_string<CharT, Traits, Alloc> >,
+    std::basic_string<CharT, Traits, Alloc> > : public true_type {
+  typedef std::basic_string<CharT, Traits, Alloc> key_type;
+
+  static int compare(const std::less<key_type> &comp, const key_type &lhs,
+                     const key_type &rhs) {
+    (void)comp;
+    return lhs.compare(rhs);
+  }
+};
+
+template <class CharT, class Traits, class Alloc>
+struct three_way_compare_traits<
+    std::greater<std::basic_string<CharT, Traits, Alloc> >,
+    std::basic_string<CharT, Traits, Alloc> > : public true_type {
+  typedef std::basic_string<CharT, Traits, Alloc> key_type;
+
+  static int compare(const std::greater<key_type> &comp, const key_type &lhs,
+                     const key_type &rhs) {
+    (void)comp;
+    return rhs.compare(lhs);
+  }
+};
+
+// 比較関数 Compare が is_transparent を持つかどうかを表す特性クラス.
+// 持っている場合, map や set の探索はキー以外の型の引数も受け付ける.
+template <class Compare>
+struct has_is_transparent {
+ private:
+  typedef char yes_type;
+  struct no_type {
+    char dummy[2];
+  };
+
+  template <class U>
+  static yes_type test(typename U::is_transparent *);
+  template <class U>
+  static no_type test(...);
+
+ public:
+  static const bool value = sizeof(test<Compare>(0)) == sizeof(yes_type);
+};
+
+// Compare が is_transparent を持つ場合だけ type (= T) を定義する.
+// 探索する型 K にも依存させて, 探索関数のテンプレートで SFINAE を効かせる.
+template <class Compare, class K, class T,
+          bool = has_is_transparent<Compare>::value>
+struct enable_if_transparent {};
+
+template <class Compare, class K, class T>
+struct enable_if_transparent<Compare, K, T, true> {
+  typedef T type;
+};
+
+// operator< で比較する関数オブジェクト.
+// less<> (less<void>) は引数の型を呼び出し時に決め, is_transparent を持つ.
+template <class T = void>
+struct less {
+  typedef T first_argument_type;
+  typedef T second_argument_type;
+  typedef bool result_type;
+
+  bool operator()(const T &lhs, const T &rhs) const {
+    return lhs < rhs;
+  }
+};
+
+template <>
+struct less<void> {
+  typedef void is_transparent;
+
+  template <class T, class U>
+  bool operator()(const T &lhs, const U &rhs) const {
+    return lhs < rhs;
+  }
+};
+
+template <class CharT, class Traits, class Alloc>
+struct three_way_compare_traits<less<void>,
+                                std::basic_string<CharT, Traits, Alloc> >
+    : public true_type {
+  typedef std::basic_string<CharT, Traits, Alloc> key_type;
+
+  static int compare(const less<void> &comp, const key_type &lhs,
+                     const key_type &rhs) {
+    (void)comp;
+    return lhs.compare(rhs);
+  }
+};
+
+}  // namespace ft
+
+#endif /* FUNCTIONAL_H_ */
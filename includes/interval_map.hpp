@@ -0,0 +1,273 @@
+#ifndef INTERVAL_MAP_H_
+#define INTERVAL_MAP_H_
+
+#include <functional>
+
+#include "map.hpp"
+#include "pair.hpp"
+#include "red_black_tree.hpp"
+
+namespace ft {
+
+// 半開区間 [first, second) をキーに値を持つ連想コンテナ.
+//
+// 区間は始点, 終点の順に比べて並べる. 同じ区間は1つしか持てない.
+// 各ノードに部分木の中で最大の終点を持たせていて,
+// ある区間と重なる区間を木の高さに比例する時間で見つけられる.
+//
+// 最大の終点は Compare() で求めるので, Compare は状態を持たないものにする.
+template <class Key, class T, class Compare = std::less<Key>,
+          class Allocator =
+              std::allocator<ft::pair<const ft::pair<Key, Key>, T> > >
+class interval_map {
+ public:
+  typedef Key bound_type;
+  typedef ft::pair<Key, Key> key_type;
+  typedef T mapped_type;
+  typedef ft::pair<const key_type, T> value_type;
+  typedef Compare bound_compare;
+  typedef Allocator allocator_type;
+
+  class key_compare {
+    friend class interval_map<Key, T, Compare, Allocator>;
+
+   public:
+    typedef key_type first_argument_type;
+    typedef key_type second_argument_type;
+    typedef bool result_type;
+
+    explicit key_compare(const Compare& c = Compare()) : comp(c) {}
+
+    bool operator()(const key_type& lhs, const key_type& rhs) const {
+      if (comp(lhs.first, rhs.first)) {
+        return true;
+      }
+      if (comp(rhs.first, lhs.first)) {
+        return false;
+      }
+      return comp(lhs.second, rhs.second);
+    }
+
+   protected:
+    Compare comp;
+  };
+
+ private:
+  // 部分木の中で最大の終点.
+  struct __max_end_augment {
+    typedef Key result_type;
+
+    static result_type value(const value_type& value) {
+      return value.first.second;
+    }
+
+    static result_type combine(const result_type& lhs,
+                               const result_type& rhs) {
+      return Compare()(lhs, rhs) ? rhs : lhs;
+    }
+  };
+
+  typedef
+      typename Allocator::template rebind<value_type>::other pair_alloc_type;
+  typedef RedBlackTree<key_type, value_type, Select1st<value_type>, key_compare,
+                       pair_alloc_type,
+                       rbtree_augmented_node_policy<__max_end_augment> >
+      RepType;
+  typedef typename RepType::node_type node_type;
+
+  RepType rbtree_;
+
+ public:
+  typedef typename pair_alloc_type::reference reference;
+  typedef typename pair_alloc_type::const_reference const_reference;
+  typedef typename pair_alloc_type::pointer pointer;
+  typedef typename pair_alloc_type::const_pointer const_pointer;
+  typedef typename RepType::size_type size_type;
+  typedef typename RepType::difference_type difference_type;
+  typedef typename RepType::iterator iterator;
+  typedef typename RepType::const_iterator const_iterator;
+  typedef typename RepType::reverse_iterator reverse_iterator;
+  typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+
+  /********** Constructor and Assignation **********/
+  interval_map() : rbtree_(key_compare(Compare())) {}
+
+  explicit interval_map(const Compare& comp,
+                        const Allocator& alloc = Allocator())
+      : rbtree_(key_compare(comp), alloc) {}
+
+  interval_map(const interval_map& other) : rbtree_(other.rbtree_) {}
+
+  interval_map& operator=(const interval_map& other) {
+    if (this != &other) {
+      rbtree_ = other.rbtree_;
+    }
+    return *this;
+  }
+
+  ~interval_map() {}
+
+  allocator_type get_allocator() const {
+    return allocator_type(rbtree_.get_allocator());
+  }
+
+  /********** Iterators **********/
+  iterator begin() {
+    return rbtree_.begin();
+  }
+
+  const_iterator begin() const {
+    return rbtree_.begin();
+  }
+
+  iterator end() {
+    return rbtree_.end();
+  }
+
+  const_iterator end() const {
+    return rbtree_.end();
+  }
+
+  reverse_iterator rbegin() {
+    return rbtree_.rbegin();
+  }
+
+  const_reverse_iterator rbegin() const {
+    return rbtree_.rbegin();
+  }
+
+  reverse_iterator rend() {
+    return rbtree_.rend();
+  }
+
+  const_reverse_iterator rend() const {
+    return rbtree_.rend();
+  }
+
+  /********** Capacity **********/
+  bool empty() const {
+    return rbtree_.empty();
+  }
+
+  size_type size() const {
+    return rbtree_.size();
+  }
+
+  size_type max_size() const {
+    return rbtree_.max_size();
+  }
+
+  /********** Modifiers **********/
+  ft::pair<iterator, bool> insert(const value_type& value) {
+    return rbtree_.insert_unique(value);
+  }
+
+  ft::pair<iterator, bool> insert(const Key& lo, const Key& hi,
+                                  const mapped_type& obj) {
+    return rbtree_.insert_unique(value_type(key_type(lo, hi), obj));
+  }
+
+  void erase(iterator pos) {
+    rbtree_.erase(pos);
+  }
+
+  size_type erase(const key_type& key) {
+    return rbtree_.erase(key);
+  }
+
+  void clear() {
+    rbtree_.clear();
+  }
+
+  void swap(interval_map& other) {
+    rbtree_.swap(other.rbtree_);
+  }
+
+  /********** Lookup **********/
+  iterator find(const key_type& key) {
+    return rbtree_.find(key);
+  }
+
+  const_iterator find(const key_type& key) const {
+    return rbtree_.find(key);
+  }
+
+  // [lo, hi) と重なる区間のうち, 最も前にあるもの. 無ければ end().
+  iterator find_overlapping(const Key& lo, const Key& hi) {
+    return const_cast<const interval_map*>(this)
+        ->find_overlapping(lo, hi)
+        .cast_nonconst();
+  }
+
+  const_iterator find_overlapping(const Key& lo, const Key& hi) const {
+    const node_type* node = __find_first_overlapping(lo, hi);
+    return node ? const_iterator(node) : end();
+  }
+
+  // [lo, hi) と重なる区間を前から順に全て out に書き出す.
+  // 重ならない部分木は最大の終点を見て丸ごと飛ばす.
+  template <class OutputIt>
+  OutputIt overlapping(const Key& lo, const Key& hi, OutputIt out) const {
+    __collect_overlapping(rbtree_.root_node(), lo, hi, out);
+    return out;
+  }
+
+  /********** Observers **********/
+  key_compare key_comp() const {
+    return rbtree_.key_comp();
+  }
+
+  bound_compare bound_comp() const {
+    return rbtree_.key_comp().comp;
+  }
+
+ private:
+  bool __less(const Key& lhs, const Key& rhs) const {
+    return rbtree_.key_comp().comp(lhs, rhs);
+  }
+
+  // 区間 [start, end) と [lo, hi) は start < hi かつ lo < end の時に重なる.
+  //
+  // 左部分木に lo より後ろで終わる区間があれば, 答えはそこにあるか, 無い.
+  // 無い場合はその区間の始点が hi 以降なので,
+  // 自分と右部分木の始点も hi 以降になる.
+  const node_type* __find_first_overlapping(const Key& lo,
+                                            const Key& hi) const {
+    const node_type* node = rbtree_.root_node();
+    while (node && __less(lo, node->aggregate_)) {
+      if (node->left_ && __less(lo, node->left_->aggregate_)) {
+        node = node->left_;
+        continue;
+      }
+      if (!__less(node->value_.first.first, hi)) {
+        return NULL;
+      }
+      if (__less(lo, node->value_.first.second)) {
+        return node;
+      }
+      node = node->right_;
+    }
+    return NULL;
+  }
+
+  template <class OutputIt>
+  void __collect_overlapping(const node_type* node, const Key& lo,
+                             const Key& hi, OutputIt& out) const {
+    if (node == NULL || !__less(lo, node->aggregate_)) {
+      return;
+    }
+    __collect_overlapping(node->left_, lo, hi, out);
+    if (!__less(node->value_.first.first, hi)) {
+      return;
+    }
+    if (__less(lo, node->value_.first.second)) {
+      *out = const_iterator(node);
+      ++out;
+    }
+    __collect_overlapping(node->right_, lo, hi, out);
+  }
+};
+
+}  // namespace ft
+
+#endif /* INTERVAL_MAP_H_ */
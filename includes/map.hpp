@@ -3,6 +3,8 @@
 
 #include <functional>
 
+#include "eytzinger_tree.hpp"
+#include "fork_join.hpp"
 #include "pair.hpp"
 #include "red_black_tree.hpp"
 
@@ -25,8 +27,11 @@ struct Select1st {
   }
 };
 
+// NodePolicy は RedBlackTree のノードのリンクの持ち方.
+// rbtree_threaded_node_policy を指定するとイテレータの移動が O(1) になる.
 template <class Key, class Val, class Compare = std::less<Key>,
-          class Allocator = std::allocator<ft::pair<const Key, Val> > >
+          class Allocator = std::allocator<ft::pair<const Key, Val> >,
+          class NodePolicy = rbtree_default_node_policy>
 class map {
  public:
   typedef Key key_type;
@@ -40,7 +45,7 @@ class map {
   typedef
       typename Allocator::template rebind<value_type>::other pair_alloc_type;
   typedef RedBlackTree<key_type, value_type, Select1st<value_type>, key_compare,
-                       pair_alloc_type>
+                       pair_alloc_type, NodePolicy>
       RepType;
 
   // The actual tree structure.
@@ -57,12 +62,20 @@ class map {
   typedef typename RepType::const_iterator const_iterator;
   typedef typename RepType::reverse_iterator reverse_iterator;
   typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+  // freeze() が返す, 変更できない探索用のスナップショット.
+  typedef EytzingerTree<key_type, value_type, Select1st<value_type>,
+                        key_compare, pair_alloc_type>
+      frozen_type;
 
-  class value_compare
-      : public std::binary_function<value_type, value_type, bool> {
-    friend class map<Key, Val, Compare, Allocator>;
+  // std::binary_function は C++11 で非推奨になったので typedef を直接持つ.
+  class value_compare {
+    friend class map<Key, Val, Compare, Allocator, NodePolicy>;
 
    public:
+    typedef value_type first_argument_type;
+    typedef value_type second_argument_type;
+    typedef bool result_type;
+
     bool operator()(const value_type& lhs, const value_type& rhs) const {
       return comp(lhs.first, rhs.first);
     }
@@ -93,6 +106,17 @@ class map {
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  // ノードを付け替えるだけで例外を投げないので, ft::vector<map> の再確保で
+  // コピーされずにムーブされる.
+  map(map&& other) noexcept : rbtree_(std::move(other.rbtree_)) {}
+
+  map& operator=(map&& other) noexcept {
+    rbtree_ = std::move(other.rbtree_);
+    return *this;
+  }
+#endif
+
   /********** Destructor **********/
   ~map() {}
 
@@ -102,13 +126,21 @@ class map {
   }
 
   /********** Element access **********/
+  // キーが無い場合は mapped_type をノード内で直接値初期化する.
   mapped_type& operator[](const key_type& key) {
-    iterator it = lower_bound(key);
-    if (it == end() || key_comp()(key, (*it).first)) {
-      it = insert(it, value_type(key, mapped_type()));
-    }
-    return (*it).second;
+    return (*rbtree_.try_emplace_unique(key, __emplace_second_tag(), key).first)
+        .second;
+  }
+
+#if __cplusplus >= 201103L
+  mapped_type& operator[](key_type&& key) {
+    return (*rbtree_
+                 .try_emplace_unique(key, __emplace_second_tag(),
+                                     std::move(key))
+                 .first)
+        .second;
   }
+#endif
 
   mapped_type& at(const key_type& key) {
     iterator it = lower_bound(key);
@@ -192,6 +224,126 @@ class map {
     rbtree_.insert_range_unique(first, last);
   }
 
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    return rbtree_.insert_unique(std::move(value));
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return rbtree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    return rbtree_.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return rbtree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+
+  /* key が無い場合だけ, args から mapped_type をノード内に直接構築する.
+   * key が既にある場合は args に触れない. (ムーブされない)
+   */
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return rbtree_.try_emplace_unique(key, __emplace_second_tag(), key,
+                                      std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+    return rbtree_.try_emplace_unique(key, __emplace_second_tag(),
+                                      std::move(key),
+                                      std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, const key_type& key, Args&&... args) {
+    return rbtree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(), key,
+                                 std::forward<Args>(args)...)
+        .first;
+  }
+
+  template <class... Args>
+  iterator try_emplace(iterator hint, key_type&& key, Args&&... args) {
+    return rbtree_
+        .try_emplace_hint_unique(hint, key, __emplace_second_tag(),
+                                 std::move(key), std::forward<Args>(args)...)
+        .first;
+  }
+
+  // key が既にある場合は値を代入し, 無い場合はノード内に直接構築する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        rbtree_.try_emplace_unique(key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+      rbtree_.refresh(res.first);
+    }
+    return res;
+  }
+
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        rbtree_.try_emplace_unique(key, std::move(key), std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+      rbtree_.refresh(res.first);
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, M&& obj) {
+    ft::pair<iterator, bool> res =
+        rbtree_.try_emplace_hint_unique(hint, key, key, std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+      rbtree_.refresh(res.first);
+    }
+    return res.first;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, key_type&& key, M&& obj) {
+    ft::pair<iterator, bool> res = rbtree_.try_emplace_hint_unique(
+        hint, key, std::move(key), std::forward<M>(obj));
+    if (!res.second) {
+      (*res.first).second = std::forward<M>(obj);
+      rbtree_.refresh(res.first);
+    }
+    return res.first;
+  }
+#else
+  // C++98 では mapped_type は obj からコピーで構築する.
+  template <class M>
+  ft::pair<iterator, bool> insert_or_assign(const key_type& key,
+                                            const M& obj) {
+    ft::pair<iterator, bool> res = rbtree_.try_emplace_unique(key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+      rbtree_.refresh(res.first);
+    }
+    return res;
+  }
+
+  template <class M>
+  iterator insert_or_assign(iterator hint, const key_type& key, const M& obj) {
+    ft::pair<iterator, bool> res =
+        rbtree_.try_emplace_hint_unique(hint, key, key, obj);
+    if (!res.second) {
+      (*res.first).second = obj;
+      rbtree_.refresh(res.first);
+    }
+    return res.first;
+  }
+#endif
+
   void erase(iterator pos) {
     rbtree_.erase(pos);
   }
@@ -208,6 +360,45 @@ class map {
     rbtree_.swap(other.rbtree_);
   }
 
+  /********** Set operations **********/
+  // ノードを作り直さずに木を組み替える. 小さい方の要素数を m, 大きい方を n
+  // とすると O(m log(n/m + 1)) で済む.
+
+  // other の要素を全て移す. 同じキーがあれば自分の要素を残し, other は空になる.
+  void unite(map& other) {
+    rbtree_.union_unique(other.rbtree_);
+  }
+
+  // other に無いキーの要素を取り除く.
+  void intersect(const map& other) {
+    rbtree_.intersect_unique(other.rbtree_);
+  }
+
+  // other にあるキーの要素を取り除く.
+  void subtract(const map& other) {
+    rbtree_.subtract_unique(other.rbtree_);
+  }
+
+  // executor で左右の部分木を並行に処理する版.
+  // 比較関数オブジェクトは複数のスレッドから同時に呼ばれる.
+  void unite(map& other, const fork_join_executor& executor) {
+    rbtree_.union_unique(other.rbtree_, executor);
+  }
+
+  void intersect(const map& other, const fork_join_executor& executor) {
+    rbtree_.intersect_unique(other.rbtree_, executor);
+  }
+
+  void subtract(const map& other, const fork_join_executor& executor) {
+    rbtree_.subtract_unique(other.rbtree_, executor);
+  }
+
+  // [first, last) を挿入する. 要素の木を作ってから並行に合わせる.
+  template <class InputIt>
+  void insert(InputIt first, InputIt last, const fork_join_executor& executor) {
+    rbtree_.insert_range_unique(first, last, executor);
+  }
+
   /********** Lookup **********/
 
   iterator find(const key_type& key) {
@@ -247,6 +438,136 @@ class map {
     return rbtree_.upper_bound(key);
   }
 
+  /* key_compare が is_transparent を持つ場合は, key_type と比較出来る任意の型で
+   * 探索する. (例えば map<std::string, T, ft::less<> > を const char* で探す)
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return rbtree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) {
+    return rbtree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type find(
+      const K& key) const {
+    return rbtree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) {
+    return rbtree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      key_compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K& key) const {
+    return rbtree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) {
+    return rbtree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  lower_bound(const K& key) const {
+    return rbtree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) {
+    return rbtree_.upper_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  upper_bound(const K& key) const {
+    return rbtree_.upper_bound(key);
+  }
+
+  /* [first, last) の各キーについて find, lower_bound した結果を, キーの順に
+   * out から書いて, 書き終えた位置を返す. 複数の探索を交互に1段ずつ進めて
+   * ノードを先読みするので, 木がキャッシュに乗らない時に1つずつ探すより速い.
+   */
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return rbtree_.find_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const {
+    return rbtree_.find_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return rbtree_.lower_bound_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last,
+                            OutputIt out) const {
+    return rbtree_.lower_bound_many(first, last, out);
+  }
+
+  /********** Order statistics **********/
+  // NodePolicy が rbtree_order_statistic_node_policy の時だけ使える.
+  // どれも木の高さに比例する時間で求める.
+
+  iterator nth(size_type k) {
+    return rbtree_.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return rbtree_.nth(k);
+  }
+
+  size_type rank(const key_type& key) const {
+    return rbtree_.rank(key);
+  }
+
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    return rbtree_.count_range(lo, hi);
+  }
+
+  size_type index_of(const_iterator pos) const {
+    return rbtree_.index_of(pos);
+  }
+
+  /********** Aggregate **********/
+  // NodePolicy が rbtree_augmented_node_policy の時だけ使える.
+
+  // [lo, hi) のキーを持つ要素の集計値を木の高さに比例する時間で求める.
+  typename NodePolicy::aggregate_type range_aggregate(
+      const key_type& lo, const key_type& hi) const {
+    return rbtree_.range_aggregate(lo, hi);
+  }
+
+  // operator[] やイテレータ経由で値を書き換えた後は, 集計値を直すために呼ぶ.
+  // insert_or_assign() は自分で呼ぶ.
+  void refresh(const_iterator pos) {
+    rbtree_.refresh(pos);
+  }
+
+  /********** Snapshot **********/
+  // 今の要素を中間順に読んで, Eytzinger 配置の配列にコピーする. O(n)
+  // 探索は木を辿らないので速いが, 後で変更しても反映されない.
+  frozen_type freeze() const {
+    return frozen_type(begin(), size(), key_comp(), get_allocator());
+  }
+
   /********** Observers **********/
 
   key_compare key_comp() const {
@@ -258,46 +579,54 @@ class map {
   }
 
   /********** Basic comparison operators **********/
-  template <typename K1, typename T1, typename C1, typename A>
-  friend bool operator==(const map<K1, T1, C1, A>&, const map<K1, T1, C1, A>&);
+  template <typename K1, typename T1, typename C1, typename A, typename P>
+  friend bool operator==(const map<K1, T1, C1, A, P>&,
+                         const map<K1, T1, C1, A, P>&);
 
-  template <typename K1, typename T1, typename C1, typename A>
-  friend bool operator<(const map<K1, T1, C1, A>&, const map<K1, T1, C1, A>&);
+  template <typename K1, typename T1, typename C1, typename A, typename P>
+  friend bool operator<(const map<K1, T1, C1, A, P>&,
+                        const map<K1, T1, C1, A, P>&);
 };
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator==(const map<Key, Value, Compare, Alloc>& lhs,
-                       const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator==(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                       const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return lhs.rbtree_ == rhs.rbtree_;
 }
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator<(const map<Key, Value, Compare, Alloc>& lhs,
-                      const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator<(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                      const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return lhs.rbtree_ < rhs.rbtree_;
 }
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator!=(const map<Key, Value, Compare, Alloc>& lhs,
-                       const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator!=(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                       const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator>(const map<Key, Value, Compare, Alloc>& lhs,
-                      const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator>(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                      const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator<=(const map<Key, Value, Compare, Alloc>& lhs,
-                       const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator<=(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                       const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return !(rhs < lhs);
 }
 
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline bool operator>=(const map<Key, Value, Compare, Alloc>& lhs,
-                       const map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline bool operator>=(const map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                       const map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   return !(lhs < rhs);
 }
 
@@ -305,9 +634,10 @@ inline bool operator>=(const map<Key, Value, Compare, Alloc>& lhs,
 
 // specializes the std::swap algorithm
 namespace std {
-template <typename Key, typename Value, typename Compare, typename Alloc>
-inline void swap(const ft::map<Key, Value, Compare, Alloc>& lhs,
-                 const ft::map<Key, Value, Compare, Alloc>& rhs) {
+template <typename Key, typename Value, typename Compare, typename Alloc,
+          typename NodePolicy>
+inline void swap(const ft::map<Key, Value, Compare, Alloc, NodePolicy>& lhs,
+                 const ft::map<Key, Value, Compare, Alloc, NodePolicy>& rhs) {
   lhs.swap(rhs);
 }
 }  // namespace std
@@ -0,0 +1,321 @@
+#ifndef NODE_POOL_ALLOCATOR_H_
+#define NODE_POOL_ALLOCATOR_H_
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#if __cplusplus >= 201103L
+#include <utility>
+#endif
+
+namespace ft {
+
+// 同じ大きさの領域(スロット)を大きな塊(スラブ)から切り出して配る.
+// 解放されたスロットは先頭のワードを次へのポインタとして使う
+// 連結リスト(free list)に繋いで再利用する.
+// スラブは pool を持つ __node_pool_group が無くなった時にまとめて解放する.
+class __node_pool {
+ public:
+  explicit __node_pool(std::size_t slot_size, __node_pool *next)
+      : next_(next),
+        slot_size_(__round_up_slot_size(slot_size)),
+        free_list_(NULL),
+        current_(NULL),
+        end_(NULL),
+        slabs_(NULL),
+        next_slab_slots_(kMinSlabSlots) {}
+
+  ~__node_pool() {
+    while (slabs_) {
+      __slab_header *next = slabs_->next_;
+      ::operator delete(static_cast<void *>(slabs_));
+      slabs_ = next;
+    }
+  }
+
+  // 大きさが slot_size の要求を受け持てるかどうか.
+  bool serves(std::size_t slot_size) const {
+    return slot_size_ == __round_up_slot_size(slot_size);
+  }
+
+  // 同じ __node_pool_group に属する pool の連結リスト
+  __node_pool *next_;
+
+  void *allocate() {
+    if (free_list_) {
+      __free_slot *slot = free_list_;
+      free_list_ = slot->next_;
+      return slot;
+    }
+    if (current_ == end_) {
+      __allocate_slab();
+    }
+    void *slot = current_;
+    current_ += slot_size_;
+    return slot;
+  }
+
+  void deallocate(void *p) {
+    __free_slot *slot = static_cast<__free_slot *>(p);
+    slot->next_ = free_list_;
+    free_list_ = slot;
+  }
+
+ private:
+  enum { kMinSlabSlots = 32, kMaxSlabSlots = 4096 };
+
+  struct __free_slot {
+    __free_slot *next_;
+  };
+
+  // スロットが最も厳しいアラインメントで始まるように,
+  // スラブの先頭に置くヘッダの大きさを基本型で揃えておく.
+  union __slab_header {
+    __slab_header *next_;
+    long double ld_;
+    long long ll_;
+    double d_;
+    void *p_;
+  };
+
+  // ノードの大きさは自身のアラインメントの倍数なので,
+  // ポインタの大きさの倍数に切り上げてもアラインメントは崩れない.
+  static std::size_t __round_up_slot_size(std::size_t size) {
+    const std::size_t align = sizeof(__free_slot);
+    if (size < align) {
+      return align;
+    }
+    return (size + align - 1) / align * align;
+  }
+
+  // 使い切ったスラブの次は倍の大きさのスラブを確保する.
+  void __allocate_slab() {
+    const std::size_t slots = next_slab_slots_;
+    char *raw = static_cast<char *>(
+        ::operator new(sizeof(__slab_header) + slot_size_ * slots));
+    __slab_header *slab = reinterpret_cast<__slab_header *>(raw);
+    slab->next_ = slabs_;
+    slabs_ = slab;
+    current_ = raw + sizeof(__slab_header);
+    end_ = current_ + slot_size_ * slots;
+    if (next_slab_slots_ < kMaxSlabSlots) {
+      next_slab_slots_ *= 2;
+    }
+  }
+
+  const std::size_t slot_size_;
+  __free_slot *free_list_;
+  // 現在のスラブのうちまだ配っていない範囲
+  char *current_;
+  char *end_;
+  __slab_header *slabs_;
+  std::size_t next_slab_slots_;
+
+  // スラブを所有するのでコピーは禁止
+  __node_pool(const __node_pool &);
+  __node_pool &operator=(const __node_pool &);
+};
+
+// コピーや rebind で繋がったアロケータが共有する, スロットの大きさごとの
+// __node_pool の集まり. 参照カウントで共有し, 参照が無くなったら
+// 全ての pool を解放する.
+// rebind したアロケータも同じ group を使うので, コンテナが rebind した
+// 一時的なアロケータで確保した領域も元のアロケータが生きている間は有効.
+class __node_pool_group {
+ public:
+  __node_pool_group() : pools_(NULL), ref_count_(1) {}
+
+  ~__node_pool_group() {
+    while (pools_) {
+      __node_pool *next = pools_->next_;
+      delete pools_;
+      pools_ = next;
+    }
+  }
+
+  // 大きさが slot_size のスロットを配る pool を返す. 無ければ作る.
+  // 種類はノード型の数しか無いので線形探索で足りる.
+  __node_pool *pool_for(std::size_t slot_size) {
+    for (__node_pool *pool = pools_; pool; pool = pool->next_) {
+      if (pool->serves(slot_size)) {
+        return pool;
+      }
+    }
+    pools_ = new __node_pool(slot_size, pools_);
+    return pools_;
+  }
+
+  void retain() {
+    ++ref_count_;
+  }
+
+  // 参照が無くなったら group を解放する.
+  static void release(__node_pool_group *group) {
+    if (--group->ref_count_ == 0) {
+      delete group;
+    }
+  }
+
+ private:
+  __node_pool *pools_;
+  std::size_t ref_count_;
+
+  // コピーは参照カウントで共有するので禁止
+  __node_pool_group(const __node_pool_group &);
+  __node_pool_group &operator=(const __node_pool_group &);
+};
+
+// RedBlackTree のノードのように 1 個ずつ確保, 解放される型のためのアロケータ.
+// map や set の Allocator に指定すると, ノード型に rebind されたものが使われる.
+//
+// 1 個の確保は __node_pool から数命令で行い, 2 個以上の確保は
+// ::operator new にそのまま渡す.
+// コピーや rebind をしたアロケータは __node_pool_group を共有し,
+// 等しいものとして扱われる. (A(B(a)) == a)
+// 確保は型の大きさごとに group 内の別の pool から行う.
+// group は最初にコピーか確保をした時に作るので, 空のコンテナは何も確保しない.
+template <class T>
+class node_pool_allocator {
+ public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <class U>
+  struct rebind {
+    typedef node_pool_allocator<U> other;
+  };
+
+  template <class U>
+  friend class node_pool_allocator;
+
+  node_pool_allocator() : group_(NULL), pool_(NULL) {}
+
+  node_pool_allocator(const node_pool_allocator &other)
+      : group_(other.__get_group()), pool_(other.pool_) {
+    group_->retain();
+  }
+
+  template <class U>
+  node_pool_allocator(const node_pool_allocator<U> &other)
+      : group_(other.__get_group()), pool_(NULL) {
+    group_->retain();
+  }
+
+  node_pool_allocator &operator=(const node_pool_allocator &rhs) {
+    if (this != &rhs) {
+      __node_pool_group *group = rhs.__get_group();
+      group->retain();
+      __release_group();
+      group_ = group;
+      pool_ = rhs.pool_;
+    }
+    return *this;
+  }
+
+  ~node_pool_allocator() {
+    __release_group();
+  }
+
+  pointer address(reference x) const {
+    return &x;
+  }
+
+  const_pointer address(const_reference x) const {
+    return &x;
+  }
+
+  pointer allocate(size_type n, const void *hint = 0) {
+    (void)hint;
+    if (n == 1) {
+      return static_cast<pointer>(__get_pool()->allocate());
+    }
+    if (n > max_size()) {
+      throw std::bad_alloc();
+    }
+    return static_cast<pointer>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n) {
+    if (n == 1) {
+      __get_pool()->deallocate(p);
+    } else {
+      ::operator delete(static_cast<void *>(p));
+    }
+  }
+
+  size_type max_size() const {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+
+  void construct(pointer p, const_reference val) {
+    new (static_cast<void *>(p)) T(val);
+  }
+
+#if __cplusplus >= 201103L
+  template <class U, class... Args>
+  void construct(U *p, Args &&...args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+#endif
+
+  void destroy(pointer p) {
+    p->~T();
+  }
+
+  // 互いに確保した領域を解放出来るのは group を共有している時だけ.
+  friend bool operator==(const node_pool_allocator &lhs,
+                         const node_pool_allocator &rhs) {
+    return lhs.__get_group() == rhs.__get_group();
+  }
+
+  friend bool operator!=(const node_pool_allocator &lhs,
+                         const node_pool_allocator &rhs) {
+    return !(lhs == rhs);
+  }
+
+  // group を付け替えるだけなので, コピーと違って group を作らない.
+  friend void swap(node_pool_allocator &lhs, node_pool_allocator &rhs) {
+    __node_pool_group *group = lhs.group_;
+    lhs.group_ = rhs.group_;
+    rhs.group_ = group;
+    __node_pool *pool = lhs.pool_;
+    lhs.pool_ = rhs.pool_;
+    rhs.pool_ = pool;
+  }
+
+ private:
+  // コピー元とも group を共有するために, const なアロケータからも group を作る.
+  __node_pool_group *__get_group() const {
+    if (group_ == NULL) {
+      group_ = new __node_pool_group();
+    }
+    return group_;
+  }
+
+  __node_pool *__get_pool() const {
+    if (pool_ == NULL) {
+      pool_ = __get_group()->pool_for(sizeof(T));
+    }
+    return pool_;
+  }
+
+  void __release_group() {
+    if (group_) {
+      __node_pool_group::release(group_);
+      group_ = NULL;
+    }
+  }
+
+  mutable __node_pool_group *group_;
+  // group_ 内の sizeof(T) を受け持つ pool のキャッシュ
+  mutable __node_pool *pool_;
+};
+
+}  // namespace ft
+
+#endif /* NODE_POOL_ALLOCATOR_H_ */
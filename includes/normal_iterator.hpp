@@ -35,6 +35,8 @@ class normal_iterator {
 
   explicit normal_iterator(const Iterator& it) : current_(it) {}
 
+  normal_iterator(const normal_iterator& other) : current_(other.current_) {}
+
   // Allow iterator to const_iterator conversion
   template <typename Iter>
   normal_iterator(
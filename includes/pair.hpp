@@ -1,7 +1,17 @@
 #ifndef PAIR_H_
 #define PAIR_H_
 
+#if __cplusplus >= 201103L
+#include <type_traits>
+#include <utility>
+#endif
+
 namespace ft {
+
+// second を first 以外の引数から直接構築することを表す印.
+// map の operator[] や try_emplace がノード内に値を作る時に使う.
+struct __emplace_second_tag {};
+
 template <class T1, class T2>
 struct pair {
   typedef T1 first_type;
@@ -16,7 +26,32 @@ struct pair {
   template <class U1, class U2>
   pair(const pair<U1, U2>& other) : first(other.first), second(other.second) {}
 
-  ~pair() {}
+#if __cplusplus >= 201103L
+  template <class U1, class... Args>
+  pair(__emplace_second_tag, U1&& x, Args&&... args)
+      : first(std::forward<U1>(x)), second(std::forward<Args>(args)...) {}
+
+  template <class U1, class U2>
+  pair(U1&& x, U2&& y)
+      : first(std::forward<U1>(x)), second(std::forward<U2>(y)) {}
+
+  // ft::vector は再確保で例外を投げないムーブだけを使うので, 要素が共に
+  // 例外を投げずにムーブできる時は noexcept にする.
+  pair(pair&& other) noexcept(
+      std::is_nothrow_move_constructible<T1>::value &&
+      std::is_nothrow_move_constructible<T2>::value)
+      : first(std::move(other.first)), second(std::move(other.second)) {}
+
+  template <class U1, class U2>
+  pair(pair<U1, U2>&& other)
+      : first(std::move(other.first)), second(std::move(other.second)) {}
+#else
+  template <class U1>
+  pair(__emplace_second_tag, const U1& x) : first(x), second() {}
+#endif
+
+  // デストラクタは暗黙のものに任せて, 要素が共にトリビアルに破棄出来るなら
+  // pair もトリビアルに破棄出来るようにする.
 
   pair& operator=(const pair& other) {
     if (this != &other) {
@@ -26,6 +61,18 @@ struct pair {
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  pair& operator=(pair&& other) noexcept(
+      std::is_nothrow_move_assignable<T1>::value &&
+      std::is_nothrow_move_assignable<T2>::value) {
+    if (this != &other) {
+      first = std::move(other.first);
+      second = std::move(other.second);
+    }
+    return *this;
+  }
+#endif
+
   T1 first;
   T2 second;
 };
@@ -1,33 +1,59 @@
 #ifndef RED_BLACK_TREE_H_
 #define RED_BLACK_TREE_H_
 
+#include <stdint.h>
+
+#include <climits>
 #include <cstddef>
 #include <iostream>
+#include <memory>
 
 #include "equal.hpp"
+#include "fork_join.hpp"
+#include "functional.hpp"
 #include "iterator_traits.hpp"
 #include "lexicographical_compare.hpp"
 #include "pair.hpp"
 #include "reverse_iterator.hpp"
+#include "type_traits.hpp"
+
+// 後で読むアドレスを先にキャッシュに読み込ませる. 対応していないコンパイラでは
+// 何もしない. 読み込みは投機的なので, NULL を渡しても良い.
+#if defined(__GNUC__) || defined(__clang__)
+#define FT_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define FT_PREFETCH(address) static_cast<void>(address)
+#endif
 
 namespace ft {
 
-template <class Value>
+struct rbtree_default_node_policy;
+struct rbtree_threaded_node_policy;
+template <class BasePolicy>
+struct rbtree_order_statistic_node_policy;
+template <class Augment, class BasePolicy>
+struct rbtree_augmented_node_policy;
+
+template <class Value, class NodePolicy = rbtree_default_node_policy>
 struct RBTNode;
 
-template <class Value>
-RBTNode<Value> *find_minimum_node(const RBTNode<Value> *root);
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *find_minimum_node(
+    const RBTNode<Value, NodePolicy> *root);
 
-template <class Value>
-RBTNode<Value> *find_maximum_node(const RBTNode<Value> *root);
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *find_maximum_node(
+    const RBTNode<Value, NodePolicy> *root);
 
-template <class Value>
-RBTNode<Value> *get_next_node(const RBTNode<Value> *current);
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *get_next_node(
+    const RBTNode<Value, NodePolicy> *current);
 
-template <class Value>
-RBTNode<Value> *get_prev_node(const RBTNode<Value> *current);
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *get_prev_node(
+    const RBTNode<Value, NodePolicy> *current);
 
-template <class Value>
+template <class Value, class NodePolicy = rbtree_default_node_policy>
 struct rbtree_iterator {
   typedef Value value_type;
   typedef Value &reference;
@@ -36,8 +62,8 @@ struct rbtree_iterator {
   typedef std::bidirectional_iterator_tag iterator_category;
   typedef std::ptrdiff_t difference_type;
 
-  typedef rbtree_iterator<Value> self_type;
-  typedef RBTNode<Value> node_type;
+  typedef rbtree_iterator<Value, NodePolicy> self_type;
+  typedef RBTNode<Value, NodePolicy> node_type;
   typedef node_type *node_pointer;
 
   node_pointer node_;
@@ -46,6 +72,8 @@ struct rbtree_iterator {
 
   explicit rbtree_iterator(node_pointer ptr) : node_(ptr) {}
 
+  rbtree_iterator(const self_type &other) : node_(other.node_) {}
+
   self_type &operator=(const self_type &other) {
     if (this != &other) {
       node_ = other.node_;
@@ -64,24 +92,24 @@ struct rbtree_iterator {
   }
 
   self_type &operator++() {
-    node_ = get_next_node<Value>(node_);
+    node_ = NodePolicy::next_node(node_);
     return *this;
   }
 
   self_type operator++(int) {
     self_type tmp = *this;
-    node_ = get_next_node<Value>(node_);
+    node_ = NodePolicy::next_node(node_);
     return tmp;
   }
 
   self_type &operator--() {
-    node_ = get_prev_node<Value>(node_);
+    node_ = NodePolicy::prev_node(node_);
     return *this;
   }
 
   self_type operator--(int) {
     self_type tmp = *this;
-    node_ = get_prev_node<Value>(node_);
+    node_ = NodePolicy::prev_node(node_);
     return tmp;
   }
 
@@ -94,19 +122,19 @@ struct rbtree_iterator {
   }
 };
 
-template <class Value>
+template <class Value, class NodePolicy = rbtree_default_node_policy>
 struct rbtree_const_iterator {
   typedef Value value_type;
   typedef const Value &reference;
   typedef const Value *pointer;
 
-  typedef rbtree_iterator<Value> iterator;
+  typedef rbtree_iterator<Value, NodePolicy> iterator;
 
   typedef std::bidirectional_iterator_tag iterator_category;
   typedef std::ptrdiff_t difference_type;
 
-  typedef rbtree_const_iterator<Value> self_type;
-  typedef RBTNode<Value> node_type;
+  typedef rbtree_const_iterator<Value, NodePolicy> self_type;
+  typedef RBTNode<Value, NodePolicy> node_type;
   typedef const node_type *node_pointer;
 
   node_pointer node_;
@@ -115,6 +143,8 @@ struct rbtree_const_iterator {
 
   explicit rbtree_const_iterator(node_pointer ptr) : node_(ptr) {}
 
+  rbtree_const_iterator(const self_type &other) : node_(other.node_) {}
+
   rbtree_const_iterator(const iterator &it) : node_(it.node_) {}
 
   self_type &operator=(const self_type &other) {
@@ -139,24 +169,24 @@ struct rbtree_const_iterator {
   }
 
   self_type &operator++() {
-    node_ = get_next_node<Value>(node_);
+    node_ = NodePolicy::next_node(node_);
     return *this;
   }
 
   self_type operator++(int) {
     self_type tmp = *this;
-    node_ = get_next_node<Value>(node_);
+    node_ = NodePolicy::next_node(node_);
     return tmp;
   }
 
   self_type &operator--() {
-    node_ = get_prev_node<Value>(node_);
+    node_ = NodePolicy::prev_node(node_);
     return *this;
   }
 
   self_type operator--(int) {
     self_type tmp = *this;
-    node_ = get_prev_node<Value>(node_);
+    node_ = NodePolicy::prev_node(node_);
     return tmp;
   }
 
@@ -169,34 +199,340 @@ struct rbtree_const_iterator {
   };
 };
 
-template <class Value>
-struct RBTNode {
+// ノードのリンクと色の部分.
+// RedBlackTree は値を持たないこの部分だけを番兵(end_node_)として
+// 自身のメンバーに埋め込むので, 空の木を作る時にノードの確保は行わない.
+// 葉は NULL で表し, NULL の葉は黒として扱う.
+//
+// ノードはポインタの境界に揃うので親へのポインタの最下位ビットは常に 0 になる.
+// そこに色を詰めて, ノードをポインタ3つ + 値の大きさに収めている.
+template <class Node>
+struct RBTNodeLinks {
   enum Color { BLACK = 0, RED = 1 };
 
+  uintptr_t parent_and_color_;
+  Node *left_;
+  Node *right_;
+
+  RBTNodeLinks() : parent_and_color_(0), left_(), right_() {}
+
+  Node *parent() const {
+    return reinterpret_cast<Node *>(parent_and_color_ & ~__color_mask());
+  }
+
+  void set_parent(Node *parent) {
+    parent_and_color_ = reinterpret_cast<uintptr_t>(parent) |
+                        (parent_and_color_ & __color_mask());
+  }
+
+  Color color() const {
+    return static_cast<Color>(parent_and_color_ & __color_mask());
+  }
+
+  void set_color(Color color) {
+    parent_and_color_ = (parent_and_color_ & ~__color_mask()) | color;
+  }
+
+ private:
+  static uintptr_t __color_mask() {
+    return 1;
+  }
+};
+
+// 中間順の前後のノードへのリンクも持つリンク部分.
+// 番兵も含めて環状に繋がっていて, 番兵の next_ は最小のノード,
+// prev_ は最大のノードを指す.
+template <class Node>
+struct RBTThreadedNodeLinks : public RBTNodeLinks<Node> {
+  Node *next_;
+  Node *prev_;
+
+  RBTThreadedNodeLinks() : RBTNodeLinks<Node>(), next_(), prev_() {}
+};
+
+// ノードのリンクの持ち方を決めるポリシー.
+//
+// links<Node>::type がノードのリンク部分の型で,
+// next_node() と prev_node() がイテレータの移動に使われる.
+// それ以外の関数は木の形が変わった時に RedBlackTree から呼ばれる.
+// update_node() は子が変わったノードの, update_path() はそこから根までの
+// 全てのノードの, 部分木から求める値を計算し直す.
+//
+// 他のポリシーはこれを継承し, 変えたい関数だけを定義し直す.
+// 既定のポリシーは親を遡って前後のノードを求めるので,
+// ノードに余分なポインタを持たない.
+struct rbtree_default_node_policy {
+  template <class Node>
+  struct links {
+    typedef RBTNodeLinks<Node> type;
+  };
+
+  // 部分木から集計する値の型. 集計しないポリシーでは void.
+  typedef void aggregate_type;
+
+  template <class Node>
+  static Node *next_node(const Node *node) {
+    return get_next_node(node);
+  }
+
+  template <class Node>
+  static Node *prev_node(const Node *node) {
+    return get_prev_node(node);
+  }
+
+  template <class Node>
+  static void link_inserted_node(Node *node, Node *parent, bool insert_left) {
+    (void)node;
+    (void)parent;
+    (void)insert_left;
+  }
+
+  template <class Node>
+  static void unlink_node(Node *node) {
+    (void)node;
+  }
+
+  template <class Node>
+  static void link_end_node(Node *end_node, Node *begin_node,
+                            Node *rightmost_node) {
+    (void)end_node;
+    (void)begin_node;
+    (void)rightmost_node;
+  }
+
+  template <class Node>
+  static void relink_all_nodes(Node *end_node) {
+    (void)end_node;
+  }
+
+  template <class Node>
+  static void update_node(Node *node) {
+    (void)node;
+  }
+
+  template <class Node>
+  static void update_path(Node *node, Node *end_node) {
+    (void)node;
+    (void)end_node;
+  }
+};
+
+// 各ノードに中間順の前後のノードへのポインタを持たせるポリシー.
+// ノード1つにつきポインタ2つ分大きくなる代わりに,
+// イテレータの移動がポインタを1回読むだけになる.
+struct rbtree_threaded_node_policy : public rbtree_default_node_policy {
+  template <class Node>
+  struct links {
+    typedef RBTThreadedNodeLinks<Node> type;
+  };
+
+  template <class Node>
+  static Node *next_node(const Node *node) {
+    return node->next_;
+  }
+
+  template <class Node>
+  static Node *prev_node(const Node *node) {
+    return node->prev_;
+  }
+
+  // parent の子として繋いだばかりの node を, 左の子なら parent の直前に,
+  // 右の子なら parent の直後に入れる.
+  template <class Node>
+  static void link_inserted_node(Node *node, Node *parent, bool insert_left) {
+    Node *prev = insert_left ? parent->prev_ : parent;
+    Node *next = prev->next_;
+    node->prev_ = prev;
+    node->next_ = next;
+    prev->next_ = node;
+    next->prev_ = node;
+  }
+
+  template <class Node>
+  static void unlink_node(Node *node) {
+    node->prev_->next_ = node->next_;
+    node->next_->prev_ = node->prev_;
+  }
+
+  // 番兵と最小, 最大のノードの間のリンクだけを張り直す.
+  template <class Node>
+  static void link_end_node(Node *end_node, Node *begin_node,
+                            Node *rightmost_node) {
+    end_node->next_ = begin_node;
+    begin_node->prev_ = end_node;
+    end_node->prev_ = rightmost_node;
+    rightmost_node->next_ = end_node;
+  }
+
+  // 木を中間順に辿って全てのリンクを張り直す.
+  // 木をまとめて組み立てた後に使う.
+  template <class Node>
+  static void relink_all_nodes(Node *end_node) {
+    Node *prev = end_node;
+    for (Node *node = end_node->left_ ? find_minimum_node(end_node->left_)
+                                      : end_node;
+         node != end_node; node = get_next_node(node)) {
+      prev->next_ = node;
+      node->prev_ = prev;
+      prev = node;
+    }
+    prev->next_ = end_node;
+    end_node->prev_ = prev;
+  }
+};
+
+// 部分木のノード数も持つリンク部分. Base は他のポリシーのリンク部分.
+template <class Node, class Base>
+struct RBTSizedNodeLinks : public Base {
+  std::size_t size_;
+
+  RBTSizedNodeLinks() : Base(), size_(1) {}
+};
+
+// 各ノードに部分木のノード数を持たせるポリシー.
+// k 番目のノードや, あるノードが何番目かを木の高さに比例する時間で求められる.
+// リンクの持ち方とイテレータの移動は BasePolicy に従う.
+template <class BasePolicy = rbtree_default_node_policy>
+struct rbtree_order_statistic_node_policy : public BasePolicy {
+  template <class Node>
+  struct links {
+    typedef RBTSizedNodeLinks<Node,
+                              typename BasePolicy::template links<Node>::type>
+        type;
+  };
+
+  template <class Node>
+  static void update_node(Node *node) {
+    node->size_ = 1 + subtree_size(node->left_) + subtree_size(node->right_);
+    BasePolicy::update_node(node);
+  }
+
+  template <class Node>
+  static void update_path(Node *node, Node *end_node) {
+    for (; node != end_node; node = node->parent()) {
+      update_node(node);
+    }
+  }
+
+  template <class Node>
+  static std::size_t subtree_size(const Node *node) {
+    return node ? node->size_ : 0;
+  }
+
+  // node が中間順で何番目か. end_node_ なら要素数を返す.
+  // 親を遡りながら, 右の子として登った時に親と左部分木の分を足す.
+  // 番兵は親を持たないのでそこで止まる.
+  template <class Node>
+  static std::size_t index_of(const Node *node) {
+    std::size_t index = subtree_size(node->left_);
+    for (const Node *parent = node->parent(); parent;
+         node = parent, parent = parent->parent()) {
+      if (node == parent->right_) {
+        index += subtree_size(parent->left_) + 1;
+      }
+    }
+    return index;
+  }
+
+  // root を根とする部分木の中で index 番目のノードを返す.
+  template <class Node>
+  static Node *select_node(Node *root, std::size_t index) {
+    while (root) {
+      const std::size_t left_size = subtree_size(root->left_);
+      if (index < left_size) {
+        root = root->left_;
+      } else if (index == left_size) {
+        return root;
+      } else {
+        index -= left_size + 1;
+        root = root->right_;
+      }
+    }
+    return NULL;
+  }
+};
+
+// 部分木の集計値も持つリンク部分.
+template <class Node, class Base, class Aggregate>
+struct RBTAugmentedNodeLinks : public Base {
+  Aggregate aggregate_;
+
+  RBTAugmentedNodeLinks() : Base(), aggregate_() {}
+};
+
+// 各ノードに部分木の値をモノイドで畳み込んだ値を持たせるポリシー.
+// 範囲の集計を木の高さに比例する時間で求められる.
+//
+// Augment は次のものを持つ.
+//   result_type: 集計値の型.
+//   static result_type value(const Value &v): 1要素の値.
+//   static result_type combine(const result_type &lhs,
+//                              const result_type &rhs): 結合的な演算.
+//                              lhs が中間順で前の部分になる.
+//   static result_type identity(): combine の単位元.
+//                                  空の範囲を集計する時にだけ使う.
+template <class Augment, class BasePolicy = rbtree_default_node_policy>
+struct rbtree_augmented_node_policy : public BasePolicy {
+  template <class Node>
+  struct links {
+    typedef RBTAugmentedNodeLinks<
+        Node, typename BasePolicy::template links<Node>::type,
+        typename Augment::result_type>
+        type;
+  };
+
+  typedef typename Augment::result_type aggregate_type;
+
+  template <class Node>
+  static void update_node(Node *node) {
+    aggregate_type aggregate = Augment::value(node->value_);
+    if (node->left_) {
+      aggregate = Augment::combine(node->left_->aggregate_, aggregate);
+    }
+    if (node->right_) {
+      aggregate = Augment::combine(aggregate, node->right_->aggregate_);
+    }
+    node->aggregate_ = aggregate;
+    BasePolicy::update_node(node);
+  }
+
+  template <class Node>
+  static void update_path(Node *node, Node *end_node) {
+    for (; node != end_node; node = node->parent()) {
+      update_node(node);
+    }
+  }
+
+  static aggregate_type identity() {
+    return Augment::identity();
+  }
+
+  template <class Value>
+  static aggregate_type value_of(const Value &value) {
+    return Augment::value(value);
+  }
+
+  static aggregate_type combine(const aggregate_type &lhs,
+                                const aggregate_type &rhs) {
+    return Augment::combine(lhs, rhs);
+  }
+
+  template <class Node>
+  static aggregate_type aggregate_of(const Node *node) {
+    return node ? node->aggregate_ : Augment::identity();
+  }
+};
+
+template <class Value, class NodePolicy>
+struct RBTNode : public NodePolicy::template links<
+                     RBTNode<Value, NodePolicy> >::type {
+  typedef typename NodePolicy::template links<RBTNode>::type links_type;
+
   Value value_;
-  RBTNode *parent_;
-  RBTNode *left_;
-  RBTNode *right_;
-  Color color_;
-  // C++98 の allocator.construct()
-  // は引数1つしか取れないので外部から変更出来るようにしている。
-  bool is_nil_node_;
-
-  RBTNode(Value value = Value(), bool is_nil_node = false)
-      : value_(value),
-        parent_(),
-        left_(),
-        right_(),
-        color_(BLACK),
-        is_nil_node_(is_nil_node) {}
-
-  RBTNode(const RBTNode &other)
-      : value_(other.value_),
-        parent_(other.parent_),
-        left_(other.left_),
-        right_(other.right_),
-        color_(other.color_),
-        is_nil_node_(other.is_nil_node_) {}
+
+  RBTNode(const Value &value = Value()) : links_type(), value_(value) {}
+
+  RBTNode(const RBTNode &other) : links_type(other), value_(other.value_) {}
 
   ~RBTNode() {}
 
@@ -206,81 +542,116 @@ struct RBTNode {
   RBTNode &operator=(const RBTNode &);
 };
 
-template <class Value>
-RBTNode<Value> *find_minimum_node(const RBTNode<Value> *root) {
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *find_minimum_node(
+    const RBTNode<Value, NodePolicy> *root) {
   if (!root) {
     return NULL;
   }
 
-  const RBTNode<Value> *current = root;
-  while (!current->left_->is_nil_node_) {
+  const RBTNode<Value, NodePolicy> *current = root;
+  while (current->left_) {
     current = current->left_;
   }
-  return const_cast<RBTNode<Value> *>(current);
+  return const_cast<RBTNode<Value, NodePolicy> *>(current);
 }
 
-template <class Value>
-RBTNode<Value> *find_maximum_node(const RBTNode<Value> *root) {
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *find_maximum_node(
+    const RBTNode<Value, NodePolicy> *root) {
   if (!root) {
     return NULL;
   }
 
-  const RBTNode<Value> *current = root;
-  while (!current->right_->is_nil_node_) {
+  const RBTNode<Value, NodePolicy> *current = root;
+  while (current->right_) {
     current = current->right_;
   }
-  return const_cast<RBTNode<Value> *>(current);
+  return const_cast<RBTNode<Value, NodePolicy> *>(current);
 }
 
 // 中間順木巡回の順序での次の節点のポインタを返す
-template <class Value>
-RBTNode<Value> *get_next_node(const RBTNode<Value> *current) {
-  if (!current->right_->is_nil_node_) {
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *get_next_node(
+    const RBTNode<Value, NodePolicy> *current) {
+  if (current->right_) {
     // currentが右の子を持っている時は右の子の中の最小が次のノード
     return find_minimum_node(current->right_);
   } else {
-    if (current == current->parent_->left_) {
+    if (current == current->parent()->left_) {
       // currentが親の左の子で, なおかつ右に子を持っていない場合,
       // 次のノードは親である
-      return current->parent_;
+      return current->parent();
     } else {
       // currentが親の右の子で, なおかつ右に子を持たない
       // currentが左の子になるまで親を遡る.
-      const RBTNode<Value> *next_node = current->parent_;
-      while (!next_node->is_nil_node_ && current == next_node->right_) {
+      // end_node_ は根を左の子として持つので, 最大のノードからは
+      // end_node_ に辿り着いて止まる.
+      const RBTNode<Value, NodePolicy> *next_node = current->parent();
+      while (current == next_node->right_) {
         current = next_node;
-        next_node = next_node->parent_;
+        next_node = next_node->parent();
       }
-      return const_cast<RBTNode<Value> *>(next_node);
+      return const_cast<RBTNode<Value, NodePolicy> *>(next_node);
     }
   }
 }
 
 // 中間順木巡回の逆順序での前の節点のポインタを返す
-template <class Value>
-RBTNode<Value> *get_prev_node(const RBTNode<Value> *current) {
-  if (!current->left_->is_nil_node_) {
+template <class Value, class NodePolicy>
+RBTNode<Value, NodePolicy> *get_prev_node(
+    const RBTNode<Value, NodePolicy> *current) {
+  if (current->left_) {
     // currentが左の子を持つ場合は左部分木の中の最大値
     // currentの次に小さい値
     return find_maximum_node(current->left_);
   } else {
-    if (current == current->parent_->left_) {
+    if (current == current->parent()->left_) {
       // currentが親の左の子で, なおかつ左に子を持たない
       // currentが右の子になるまで親を遡る.
-      const RBTNode<Value> *next_node = current->parent_;
-      while (!next_node->is_nil_node_ && current == next_node->left_) {
+      // 最小のノードからは根の親である end_node_ まで遡って止まる.
+      // end_node_ は親を持たない唯一のノードである.
+      const RBTNode<Value, NodePolicy> *next_node = current->parent();
+      while (next_node->parent() && current == next_node->left_) {
         current = next_node;
-        next_node = next_node->parent_;
+        next_node = next_node->parent();
       }
-      return const_cast<RBTNode<Value> *>(next_node);
+      return const_cast<RBTNode<Value, NodePolicy> *>(next_node);
     } else {
       // currentが親の右のノードで, currentが左の子を持たない場合,
       // 次のノードはcurrentの親
-      return const_cast<RBTNode<Value> *>(current->parent_);
+      return const_cast<RBTNode<Value, NodePolicy> *>(current->parent());
     }
   }
 }
 
+// 部分木のノード数を持つ木では, イテレータ間の距離をそれぞれが何番目かの差で
+// 求める. using std::distance; distance(first, last) のように呼べば
+// 引数依存の名前探索でこちらが選ばれる.
+template <class Value, class BasePolicy>
+std::ptrdiff_t distance(
+    rbtree_iterator<Value, rbtree_order_statistic_node_policy<BasePolicy> >
+        first,
+    rbtree_iterator<Value, rbtree_order_statistic_node_policy<BasePolicy> >
+        last) {
+  typedef rbtree_order_statistic_node_policy<BasePolicy> policy_type;
+  return static_cast<std::ptrdiff_t>(policy_type::index_of(last.node_)) -
+         static_cast<std::ptrdiff_t>(policy_type::index_of(first.node_));
+}
+
+template <class Value, class BasePolicy>
+std::ptrdiff_t distance(
+    rbtree_const_iterator<Value,
+                          rbtree_order_statistic_node_policy<BasePolicy> >
+        first,
+    rbtree_const_iterator<Value,
+                          rbtree_order_statistic_node_policy<BasePolicy> >
+        last) {
+  typedef rbtree_order_statistic_node_policy<BasePolicy> policy_type;
+  return static_cast<std::ptrdiff_t>(policy_type::index_of(last.node_)) -
+         static_cast<std::ptrdiff_t>(policy_type::index_of(first.node_));
+}
+
 // Red Black Tree
 //
 // ノードを辿るルールは left < key <= right である.
@@ -301,11 +672,14 @@ RBTNode<Value> *get_prev_node(const RBTNode<Value> *current) {
 // Key: キー
 // Val: ノードに格納するデータ? mapだとpair, setだと_Key.
 // KeyOfValue: _Val型のデータからキーを取り出す
+// NodePolicy: ノードのリンクの持ち方. rbtree_threaded_node_policy を指定すると
+//             ノードが中間順の前後へのリンクを持ち, イテレータの移動が O(1) になる.
 template <class Key, class Value, class KeyOfValue,
-          class Compare = std::less<Key>, class Alloc = std::allocator<Value> >
+          class Compare = std::less<Key>, class Alloc = std::allocator<Value>,
+          class NodePolicy = rbtree_default_node_policy>
 class RedBlackTree {
  public:
-  typedef RBTNode<Value> node_type;
+  typedef RBTNode<Value, NodePolicy> node_type;
   typedef typename Alloc::template rebind<node_type>::other node_allocator;
 
   typedef Key key_type;
@@ -318,8 +692,8 @@ class RedBlackTree {
   typedef ptrdiff_t difference_type;
   typedef Alloc allocator_type;
 
-  typedef rbtree_iterator<value_type> iterator;
-  typedef rbtree_const_iterator<value_type> const_iterator;
+  typedef rbtree_iterator<value_type, NodePolicy> iterator;
+  typedef rbtree_const_iterator<value_type, NodePolicy> const_iterator;
   typedef ft::reverse_iterator<iterator> reverse_iterator;
   typedef ft::reverse_iterator<const_iterator> const_reverse_iterator;
 
@@ -328,38 +702,50 @@ class RedBlackTree {
 #else
  private:
 #endif
+  // Compare が三方比較に対応していれば探索で使う.
+  typedef three_way_compare_traits<Compare, Key> __three_way_traits;
+  typedef integral_constant<bool, __three_way_traits::value>
+      __has_three_way_compare;
+
   // Members
-  node_type *nil_node_;  // point to nil_node_object
+  // 番兵. 値を持たないリンク部分だけを木の中に埋め込んでいる.
+  typename node_type::links_type header_;
   node_type *root_;
   size_type node_count_;
   // begin() と end() を O(1) でアクセスするためにメンバー変数にもたせておく
-  // begin_node_ は常に最小のノードを示す。
-  // end_node_ は左右の子としてroot_を持つ。実体は nil_node_ である。
+  // begin_node_ は常に最小のノードを示す。空の木では end_node_ と同じ。
+  // end_node_ は左の子としてroot_を持ち, 右の子は持たない。実体は header_ である。
   node_type *begin_node_;
+  // 最大のノード. end() を hint にした末尾への挿入を比較1回で判定するのに使う.
+  // 空の木では end_node_ と同じ.
+  node_type *rightmost_node_;
   node_type *end_node_;
   const Compare key_comp_;
   node_allocator node_allocator_;
 
  public:
   // Constructor, Descructor
+  // 空の木はノードを1つも確保しない.
 
   RedBlackTree()
-      : nil_node_(__alloc_nil_node()),
-        root_(nil_node_),
+      : header_(),
+        root_(NULL),
         node_count_(0),
-        begin_node_(nil_node_),
-        end_node_(nil_node_),
+        begin_node_(NULL),
+        rightmost_node_(NULL),
+        end_node_(static_cast<node_type *>(&header_)),
         key_comp_(Compare()),
         node_allocator_() {
     __initialize_empty_tree();
   }
 
   explicit RedBlackTree(const Compare &comp, const Alloc &alloc = Alloc())
-      : nil_node_(__alloc_nil_node()),
-        root_(nil_node_),
+      : header_(),
+        root_(NULL),
         node_count_(0),
-        begin_node_(nil_node_),
-        end_node_(nil_node_),
+        begin_node_(NULL),
+        rightmost_node_(NULL),
+        end_node_(static_cast<node_type *>(&header_)),
         key_comp_(comp),
         node_allocator_(node_allocator(alloc)) {
     __initialize_empty_tree();
@@ -368,11 +754,12 @@ class RedBlackTree {
   template <class InputIt>
   RedBlackTree(InputIt first, InputIt last, const Compare &comp = Compare(),
                const Alloc &alloc = Alloc())
-      : nil_node_(__alloc_nil_node()),
-        root_(nil_node_),
+      : header_(),
+        root_(NULL),
         node_count_(0),
-        begin_node_(nil_node_),
-        end_node_(nil_node_),
+        begin_node_(NULL),
+        rightmost_node_(NULL),
+        end_node_(static_cast<node_type *>(&header_)),
         key_comp_(comp),
         node_allocator_(node_allocator(alloc)) {
     __initialize_empty_tree();
@@ -380,155 +767,237 @@ class RedBlackTree {
   }
 
   RedBlackTree(const RedBlackTree &other)
-      : nil_node_(__alloc_nil_node()),
-        root_(nil_node_),
+      : header_(),
+        root_(NULL),
         node_count_(0),
-        begin_node_(nil_node_),
-        end_node_(nil_node_),
+        begin_node_(NULL),
+        rightmost_node_(NULL),
+        end_node_(static_cast<node_type *>(&header_)),
         key_comp_(Compare()),
         node_allocator_() {
+    __initialize_empty_tree();
     operator=(other);
   }
 
+  // 今あるノードは解放せずに, コピー先として使い回す.
+  // 要素のコピーが例外を投げた場合は空の木になる.
   RedBlackTree &operator=(const RedBlackTree &rhs) {
     if (&rhs != this) {
-      __delete_tree(root_);
-      // ノードをディープコピー
-      root_ = __copy_tree(rhs.root_, rhs.nil_node_);
-
-      begin_node_ = find_minimum_node(root_);
-      if (!root_->is_nil_node_) {
-        root_->parent_ = end_node_;
+      node_type *reusable = __flatten_tree(root_);
+      root_ = NULL;
+      node_count_ = 0;
+      try {
+        // ノードをディープコピー
+        root_ = __copy_tree(rhs.root_, reusable);
+      } catch (...) {
+        __delete_tree(reusable);
+        clear();
+        throw;
       }
-      end_node_->left_ = root_;
-      end_node_->right_ = root_;
+      __delete_tree(reusable);
       node_count_ = rhs.node_count_;
+      begin_node_ = root_ ? find_minimum_node(root_) : end_node_;
+      rightmost_node_ = root_ ? find_maximum_node(root_) : end_node_;
+      __update_end_node();
+      NodePolicy::relink_all_nodes(end_node_);
     }
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  // ノードは付け替えるだけで要素のコピーもムーブもしない.
+  RedBlackTree(RedBlackTree &&other) noexcept
+      : header_(),
+        root_(NULL),
+        node_count_(0),
+        begin_node_(NULL),
+        rightmost_node_(NULL),
+        end_node_(static_cast<node_type *>(&header_)),
+        key_comp_(other.key_comp_),
+        node_allocator_(other.node_allocator_) {
+    __initialize_empty_tree();
+    swap(other);
+  }
+
+  RedBlackTree &operator=(RedBlackTree &&rhs) noexcept {
+    if (&rhs != this) {
+      clear();
+      swap(rhs);
+    }
+    return *this;
+  }
+#endif
+
   ~RedBlackTree() {
     // 全てのノードをdeleteする
-    __delete_tree(root_);
-    __delete_node(nil_node_);
+    __release_tree(root_);
   }
 
   /********** Insert **********/
 
   ft::pair<iterator, bool> insert_unique(const Value &value) {
-    node_type *parent = nil_node_;
-    node_type *current = root_;
-    while (!current->is_nil_node_) {
-      parent = current;
-      if (__are_keys_equal(__get_key_of_value(value),
-                           __get_key_of_value(current->value_))) {
-        return ft::pair<iterator, bool>(iterator(current), false);
-      } else if (__compare_keys(__get_key_of_value(value),
-                                __get_key_of_value(current->value_))) {
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
+    node_type *parent;
+    bool insert_left;
+    node_type *found = __find_insert_pos_unique(__get_key_of_value(value),
+                                                parent, insert_left);
+    if (found) {
+      return ft::pair<iterator, bool>(iterator(found), false);
     }
-    node_type *new_node = __alloc_new_node(value);
-    new_node->parent_ = parent;
-    if (parent->is_nil_node_) {
-      root_ = new_node;
-    } else if (__compare_keys(__get_key_of_value(new_node->value_),
-                              __get_key_of_value(parent->value_))) {
-      parent->left_ = new_node;
-    } else {
-      parent->right_ = new_node;
+    node_type *new_node = __create_node(value);
+    __insert_node_at(parent, insert_left, new_node);
+    return ft::pair<iterator, bool>(iterator(new_node), true);
+  }
+
+  iterator insert_unique(const_iterator hint, const Value &value) {
+    node_type *parent;
+    bool insert_left;
+    node_type *found = __find_insert_pos_unique(
+        hint, __get_key_of_value(value), parent, insert_left);
+    if (found) {
+      return iterator(found);
+    }
+    node_type *new_node = __create_node(value);
+    __insert_node_at(parent, insert_left, new_node);
+    return iterator(new_node);
+  }
+
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert_unique(Value &&value) {
+    return emplace_unique(std::move(value));
+  }
+
+  iterator insert_unique(const_iterator hint, Value &&value) {
+    return emplace_hint_unique(hint, std::move(value));
+  }
+
+  // キーは構築した値からしか取り出せないので, 先にノードを作ってから
+  // 挿入位置を探す. 同じキーが既にあった場合はノードを破棄する.
+  template <class... Args>
+  ft::pair<iterator, bool> emplace_unique(Args &&...args) {
+    node_type *new_node = __create_node(std::forward<Args>(args)...);
+    node_type *parent;
+    bool insert_left;
+    node_type *found;
+    try {
+      found = __find_insert_pos_unique(__get_key_of_value(new_node->value_),
+                                       parent, insert_left);
+    } catch (...) {
+      __delete_node(new_node);
+      throw;
+    }
+    if (found) {
+      __delete_node(new_node);
+      return ft::pair<iterator, bool>(iterator(found), false);
     }
-    __insert_fixup(new_node);
-    __update_tree_info_based_on_new_node(new_node);
+    __insert_node_at(parent, insert_left, new_node);
+    return ft::pair<iterator, bool>(iterator(new_node), true);
+  }
 
+  template <class... Args>
+  iterator emplace_hint_unique(const_iterator hint, Args &&...args) {
+    node_type *new_node = __create_node(std::forward<Args>(args)...);
+    node_type *parent;
+    bool insert_left;
+    node_type *found;
+    try {
+      found = __find_insert_pos_unique(
+          hint, __get_key_of_value(new_node->value_), parent, insert_left);
+    } catch (...) {
+      __delete_node(new_node);
+      throw;
+    }
+    if (found) {
+      __delete_node(new_node);
+      return iterator(found);
+    }
+    __insert_node_at(parent, insert_left, new_node);
+    return iterator(new_node);
+  }
+
+  // key で挿入位置を一度だけ探し, 無い場合だけ args からノード内に値を構築する.
+  // map の try_emplace, insert_or_assign, operator[] で使う.
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              Args &&...args) {
+    node_type *parent;
+    bool insert_left;
+    node_type *found = __find_insert_pos_unique(key, parent, insert_left);
+    if (found) {
+      return ft::pair<iterator, bool>(iterator(found), false);
+    }
+    node_type *new_node = __create_node(std::forward<Args>(args)...);
+    __insert_node_at(parent, insert_left, new_node);
     return ft::pair<iterator, bool>(iterator(new_node), true);
   }
 
-  // Note: const_hint_it のノード情報は書き換えるが value
-  //       は書き換えないのでconstで受け取っている。
-  iterator insert_unique(const_iterator const_hint_it, const Value &value) {
-    iterator hint_it = const_hint_it.cast_nonconst();
-    iterator prev_it = iterator(hint_it);
-    if (hint_it != begin()) {
-      --prev_it;
+  template <class... Args>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   Args &&...args) {
+    node_type *parent;
+    bool insert_left;
+    node_type *found =
+        __find_insert_pos_unique(hint, key, parent, insert_left);
+    if (found) {
+      return ft::pair<iterator, bool>(iterator(found), false);
     }
-    iterator next_it = iterator(hint_it);
-    if (hint_it != end() && hint_it != --(end())) {
-      ++next_it;
+    node_type *new_node = __create_node(std::forward<Args>(args)...);
+    __insert_node_at(parent, insert_left, new_node);
+    return ft::pair<iterator, bool>(iterator(new_node), true);
+  }
+#else
+  // C++98 では可変長引数が使えないので, 値のコンストラクタに渡す引数は2つに限る.
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_unique(const key_type &key,
+                                              const Arg1 &arg1,
+                                              const Arg2 &arg2) {
+    node_type *parent;
+    bool insert_left;
+    node_type *found = __find_insert_pos_unique(key, parent, insert_left);
+    if (found) {
+      return ft::pair<iterator, bool>(iterator(found), false);
     }
+    node_type *new_node = __create_node(arg1, arg2);
+    __insert_node_at(parent, insert_left, new_node);
+    return ft::pair<iterator, bool>(iterator(new_node), true);
+  }
 
-    if (!hint_it.node_->is_nil_node_ &&
-        __are_keys_equal(__get_key_of_value(value),
-                         __get_key_of_value(*hint_it))) {
-      // hint_it == value
-      return iterator(hint_it);
-    } else if (!prev_it.node_->is_nil_node_ &&
-               __are_keys_equal(__get_key_of_value(value),
-                                __get_key_of_value(*prev_it))) {
-      // --hint_it == value
-      return iterator(prev_it);
-    } else if (!next_it.node_->is_nil_node_ &&
-               __are_keys_equal(__get_key_of_value(value),
-                                __get_key_of_value(*next_it))) {
-      // ++hint_it == value
-      return iterator(next_it);
-    } else if (__compare_keys(__get_key_of_value(value),
-                              __get_key_of_value(*hint_it)) &&
-               __compare_keys(__get_key_of_value(*prev_it),
-                              __get_key_of_value(value)) &&
-               hint_it.node_->left_->is_nil_node_) {
-      // --hint_it < value < hint_it なら hint_it の左に挿入
-      node_type *new_node = __alloc_new_node(value);
-      hint_it.node_->left_ = new_node;
-      new_node->parent_ = hint_it.node_;
-      __insert_fixup(new_node);
-      __update_tree_info_based_on_new_node(new_node);
-      return iterator(new_node);
-    } else if (__compare_keys(__get_key_of_value(*hint_it),
-                              __get_key_of_value(value)) &&
-               __compare_keys(__get_key_of_value(value),
-                              __get_key_of_value(*next_it)) &&
-               hint_it.node_->right_->is_nil_node_) {
-      // hint_it < value < ++hint_it なら hint_it の右に挿入
-      node_type *new_node = __alloc_new_node(value);
-      hint_it.node_->right_ = new_node;
-      new_node->parent_ = hint_it.node_;
-      __insert_fixup(new_node);
-      __update_tree_info_based_on_new_node(new_node);
-      return iterator(new_node);
-    } else {
-      // 入れられ無さそうなら普通にルートから入れる場所を探して入れる
-      return insert_unique(value).first;
+  template <class Arg1, class Arg2>
+  ft::pair<iterator, bool> try_emplace_hint_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   const Arg1 &arg1,
+                                                   const Arg2 &arg2) {
+    node_type *parent;
+    bool insert_left;
+    node_type *found =
+        __find_insert_pos_unique(hint, key, parent, insert_left);
+    if (found) {
+      return ft::pair<iterator, bool>(iterator(found), false);
     }
+    node_type *new_node = __create_node(arg1, arg2);
+    __insert_node_at(parent, insert_left, new_node);
+    return ft::pair<iterator, bool>(iterator(new_node), true);
   }
+#endif
 
+  // 空の木にソート済み(キーが狭義単調増加)の範囲を入れる場合は
+  // 平衡な木を O(n) で直接組み立てる. それ以外は1つずつ挿入する.
   template <class InputIt>
   void insert_range_unique(InputIt first, InputIt last) {
-    for (; first != last; ++first) {
-      insert_unique(*first);
-    }
+    __insert_range_unique(
+        first, last, typename iterator_traits<InputIt>::iterator_category());
   }
 
   /********** Search **********/
 
+  // key と同じキーを持つノードを返す. 無い場合は NULL を返す.
   node_type *search_key_node(const Key &key) const {
-    node_type *current = root_;
-    while (!current->is_nil_node_ &&
-           !__are_keys_equal(__get_key_of_value(current->value_), key)) {
-      if (__compare_keys(key, __get_key_of_value(current->value_))) {
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
-    }
-    return current;
+    return __search_key_node(key, __has_three_way_compare());
   }
 
   Value &operator[](const Key &key) const {
     node_type *node = search_key_node(key);
-    if (node->is_nil_node_) {
+    if (node == NULL) {
       throw std::out_of_range("key isn't in the tree.");
     }
     return node->value_;
@@ -589,17 +1058,18 @@ class RedBlackTree {
   /********** Modifiers **********/
 
   void clear() {
-    __delete_tree(root_);
-    root_ = nil_node_;
-    begin_node_ = root_;
+    __release_tree(root_);
+    root_ = NULL;
+    begin_node_ = end_node_;
+    rightmost_node_ = end_node_;
     node_count_ = 0;
+    __update_end_node();
+    NodePolicy::link_end_node(end_node_, begin_node_, rightmost_node_);
   }
 
   void erase(const_iterator pos) {
     __delete_node_from_tree(const_cast<node_type *>(pos.node_));
-    root_->parent_ = end_node_;
-    end_node_->left_ = root_;
-    end_node_->right_ = root_;
+    __update_end_node();
   }
 
   void erase(const_iterator first, const_iterator last) {
@@ -613,112 +1083,125 @@ class RedBlackTree {
   }
 
   size_type erase(const Key &key) {
-    // Search(key) の結果が nil_node だった場合には何もしない
+    // Search(key) の結果が NULL だった場合には何もしない
     node_type *target_node = search_key_node(key);
-    if (target_node->is_nil_node_) {
+    if (target_node == NULL) {
       return 0;
     }
-    if (target_node == begin_node_) {
-      begin_node_ = get_next_node<Value>(target_node);
-    }
     __delete_node_from_tree(target_node);
-    root_->parent_ = end_node_;
-    end_node_->left_ = root_;
-    end_node_->right_ = root_;
+    __update_end_node();
     return 1;
   }
 
+  // 番兵はそれぞれの木に埋め込まれていて入れ替えられないので,
+  // 根だけを入れ替えて自分の番兵に繋ぎ直す.
+  // ノードは確保したアロケータで解放する必要があるので, アロケータも入れ替える.
   void swap(RedBlackTree &other) {
-    std::swap(nil_node_, other.nil_node_);
+    using std::swap;
+    swap(node_allocator_, other.node_allocator_);
     std::swap(root_, other.root_);
     std::swap(node_count_, other.node_count_);
     std::swap(begin_node_, other.begin_node_);
-    std::swap(end_node_, other.end_node_);
+    std::swap(rightmost_node_, other.rightmost_node_);
+    if (root_ == NULL) {
+      begin_node_ = end_node_;
+      rightmost_node_ = end_node_;
+    }
+    if (other.root_ == NULL) {
+      other.begin_node_ = other.end_node_;
+      other.rightmost_node_ = other.end_node_;
+    }
+    __update_end_node();
+    other.__update_end_node();
+    NodePolicy::link_end_node(end_node_, begin_node_, rightmost_node_);
+    NodePolicy::link_end_node(other.end_node_, other.begin_node_,
+                              other.rightmost_node_);
+  }
+
+  /********** Set operations **********/
+  // join と split を組み合わせた集合演算.
+  // 小さい方の要素数を m, 大きい方を n とすると, 比較と木の組み替えは
+  // O(m log(n/m + 1)) で済む. ノードは作り直さずにそのまま使い回す.
+  // 取り除いた要素の破棄には, その数に比例する時間がかかる.
+  // 比較が例外を投げた場合, 木は壊れる.
+  //
+  // fork_join_executor を渡すと, 分けた左右の部分木を並行に処理する.
+  // 比較関数オブジェクトは複数のスレッドから同時に呼ばれる.
+  // ノードの確保と解放は呼び出したスレッドだけで行う.
+
+  // other の要素を全て自分に移す. 同じキーがあれば自分の要素を残す.
+  // other は空になる.
+  void union_unique(RedBlackTree &other) {
+    __union_unique(other, NULL);
+  }
+
+  void union_unique(RedBlackTree &other, const fork_join_executor &executor) {
+    __union_unique(other, &executor);
+  }
+
+  // other に無いキーの要素を取り除く.
+  void intersect_unique(const RedBlackTree &other) {
+    __intersect_unique(other, NULL);
+  }
+
+  void intersect_unique(const RedBlackTree &other,
+                        const fork_join_executor &executor) {
+    __intersect_unique(other, &executor);
+  }
+
+  // other にあるキーの要素を取り除く.
+  void subtract_unique(const RedBlackTree &other) {
+    __subtract_unique(other, NULL);
+  }
+
+  void subtract_unique(const RedBlackTree &other,
+                       const fork_join_executor &executor) {
+    __subtract_unique(other, &executor);
+  }
+
+  // [first, last) を別の木にしてから union_unique() で合わせる.
+  // 木を作る部分は呼び出したスレッドで行い, 合わせる部分を並行に処理する.
+  template <class InputIt>
+  void insert_range_unique(InputIt first, InputIt last,
+                           const fork_join_executor &executor) {
+    RedBlackTree other(first, last, key_comp_, get_allocator());
+    __union_unique(other, &executor);
   }
 
   /********** Lookup **********/
 
   size_type count(const Key &key) const {
-    node_type *node = search_key_node(key);
-    return !node->is_nil_node_;
+    return search_key_node(key) != NULL;
   }
 
   iterator find(const Key &key) {
-    node_type *node = search_key_node(key);
-    if (node->is_nil_node_) {
-      return end();
-    }
-    return iterator(node);
+    return iterator(__node_or_end(search_key_node(key)));
   }
 
   const_iterator find(const Key &key) const {
-    node_type *node = search_key_node(key);
-    if (node->is_nil_node_) {
-      return end();
-    }
-    return const_iterator(node);
+    return const_iterator(__node_or_end(search_key_node(key)));
   }
 
   /* Returns an iterator pointing to the first element that is not less than
    * (i.e. greater or equal to) key.
    */
   iterator lower_bound(const key_type &key) {
-    node_type *current = root_;
-    node_type *low_node = end_node_;
-    while (!current->is_nil_node_) {
-      if (!__compare_keys(__get_key_of_value(current->value_), key)) {
-        low_node = current;
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
-    }
-    return iterator(low_node);
+    return iterator(__lower_bound_node(key));
   }
 
   const_iterator lower_bound(const key_type &key) const {
-    node_type *current = root_;
-    node_type *low_node = end_node_;
-    while (!current->is_nil_node_) {
-      if (!__compare_keys(__get_key_of_value(current->value_), key)) {
-        low_node = current;
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
-    }
-    return const_iterator(low_node);
+    return const_iterator(__lower_bound_node(key));
   }
 
   /* Returns an iterator pointing to the first element that is greater than
   key.
    */
   iterator upper_bound(const key_type &key) {
-    node_type *current = root_;
-    node_type *high_node = end_node_;
-    while (!current->is_nil_node_) {
-      if (__compare_keys(key, __get_key_of_value(current->value_))) {
-        high_node = current;
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
-    }
-    return iterator(high_node);
+    return iterator(__upper_bound_node(key));
   }
 
   const_iterator upper_bound(const key_type &key) const {
-    node_type *current = root_;
-    node_type *high_node = end_node_;
-    while (!current->is_nil_node_) {
-      if (__compare_keys(key, __get_key_of_value(current->value_))) {
-        high_node = current;
-        current = current->left_;
-      } else {
-        current = current->right_;
-      }
-    }
-    return const_iterator(high_node);
+    return const_iterator(__upper_bound_node(key));
   }
 
   ft::pair<iterator, iterator> equal_range(const Key &key) {
@@ -730,12 +1213,151 @@ class RedBlackTree {
                                                     upper_bound(key));
   }
 
+  /* Compare が is_transparent を持つ場合は, キーと比較出来る任意の型で探索する.
+   * key_type の一時オブジェクトを作らずに済む.
+   */
+  template <class K>
+  typename enable_if_transparent<Compare, K, size_type>::type count(
+      const K &key) const {
+    return __search_key_node(key, false_type()) != NULL;
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, iterator>::type find(
+      const K &key) {
+    return iterator(__node_or_end(__search_key_node(key, false_type())));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type find(
+      const K &key) const {
+    return const_iterator(__node_or_end(__search_key_node(key, false_type())));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, iterator>::type lower_bound(
+      const K &key) {
+    return iterator(__lower_bound_node(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type lower_bound(
+      const K &key) const {
+    return const_iterator(__lower_bound_node(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, iterator>::type upper_bound(
+      const K &key) {
+    return iterator(__upper_bound_node(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K, const_iterator>::type upper_bound(
+      const K &key) const {
+    return const_iterator(__upper_bound_node(key));
+  }
+
+  template <class K>
+  typename enable_if_transparent<Compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K &key) {
+    return ft::pair<iterator, iterator>(iterator(__lower_bound_node(key)),
+                                        iterator(__upper_bound_node(key)));
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      Compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K &key) const {
+    return ft::pair<const_iterator, const_iterator>(
+        const_iterator(__lower_bound_node(key)),
+        const_iterator(__upper_bound_node(key)));
+  }
+
+  /********** Batched lookup **********/
+  /* [first, last) の各キーを探した結果をキーの順に out に書き, 書き終えた
+   * 位置を返す. find_many は見つからないキーに end() を書く.
+   * 一度に kBatchLookupWidth 個の探索を1段ずつ交互に進め, 次に読むノードを
+   * 先読みしておくので, 1つの探索がキャッシュミスを待つ間に他の探索が進む.
+   * 探索が終わるまで [first, last) の要素は動かない事.
+   */
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return __lower_bound_many<iterator>(first, last, out, true);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const {
+    return __lower_bound_many<const_iterator>(first, last, out, true);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return __lower_bound_many<iterator>(first, last, out, false);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last,
+                            OutputIt out) const {
+    return __lower_bound_many<const_iterator>(first, last, out, false);
+  }
+
+  /********** Order statistics **********/
+  // NodePolicy が rbtree_order_statistic_node_policy の時だけ使える.
+
+  // k 番目(0 始まり)の要素. k が要素数以上なら end() を返す.
+  iterator nth(size_type k) {
+    return iterator(__node_or_end(NodePolicy::select_node(root_, k)));
+  }
+
+  const_iterator nth(size_type k) const {
+    return const_iterator(__node_or_end(NodePolicy::select_node(root_, k)));
+  }
+
+  // key より小さい要素の数.
+  size_type rank(const Key &key) const {
+    return NodePolicy::index_of(__lower_bound_node(key));
+  }
+
+  // [lo, hi) に入る要素の数.
+  size_type count_range(const Key &lo, const Key &hi) const {
+    if (!__compare_keys(lo, hi)) {
+      return 0;
+    }
+    return rank(hi) - rank(lo);
+  }
+
+  // pos が先頭から何番目か. end() なら要素数.
+  size_type index_of(const_iterator pos) const {
+    return NodePolicy::index_of(pos.node_);
+  }
+
+  /********** Aggregate **********/
+  // NodePolicy が rbtree_augmented_node_policy の時だけ使える.
+
+  // [lo, hi) に入る要素の値を中間順に畳み込んだ値.
+  typename NodePolicy::aggregate_type range_aggregate(const Key &lo,
+                                                      const Key &hi) const;
+
+  // 要素の値を書き換えた後に呼んで, pos から根までの集計値を計算し直す.
+  // 集計しないポリシーでは何もしない.
+  void refresh(const_iterator pos) {
+    NodePolicy::update_path(const_cast<node_type *>(pos.node_), end_node_);
+  }
+
   /********** Observers **********/
 
   Compare key_comp() const {
     return key_comp_;
   }
 
+  // 木の形を使って探索するコンテナ(interval_map など)のために根を返す.
+  // 空の木では NULL.
+  const node_type *root_node() const {
+    return root_;
+  }
+
   /********** Debug **********/
   void print_tree_2D() const {
     __print_tree_2D_util(root_);
@@ -746,7 +1368,7 @@ class RedBlackTree {
   }
 
   int get_height(node_type *current, int count = 0) {
-    if (current->is_nil_node_) {
+    if (current == NULL) {
       return count;
     }
     int left_count = get_height(current->left_, count + 1);
@@ -756,11 +1378,14 @@ class RedBlackTree {
 
   void print_node_info(node_type *node) {
     std::cout << "Key: " << __get_key_of_value(node->value_)
-              << "\n\tValue: " << node->value_ << "\n\tColor: " << node->color_
-              << "\n\tParent: " << __get_key_of_value(node->parent_->value_)
-              << "\n\tLeft: " << __get_key_of_value(node->left_->value_)
-              << "\n\tRight: " << __get_key_of_value(node->right_->value_)
-              << std::endl;
+              << "\n\tValue: " << node->value_ << "\n\tColor: " << node->color()
+              << "\n\tParent: ";
+    __print_node_key(node->parent());
+    std::cout << "\n\tLeft: ";
+    __print_node_key(node->left_);
+    std::cout << "\n\tRight: ";
+    __print_node_key(node->right_);
+    std::cout << std::endl;
   }
 
 #ifdef DEBUG
@@ -774,98 +1399,285 @@ class RedBlackTree {
 
   /********** Debug **********/
   void __print_tree_2D_util(node_type *root, int space = 0) const;
+  void __print_node_key(const node_type *node) const;
 
   /********** TreeOperation **********/
   void __rotate_left(node_type *x);
   void __rotate_right(node_type *x);
 
+  /********** Search **********/
+  template <class K>
+  node_type *__search_key_node(const K &key, false_type) const;
+  node_type *__search_key_node(const key_type &key, true_type) const;
+  template <class K>
+  node_type *__lower_bound_node(const K &key) const;
+  template <class K>
+  node_type *__upper_bound_node(const K &key) const;
+  node_type *__node_or_end(node_type *node) const;
+  // 同時に進める探索の数. 先読みが間に合うだけの数で, 状態はスタックに置く.
+  enum { kBatchLookupWidth = 16 };
+  template <class Iterator, class ForwardIt, class OutputIt>
+  OutputIt __lower_bound_many(ForwardIt first, ForwardIt last, OutputIt out,
+                              bool exact) const;
+
   /********** Insert **********/
+  node_type *__find_insert_pos_unique(const key_type &key, node_type *&parent,
+                                      bool &insert_left) const;
+  node_type *__find_insert_pos_unique(const key_type &key, node_type *&parent,
+                                      bool &insert_left, false_type) const;
+  node_type *__find_insert_pos_unique(const key_type &key, node_type *&parent,
+                                      bool &insert_left, true_type) const;
+  node_type *__find_insert_pos_unique(const_iterator hint,
+                                      const key_type &key, node_type *&parent,
+                                      bool &insert_left);
+  void __insert_node_at(node_type *parent, bool insert_left,
+                        node_type *new_node);
+  template <class InputIt>
+  void __insert_range_unique(InputIt first, InputIt last,
+                             std::input_iterator_tag);
+  template <class ForwardIt>
+  void __insert_range_unique(ForwardIt first, ForwardIt last,
+                             std::forward_iterator_tag);
+  template <class ForwardIt>
+  size_type __count_if_strictly_increasing(ForwardIt first,
+                                           ForwardIt last) const;
+  template <class ForwardIt>
+  node_type *__build_balanced_tree(ForwardIt &first, size_type n,
+                                   size_type depth, size_type red_depth);
   void __insert_fixup(node_type *new_node);
-  void __update_tree_info_based_on_new_node(node_type *new_node);
 
   /********** Delete **********/
   void __delete_transplant(node_type *u, node_type *v);
-  void __delete_fixup(node_type *x);
+  void __delete_fixup(node_type *x, node_type *x_parent);
+
+  /********** Join and split **********/
+  // 木から切り離した部分木と, その黒高さ.
+  // 黒高さは根から葉までの道に含まれる黒ノードの数で, 根が黒なら根も数える.
+  // 葉(NULL)だけの空の部分木の黒高さは 0 である.
+  struct __subtree {
+    node_type *root;
+    size_type black_height;
+
+    __subtree() : root(NULL), black_height(0) {}
+
+    __subtree(node_type *r, size_type h) : root(r), black_height(h) {}
+  };
+
+  static size_type __black_height(const node_type *node);
+  __subtree __detach_root();
+  void __attach_root(const __subtree &tree, size_type count);
+  static void __expose(const __subtree &tree, __subtree &left,
+                       __subtree &right);
+  static node_type *__link_node(node_type *left, node_type *mid,
+                                node_type *right,
+                                typename node_type::Color color);
+  static node_type *__rotate_subtree_left(node_type *x);
+  static node_type *__rotate_subtree_right(node_type *x);
+  static node_type *__join_right(node_type *left, size_type left_height,
+                                 node_type *mid, node_type *right,
+                                 size_type right_height);
+  static node_type *__join_left(node_type *left, size_type left_height,
+                                node_type *mid, node_type *right,
+                                size_type right_height);
+  static __subtree __join(const __subtree &left, node_type *mid,
+                          const __subtree &right);
+  static void __split_last(const __subtree &tree, __subtree &rest,
+                           node_type *&last);
+  static __subtree __join2(const __subtree &left, const __subtree &right);
+  void __split(const __subtree &tree, const key_type &key, __subtree &left,
+               node_type *&found, __subtree &right) const;
+
+  /********** Set operations **********/
+  // 集合演算で取り除いたノードを, 後でまとめて破棄するために繋いだリスト.
+  // 各要素は部分木の根で, 親へのリンクを次の要素へのリンクに使う.
+  struct __node_list {
+    node_type *head;
+    node_type *tail;
+
+    __node_list() : head(NULL), tail(NULL) {}
+
+    void push_back(node_type *node) {
+      node->set_parent(NULL);
+      if (tail) {
+        tail->set_parent(node);
+      } else {
+        head = node;
+      }
+      tail = node;
+    }
+
+    void splice(const __node_list &other) {
+      if (other.head == NULL) {
+        return;
+      }
+      if (tail) {
+        tail->set_parent(other.head);
+      } else {
+        head = other.head;
+      }
+      tail = other.tail;
+    }
+  };
+
+  typedef __subtree (RedBlackTree::*__set_operation)(
+      const __subtree &tree1, const __subtree &tree2, __node_list &removed,
+      const fork_join_executor *executor);
+
+  // 左右の部分木の組に __set_operation を適用するタスク.
+  struct __set_operation_task {
+    RedBlackTree *tree;
+    __set_operation operation;
+    __subtree tree1;
+    __subtree tree2;
+    const fork_join_executor *executor;
+    __subtree result;
+    __node_list removed;
+
+    __set_operation_task(RedBlackTree *t, __set_operation op,
+                         const __subtree &t1, const __subtree &t2,
+                         const fork_join_executor *e)
+        : tree(t), operation(op), tree1(t1), tree2(t2), executor(e) {}
+
+    void operator()() {
+      result = (tree->*operation)(tree1, tree2, removed, executor);
+    }
+  };
+
+  void __union_unique(RedBlackTree &other, const fork_join_executor *executor);
+  void __intersect_unique(const RedBlackTree &other,
+                          const fork_join_executor *executor);
+  void __subtract_unique(const RedBlackTree &other,
+                         const fork_join_executor *executor);
+  static __subtree __const_subtree(const node_type *root);
+  size_type __delete_node_list(const __node_list &list);
+  void __apply_to_halves(__set_operation operation, const __subtree &left1,
+                         const __subtree &left2, const __subtree &right1,
+                         const __subtree &right2, __node_list &removed,
+                         const fork_join_executor *executor, __subtree &left,
+                         __subtree &right);
+  __subtree __union(const __subtree &tree1, const __subtree &tree2,
+                    __node_list &removed, const fork_join_executor *executor);
+  __subtree __intersect(const __subtree &tree1, const __subtree &tree2,
+                        __node_list &removed,
+                        const fork_join_executor *executor);
+  __subtree __subtract(const __subtree &tree1, const __subtree &tree2,
+                       __node_list &removed,
+                       const fork_join_executor *executor);
 
   /********** Node operations **********/
   void __delete_node_from_tree(node_type *z);
-  void __delete_tree(node_type *root);
+  size_type __delete_tree(node_type *root);
+  void __release_tree(node_type *root);
+  void __release_tree(node_type *root, true_type);
+  void __release_tree(node_type *root, false_type);
   void __delete_node(node_type *z);
-  node_type *__copy_tree(node_type *other_root, node_type *other_nil_node);
-  node_type *__alloc_new_node(value_type value);
-  node_type *__alloc_nil_node();
-  node_type *__copy_node(const node_type *z, const node_type *nil_node);
+  static node_type *__flatten_tree(node_type *root);
+  node_type *__copy_tree(const node_type *other_root, node_type *&reusable);
+#if __cplusplus >= 201103L
+  template <class... Args>
+  node_type *__create_node(Args &&...args);
+#else
+  template <class Arg>
+  node_type *__create_node(const Arg &arg);
+  template <class Arg1, class Arg2>
+  node_type *__create_node(const Arg1 &arg1, const Arg2 &arg2);
+#endif
+  node_type *__allocate_node_with_links();
+  void __deallocate_node_with_links(node_type *node);
+  node_type *__copy_node(const node_type *z, node_type *&reusable);
+  void __update_end_node();
+  static bool __is_black(const node_type *node);
 
   /********** Comparisons **********/
   bool __are_keys_equal(const key_type &key1, const key_type &key2) const;
   bool __compare_keys(const key_type &key1, const key_type &key2) const;
-  const key_type __get_key_of_value(const value_type &value) const;
+  int __compare_keys_three_way(const key_type &key1,
+                               const key_type &key2) const;
+  // 比較の度にキーをコピーしないように, value 内のキーへの参照を返す.
+  // KeyOfValue (Select1st, Identity) も参照を返す必要がある.
+  const key_type &__get_key_of_value(const value_type &value) const;
 };
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator==(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator==(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &lhs,
+                const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &rhs) {
   return lhs.size() == rhs.size() &&
          ft::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator!=(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator!=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &lhs,
+                const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &rhs) {
   return !(lhs == rhs);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator<(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
-  typedef RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> tree_type;
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator<(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                  NodePolicy> &lhs,
+               const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                  NodePolicy> &rhs) {
+  typedef RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>
+      tree_type;
   typedef typename tree_type::const_iterator const_iterator;
 
   return ft::lexicographical_compare<const_iterator, const_iterator>(
       lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator<=(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator<=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &lhs,
+                const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &rhs) {
   return !(lhs > rhs);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator>(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator>(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                  NodePolicy> &lhs,
+               const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                  NodePolicy> &rhs) {
   return rhs < lhs;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool operator>=(
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &lhs,
-    const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc> &rhs) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool operator>=(const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &lhs,
+                const RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                                   NodePolicy> &rhs) {
   return !(lhs < rhs);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare,
-                  Alloc>::__initialize_empty_tree() {
-  nil_node_->parent_ = nil_node_;
-  nil_node_->left_ = nil_node_;
-  nil_node_->right_ = nil_node_;
-  nil_node_->color_ = node_type::BLACK;
-
-  begin_node_ = root_;
-  end_node_->left_ = root_;
-  end_node_->right_ = root_;
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__initialize_empty_tree() {
+  header_.parent_and_color_ = 0;  // 親は無く, 色は黒
+  header_.right_ = NULL;
+
+  root_ = NULL;
+  begin_node_ = end_node_;
+  rightmost_node_ = end_node_;
+  __update_end_node();
+  NodePolicy::link_end_node(end_node_, begin_node_, rightmost_node_);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__print_tree_2D_util(
-    node_type *root, int space) const {
-  if (root->is_nil_node_)
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__print_tree_2D_util(node_type *root,
+                                                    int space) const {
+  if (root == NULL)
     return;
 
   space += 10;
@@ -877,12 +1689,24 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__print_tree_2D_util(
   std::cout << std::endl;
   for (int i = 10; i < space; i++) std::cout << " ";
   std::cout << __get_key_of_value(root->value_)
-            << (root->color_ == node_type::RED ? "(R)" : "(B)") << std::endl;
+            << (root->color() == node_type::RED ? "(R)" : "(B)") << std::endl;
 
   // print left
   __print_tree_2D_util(root->left_, space);
 }
 
+// 葉(NULL)と end_node_ は値を持たないので NIL と表示する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__print_node_key(const node_type *node) const {
+  if (node == NULL || node == end_node_) {
+    std::cout << "NIL";
+  } else {
+    std::cout << __get_key_of_value(node->value_);
+  }
+}
+
 /*
  * RotateLeft
  *
@@ -898,28 +1722,32 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__print_tree_2D_util(
  *         /  \                           /  \
  *        14  19                         9   14
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_left(
-    node_type *x) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__rotate_left(node_type *x) {
   node_type *y = x->right_;  // y を x の右の子とする.
   x->right_ = y->left_;      // y の左部分木を x の右部分木にする.
-  if (!y->left_->is_nil_node_) {
+  if (y->left_) {
     // yの左の子の親が左回転後のxになるようにする
-    y->left_->parent_ = x;
+    y->left_->set_parent(x);
   }
-  y->parent_ = x->parent_;  // xの親をyにする
+  y->set_parent(x->parent());  // xの親をyにする
   // xの親の左右どちらにyを付けるか
-  if (x->parent_->is_nil_node_) {
+  if (x->parent() == end_node_) {
     // xが根だった場合
     root_ = y;
-  } else if (x == x->parent_->left_) {
-    x->parent_->left_ = y;
+  } else if (x == x->parent()->left_) {
+    x->parent()->left_ = y;
   } else {
-    x->parent_->right_ = y;
+    x->parent()->right_ = y;
   }
   // xをyの左の子とする.
   y->left_ = x;
-  x->parent_ = y;
+  x->set_parent(y);
+  // 部分木が変わるのは x と y だけで, y は x を子に持つので x から計算する.
+  NodePolicy::update_node(x);
+  NodePolicy::update_node(y);
 }
 
 /* RotateRight
@@ -936,28 +1764,524 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_left(
  *  /  \                                     / \
  * 2    5                                   5   8
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_right(
-    node_type *x) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__rotate_right(node_type *x) {
   node_type *y = x->left_;  // y を x の左の子とする.
   x->left_ = y->right_;     // y の右部分木を x の左部分木にする.
-  if (!y->right_->is_nil_node_) {
+  if (y->right_) {
     // yの右の子の親が右回転後のxになるようにする
-    y->right_->parent_ = x;
+    y->right_->set_parent(x);
   }
-  y->parent_ = x->parent_;  // xの親をyにする
+  y->set_parent(x->parent());  // xの親をyにする
   // xの親の左右どちらにyを付けるか
-  if (x->parent_->is_nil_node_) {
+  if (x->parent() == end_node_) {
     // xが根だった場合
     root_ = y;
-  } else if (x == x->parent_->right_) {
-    x->parent_->right_ = y;
+  } else if (x == x->parent()->right_) {
+    x->parent()->right_ = y;
   } else {
-    x->parent_->left_ = y;
+    x->parent()->left_ = y;
   }
   // xをyの右の子とする.
   y->right_ = x;
-  x->parent_ = y;
+  x->set_parent(y);
+  NodePolicy::update_node(x);
+  NodePolicy::update_node(y);
+}
+
+// lo と hi の間で左右に分かれるノードを探し, そこから lo 側と hi 側の境界を
+// 辿りながら, 範囲に完全に入る部分木の集計値を拾っていく.
+// どちらの境界も木の高さ分しか辿らない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename NodePolicy::aggregate_type
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::range_aggregate(const Key &lo, const Key &hi) const {
+  typedef typename NodePolicy::aggregate_type aggregate_type;
+
+  const node_type *split = root_;
+  while (split) {
+    const key_type &key = __get_key_of_value(split->value_);
+    if (__compare_keys(key, lo)) {
+      split = split->right_;
+    } else if (!__compare_keys(key, hi)) {
+      split = split->left_;
+    } else {
+      break;
+    }
+  }
+  if (split == NULL) {
+    return NodePolicy::identity();
+  }
+
+  // lo 以上の部分. 左に降りる時に, そのノードと右部分木を前に足す.
+  aggregate_type lo_side = NodePolicy::identity();
+  for (const node_type *node = split->left_; node;) {
+    if (__compare_keys(__get_key_of_value(node->value_), lo)) {
+      node = node->right_;
+    } else {
+      lo_side = NodePolicy::combine(
+          NodePolicy::combine(NodePolicy::value_of(node->value_),
+                              NodePolicy::aggregate_of(node->right_)),
+          lo_side);
+      node = node->left_;
+    }
+  }
+  // hi 未満の部分. 右に降りる時に, 左部分木とそのノードを後ろに足す.
+  aggregate_type hi_side = NodePolicy::identity();
+  for (const node_type *node = split->right_; node;) {
+    if (__compare_keys(__get_key_of_value(node->value_), hi)) {
+      hi_side = NodePolicy::combine(
+          hi_side, NodePolicy::combine(NodePolicy::aggregate_of(node->left_),
+                                       NodePolicy::value_of(node->value_)));
+      node = node->right_;
+    } else {
+      node = node->left_;
+    }
+  }
+  return NodePolicy::combine(
+      NodePolicy::combine(lo_side, NodePolicy::value_of(split->value_)),
+      hi_side);
+}
+
+// 各段で1回だけ比較して key 以上の最小のノードを探し,
+// 一致するかどうかは最後に1回だけ確かめる.
+// key はキーと比較出来る型なら良いので, 比較は key_comp_ で直接行う.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class K>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__search_key_node(const K &key, false_type) const {
+  node_type *low_node = __lower_bound_node(key);
+  if (low_node == end_node_ ||
+      key_comp_(key, __get_key_of_value(low_node->value_))) {
+    return NULL;
+  }
+  return low_node;
+}
+
+// 三方比較が出来る場合は一致した時点で探索を終える.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__search_key_node(const key_type &key,
+                                            true_type) const {
+  node_type *current = root_;
+  while (current) {
+    const int result =
+        __compare_keys_three_way(key, __get_key_of_value(current->value_));
+    if (result == 0) {
+      return current;
+    }
+    current = result < 0 ? current->left_ : current->right_;
+  }
+  return NULL;
+}
+
+// key 以上の最小のノードを返す. 無い場合は end_node_ を返す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class K>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__lower_bound_node(const K &key) const {
+  node_type *current = root_;
+  node_type *low_node = end_node_;
+  while (current) {
+    if (!key_comp_(__get_key_of_value(current->value_), key)) {
+      low_node = current;
+      current = current->left_;
+    } else {
+      current = current->right_;
+    }
+  }
+  return low_node;
+}
+
+// key より大きい最小のノードを返す. 無い場合は end_node_ を返す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class K>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__upper_bound_node(const K &key) const {
+  node_type *current = root_;
+  node_type *high_node = end_node_;
+  while (current) {
+    if (key_comp_(key, __get_key_of_value(current->value_))) {
+      high_node = current;
+      current = current->left_;
+    } else {
+      current = current->right_;
+    }
+  }
+  return high_node;
+}
+
+// __lower_bound_node と同じ探索を, kBatchLookupWidth 個のキーについて
+// 1段ずつ順番に進める. 各探索は次のノードを先読みしてから他の探索に譲るので,
+// そのノードを読む頃にはキャッシュに届いている.
+// exact が真なら, key と一致しない結果を end に置き換える.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class Iterator, class ForwardIt, class OutputIt>
+OutputIt RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__lower_bound_many(ForwardIt first,
+                                                      ForwardIt last,
+                                                      OutputIt out,
+                                                      bool exact) const {
+  typedef typename iterator_traits<ForwardIt>::value_type search_key_type;
+
+  const search_key_type *keys[kBatchLookupWidth];
+  node_type *current[kBatchLookupWidth];
+  node_type *low_node[kBatchLookupWidth];
+  while (first != last) {
+    size_type width = 0;
+    for (; width < kBatchLookupWidth && first != last; ++width, ++first) {
+      keys[width] = &*first;
+      current[width] = root_;
+      low_node[width] = end_node_;
+    }
+    FT_PREFETCH(root_);
+
+    // 全ての探索が葉に着くまで, 各探索を1段ずつ進める.
+    for (size_type active = width; active != 0;) {
+      active = 0;
+      for (size_type i = 0; i < width; ++i) {
+        node_type *node = current[i];
+        if (node == NULL) {
+          continue;
+        }
+        if (!key_comp_(__get_key_of_value(node->value_), *keys[i])) {
+          low_node[i] = node;
+          node = node->left_;
+        } else {
+          node = node->right_;
+        }
+        if (node != NULL) {
+          FT_PREFETCH(node);
+          ++active;
+        }
+        current[i] = node;
+      }
+    }
+
+    for (size_type i = 0; i < width; ++i, ++out) {
+      node_type *node = low_node[i];
+      if (exact && node != end_node_ &&
+          key_comp_(*keys[i], __get_key_of_value(node->value_))) {
+        node = end_node_;
+      }
+      *out = Iterator(node);
+    }
+  }
+  return out;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__node_or_end(node_type *node) const {
+  return node ? node : end_node_;
+}
+
+// key を挿入する位置を根から探す.
+// 同じキーを持つノードが既にある場合はそのノードを返す.
+// 無い場合は NULL を返し, parent に新しいノードの親になるノードを,
+// insert_left にその左右どちらの子になるかを設定する.
+// 木が空の場合の parent は end_node_ になる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__find_insert_pos_unique(const key_type &key,
+                                                   node_type *&parent,
+                                                   bool &insert_left) const {
+  return __find_insert_pos_unique(key, parent, insert_left,
+                                  __has_three_way_compare());
+}
+
+// 各段では key < current かどうかだけで左右を決めて葉まで降りる.
+// 同じキーのノードがあるとすれば, それは降りた先の直前のノードなので
+// 最後にそのノードとだけ比較する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__find_insert_pos_unique(const key_type &key,
+                                                   node_type *&parent,
+                                                   bool &insert_left,
+                                                   false_type) const {
+  parent = end_node_;
+  node_type *current = root_;
+  bool go_left = true;
+  while (current) {
+    parent = current;
+    go_left = __compare_keys(key, __get_key_of_value(current->value_));
+    current = go_left ? current->left_ : current->right_;
+  }
+  insert_left = go_left;
+
+  node_type *prev_node = parent;
+  if (go_left) {
+    if (parent == end_node_) {
+      return NULL;
+    }
+    // parent が最小のノードなら直前は end_node_ になる
+    prev_node = NodePolicy::prev_node(parent);
+    if (prev_node == end_node_) {
+      return NULL;
+    }
+  }
+  if (__compare_keys(__get_key_of_value(prev_node->value_), key)) {
+    return NULL;
+  }
+  return prev_node;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__find_insert_pos_unique(const key_type &key,
+                                                   node_type *&parent,
+                                                   bool &insert_left,
+                                                   true_type) const {
+  parent = end_node_;
+  insert_left = true;
+  node_type *current = root_;
+  while (current) {
+    const int result =
+        __compare_keys_three_way(key, __get_key_of_value(current->value_));
+    if (result == 0) {
+      return current;
+    }
+    parent = current;
+    insert_left = result < 0;
+    current = insert_left ? current->left_ : current->right_;
+  }
+  return NULL;
+}
+
+// hint の前後を見て key を挿入する位置を探す.
+// 戻り値と parent の意味は hint を取らない方と同じ.
+// hint の直前に入る場合は比較2回, 直後に入る場合は3回で, 左右も含めて決まる.
+// 特に end() を hint にした末尾への追加と begin() を hint にした先頭への追加は
+// rightmost_node_, begin_node_ との比較1回で決まる.
+// 入らない場合は根から探し直す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__find_insert_pos_unique(const_iterator hint,
+                                                   const key_type &key,
+                                                   node_type *&parent,
+                                                   bool &insert_left) {
+  node_type *hint_node = const_cast<node_type *>(hint.node_);
+
+  // end_node_ は値を持たないので参照する前に必ず確認する.
+  if (hint_node == end_node_) {
+    if (rightmost_node_ != end_node_ &&
+        __compare_keys(__get_key_of_value(rightmost_node_->value_), key)) {
+      // 最大のノードの右に追加
+      parent = rightmost_node_;
+      insert_left = false;
+      return NULL;
+    }
+    return __find_insert_pos_unique(key, parent, insert_left);
+  }
+
+  if (__compare_keys(key, __get_key_of_value(hint_node->value_))) {
+    // key < hint
+    if (hint_node == begin_node_) {
+      // 最小のノードの左に追加
+      parent = hint_node;
+      insert_left = true;
+      return NULL;
+    }
+    node_type *prev_node = NodePolicy::prev_node(hint_node);
+    if (__compare_keys(__get_key_of_value(prev_node->value_), key)) {
+      // prev < key < hint. prev の右か hint の左のどちらかは空いている.
+      insert_left = prev_node->right_ != NULL;
+      parent = insert_left ? hint_node : prev_node;
+      return NULL;
+    }
+  } else if (__compare_keys(__get_key_of_value(hint_node->value_), key)) {
+    // hint < key
+    if (hint_node == rightmost_node_) {
+      parent = hint_node;
+      insert_left = false;
+      return NULL;
+    }
+    node_type *next_node = NodePolicy::next_node(hint_node);
+    if (__compare_keys(key, __get_key_of_value(next_node->value_))) {
+      // hint < key < next. hint の右か next の左のどちらかは空いている.
+      insert_left = hint_node->right_ != NULL;
+      parent = insert_left ? next_node : hint_node;
+      return NULL;
+    }
+  } else {
+    // hint == key
+    return hint_node;
+  }
+  // hint の隣に入らないなら普通にルートから入れる場所を探す
+  return __find_insert_pos_unique(key, parent, insert_left);
+}
+
+// __find_insert_pos_unique() で見つけた parent の insert_left 側の子として
+// new_node を繋ぐ. 左右は探索中に決まっているので比較はしない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__insert_node_at(node_type *parent,
+                                                bool insert_left,
+                                                node_type *new_node) {
+  new_node->set_parent(parent);
+  // 最小, 最大のノードの子になる場合だけ begin_node_, rightmost_node_ が変わる.
+  if (parent == end_node_) {
+    root_ = new_node;
+    begin_node_ = new_node;
+    rightmost_node_ = new_node;
+  } else if (insert_left) {
+    parent->left_ = new_node;
+    if (parent == begin_node_) {
+      begin_node_ = new_node;
+    }
+  } else {
+    parent->right_ = new_node;
+    if (parent == rightmost_node_) {
+      rightmost_node_ = new_node;
+    }
+  }
+  NodePolicy::link_inserted_node(new_node, parent, insert_left);
+  NodePolicy::update_path(new_node, end_node_);
+  __insert_fixup(new_node);
+  // end_node_ の子が新たなルートを指すようにする
+  __update_end_node();
+  ++node_count_;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class InputIt>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__insert_range_unique(InputIt first,
+                                                     InputIt last,
+                                                     std::input_iterator_tag) {
+  for (; first != last; ++first) {
+    insert_unique(*first);
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class ForwardIt>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__insert_range_unique(
+    ForwardIt first, ForwardIt last, std::forward_iterator_tag) {
+  const size_type n =
+      root_ == NULL ? __count_if_strictly_increasing(first, last) : 0;
+  if (n == 0) {
+    __insert_range_unique(first, last, std::input_iterator_tag());
+    return;
+  }
+
+  // 中央の要素を根にして左右に分けていくと, 最後の段以外は全て埋まる.
+  // 最後の段(深さ floor(log2(n + 1)))のノードだけを赤にすれば,
+  // どの葉までの道の黒ノード数も等しくなる.
+  size_type red_depth = 0;
+  while ((n + 1) >> (red_depth + 1)) {
+    ++red_depth;
+  }
+  root_ = __build_balanced_tree(first, n, 0, red_depth);
+  node_count_ = n;
+  begin_node_ = find_minimum_node(root_);
+  rightmost_node_ = find_maximum_node(root_);
+  __update_end_node();
+  NodePolicy::relink_all_nodes(end_node_);
+}
+
+// [first, last) のキーが狭義単調増加ならその要素数を, そうでなければ 0 を返す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class ForwardIt>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::size_type
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__count_if_strictly_increasing(ForwardIt first,
+                                                         ForwardIt last) const {
+  if (first == last) {
+    return 0;
+  }
+  size_type n = 1;
+  ForwardIt prev = first;
+  for (++first; first != last; ++first, ++prev, ++n) {
+    if (!__compare_keys(__get_key_of_value(*prev),
+                        __get_key_of_value(*first))) {
+      return 0;
+    }
+  }
+  return n;
+}
+
+// first から n 個の要素で部分木を作り, first を n 個進める.
+// 要素は中間順に読むので, 前から順に1回ずつしか参照しない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class ForwardIt>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__build_balanced_tree(ForwardIt &first, size_type n,
+                                                size_type depth,
+                                                size_type red_depth) {
+  if (n == 0) {
+    return NULL;
+  }
+  const size_type left_n = (n - 1) / 2;
+  node_type *left = __build_balanced_tree(first, left_n, depth + 1, red_depth);
+  node_type *node;
+  try {
+    node = __create_node(*first);
+  } catch (...) {
+    __delete_tree(left);
+    throw;
+  }
+  ++first;
+  node_type *right;
+  try {
+    right = __build_balanced_tree(first, n - 1 - left_n, depth + 1, red_depth);
+  } catch (...) {
+    __delete_tree(left);
+    __delete_node(node);
+    throw;
+  }
+
+  node->set_color(depth == red_depth ? node_type::RED : node_type::BLACK);
+  node->left_ = left;
+  node->right_ = right;
+  if (left) {
+    left->set_parent(node);
+  }
+  if (right) {
+    right->set_parent(node);
+  }
+  NodePolicy::update_node(node);
+  return node;
 }
 
 /* 挿入時にRBTreeの2色条件を維持するための関数
@@ -1010,78 +2334,63 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__rotate_right(
  *                                              \
  *                                               u_B
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__insert_fixup(
-    node_type *new_node) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__insert_fixup(node_type *new_node) {
   // 新しいノードは赤色であり, 赤ノードは赤ノードを子に持つことは出来ない.
-  while (new_node->parent_->color_ == node_type::RED) {
-    if (new_node->parent_ == new_node->parent_->parent_->left_) {
+  while (new_node->parent()->color() == node_type::RED) {
+    if (new_node->parent() == new_node->parent()->parent()->left_) {
       // 新しいノードの親は祖父の左の子
       // 叔父ノード
-      node_type *uncle_node = new_node->parent_->parent_->right_;
-      if (uncle_node->color_ == node_type::RED) {
+      node_type *uncle_node = new_node->parent()->parent()->right_;
+      if (!__is_black(uncle_node)) {
         // 修正パターン1: 親と叔父ノードが赤色
         // 親と叔父ノードを黒にし, 祖父を赤にする.
-        new_node->parent_->color_ = node_type::BLACK;
-        uncle_node->color_ = node_type::BLACK;
-        new_node->parent_->parent_->color_ = node_type::RED;
-        new_node = new_node->parent_->parent_;
+        new_node->parent()->set_color(node_type::BLACK);
+        uncle_node->set_color(node_type::BLACK);
+        new_node->parent()->parent()->set_color(node_type::RED);
+        new_node = new_node->parent()->parent();
       } else {
         // 修正パターン3 の後半部分の処理は パターン2 と同じなのでまとめられる
 
-        if (new_node == new_node->parent_->right_) {
+        if (new_node == new_node->parent()->right_) {
           // 修正パターン3: 叔父ノードが黒色 + 挿入するノードが親の右の子
-          new_node = new_node->parent_;
+          new_node = new_node->parent();
           __rotate_left(new_node);
         }
         // 修正パターン2: 叔父ノードが黒色 + 挿入するノードが親の左の子
-        new_node->parent_->color_ = node_type::BLACK;
-        new_node->parent_->parent_->color_ = node_type::RED;
-        __rotate_right(new_node->parent_->parent_);
+        new_node->parent()->set_color(node_type::BLACK);
+        new_node->parent()->parent()->set_color(node_type::RED);
+        __rotate_right(new_node->parent()->parent());
       }
     } else {
       // 新しいノードの親は祖父の右の子
       // 叔父ノード
-      node_type *uncle_node = new_node->parent_->parent_->left_;
-      if (uncle_node->color_ == node_type::RED) {
+      node_type *uncle_node = new_node->parent()->parent()->left_;
+      if (!__is_black(uncle_node)) {
         // 修正パターン1: 親と叔父ノードが赤色
         // 親と叔父ノードを黒にし, 祖父を赤にする.
-        new_node->parent_->color_ = node_type::BLACK;
-        uncle_node->color_ = node_type::BLACK;
-        new_node->parent_->parent_->color_ = node_type::RED;
-        new_node = new_node->parent_->parent_;
+        new_node->parent()->set_color(node_type::BLACK);
+        uncle_node->set_color(node_type::BLACK);
+        new_node->parent()->parent()->set_color(node_type::RED);
+        new_node = new_node->parent()->parent();
       } else {
         // 修正パターン3 の後半部分の処理は パターン2 と同じなのでまとめられる
 
-        if (new_node == new_node->parent_->left_) {
+        if (new_node == new_node->parent()->left_) {
           // 修正パターン3: 叔父ノードが黒色 + 挿入するノードが親の左の子
-          new_node = new_node->parent_;
+          new_node = new_node->parent();
           __rotate_right(new_node);
         }
         // 修正パターン2: 叔父ノードが黒色 + 挿入するノードが親の右の子
-        new_node->parent_->color_ = node_type::BLACK;
-        new_node->parent_->parent_->color_ = node_type::RED;
-        __rotate_left(new_node->parent_->parent_);
+        new_node->parent()->set_color(node_type::BLACK);
+        new_node->parent()->parent()->set_color(node_type::RED);
+        __rotate_left(new_node->parent()->parent());
       }
     }
   }
-  root_->color_ = node_type::BLACK;
-}
-
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::
-    __update_tree_info_based_on_new_node(node_type *new_node) {
-  // begin_node_ の更新
-  if (begin_node_->is_nil_node_ ||
-      __compare_keys(__get_key_of_value(new_node->value_),
-                     __get_key_of_value(begin_node_->value_))) {
-    begin_node_ = new_node;
-  }
-  // end_node_ の子が新たなルートを指すようにする
-  root_->parent_ = end_node_;
-  end_node_->left_ = root_;
-  end_node_->right_ = root_;
-  ++node_count_;
+  root_->set_color(node_type::BLACK);
 }
 
 /* ノードの削除
@@ -1137,46 +2446,58 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::
  *                                       /
  *                                      3
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare,
-                  Alloc>::__delete_node_from_tree(node_type *z) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__delete_node_from_tree(node_type *z) {
   // yがもともと置かれていた場所に移動する節点
+  // 葉は NULL なので x が NULL になることもある. そのため親を別に覚えておく.
   node_type *x;
+  node_type *x_parent;
   // 木からの削除あるいは木の中の移動が想定される節点.
   // zの子が1つの場合は削除対象, zの子が2つの場合は移動対象.
   node_type *y = z;
   // 節点yを再彩色する可能性があるので元の色を保持する.
   // yの代入直後のyの色を覚えておく.
-  typename node_type::Color y_original_color = y->color_;
+  typename node_type::Color y_original_color = y->color();
 
-  if (z->left_->is_nil_node_) {
+  if (z == begin_node_) {
+    begin_node_ = NodePolicy::next_node(z);
+  }
+  if (z == rightmost_node_) {
+    rightmost_node_ = NodePolicy::prev_node(z);
+  }
+  NodePolicy::unlink_node(z);
+  if (z->left_ == NULL) {
     x = z->right_;
+    x_parent = z->parent();
     __delete_transplant(z, z->right_);
-  } else if (z->right_->is_nil_node_) {
+  } else if (z->right_ == NULL) {
     x = z->left_;
+    x_parent = z->parent();
     __delete_transplant(z, z->left_);
   } else {
     // 削除ノードが2つ子を持つ場合
     y = find_minimum_node(z->right_);
-    y_original_color = y->color_;
+    y_original_color = y->color();
     x = y->right_;
-    if (y->parent_ == z) {
+    if (y->parent() == z) {
       // 削除ノードの右の子が次節点の場合
-      x->parent_ = y;
+      x_parent = y;
     } else {
+      x_parent = y->parent();
       __delete_transplant(y, y->right_);
       y->right_ = z->right_;
-      y->right_->parent_ = y;
+      y->right_->set_parent(y);
     }
     __delete_transplant(z, y);
     y->left_ = z->left_;
-    y->left_->parent_ = y;
-    y->color_ = z->color_;
-  }
-  if (z == begin_node_) {
-    begin_node_ = get_next_node<Value>(z);
+    y->left_->set_parent(y);
+    y->set_color(z->color());
   }
   __delete_node(z);
+  // 部分木が変わったのは x_parent から根までのノードである.
+  NodePolicy::update_path(x_parent, end_node_);
 
   if (y_original_color == node_type::BLACK) {
     // yが黒ならば, Deleteの操作によって2色条件が崩れた可能性がある.
@@ -1198,7 +2519,7 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare,
     //    元々yを含んでいた単純道の黒節点数が1減少する可能性がある.
     //    これは2色条件その5(任意のノードは子孫の葉までに含まれる黒節点数は一定である)
     //    に違反する.
-    __delete_fixup(x);
+    __delete_fixup(x, x_parent);
   }
   node_count_--;
 }
@@ -1206,18 +2527,21 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare,
 // ある節点の子であるuを根とする部分木を別の節点の子のvを根とする部分木に置き換える.
 // v.left_, v.right_ に対しては変更を行わないので注意.
 // ノードを削除する際に使う
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__delete_transplant(
-    node_type *u, node_type *v) {
-  if (u->parent_->is_nil_node_) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__delete_transplant(node_type *u, node_type *v) {
+  if (u->parent() == end_node_) {
     // uが根のとき
     root_ = v;
-  } else if (u == u->parent_->left_) {
-    u->parent_->left_ = v;
+  } else if (u == u->parent()->left_) {
+    u->parent()->left_ = v;
   } else {
-    u->parent_->right_ = v;
+    u->parent()->right_ = v;
+  }
+  if (v) {
+    v->set_parent(u->parent());
   }
-  v->parent_ = u->parent_;
 }
 
 /* ノード削除によって2色条件が違反が発生したか調べ, 発生していたら修正する.
@@ -1290,168 +2614,898 @@ void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__delete_transplant(
  *                      /   \
  *                    x_B   l_B
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__delete_fixup(
-    node_type *x) {
-  while (x != root_ && x->color_ == node_type::BLACK) {
-    if (x == x->parent_->left_) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__delete_fixup(node_type *x,
+                                              node_type *x_parent) {
+  // x は NULL(黒の葉)のこともあるので, 親は x_parent で辿る.
+  while (x != root_ && __is_black(x)) {
+    if (x == x_parent->left_) {
       // 兄弟ノード
-      node_type *w = x->parent_->right_;
-      if (w->color_ == node_type::RED) {
+      node_type *w = x_parent->right_;
+      if (w->color() == node_type::RED) {
         // 修正パターン1: 兄弟が赤
-        w->color_ = node_type::BLACK;
-        x->parent_->color_ = node_type::RED;
-        __rotate_left(x->parent_);
-        w = x->parent_->right_;
+        w->set_color(node_type::BLACK);
+        x_parent->set_color(node_type::RED);
+        __rotate_left(x_parent);
+        w = x_parent->right_;
       }
-      if (w->left_->color_ == node_type::BLACK &&
-          w->right_->color_ == node_type::BLACK) {
+      if (__is_black(w->left_) && __is_black(w->right_)) {
         // 修正パターン2: 兄弟が黒 + 兄弟の子が両方黒
-        w->color_ = node_type::RED;
-        x = x->parent_;
+        w->set_color(node_type::RED);
+        x = x_parent;
+        x_parent = x_parent->parent();
       } else {
-        if (w->right_->color_ == node_type::BLACK) {
+        if (__is_black(w->right_)) {
           // 修正パターン3: 兄弟が黒 + 兄弟の左の子が赤, 右の子が黒
-          w->left_->color_ = node_type::BLACK;
-          w->color_ = node_type::RED;
+          w->left_->set_color(node_type::BLACK);
+          w->set_color(node_type::RED);
           __rotate_right(w);
-          w = x->parent_->right_;
+          w = x_parent->right_;
         }
         // 修正パターン4: 兄弟が黒 + 兄弟の右の子が赤
-        w->color_ = x->parent_->color_;
-        x->parent_->color_ = node_type::BLACK;
-        w->right_->color_ = node_type::BLACK;
-        __rotate_left(x->parent_);
+        w->set_color(x_parent->color());
+        x_parent->set_color(node_type::BLACK);
+        w->right_->set_color(node_type::BLACK);
+        __rotate_left(x_parent);
         x = root_;
       }
     } else {
       // 兄弟ノード
-      node_type *w = x->parent_->left_;
-      if (w->color_ == node_type::RED) {
+      node_type *w = x_parent->left_;
+      if (w->color() == node_type::RED) {
         // 修正パターン1: 兄弟が赤
-        w->color_ = node_type::BLACK;
-        x->parent_->color_ = node_type::RED;
-        __rotate_right(x->parent_);
-        w = x->parent_->left_;
+        w->set_color(node_type::BLACK);
+        x_parent->set_color(node_type::RED);
+        __rotate_right(x_parent);
+        w = x_parent->left_;
       }
-      if (w->right_->color_ == node_type::BLACK &&
-          w->left_->color_ == node_type::BLACK) {
+      if (__is_black(w->right_) && __is_black(w->left_)) {
         // 修正パターン2: 兄弟が黒 + 兄弟の子が両方黒
-        w->color_ = node_type::RED;
-        x = x->parent_;
+        w->set_color(node_type::RED);
+        x = x_parent;
+        x_parent = x_parent->parent();
       } else {
-        if (w->left_->color_ == node_type::BLACK) {
+        if (__is_black(w->left_)) {
           // 修正パターン3: 兄弟が黒 + 兄弟の左の子が赤, 右の子が黒
-          w->right_->color_ = node_type::BLACK;
-          w->color_ = node_type::RED;
+          w->right_->set_color(node_type::BLACK);
+          w->set_color(node_type::RED);
           __rotate_left(w);
-          w = x->parent_->left_;
+          w = x_parent->left_;
         }
         // 修正パターン4: 兄弟が黒 + 兄弟の右の子が赤
-        w->color_ = x->parent_->color_;
-        x->parent_->color_ = node_type::BLACK;
-        w->left_->color_ = node_type::BLACK;
-        __rotate_right(x->parent_);
+        w->set_color(x_parent->color());
+        x_parent->set_color(node_type::BLACK);
+        w->left_->set_color(node_type::BLACK);
+        __rotate_right(x_parent);
         x = root_;
       }
     }
   }
-  x->color_ = node_type::BLACK;
+  if (x) {
+    x->set_color(node_type::BLACK);
+  }
+}
+
+/********** Join and split **********/
+// 集合演算は Blelloch, Ferizovic, Sun の "Just Join for Parallel Ordered
+// Sets" に従い, 木を join と split だけで組み替える.
+// 部分木の根の親へのリンクは, 繋ぐ側が張る.
+
+// 左端の道を辿って黒高さを数える. どの道でも同じなので左端で良い.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::size_type
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__black_height(const node_type *node) {
+  size_type height = 0;
+  for (; node; node = node->left_) {
+    if (__is_black(node)) {
+      ++height;
+    }
+  }
+  return height;
+}
+
+// 木の全てのノードを部分木として切り離し, 自分は空にする.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__detach_root() {
+  __subtree tree(root_, __black_height(root_));
+  if (root_) {
+    root_->set_parent(NULL);
+  }
+  root_ = NULL;
+  node_count_ = 0;
+  return tree;
+}
+
+// 部分木を自分の木として繋ぎ直す. 空の木に対して呼ぶ.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__attach_root(const __subtree &tree,
+                                             size_type count) {
+  root_ = tree.root;
+  node_count_ = count;
+  if (root_) {
+    // 根を黒にしても黒高さが全ての道で1増えるだけなので2色条件は崩れない.
+    root_->set_color(node_type::BLACK);
+    begin_node_ = find_minimum_node(root_);
+    rightmost_node_ = find_maximum_node(root_);
+  } else {
+    begin_node_ = end_node_;
+    rightmost_node_ = end_node_;
+  }
+  __update_end_node();
+  NodePolicy::relink_all_nodes(end_node_);
+}
+
+// 部分木を根と左右の部分木に分ける. 根は子を持たないノードになる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__expose(const __subtree &tree,
+                                        __subtree &left, __subtree &right) {
+  node_type *node = tree.root;
+  const size_type child_height =
+      tree.black_height - (__is_black(node) ? 1 : 0);
+  left = __subtree(node->left_, child_height);
+  right = __subtree(node->right_, child_height);
+  node->left_ = NULL;
+  node->right_ = NULL;
+}
+
+// left と right を mid の子にして, mid を color に塗る.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__link_node(
+    node_type *left, node_type *mid, node_type *right,
+    typename node_type::Color color) {
+  mid->left_ = left;
+  mid->right_ = right;
+  if (left) {
+    left->set_parent(mid);
+  }
+  if (right) {
+    right->set_parent(mid);
+  }
+  mid->set_color(color);
+  NodePolicy::update_node(mid);
+  return mid;
 }
 
-/* 木の全てのノードを削除する.
+// 部分木の根 x を左回転して, 新しい根を返す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__rotate_subtree_left(node_type *x) {
+  node_type *y = x->right_;
+  x->right_ = y->left_;
+  if (y->left_) {
+    y->left_->set_parent(x);
+  }
+  y->left_ = x;
+  x->set_parent(y);
+  NodePolicy::update_node(x);
+  NodePolicy::update_node(y);
+  return y;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__rotate_subtree_right(node_type *x) {
+  node_type *y = x->left_;
+  x->left_ = y->right_;
+  if (y->right_) {
+    y->right_->set_parent(x);
+  }
+  y->right_ = x;
+  x->set_parent(y);
+  NodePolicy::update_node(x);
+  NodePolicy::update_node(y);
+  return y;
+}
+
+// 黒高さが left の方が高い時に, left の右端の道を降りて
+// right と同じ黒高さの黒ノードの所に mid を赤で繋ぐ.
+// 赤が2つ続いたら1つ上で左回転して直す.
+// 返す部分木の黒高さは left_height のままで, 根と右の子が共に赤の場合がある.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__join_right(
+    node_type *left, size_type left_height, node_type *mid, node_type *right,
+    size_type right_height) {
+  if (__is_black(left) && left_height == right_height) {
+    return __link_node(left, mid, right, node_type::RED);
+  }
+  const size_type child_height = left_height - (__is_black(left) ? 1 : 0);
+  node_type *joined =
+      __join_right(left->right_, child_height, mid, right, right_height);
+  left->right_ = joined;
+  joined->set_parent(left);
+  if (__is_black(left) && !__is_black(joined) &&
+      !__is_black(joined->right_)) {
+    joined->right_->set_color(node_type::BLACK);
+    return __rotate_subtree_left(left);
+  }
+  NodePolicy::update_node(left);
+  return left;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__join_left(
+    node_type *left, size_type left_height, node_type *mid, node_type *right,
+    size_type right_height) {
+  if (__is_black(right) && left_height == right_height) {
+    return __link_node(left, mid, right, node_type::RED);
+  }
+  const size_type child_height = right_height - (__is_black(right) ? 1 : 0);
+  node_type *joined =
+      __join_left(left, left_height, mid, right->left_, child_height);
+  right->left_ = joined;
+  joined->set_parent(right);
+  if (__is_black(right) && !__is_black(joined) &&
+      !__is_black(joined->left_)) {
+    joined->left_->set_color(node_type::BLACK);
+    return __rotate_subtree_right(right);
+  }
+  NodePolicy::update_node(right);
+  return right;
+}
+
+// left の全てのキー < mid のキー < right の全てのキー の時に,
+// 3つを繋いだ部分木を作る. 黒高さの差を d として O(d + 1) で済む.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__join(
+    const __subtree &left, node_type *mid, const __subtree &right) {
+  node_type *root;
+  size_type height;
+  if (left.black_height > right.black_height) {
+    root = __join_right(left.root, left.black_height, mid, right.root,
+                        right.black_height);
+    height = left.black_height;
+    if (!__is_black(root) && !__is_black(root->right_)) {
+      root->set_color(node_type::BLACK);
+      ++height;
+    }
+  } else if (left.black_height < right.black_height) {
+    root = __join_left(left.root, left.black_height, mid, right.root,
+                       right.black_height);
+    height = right.black_height;
+    if (!__is_black(root) && !__is_black(root->left_)) {
+      root->set_color(node_type::BLACK);
+      ++height;
+    }
+  } else if (__is_black(left.root) && __is_black(right.root)) {
+    root = __link_node(left.root, mid, right.root, node_type::RED);
+    height = left.black_height;
+  } else {
+    root = __link_node(left.root, mid, right.root, node_type::BLACK);
+    height = left.black_height + 1;
+  }
+  root->set_parent(NULL);
+  return __subtree(root, height);
+}
+
+// 最大のノードを last として取り出し, 残りを rest にする.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__split_last(const __subtree &tree,
+                                            __subtree &rest,
+                                            node_type *&last) {
+  node_type *node = tree.root;
+  __subtree left;
+  __subtree right;
+  __expose(tree, left, right);
+  if (right.root == NULL) {
+    if (left.root) {
+      left.root->set_parent(NULL);
+    }
+    rest = left;
+    last = node;
+    return;
+  }
+  __subtree right_rest;
+  __split_last(right, right_rest, last);
+  rest = __join(left, node, right_rest);
+}
+
+// 間に入れるノード無しで left と right を繋ぐ.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__join2(
+    const __subtree &left, const __subtree &right) {
+  if (left.root == NULL) {
+    return right;
+  }
+  __subtree rest;
+  node_type *last;
+  __split_last(left, rest, last);
+  return __join(rest, last, right);
+}
+
+// tree を key より小さい部分 left と大きい部分 right に分ける.
+// key と等しいノードがあれば子を持たないノードとして found に返し,
+// 無ければ found は NULL になる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__split(
+    const __subtree &tree, const key_type &key, __subtree &left,
+    node_type *&found, __subtree &right) const {
+  if (tree.root == NULL) {
+    left = __subtree();
+    right = __subtree();
+    found = NULL;
+    return;
+  }
+  node_type *node = tree.root;
+  __subtree node_left;
+  __subtree node_right;
+  __expose(tree, node_left, node_right);
+  const key_type &node_key = __get_key_of_value(node->value_);
+  if (__compare_keys(key, node_key)) {
+    __subtree rest;
+    __split(node_left, key, left, found, rest);
+    right = __join(rest, node, node_right);
+  } else if (__compare_keys(node_key, key)) {
+    __subtree rest;
+    __split(node_right, key, rest, found, right);
+    left = __join(node_left, node, rest);
+  } else {
+    if (node_left.root) {
+      node_left.root->set_parent(NULL);
+    }
+    if (node_right.root) {
+      node_right.root->set_parent(NULL);
+    }
+    left = node_left;
+    found = node;
+    right = node_right;
+  }
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::
+    __union_unique(RedBlackTree &other, const fork_join_executor *executor) {
+  if (&other == this) {
+    return;
+  }
+  if (node_allocator_ != other.node_allocator_) {
+    // 別のアロケータで確保したノードは付け替えられないのでコピーする.
+    insert_range_unique(other.begin(), other.end());
+    other.clear();
+    return;
+  }
+  const size_type count = node_count_ + other.node_count_;
+  __node_list removed;
+  const __subtree merged =
+      __union(__detach_root(), other.__detach_root(), removed, executor);
+  other.__attach_root(__subtree(), 0);
+  __attach_root(merged, count - __delete_node_list(removed));
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::
+    __intersect_unique(const RedBlackTree &other,
+                       const fork_join_executor *executor) {
+  if (&other == this) {
+    return;
+  }
+  const size_type count = node_count_;
+  __node_list removed;
+  const __subtree result = __intersect(
+      __detach_root(), __const_subtree(other.root_), removed, executor);
+  __attach_root(result, count - __delete_node_list(removed));
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::
+    __subtract_unique(const RedBlackTree &other,
+                      const fork_join_executor *executor) {
+  if (&other == this) {
+    clear();
+    return;
+  }
+  const size_type count = node_count_;
+  __node_list removed;
+  const __subtree result = __subtract(
+      __detach_root(), __const_subtree(other.root_), removed, executor);
+  __attach_root(result, count - __delete_node_list(removed));
+}
+
+// 変更しない木を __subtree として扱う. __intersect と __subtract は
+// tree2 を分けずに子を辿るだけなので, ノードを書き換えることは無い.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__const_subtree(const node_type *root) {
+  return __subtree(const_cast<node_type *>(root), __black_height(root));
+}
+
+// リストに繋いだ部分木のノードを全て破棄し, その数を返す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::size_type
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__delete_node_list(const __node_list &list) {
+  size_type count = 0;
+  node_type *node = list.head;
+  while (node) {
+    node_type *next = node->parent();
+    count += __delete_tree(node);
+    node = next;
+  }
+  return count;
+}
+
+// (left1, left2) と (right1, right2) に operation を適用する.
+// 黒高さ h の部分木には少なくとも 2^h - 1 個のノードがあるので,
+// 左右どちらの組もそれが grain_size 以上なら並行に実行する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::
+    __apply_to_halves(__set_operation operation, const __subtree &left1,
+                      const __subtree &left2, const __subtree &right1,
+                      const __subtree &right2, __node_list &removed,
+                      const fork_join_executor *executor, __subtree &left,
+                      __subtree &right) {
+  __set_operation_task left_task(this, operation, left1, left2, executor);
+  __set_operation_task right_task(this, operation, right1, right2, executor);
+  size_type height = left1.black_height;
+  if (right1.black_height < height) {
+    height = right1.black_height;
+  }
+  if (left2.black_height < height) {
+    height = left2.black_height;
+  }
+  const size_type max_shift = sizeof(size_type) * CHAR_BIT - 1;
+  if (executor &&
+      (height >= max_shift ||
+       (size_type(1) << height) - 1 >= executor->grain_size())) {
+    executor->fork_join(left_task, right_task);
+  } else {
+    left_task();
+    right_task();
+  }
+  removed.splice(left_task.removed);
+  removed.splice(right_task.removed);
+  left = left_task.result;
+  right = right_task.result;
+}
+
+// tree2 の根で tree1 を分け, 左右をそれぞれ再帰的に合わせてから繋ぐ.
+// 同じキーのノードは tree1 の方を残し, tree2 の方を removed に入れる.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__union(
+    const __subtree &tree1, const __subtree &tree2, __node_list &removed,
+    const fork_join_executor *executor) {
+  if (tree1.root == NULL) {
+    return tree2;
+  }
+  if (tree2.root == NULL) {
+    return tree1;
+  }
+  node_type *node = tree2.root;
+  __subtree left2;
+  __subtree right2;
+  __expose(tree2, left2, right2);
+  __subtree left1;
+  __subtree right1;
+  node_type *found;
+  __split(tree1, __get_key_of_value(node->value_), left1, found, right1);
+  __subtree left;
+  __subtree right;
+  __apply_to_halves(&RedBlackTree::__union, left1, left2, right1, right2,
+                    removed, executor, left, right);
+  if (found) {
+    removed.push_back(node);
+    node = found;
+  }
+  return __join(left, node, right);
+}
+
+// tree1 のうち tree2 にもあるキーのノードだけを残し, 残りを removed に入れる.
+// tree2 は変更しない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__intersect(
+    const __subtree &tree1, const __subtree &tree2, __node_list &removed,
+    const fork_join_executor *executor) {
+  if (tree1.root == NULL) {
+    return tree1;
+  }
+  if (tree2.root == NULL) {
+    removed.push_back(tree1.root);
+    return __subtree();
+  }
+  const size_type child_height =
+      tree2.black_height - (__is_black(tree2.root) ? 1 : 0);
+  __subtree left1;
+  __subtree right1;
+  node_type *found;
+  __split(tree1, __get_key_of_value(tree2.root->value_), left1, found,
+          right1);
+  __subtree left;
+  __subtree right;
+  __apply_to_halves(&RedBlackTree::__intersect, left1,
+                    __subtree(tree2.root->left_, child_height), right1,
+                    __subtree(tree2.root->right_, child_height), removed,
+                    executor, left, right);
+  if (found) {
+    return __join(left, found, right);
+  }
+  return __join2(left, right);
+}
+
+// tree1 のうち tree2 にあるキーのノードを removed に入れる.
+// tree2 は変更しない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::__subtree
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc, NodePolicy>::__subtract(
+    const __subtree &tree1, const __subtree &tree2, __node_list &removed,
+    const fork_join_executor *executor) {
+  if (tree1.root == NULL || tree2.root == NULL) {
+    return tree1;
+  }
+  const size_type child_height =
+      tree2.black_height - (__is_black(tree2.root) ? 1 : 0);
+  __subtree left1;
+  __subtree right1;
+  node_type *found;
+  __split(tree1, __get_key_of_value(tree2.root->value_), left1, found,
+          right1);
+  __subtree left;
+  __subtree right;
+  __apply_to_halves(&RedBlackTree::__subtract, left1,
+                    __subtree(tree2.root->left_, child_height), right1,
+                    __subtree(tree2.root->right_, child_height), removed,
+                    executor, left, right);
+  if (found) {
+    removed.push_back(found);
+  }
+  return __join2(left, right);
+}
+
+/* root を根とする部分木の全てのノードを削除し, その数を返す.
+ * 先に right_ で繋いだリストにするので, 再帰もスタックも使わない.
  *
  * 注意: root_, node_count, begin_node_ などのメンバー変数は更新されない.
  */
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__delete_tree(
-    node_type *root) {
-  // 注意: NILノードは __delete_tree()
-  // を呼び出した後に呼び出し側で呼ぶ必要がある
-  if (root->is_nil_node_) {
-    return;
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::size_type
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__delete_tree(node_type *root) {
+  size_type count = 0;
+  node_type *node = __flatten_tree(root);
+  while (node) {
+    node_type *next = node->right_;
+    FT_PREFETCH(next);
+    __delete_node(node);
+    node = next;
+    ++count;
+  }
+  return count;
+}
+
+// clear() とデストラクタで全てのノードを手放す.
+// アロケータが単調でノードのデストラクタが何もしなければ, ノードを辿らない.
+// 領域はアロケータを共有する全てのコピーが無くなった時にまとめて解放される.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__release_tree(node_type *root) {
+  typedef integral_constant<
+      bool, is_monotonic_allocator<node_allocator>::value &&
+                is_trivially_destructible<value_type>::value &&
+                is_trivially_destructible<
+                    typename node_type::links_type>::value>
+      can_drop_nodes;
+
+  __release_tree(root, can_drop_nodes());
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__release_tree(node_type *root, true_type) {
+  (void)root;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__release_tree(node_type *root, false_type) {
+  __delete_tree(root);
+}
+
+// root を根とする部分木を, 中間順に right_ で繋いだリストに組み替えて
+// 先頭を返す. 左の子がある間は右回転して左の子を上げるだけなので,
+// 各ノードは高々1回しか回転せず O(n) で済む. parent と色は設定しない.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__flatten_tree(node_type *root) {
+  node_type **link = &root;
+  while (*link) {
+    node_type *node = *link;
+    if (node->left_) {
+      node_type *left = node->left_;
+      node->left_ = left->right_;
+      left->right_ = node;
+      *link = left;
+    } else {
+      link = &node->right_;
+    }
   }
-  __delete_tree(root->left_);
-  __delete_tree(root->right_);
-  __delete_node(root);
+  return root;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__delete_node(
-    node_type *z) {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__delete_node(node_type *z) {
   node_allocator_.destroy(z);
   node_allocator_.deallocate(z, 1);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::node_type *
-RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__copy_tree(
-    node_type *other_root, node_type *other_nil_node) {
-  if (other_root == other_nil_node) {
-    return nil_node_;
+// other_root を根とする部分木をコピーする. 根の親は呼び出し側で設定する.
+// コピー元の parent を辿って前順に1回だけ走査するので, 再帰もスタックも
+// 使わない. ノードは reusable (right_ で繋いだリスト)から先に使う.
+// 例外が起きた場合はコピー済みのノードを破棄して投げ直す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__copy_tree(const node_type *other_root,
+                                      node_type *&reusable) {
+  if (other_root == NULL) {
+    return NULL;
+  }
+  node_type *copy_root = __copy_node(other_root, reusable);
+  copy_root->set_parent(NULL);
+  const node_type *src = other_root;
+  node_type *dst = copy_root;
+  try {
+    for (;;) {
+      // 左の子はすぐに, 右の子は左の部分木を終えた後に読む.
+      FT_PREFETCH(src->right_);
+      if (src->left_ && dst->left_ == NULL) {
+        node_type *copy = __copy_node(src->left_, reusable);
+        copy->set_parent(dst);
+        dst->left_ = copy;
+        src = src->left_;
+        dst = copy;
+      } else if (src->right_ && dst->right_ == NULL) {
+        node_type *copy = __copy_node(src->right_, reusable);
+        copy->set_parent(dst);
+        dst->right_ = copy;
+        src = src->right_;
+        dst = copy;
+      } else if (src == other_root) {
+        break;
+      } else {
+        src = src->parent();
+        dst = dst->parent();
+      }
+    }
+  } catch (...) {
+    __delete_tree(copy_root);
+    throw;
   }
-  node_type *copy_root = __copy_node(other_root, other_nil_node);
-  copy_root->parent_ = nil_node_;
-  copy_root->left_ = __copy_tree(other_root->left_, other_nil_node);
-  copy_root->left_->parent_ = copy_root;
-  copy_root->right_ = __copy_tree(other_root->right_, other_nil_node);
-  copy_root->right_->parent_ = copy_root;
   return copy_root;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::node_type *
-RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__alloc_new_node(
-    value_type value) {
+#if __cplusplus >= 201103L
+// args から値をノード内に直接構築する.
+// RBTNode のコンストラクタを通すと値が一時オブジェクトからコピーされるので,
+// value_ だけを構築してリンクは後から設定する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class... Args>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__create_node(Args &&...args) {
+  node_type *new_node = __allocate_node_with_links();
+  try {
+    std::allocator_traits<node_allocator>::construct(
+        node_allocator_, &new_node->value_, std::forward<Args>(args)...);
+  } catch (...) {
+    __deallocate_node_with_links(new_node);
+    throw;
+  }
+  return new_node;
+}
+#else
+// C++98 のアロケータの construct はノード型しか受け取らないので,
+// value_ は配置 new で直接構築する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class Arg>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__create_node(const Arg &arg) {
+  node_type *new_node = __allocate_node_with_links();
+  try {
+    ::new (static_cast<void *>(&new_node->value_)) value_type(arg);
+  } catch (...) {
+    __deallocate_node_with_links(new_node);
+    throw;
+  }
+  return new_node;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+template <class Arg1, class Arg2>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__create_node(const Arg1 &arg1, const Arg2 &arg2) {
+  node_type *new_node = __allocate_node_with_links();
+  try {
+    ::new (static_cast<void *>(&new_node->value_)) value_type(arg1, arg2);
+  } catch (...) {
+    __deallocate_node_with_links(new_node);
+    throw;
+  }
+  return new_node;
+}
+#endif
+
+// ノードを確保してリンク部分だけを構築する. value_ は呼び出し側で構築する.
+// 集計値を持つポリシーではリンク部分の構築でも例外が起こり得る.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__allocate_node_with_links() {
+  typedef typename node_type::links_type links_type;
+
   node_type *new_node = node_allocator_.allocate(1);
-  node_allocator_.construct(new_node, value);
-  new_node->left_ = nil_node_;
-  new_node->right_ = nil_node_;
-  new_node->color_ = node_type::RED;  // 新しいノードの色は最初は赤に設定される
+  try {
+    ::new (static_cast<void *>(static_cast<links_type *>(new_node)))
+        links_type();
+  } catch (...) {
+    node_allocator_.deallocate(new_node, 1);
+    throw;
+  }
+  new_node->set_color(node_type::RED);  // 新しいノードの色は最初は赤に設定される
   return new_node;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::node_type *
-RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__alloc_nil_node() {
-  node_type *nil_node = node_allocator_.allocate(1);
-  node_allocator_.construct(nil_node, Value());
-  nil_node->is_nil_node_ = true;
-  nil_node->parent_ = nil_node;
-  nil_node->left_ = nil_node;
-  nil_node->right_ = nil_node;
-  nil_node->color_ = node_type::BLACK;
-  return nil_node;
+// value_ を構築する前のノードを解放する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__deallocate_node_with_links(node_type *node) {
+  typedef typename node_type::links_type links_type;
+
+  static_cast<links_type *>(node)->~links_type();
+  node_allocator_.deallocate(node, 1);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::node_type *
-RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__copy_node(
-    const node_type *z, const node_type *nil_node) {
-  if (z == nil_node) {
-    return nil_node_;
+// z の値と色, ポリシーが持つ値をコピーしたノードを作る. 子は持たない.
+// reusable に使い終わったノードがあれば, 確保せずにその領域に構築する.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                      NodePolicy>::node_type *
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__copy_node(const node_type *z,
+                                      node_type *&reusable) {
+  node_type *new_node;
+  if (reusable) {
+    new_node = reusable;
+    reusable = reusable->right_;
+    node_allocator_.destroy(new_node);
+  } else {
+    new_node = node_allocator_.allocate(1);
   }
-  node_type *new_node = node_allocator_.allocate(1);
-  node_allocator_.construct(new_node, *z);
+  try {
+    node_allocator_.construct(new_node, *z);
+  } catch (...) {
+    node_allocator_.deallocate(new_node, 1);
+    throw;
+  }
+  new_node->left_ = NULL;
+  new_node->right_ = NULL;
   return new_node;
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__are_keys_equal(
-    const key_type &key1, const key_type &key2) const {
+// 根が変わった後に end_node_ と根を繋ぎ直す.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+void RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__update_end_node() {
+  if (root_) {
+    root_->set_parent(end_node_);
+  }
+  end_node_->left_ = root_;
+}
+
+// 葉(NULL)は黒として扱う.
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__is_black(const node_type *node) {
+  return node == NULL || node->color() == node_type::BLACK;
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__are_keys_equal(const key_type &key1,
+                                                const key_type &key2) const {
   return !__compare_keys(key1, key2) && !__compare_keys(key2, key1);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-bool RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__compare_keys(
-    const key_type &key1, const key_type &key2) const {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+bool RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                  NodePolicy>::__compare_keys(const key_type &key1,
+                                              const key_type &key2) const {
   return key_comp_(key1, key2);
 }
 
-template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-const typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::key_type
-RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc>::__get_key_of_value(
-    const value_type &value) const {
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+int RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                 NodePolicy>::__compare_keys_three_way(
+    const key_type &key1, const key_type &key2) const {
+  return __three_way_traits::compare(key_comp_, key1, key2);
+}
+
+template <class Key, class Value, class KeyOfValue, class Compare, class Alloc,
+          class NodePolicy>
+const typename RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+                            NodePolicy>::key_type &
+RedBlackTree<Key, Value, KeyOfValue, Compare, Alloc,
+             NodePolicy>::__get_key_of_value(const value_type &value) const {
   return KeyOfValue()(value);
 }
 
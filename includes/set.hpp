@@ -4,6 +4,8 @@
 #include <functional>
 #include <memory>
 
+#include "eytzinger_tree.hpp"
+#include "fork_join.hpp"
 #include "pair.hpp"
 #include "red_black_tree.hpp"
 
@@ -24,8 +26,10 @@ struct Identity {
   }
 };
 
+// NodePolicy は RedBlackTree のノードのリンクの持ち方.
 template <class Key, class Compare = std::less<Key>,
-          class Allocator = std::allocator<Key> >
+          class Allocator = std::allocator<Key>,
+          class NodePolicy = rbtree_default_node_policy>
 class set {
  public:
   typedef Key key_type;
@@ -38,7 +42,7 @@ class set {
   // This turns a red-black tree into a set.
   typedef typename Allocator::template rebind<value_type>::other key_alloc_type;
   typedef RedBlackTree<key_type, value_type, Identity<value_type>, key_compare,
-                       key_alloc_type>
+                       key_alloc_type, NodePolicy>
       RepType;
 
   // The actual tree structure.
@@ -55,6 +59,10 @@ class set {
   typedef typename RepType::const_iterator const_iterator;
   typedef typename RepType::const_reverse_iterator reverse_iterator;
   typedef typename RepType::const_reverse_iterator const_reverse_iterator;
+  // freeze() が返す, 変更できない探索用のスナップショット.
+  typedef EytzingerTree<key_type, value_type, Identity<value_type>,
+                        key_compare, key_alloc_type>
+      frozen_type;
 
   /********** Constructor, Assignation and Destructor **********/
   set() : rbtree_() {}
@@ -76,6 +84,16 @@ class set {
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  // ノードを付け替えるだけなので例外を投げない.
+  set(set&& other) noexcept : rbtree_(std::move(other.rbtree_)) {}
+
+  set& operator=(set&& other) noexcept {
+    rbtree_ = std::move(other.rbtree_);
+    return *this;
+  }
+#endif
+
   ~set() {}
 
   /********** Get allocator **********/
@@ -131,6 +149,26 @@ class set {
     rbtree_.insert_range_unique(first, last);
   }
 
+#if __cplusplus >= 201103L
+  ft::pair<iterator, bool> insert(value_type&& value) {
+    return rbtree_.insert_unique(std::move(value));
+  }
+
+  iterator insert(iterator hint, value_type&& value) {
+    return rbtree_.insert_unique(hint, std::move(value));
+  }
+
+  template <class... Args>
+  ft::pair<iterator, bool> emplace(Args&&... args) {
+    return rbtree_.emplace_unique(std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator emplace_hint(iterator hint, Args&&... args) {
+    return rbtree_.emplace_hint_unique(hint, std::forward<Args>(args)...);
+  }
+#endif
+
   void erase(iterator pos) {
     rbtree_.erase(pos);
   }
@@ -147,6 +185,45 @@ class set {
     rbtree_.swap(other.rbtree_);
   }
 
+  /********** Set operations **********/
+  // ノードを作り直さずに木を組み替える. 小さい方の要素数を m, 大きい方を n
+  // とすると O(m log(n/m + 1)) で済む.
+
+  // other の要素を全て移す. 同じキーがあれば自分の要素を残し, other は空になる.
+  void unite(set& other) {
+    rbtree_.union_unique(other.rbtree_);
+  }
+
+  // other に無いキーの要素を取り除く.
+  void intersect(const set& other) {
+    rbtree_.intersect_unique(other.rbtree_);
+  }
+
+  // other にあるキーの要素を取り除く.
+  void subtract(const set& other) {
+    rbtree_.subtract_unique(other.rbtree_);
+  }
+
+  // executor で左右の部分木を並行に処理する版.
+  // 比較関数オブジェクトは複数のスレッドから同時に呼ばれる.
+  void unite(set& other, const fork_join_executor& executor) {
+    rbtree_.union_unique(other.rbtree_, executor);
+  }
+
+  void intersect(const set& other, const fork_join_executor& executor) {
+    rbtree_.intersect_unique(other.rbtree_, executor);
+  }
+
+  void subtract(const set& other, const fork_join_executor& executor) {
+    rbtree_.subtract_unique(other.rbtree_, executor);
+  }
+
+  // [first, last) を挿入する. 要素の木を作ってから並行に合わせる.
+  template <class InputIt>
+  void insert(InputIt first, InputIt last, const fork_join_executor& executor) {
+    rbtree_.insert_range_unique(first, last, executor);
+  }
+
   /********** Lookup **********/
   size_type count(const Key& key) const {
     return rbtree_.find(key) == rbtree_.end() ? 0 : 1;
@@ -184,6 +261,121 @@ class set {
     return rbtree_.upper_bound(key);
   }
 
+  /* key_compare が is_transparent を持つ場合は, Key と比較出来る任意の型で
+   * 探索する. (例えば set<std::string, ft::less<> > を const char* で探す)
+   */
+  template <class K>
+  typename enable_if_transparent<key_compare, K, size_type>::type count(
+      const K& key) const {
+    return rbtree_.count(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type find(
+      const K& key) {
+    return rbtree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type find(
+      const K& key) const {
+    return rbtree_.find(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K,
+                                 ft::pair<iterator, iterator> >::type
+  equal_range(const K& key) {
+    return rbtree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<
+      key_compare, K, ft::pair<const_iterator, const_iterator> >::type
+  equal_range(const K& key) const {
+    return rbtree_.equal_range(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type lower_bound(
+      const K& key) {
+    return rbtree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  lower_bound(const K& key) const {
+    return rbtree_.lower_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, iterator>::type upper_bound(
+      const K& key) {
+    return rbtree_.upper_bound(key);
+  }
+
+  template <class K>
+  typename enable_if_transparent<key_compare, K, const_iterator>::type
+  upper_bound(const K& key) const {
+    return rbtree_.upper_bound(key);
+  }
+
+  /* [first, last) の各キーについて find, lower_bound した結果を, キーの順に
+   * out から書いて, 書き終えた位置を返す. 複数の探索を交互に1段ずつ進めて
+   * ノードを先読みするので, 木がキャッシュに乗らない時に1つずつ探すより速い.
+   */
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return rbtree_.find_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const {
+    return rbtree_.find_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last, OutputIt out) {
+    return rbtree_.lower_bound_many(first, last, out);
+  }
+
+  template <class ForwardIt, class OutputIt>
+  OutputIt lower_bound_many(ForwardIt first, ForwardIt last,
+                            OutputIt out) const {
+    return rbtree_.lower_bound_many(first, last, out);
+  }
+
+  /********** Order statistics **********/
+  // NodePolicy が rbtree_order_statistic_node_policy の時だけ使える.
+  // どれも木の高さに比例する時間で求める.
+
+  iterator nth(size_type k) {
+    return rbtree_.nth(k);
+  }
+
+  const_iterator nth(size_type k) const {
+    return rbtree_.nth(k);
+  }
+
+  size_type rank(const Key& key) const {
+    return rbtree_.rank(key);
+  }
+
+  size_type count_range(const Key& lo, const Key& hi) const {
+    return rbtree_.count_range(lo, hi);
+  }
+
+  size_type index_of(const_iterator pos) const {
+    return rbtree_.index_of(pos);
+  }
+
+  /********** Snapshot **********/
+  // 今の要素を中間順に読んで, Eytzinger 配置の配列にコピーする. O(n)
+  // 探索は木を辿らないので速いが, 後で変更しても反映されない.
+  frozen_type freeze() const {
+    return frozen_type(begin(), size(), key_comp(), get_allocator());
+  }
+
   /********** Observers **********/
   key_compare key_comp() const {
     return rbtree_.key_comp();
@@ -194,55 +386,55 @@ class set {
   }
 
   /********** Basic comparison operators **********/
-  template <typename K1, typename C1, typename A>
-  friend bool operator==(const set<K1, C1, A>&, const set<K1, C1, A>&);
+  template <typename K1, typename C1, typename A, typename P>
+  friend bool operator==(const set<K1, C1, A, P>&, const set<K1, C1, A, P>&);
 
-  template <typename K1, typename C1, typename A>
-  friend bool operator<(const set<K1, C1, A>&, const set<K1, C1, A>&);
+  template <typename K1, typename C1, typename A, typename P>
+  friend bool operator<(const set<K1, C1, A, P>&, const set<K1, C1, A, P>&);
 };
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator==(const set<Key, Compare, Alloc>& lhs,
-                       const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator==(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                       const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return lhs.rbtree_ == rhs.rbtree_;
 }
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator<(const set<Key, Compare, Alloc>& lhs,
-                      const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator<(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                      const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return lhs.rbtree_ < rhs.rbtree_;
 }
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator!=(const set<Key, Compare, Alloc>& lhs,
-                       const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator!=(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                       const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return !(lhs == rhs);
 }
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator>(const set<Key, Compare, Alloc>& lhs,
-                      const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator>(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                      const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return rhs < lhs;
 }
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator<=(const set<Key, Compare, Alloc>& lhs,
-                       const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator<=(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                       const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return !(rhs < lhs);
 }
 
-template <typename Key, typename Compare, typename Alloc>
-inline bool operator>=(const set<Key, Compare, Alloc>& lhs,
-                       const set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline bool operator>=(const set<Key, Compare, Alloc, NodePolicy>& lhs,
+                       const set<Key, Compare, Alloc, NodePolicy>& rhs) {
   return !(lhs < rhs);
 }
 
 }  // namespace ft
 
 namespace std {  // specializes the std::swap algorithm
-template <typename Key, typename Compare, typename Alloc>
-inline void swap(const ft::set<Key, Compare, Alloc>& lhs,
-                 const ft::set<Key, Compare, Alloc>& rhs) {
+template <typename Key, typename Compare, typename Alloc, typename NodePolicy>
+inline void swap(const ft::set<Key, Compare, Alloc, NodePolicy>& lhs,
+                 const ft::set<Key, Compare, Alloc, NodePolicy>& rhs) {
   lhs.swap(rhs);
 }
 }  // namespace std
@@ -0,0 +1,611 @@
+#ifndef SMALL_VECTOR_H_
+#define SMALL_VECTOR_H_
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "equal.hpp"
+#include "lexicographical_compare.hpp"
+#include "normal_iterator.hpp"
+#include "reverse_iterator.hpp"
+#include "type_traits.hpp"
+#include "uninitialized.hpp"
+
+namespace ft {
+
+// N 個までの要素をオブジェクト内の領域に置き, 超えるとヒープに移る vector.
+// 要素数が少ない間はヒープ確保を一切行わない.
+// インターフェースは ft::vector と同じ.
+//
+// 注意: 内部領域のアラインメントは基本型の中で最も厳しいものに揃えているので,
+//       それを超えるアラインメントを要求する型は扱えない.
+template <typename T, std::size_t N, typename Allocator = std::allocator<T> >
+class small_vector {
+ public:
+  typedef T value_type;
+  typedef Allocator allocator_type;
+  typedef value_type &reference;
+  typedef ptrdiff_t difference_type;
+  typedef const value_type &const_reference;
+  typedef value_type *pointer;
+  typedef const value_type *const_pointer;
+  typedef ft::normal_iterator<pointer, small_vector> iterator;
+  typedef ft::normal_iterator<const_pointer, small_vector> const_iterator;
+  typedef ft::reverse_iterator<const_iterator> const_reverse_iterator;
+  typedef ft::reverse_iterator<iterator> reverse_iterator;
+  typedef std::size_t size_type;
+
+  static const size_type inline_capacity = N;
+
+ private:
+  // N 個分の要素を置くための領域.
+  // union にすることで最も厳しいアラインメントの基本型に揃える.
+  union inline_storage {
+    char bytes_[sizeof(T) * (N == 0 ? 1 : N)];
+    long double align_long_double_;
+    long long align_long_long_;
+    double align_double_;
+    void *align_pointer_;
+  };
+
+  allocator_type allocator_;
+  pointer start_;
+  pointer finish_;
+  pointer end_of_storage_;
+  inline_storage storage_;
+
+ public:
+  small_vector() : allocator_() {
+    __reset_to_inline();
+  }
+
+  explicit small_vector(const Allocator &alloc) : allocator_(alloc) {
+    __reset_to_inline();
+  }
+
+  explicit small_vector(size_type n, const value_type &val = value_type(),
+                        allocator_type alloc = allocator_type())
+      : allocator_(alloc) {
+    __reset_to_inline();
+    insert(end(), n, val);
+  }
+
+  template <class InputIterator>
+  small_vector(
+      InputIterator first, InputIterator last,
+      allocator_type alloc = allocator_type(),
+      typename disable_if<is_integral<InputIterator>::value>::type * = 0)
+      : allocator_(alloc) {
+    __reset_to_inline();
+    insert(end(), first, last);
+  }
+
+  small_vector(const small_vector &other) : allocator_(other.allocator_) {
+    __reset_to_inline();
+    insert(end(), other.begin(), other.end());
+  }
+
+  small_vector &operator=(const small_vector &rhs) {
+    if (this != &rhs) {
+      assign(rhs.begin(), rhs.end());
+    }
+    return *this;
+  }
+
+#if __cplusplus >= 201103L
+  // 相手がヒープを使っている場合は領域ごと奪う.
+  // 内部領域を使っている場合は要素を1つずつムーブするしかない.
+  small_vector(small_vector &&other) : allocator_(other.allocator_) {
+    __reset_to_inline();
+    __steal_or_move(other);
+  }
+
+  // 奪った領域は後で rhs のアロケータで解放する必要があるので,
+  // ft::vector と同じくアロケータも rhs から受け取る.
+  small_vector &operator=(small_vector &&rhs) {
+    if (this != &rhs) {
+      clear();
+      __release_heap();
+      __reset_to_inline();
+      allocator_ = rhs.allocator_;
+      __steal_or_move(rhs);
+    }
+    return *this;
+  }
+#endif
+
+  ~small_vector() {
+    __destroy_a(allocator_, start_, finish_);
+    __release_heap();
+  }
+
+  // Iterators
+  iterator begin() {
+    return iterator(start_);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(start_);
+  }
+
+  iterator end() {
+    return iterator(finish_);
+  }
+
+  const_iterator end() const {
+    return const_iterator(finish_);
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  // Size and Capacity
+
+  size_type size() const {
+    return size_type(finish_ - start_);
+  }
+
+  size_type max_size() const {
+    return allocator_.max_size();
+  }
+
+  size_type capacity() const {
+    return size_type(end_of_storage_ - start_);
+  }
+
+  bool empty() const {
+    return start_ == finish_;
+  }
+
+  // 要素が内部領域に置かれているかどうか
+  bool is_inline() const {
+    return start_ == __inline_begin();
+  }
+
+  void reserve(size_type n) {
+    if (n > max_size())
+      throw std::length_error("small_vector::reserve");
+    if (capacity() < n) {
+      __expand_and_copy_storage(n);
+    }
+  }
+
+  // Element access
+
+  reference operator[](size_type n) {
+    return start_[n];
+  }
+
+  const_reference operator[](size_type n) const {
+    return start_[n];
+  }
+
+  reference at(size_type n) {
+    if (n >= size())
+      throw std::out_of_range("small_vector::at");
+    return start_[n];
+  }
+
+  const_reference at(size_type n) const {
+    if (n >= size())
+      throw std::out_of_range("small_vector::at");
+    return start_[n];
+  }
+
+  reference front() {
+    return *start_;
+  }
+
+  const_reference front() const {
+    return *start_;
+  }
+
+  reference back() {
+    return *(finish_ - 1);
+  }
+
+  const_reference back() const {
+    return *(finish_ - 1);
+  }
+
+  pointer data() {
+    return start_;
+  }
+
+  const_pointer data() const {
+    return start_;
+  }
+
+  // Modifiers
+  template <class InputIterator>
+  void assign(
+      InputIterator first, InputIterator last,
+      typename disable_if<is_integral<InputIterator>::value>::type * = 0) {
+    clear();
+    insert(end(), first, last);
+  }
+
+  void assign(size_type n, const value_type &val) {
+    const value_type val_copy(val);
+    clear();
+    insert(end(), n, val_copy);
+  }
+
+  void push_back(const value_type &val) {
+    if (finish_ != end_of_storage_) {
+      __construct_a(allocator_, finish_, val);
+      ++finish_;
+    } else {
+      __realloc_append(val);
+    }
+  }
+
+#if __cplusplus >= 201103L
+  void push_back(value_type &&val) {
+    emplace_back(std::move(val));
+  }
+
+  template <class... Args>
+  void emplace_back(Args &&...args) {
+    if (finish_ != end_of_storage_) {
+      __construct_a(allocator_, finish_, std::forward<Args>(args)...);
+      ++finish_;
+    } else {
+      __realloc_insert(finish_, std::forward<Args>(args)...);
+    }
+  }
+#endif
+
+  void pop_back() {
+    if (size() == 0) {
+      return;
+    }
+    --finish_;
+    __destroy_a(allocator_, finish_, finish_ + 1);
+  }
+
+  void resize(size_type n, T value = T()) {
+    if (n < size()) {
+      __erase_at_end(start_ + n);
+    } else if (n > size()) {
+      insert(end(), n - size(), value);
+    }
+  }
+
+  iterator insert(iterator position, const value_type &val) {
+    const size_type offset = position - begin();
+    insert(position, 1, val);
+    return begin() + offset;
+  }
+
+#if __cplusplus >= 201103L
+  iterator insert(iterator position, value_type &&val) {
+    return emplace(position, std::move(val));
+  }
+
+  template <class... Args>
+  iterator emplace(iterator position, Args &&...args) {
+    const size_type offset = position - begin();
+    if (finish_ == end_of_storage_) {
+      __realloc_insert(position.base(), std::forward<Args>(args)...);
+    } else if (position == end()) {
+      __construct_a(allocator_, finish_, std::forward<Args>(args)...);
+      ++finish_;
+    } else {
+      // args が要素を参照している可能性があるので先に一時オブジェクトを作る.
+      value_type tmp(std::forward<Args>(args)...);
+      __construct_a(allocator_, finish_, std::move(*(finish_ - 1)));
+      ++finish_;
+      __move_backward_within(position.base(), finish_ - 2, finish_ - 1);
+      *position = std::move(tmp);
+    }
+    return begin() + offset;
+  }
+#endif
+
+  void insert(iterator position, size_type n, const value_type &val) {
+    if (n == 0) {
+      return;
+    }
+    const size_type offset = position - begin();
+    // val が要素を指している可能性があるので領域を広げる前にコピーしておく.
+    const value_type val_copy(val);
+    if (size_type(end_of_storage_ - finish_) < n) {
+      __expand_and_copy_storage(__calc_new_capacity(n));
+    }
+    pointer pos = start_ + offset;
+    pointer old_finish = finish_;
+    const size_type elems_after = old_finish - pos;
+    if (elems_after > n) {
+      finish_ = __uninitialized_move_a(allocator_, old_finish - n, old_finish,
+                                       old_finish);
+      __move_backward_within(pos, old_finish - n, old_finish);
+      std::fill(pos, pos + n, val_copy);
+    } else {
+      __uninitialized_fill_n_a(allocator_, old_finish, n - elems_after,
+                               val_copy);
+      finish_ += n - elems_after;
+      finish_ = __uninitialized_move_a(allocator_, pos, old_finish, finish_);
+      std::fill(pos, old_finish, val_copy);
+    }
+  }
+
+  template <class InputIterator>
+  void insert(
+      iterator position, InputIterator first, InputIterator last,
+      typename disable_if<is_integral<InputIterator>::value>::type * = 0) {
+    __insert_range(
+        position, first, last,
+        typename iterator_traits<InputIterator>::iterator_category());
+  }
+
+  iterator erase(iterator position) {
+    if (position + 1 != end())
+      __move_within(position.base() + 1, finish_, position.base());
+    __erase_at_end(finish_ - 1);
+    return position;
+  }
+
+  iterator erase(iterator first, iterator last) {
+    if (first != last) {
+      if (last != end()) {
+        __move_within(last.base(), finish_, first.base());
+      }
+      __erase_at_end(first.base() + (end() - last));
+    }
+    return first;
+  }
+
+  // 両方がヒープを使っている場合はポインタの交換だけで済む.
+  // どちらかが内部領域を使っている場合は要素を入れ替える必要がある.
+  void swap(small_vector &x) {
+    if (!is_inline() && !x.is_inline()) {
+      std::swap(allocator_, x.allocator_);
+      std::swap(start_, x.start_);
+      std::swap(finish_, x.finish_);
+      std::swap(end_of_storage_, x.end_of_storage_);
+      return;
+    }
+#if __cplusplus >= 201103L
+    small_vector tmp(std::move(x));
+    x = std::move(*this);
+    *this = std::move(tmp);
+#else
+    small_vector tmp(x);
+    x = *this;
+    *this = tmp;
+#endif
+  }
+
+  void clear() {
+    __erase_at_end(start_);
+  }
+
+  // Allocator
+  allocator_type get_allocator() const {
+    return allocator_type(allocator_);
+  }
+
+ private:
+  pointer __inline_begin() {
+    return reinterpret_cast<pointer>(storage_.bytes_);
+  }
+
+  const_pointer __inline_begin() const {
+    return reinterpret_cast<const_pointer>(storage_.bytes_);
+  }
+
+  void __reset_to_inline() {
+    start_ = __inline_begin();
+    finish_ = start_;
+    end_of_storage_ = start_ + N;
+  }
+
+  void __release_heap() {
+    if (!is_inline()) {
+      allocator_.deallocate(start_, capacity());
+    }
+  }
+
+#if __cplusplus >= 201103L
+  void __steal_or_move(small_vector &other) {
+    if (other.is_inline()) {
+      finish_ = __uninitialized_move_a(allocator_, other.start_, other.finish_,
+                                       start_);
+      other.clear();
+    } else {
+      start_ = other.start_;
+      finish_ = other.finish_;
+      end_of_storage_ = other.end_of_storage_;
+      other.__reset_to_inline();
+    }
+  }
+#endif
+
+  void __erase_at_end(pointer new_finish) {
+    __destroy_a(allocator_, new_finish, finish_);
+    finish_ = new_finish;
+  }
+
+  // ヒープに new_cap の領域を確保して要素を移す.
+  // 要素のコピー中に例外が発生した場合は元の状態のまま例外を投げ直す.
+  void __expand_and_copy_storage(size_type new_cap) {
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      new_finish = __relocate_a(allocator_, start_, finish_, new_start);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
+    }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+
+  // 容量が足りない時の push_back().
+  // val が要素を指している場合があるので, 先に新しい領域に val を構築する.
+  void __realloc_append(const value_type &val) {
+    const size_type old_size = size();
+    const size_type new_cap = __calc_new_capacity(1);
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      __construct_a(allocator_, new_start + old_size, val);
+      new_finish = __relocate_around_a(allocator_, start_, finish_, finish_,
+                                       new_start, 1);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
+    }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+
+#if __cplusplus >= 201103L
+  // 容量が足りない時の emplace(), emplace_back().
+  template <class... Args>
+  void __realloc_insert(pointer pos, Args &&...args) {
+    const size_type offset = pos - start_;
+    const size_type new_cap = __calc_new_capacity(1);
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      __construct_a(allocator_, new_start + offset,
+                    std::forward<Args>(args)...);
+      new_finish = __relocate_around_a(allocator_, start_, pos, finish_,
+                                       new_start, 1);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
+    }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+#endif
+
+  // n 個の要素を追加する時の新しい容量.
+  // ft::vector と同様に少なくとも現在の容量の2倍に拡張する.
+  size_type __calc_new_capacity(size_type n) {
+    if (max_size() - size() < n) {
+      throw std::length_error("small_vector::__calc_new_capacity");
+    }
+    const size_type new_cap = std::max(size() + n, capacity() * 2);
+    return (new_cap < size() || new_cap > max_size()) ? max_size() : new_cap;
+  }
+
+  template <class InputIterator>
+  void __insert_range(iterator position, InputIterator first,
+                      InputIterator last, std::input_iterator_tag) {
+    if (position == end()) {
+      for (; first != last; ++first) {
+        push_back(*first);
+      }
+    } else if (first != last) {
+      small_vector tmp(first, last, get_allocator());
+      insert(position, tmp.begin(), tmp.end());
+    }
+  }
+
+  template <class ForwardIterator>
+  void __insert_range(iterator position, ForwardIterator first,
+                      ForwardIterator last, std::forward_iterator_tag) {
+    const size_type n = std::distance(first, last);
+    if (n == 0) {
+      return;
+    }
+    const size_type offset = position - begin();
+    if (size_type(end_of_storage_ - finish_) < n) {
+      __expand_and_copy_storage(__calc_new_capacity(n));
+    }
+    pointer pos = start_ + offset;
+    pointer old_finish = finish_;
+    const size_type elems_after = old_finish - pos;
+    if (elems_after > n) {
+      finish_ = __uninitialized_move_a(allocator_, old_finish - n, old_finish,
+                                       old_finish);
+      __move_backward_within(pos, old_finish - n, old_finish);
+      std::copy(first, last, pos);
+    } else {
+      ForwardIterator mid = first;
+      std::advance(mid, elems_after);
+      finish_ = __uninitialized_copy_a(allocator_, mid, last, old_finish);
+      finish_ = __uninitialized_move_a(allocator_, pos, old_finish, finish_);
+      std::copy(first, mid, pos);
+    }
+  }
+
+  // 古い領域の要素を破棄し, ヒープなら解放して新しい領域に置き換える.
+  void __adopt_storage(pointer new_start, pointer new_finish,
+                       size_type new_cap) {
+    __destroy_a(allocator_, start_, finish_);
+    __release_heap();
+    start_ = new_start;
+    finish_ = new_finish;
+    end_of_storage_ = start_ + new_cap;
+  }
+};
+
+template <class T, std::size_t N, class Alloc>
+const typename small_vector<T, N, Alloc>::size_type
+    small_vector<T, N, Alloc>::inline_capacity;
+
+template <class T, std::size_t N, class Alloc>
+bool operator==(const small_vector<T, N, Alloc> &lhs,
+                const small_vector<T, N, Alloc> &rhs) {
+  return lhs.size() == rhs.size() &&
+         ft::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, std::size_t N, class Alloc>
+bool operator!=(const small_vector<T, N, Alloc> &lhs,
+                const small_vector<T, N, Alloc> &rhs) {
+  return !(lhs == rhs);
+}
+
+template <class T, std::size_t N, class Alloc>
+bool operator<(const small_vector<T, N, Alloc> &lhs,
+               const small_vector<T, N, Alloc> &rhs) {
+  return ft::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                     rhs.end());
+}
+
+template <class T, std::size_t N, class Alloc>
+bool operator<=(const small_vector<T, N, Alloc> &lhs,
+                const small_vector<T, N, Alloc> &rhs) {
+  return !(lhs > rhs);
+}
+
+template <class T, std::size_t N, class Alloc>
+bool operator>(const small_vector<T, N, Alloc> &lhs,
+               const small_vector<T, N, Alloc> &rhs) {
+  return rhs < lhs;
+}
+
+template <class T, std::size_t N, class Alloc>
+bool operator>=(const small_vector<T, N, Alloc> &lhs,
+                const small_vector<T, N, Alloc> &rhs) {
+  return !(lhs < rhs);
+}
+
+}  // namespace ft
+
+namespace std {
+template <typename T, std::size_t N, typename Alloc>
+inline void swap(ft::small_vector<T, N, Alloc> &lhs,
+                 ft::small_vector<T, N, Alloc> &rhs) {
+  lhs.swap(rhs);
+}
+}  // namespace std
+
+#endif
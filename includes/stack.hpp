@@ -1,6 +1,10 @@
 #ifndef STACK_H_
 #define STACK_H_
 
+#if __cplusplus >= 201103L
+#include <type_traits>
+#endif
+
 #include "vector.hpp"
 
 namespace ft {
@@ -47,6 +51,21 @@ class stack {
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  explicit stack(container_type&& container) : c(std::move(container)) {}
+
+  // 中のコンテナのムーブが例外を投げなければ stack も投げない.
+  stack(stack<T, Container>&& other) noexcept(
+      std::is_nothrow_move_constructible<Container>::value)
+      : c(std::move(other.c)) {}
+
+  stack<T, Container>& operator=(stack<T, Container>&& rhs) noexcept(
+      std::is_nothrow_move_assignable<Container>::value) {
+    c = std::move(rhs.c);
+    return *this;
+  }
+#endif
+
   ~stack() {}
 
   bool empty() const {
@@ -69,6 +88,17 @@ class stack {
     c.push_back(val);
   }
 
+#if __cplusplus >= 201103L
+  void push(value_type&& val) {
+    c.push_back(std::move(val));
+  }
+
+  template <class... Args>
+  void emplace(Args&&... args) {
+    c.emplace_back(std::forward<Args>(args)...);
+  }
+#endif
+
   void pop() {
     c.pop_back();
   }
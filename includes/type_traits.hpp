@@ -157,6 +157,57 @@ struct is_same : public false_type {};
 template <typename T>
 struct is_same<T, T> : public true_type {};
 
+/* is_trivially_copyable, is_trivially_destructible
+C++98 には型がトリビアルかどうかを調べる標準の方法が無いので,
+GCC と Clang が提供している組み込み関数を使う.
+組み込み関数が無いコンパイラでは整数型のみをトリビアルとみなす.
+(false になっても要素ごとの処理にフォールバックするだけなので安全側に倒れる)
+*/
+#if defined(__clang__)
+#define FT_IS_TRIVIALLY_COPYABLE(T) __is_trivially_copyable(T)
+#define FT_IS_TRIVIALLY_DESTRUCTIBLE(T) __is_trivially_destructible(T)
+#elif defined(__GNUC__)
+#define FT_IS_TRIVIALLY_COPYABLE(T) __is_trivially_copyable(T)
+#define FT_IS_TRIVIALLY_DESTRUCTIBLE(T) __has_trivial_destructor(T)
+#else
+#define FT_IS_TRIVIALLY_COPYABLE(T) is_integral<T>::value
+#define FT_IS_TRIVIALLY_DESTRUCTIBLE(T) is_integral<T>::value
+#endif
+
+template <typename T>
+struct is_trivially_copyable
+    : public integral_constant<bool, FT_IS_TRIVIALLY_COPYABLE(T)> {};
+
+template <typename T>
+struct is_trivially_destructible
+    : public integral_constant<bool, FT_IS_TRIVIALLY_DESTRUCTIBLE(T)> {};
+
+/* is_monotonic_allocator
+アロケータ Alloc が is_monotonic を持つかどうか.
+単調なアロケータ(arena_allocator など)は deallocate() で領域を再利用せず,
+アロケータを共有する全てのコピーが無くなった時にまとめて解放する.
+construct() と destroy() もコンストラクタとデストラクタを呼ぶだけとする.
+このため要素のデストラクタが何もしなければ,
+コンテナは要素を1つずつ破棄, 解放しなくて良い.
+*/
+template <class Alloc>
+struct is_monotonic_allocator {
+ private:
+  typedef char yes_type;
+  struct no_type {
+    char dummy[2];
+  };
+
+  template <class U>
+  static yes_type test(typename U::is_monotonic *);
+  template <class U>
+  static no_type test(...);
+
+ public:
+  static const bool value = sizeof(test<Alloc>(0)) == sizeof(yes_type);
+  typedef integral_constant<bool, value> type;
+};
+
 }  // namespace ft
 
 #endif
\ No newline at end of file
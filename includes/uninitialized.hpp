@@ -0,0 +1,321 @@
+#ifndef UNINITIALIZED_H_
+#define UNINITIALIZED_H_
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#if __cplusplus >= 201103L
+#include <type_traits>
+#endif
+
+#include "normal_iterator.hpp"
+#include "type_traits.hpp"
+
+namespace ft {
+
+/* ft::vector と ft::small_vector が共有する, 未初期化領域への要素の構築,
+ * 破棄, 移し替え.
+ *
+ * 要素は全て alloc の construct()/destroy() を通して扱う. 途中で例外が
+ * 発生した場合は, その関数が構築した分だけを破棄してから投げ直す.
+ */
+
+// 要素の構築と破棄を alloc を経由せずに memcpy や
+// デストラクタ呼び出しの省略で済ませられるかどうか.
+// std::allocator 以外の allocator は construct()/destroy()
+// に副作用を持たせられるので要素ごとの処理を維持する.
+// 単調なアロケータの destroy() はデストラクタを呼ぶだけなので省略出来る.
+template <class T, class Alloc>
+struct __is_bitwise_constructible
+    : integral_constant<bool,
+                        is_trivially_copyable<T>::value &&
+                            is_same<Alloc, std::allocator<T> >::value> {};
+
+template <class T, class Alloc>
+struct __is_trivially_destroyable
+    : integral_constant<bool, is_trivially_destructible<T>::value &&
+                                  (is_same<Alloc, std::allocator<T> >::value ||
+                                   is_monotonic_allocator<Alloc>::value)> {};
+
+#if __cplusplus >= 201103L
+template <class Alloc, class T, class... Args>
+inline void __construct_a(Alloc &alloc, T *p, Args &&...args) {
+  std::allocator_traits<Alloc>::construct(alloc, p,
+                                          std::forward<Args>(args)...);
+}
+#else
+template <class Alloc, class T, class U>
+inline void __construct_a(Alloc &alloc, T *p, const U &val) {
+  alloc.construct(p, val);
+}
+#endif
+
+template <class Alloc, class T>
+inline void __destroy_a(Alloc &alloc, T *first, T *last, true_type) {
+  // デストラクタが何もしないので要素ごとのループを省略する
+  (void)alloc;
+  (void)first;
+  (void)last;
+}
+
+template <class Alloc, class T>
+inline void __destroy_a(Alloc &alloc, T *first, T *last, false_type) {
+  for (; first != last; ++first) {
+    alloc.destroy(first);
+  }
+}
+
+template <class Alloc, class T>
+inline void __destroy_a(Alloc &alloc, T *first, T *last) {
+  __destroy_a(alloc, first, last,
+              typename __is_trivially_destroyable<T, Alloc>::type());
+}
+
+// 未初期化領域に代入はできないので, 先頭の1つだけ構築して,
+// 残りは構築済みの部分を memcpy で倍々に複製する.
+template <class Alloc, class T>
+inline void __uninitialized_fill_n_a(Alloc &alloc, T *first, std::size_t count,
+                                     const T &value, true_type) {
+  if (count == 0) {
+    return;
+  }
+  __construct_a(alloc, first, value);
+  for (std::size_t filled = 1; filled < count;) {
+    const std::size_t chunk = std::min(filled, count - filled);
+    std::memcpy(static_cast<void *>(first + filled),
+                static_cast<const void *>(first), chunk * sizeof(T));
+    filled += chunk;
+  }
+}
+
+template <class Alloc, class T>
+inline void __uninitialized_fill_n_a(Alloc &alloc, T *first, std::size_t count,
+                                     const T &value, false_type) {
+  T *current = first;
+  try {
+    for (std::size_t i = 0; i < count; ++i, ++current) {
+      __construct_a(alloc, current, value);
+    }
+  } catch (...) {
+    __destroy_a(alloc, first, current);
+    throw;
+  }
+}
+
+template <class Alloc, class T>
+inline void __uninitialized_fill_n_a(Alloc &alloc, T *first, std::size_t count,
+                                     const T &value) {
+  __uninitialized_fill_n_a(
+      alloc, first, count, value,
+      typename __is_bitwise_constructible<T, Alloc>::type());
+}
+
+// 1つずつ構築する. 他の __uninitialized_copy_a はここに行き着く.
+template <class Alloc, class InputIt, class T>
+inline T *__uninitialized_copy_each_a(Alloc &alloc, InputIt first,
+                                      InputIt last, T *d_first) {
+  T *current = d_first;
+  try {
+    for (; first != last; ++first, ++current) {
+      __construct_a(alloc, current, *first);
+    }
+    return current;
+  } catch (...) {
+    __destroy_a(alloc, d_first, current);
+    throw;
+  }
+}
+
+template <class Alloc, class InputIt, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc, InputIt first, InputIt last,
+                                 T *d_first) {
+  return __uninitialized_copy_each_a(alloc, first, last, d_first);
+}
+
+// 連続領域からのコピーは memcpy でまとめてコピー出来る可能性があるので,
+// ポインタと normal_iterator はポインタに揃えてから振り分ける.
+template <class Alloc, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc, const T *first, const T *last,
+                                 T *d_first, true_type) {
+  (void)alloc;
+  const std::size_t n = last - first;
+  if (n != 0) {
+    std::memcpy(static_cast<void *>(d_first), static_cast<const void *>(first),
+                n * sizeof(T));
+  }
+  return d_first + n;
+}
+
+template <class Alloc, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc, const T *first, const T *last,
+                                 T *d_first, false_type) {
+  return __uninitialized_copy_each_a(alloc, first, last, d_first);
+}
+
+template <class Alloc, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc, const T *first, const T *last,
+                                 T *d_first) {
+  return __uninitialized_copy_a(
+      alloc, first, last, d_first,
+      typename __is_bitwise_constructible<T, Alloc>::type());
+}
+
+template <class Alloc, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc, T *first, T *last, T *d_first) {
+  return __uninitialized_copy_a(alloc, const_cast<const T *>(first),
+                                const_cast<const T *>(last), d_first);
+}
+
+template <class Alloc, class Pointer, class Container, class T>
+inline T *__uninitialized_copy_a(Alloc &alloc,
+                                 normal_iterator<Pointer, Container> first,
+                                 normal_iterator<Pointer, Container> last,
+                                 T *d_first) {
+  return __uninitialized_copy_a(alloc, first.base(), last.base(), d_first);
+}
+
+// [first, last) の要素を d_first から始まる未初期化領域にムーブする.
+// C++98 ではムーブが無いのでコピーになる.
+#if __cplusplus >= 201103L
+template <class Alloc, class T>
+inline T *__uninitialized_move_a(Alloc &alloc, T *first, T *last, T *d_first,
+                                 true_type) {
+  return __uninitialized_copy_a(alloc, first, last, d_first);
+}
+
+template <class Alloc, class T>
+inline T *__uninitialized_move_a(Alloc &alloc, T *first, T *last, T *d_first,
+                                 false_type) {
+  return __uninitialized_copy_a(alloc, std::make_move_iterator(first),
+                                std::make_move_iterator(last), d_first);
+}
+#endif
+
+template <class Alloc, class T>
+inline T *__uninitialized_move_a(Alloc &alloc, T *first, T *last, T *d_first) {
+#if __cplusplus >= 201103L
+  return __uninitialized_move_a(
+      alloc, first, last, d_first,
+      typename __is_bitwise_constructible<T, Alloc>::type());
+#else
+  return __uninitialized_copy_a(alloc, first, last, d_first);
+#endif
+}
+
+// 構築済みの領域内で [first, last) を d_first から始まる位置に代入する.
+// d_first <= first であれば領域が重なっていても良い.
+// C++11 以降はムーブ代入, C++98 ではコピー代入になる.
+template <class T>
+inline T *__move_within(T *first, T *last, T *d_first, true_type) {
+  const std::size_t n = last - first;
+  if (n != 0) {
+    std::memmove(static_cast<void *>(d_first), static_cast<const void *>(first),
+                 n * sizeof(T));
+  }
+  return d_first + n;
+}
+
+template <class T>
+inline T *__move_within(T *first, T *last, T *d_first, false_type) {
+#if __cplusplus >= 201103L
+  return std::move(first, last, d_first);
+#else
+  return std::copy(first, last, d_first);
+#endif
+}
+
+template <class T>
+inline T *__move_within(T *first, T *last, T *d_first) {
+  return __move_within(first, last, d_first,
+                       typename is_trivially_copyable<T>::type());
+}
+
+// 構築済みの領域内で [first, last) を d_last で終わる位置に代入する.
+// d_last >= last であれば領域が重なっていても良い.
+template <class T>
+inline T *__move_backward_within(T *first, T *last, T *d_last, true_type) {
+  const std::size_t n = last - first;
+  if (n != 0) {
+    std::memmove(static_cast<void *>(d_last - n),
+                 static_cast<const void *>(first), n * sizeof(T));
+  }
+  return d_last - n;
+}
+
+template <class T>
+inline T *__move_backward_within(T *first, T *last, T *d_last, false_type) {
+#if __cplusplus >= 201103L
+  return std::move_backward(first, last, d_last);
+#else
+  return std::copy_backward(first, last, d_last);
+#endif
+}
+
+template <class T>
+inline T *__move_backward_within(T *first, T *last, T *d_last) {
+  return __move_backward_within(first, last, d_last,
+                                typename is_trivially_copyable<T>::type());
+}
+
+// 既存の要素を new_start から始まる未初期化領域に構築し直す.
+// 再確保時の要素の移し替えは全てここを通る.
+// C++11 以降はムーブコンストラクタが例外を投げない場合のみムーブする.
+// 例外を投げうる場合は強い例外保証のためにコピーする.
+// (コピー出来ない型はムーブするしかないので std::move_if_noexcept と同じ扱い)
+#if __cplusplus >= 201103L
+template <class Alloc, class T>
+inline T *__relocate_a(Alloc &alloc, T *first, T *last, T *new_start,
+                       true_type) {
+  return __uninitialized_move_a(alloc, first, last, new_start);
+}
+
+template <class Alloc, class T>
+inline T *__relocate_a(Alloc &alloc, T *first, T *last, T *new_start,
+                       false_type) {
+  return __uninitialized_copy_a(alloc, first, last, new_start);
+}
+#endif
+
+template <class Alloc, class T>
+inline T *__relocate_a(Alloc &alloc, T *first, T *last, T *new_start) {
+#if __cplusplus >= 201103L
+  return __relocate_a(
+      alloc, first, last, new_start,
+      integral_constant<bool, std::is_nothrow_move_constructible<T>::value ||
+                                  !std::is_copy_constructible<T>::value>());
+#else
+  return __uninitialized_copy_a(alloc, first, last, new_start);
+#endif
+}
+
+/* 再確保で [first, pos) と [pos, last) を new_start からの新しい領域に
+ * 移し, その間に n 個分の隙間を空ける. 隙間には呼び出し側が先に要素を
+ * 構築しておく. (挿入する値が移す前の要素を参照していても良いように)
+ * 移す途中で例外が発生した場合は, 隙間の要素も含めて新しい領域に構築した
+ * 要素を全て破棄して投げ直す. 新しい領域の解放は呼び出し側で行う.
+ * 新しい領域の最後の要素の次を返す.
+ */
+template <class Alloc, class T>
+inline T *__relocate_around_a(Alloc &alloc, T *first, T *pos, T *last,
+                              T *new_start, std::size_t n) {
+  T *new_pos = new_start + (pos - first);
+  T *new_finish;
+  try {
+    new_finish = __relocate_a(alloc, first, pos, new_start);
+    try {
+      new_finish = __relocate_a(alloc, pos, last, new_finish + n);
+    } catch (...) {
+      __destroy_a(alloc, new_start, new_pos);
+      throw;
+    }
+  } catch (...) {
+    __destroy_a(alloc, new_pos, new_pos + n);
+    throw;
+  }
+  return new_finish;
+}
+
+}  // namespace ft
+
+#endif
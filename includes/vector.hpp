@@ -1,5 +1,7 @@
 #ifndef VECTOR_H_
 #define VECTOR_H_
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -8,6 +10,8 @@
 #include "lexicographical_compare.hpp"
 #include "normal_iterator.hpp"
 #include "reverse_iterator.hpp"
+#include "type_traits.hpp"
+#include "uninitialized.hpp"
 
 namespace ft {
 template <typename T, typename Allocator = std::allocator<T> >
@@ -34,19 +38,21 @@ class vector {
   pointer end_of_storage_;
 
  public:
-  vector(size_type n = 0, const value_type &val = value_type(),
-         allocator_type alloc = allocator_type())
+  // 要素を構築しないのでコピー出来ない型(C++11 のムーブオンリー型)でも使える.
+  // 空の vector は領域を確保せず NULL を持つ.
+  vector()
+      : allocator_(), cap_(0), start_(), finish_(), end_of_storage_() {}
+
+  explicit vector(size_type n, const value_type &val = value_type(),
+                  allocator_type alloc = allocator_type())
       : allocator_(alloc), cap_(n) {
     __allocate(cap_);
-    __uninitialized_fill_n(start_, n, val);
+    __uninitialized_fill_n_a(allocator_, start_, n, val);
     finish_ = start_ + n;
   }
 
-  explicit vector(const Allocator &alloc) : allocator_(alloc), cap_(0) {
-    __allocate(cap_);
-    __uninitialized_fill_n(start_, size_type(0), value_type());
-    finish_ = start_;
-  }
+  explicit vector(const Allocator &alloc)
+      : allocator_(alloc), cap_(0), start_(), finish_(), end_of_storage_() {}
 
   template <class InputIterator>
   vector(InputIterator first, InputIterator last,
@@ -74,8 +80,30 @@ class vector {
     return *this;
   }
 
+#if __cplusplus >= 201103L
+  vector(vector &&other) noexcept
+      : allocator_(std::move(other.allocator_)),
+        cap_(other.cap_),
+        start_(other.start_),
+        finish_(other.finish_),
+        end_of_storage_(other.end_of_storage_) {
+    other.cap_ = 0;
+    other.start_ = NULL;
+    other.finish_ = NULL;
+    other.end_of_storage_ = NULL;
+  }
+
+  vector &operator=(vector &&rhs) noexcept {
+    if (this != &rhs) {
+      vector tmp(std::move(rhs));
+      swap(tmp);
+    }
+    return *this;
+  }
+#endif
+
   ~vector() {
-    __destroy(start_, finish_);
+    __destroy_a(allocator_, start_, finish_);
     __deallocate();
   }
 
@@ -200,12 +228,12 @@ class vector {
 
   void assign(size_type n, const value_type &val) {
     if (n > capacity()) {
-      vector<T> tmp(n, val);
+      vector tmp(n, val, allocator_);
       swap(tmp);
     } else if (n > size()) {
       std::fill(begin(), end(), val);
       size_type remain = n - size();
-      __uninitialized_fill_n(finish_, remain, val);
+      __uninitialized_fill_n_a(allocator_, finish_, remain, val);
       finish_ = start_ + n;
     } else {
       std::fill_n(start_, n, val);
@@ -215,13 +243,30 @@ class vector {
   }
 
   void push_back(const value_type &val) {
-    if (size() == capacity()) {
-      __expand_and_copy_storage(__calc_new_capacity(capacity()));
+    if (finish_ != end_of_storage_) {
+      __construct_a(allocator_, finish_, val);
+      ++finish_;
+    } else {
+      __realloc_append(val);
     }
-    allocator_.construct(finish_, val);
-    ++finish_;
   }
 
+#if __cplusplus >= 201103L
+  void push_back(value_type &&val) {
+    emplace_back(std::move(val));
+  }
+
+  template <class... Args>
+  void emplace_back(Args &&...args) {
+    if (finish_ != end_of_storage_) {
+      __construct_a(allocator_, finish_, std::forward<Args>(args)...);
+      ++finish_;
+    } else {
+      __realloc_insert(finish_, std::forward<Args>(args)...);
+    }
+  }
+#endif
+
   void pop_back() {
     if (size() == 0) {
       return;
@@ -233,10 +278,8 @@ class vector {
   void resize(size_type n, T value = T()) {
     if (n < size()) {
       __erase_at_end(start_ + n);
-    } else {
-      for (size_type i = size(); i < n; ++i) {
-        push_back(value);
-      }
+    } else if (n > size()) {
+      __insert_n_val(end(), n - size(), value);
     }
   }
 
@@ -244,6 +287,32 @@ class vector {
     return __insert_n_val(position, 1, val);
   }
 
+#if __cplusplus >= 201103L
+  iterator insert(iterator position, value_type &&val) {
+    return emplace(position, std::move(val));
+  }
+
+  template <class... Args>
+  iterator emplace(iterator position, Args &&...args) {
+    const size_type offset = position - begin();
+    if (finish_ == end_of_storage_) {
+      __realloc_insert(position.base(), std::forward<Args>(args)...);
+    } else if (position == end()) {
+      __construct_a(allocator_, finish_, std::forward<Args>(args)...);
+      ++finish_;
+    } else {
+      // args が vector 内の要素を参照している可能性があるので,
+      // 要素をずらす前に一時オブジェクトを構築しておく.
+      value_type tmp(std::forward<Args>(args)...);
+      __construct_a(allocator_, finish_, std::move(*(finish_ - 1)));
+      ++finish_;
+      __move_backward_within(position.base(), finish_ - 2, finish_ - 1);
+      *position = std::move(tmp);
+    }
+    return begin() + offset;
+  }
+#endif
+
   void insert(iterator position, size_type n, const value_type &val) {
     __insert_n_val(position, n, val);
   }
@@ -259,7 +328,7 @@ class vector {
 
   iterator erase(iterator position) {
     if (position + 1 != end())
-      std::copy(position + 1, end(), position);
+      __move_within(position.base() + 1, finish_, position.base());
     --finish_;
     allocator_.destroy(finish_);
     return position;
@@ -268,14 +337,15 @@ class vector {
   iterator erase(iterator first, iterator last) {
     if (first != last) {
       if (last != end()) {
-        std::copy(last, end(), first);
+        __move_within(last.base(), finish_, first.base());
       }
       __erase_at_end(first.base() + (end() - last));
     }
     return first;
   }
 
-  void swap(vector<T> &x) {
+  void swap(vector &x) {
+    std::swap(allocator_, x.allocator_);
     std::swap(cap_, x.cap_);
     std::swap(start_, x.start_);
     std::swap(finish_, x.finish_);
@@ -292,21 +362,18 @@ class vector {
   }
 
  private:
+  // 容量 0 の場合は allocate(0) を呼ばずに NULL を持たせる.
   void __allocate(size_type cap) {
-    start_ = allocator_.allocate(cap);
+    start_ = cap == 0 ? pointer() : allocator_.allocate(cap);
     finish_ = start_;
     cap_ = cap;
     end_of_storage_ = start_ + cap_;
   }
 
-  void __destroy(pointer first, pointer last) {
-    for (; first != last; ++first) {
-      allocator_.destroy(first);
-    }
-  }
-
   void __deallocate() {
-    allocator_.deallocate(start_, cap_);
+    if (start_ != NULL) {
+      allocator_.deallocate(start_, cap_);
+    }
     start_ = NULL;
     finish_ = NULL;
     cap_ = 0;
@@ -314,47 +381,10 @@ class vector {
   }
 
   void __erase_at_end(pointer new_finish) {
-    __destroy(new_finish, finish_);
+    __destroy_a(allocator_, new_finish, finish_);
     finish_ = new_finish;
   }
 
-  template <class ForwardIterator, class Size, class _T>
-  void __uninitialized_fill_n(ForwardIterator first, Size count,
-                              const _T &value) {
-    typedef typename iterator_traits<ForwardIterator>::value_type V;
-
-    ForwardIterator current = first;
-    try {
-      for (size_type i = 0; i < count; ++i, ++current) {
-        allocator_.construct(current, value);
-      }
-    } catch (...) {
-      for (; first != current; ++first) {
-        first->~V();
-      }
-      throw;
-    }
-  }
-
-  template <class InputIt, class ForwardIterator>
-  ForwardIterator __uninitialized_copy(InputIt first, InputIt last,
-                                       ForwardIterator d_first) {
-    typedef typename iterator_traits<ForwardIterator>::value_type V;
-
-    ForwardIterator current = d_first;
-    try {
-      for (; first != last; ++first, ++current) {
-        allocator_.construct(current, *first);
-      }
-      return current;
-    } catch (...) {
-      for (; d_first != current; ++d_first) {
-        d_first->~V();
-      }
-      throw;
-    }
-  }
-
   template <class InputIterator>
   void __range_initialize(InputIterator first, InputIterator last,
                           std::input_iterator_tag) {
@@ -371,21 +401,100 @@ class vector {
       throw std::length_error(
           "cannot create std::vector larger than max_size()");
     __allocate(len);
-    __uninitialized_copy(first, last, start_);
+    __uninitialized_copy_a(allocator_, first, last, start_);
     finish_ = start_ + len;
   }
 
+  // allocator_ で new_cap の領域を確保し, 要素を1度だけ構築し直して移す.
+  // 要素のコピー中に例外が発生した場合は新しい領域を解放して
+  // 元の状態のまま例外を投げ直す(強い例外保証).
   void __expand_and_copy_storage(size_type new_cap) {
-    if (size() == 0) {
-      // 要素がない場合は新しい領域を確保するだけ
-      __deallocate();
-      __allocate(new_cap);
-    } else {
-      vector<T> tmp;
-      tmp.reserve(new_cap);
-      tmp = *this;
-      swap(tmp);
+    if (__try_extend_storage(new_cap)) {
+      return;
+    }
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      new_finish = __relocate_a(allocator_, start_, finish_, new_start);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
     }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+
+  // 容量が足りない時の push_back().
+  // val が vector 内の要素を指している場合があるので,
+  // 古い領域を解放する前に新しい領域に val を構築する.
+  void __realloc_append(const value_type &val) {
+    const size_type old_size = size();
+    const size_type new_cap = __calc_new_capacity(capacity());
+    if (__try_extend_storage(new_cap)) {
+      // 要素は動かないので val が vector 内を指していてもそのまま使える.
+      __construct_a(allocator_, finish_, val);
+      ++finish_;
+      return;
+    }
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      __construct_a(allocator_, new_start + old_size, val);
+      new_finish = __relocate_around_a(allocator_, start_, finish_, finish_,
+                                       new_start, 1);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
+    }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+
+#if __cplusplus >= 201103L
+  // 容量が足りない時の emplace(), emplace_back().
+  // args が vector 内の要素を参照している場合があるので,
+  // 既存の要素を移す前に新しい領域に要素を構築する.
+  template <class... Args>
+  void __realloc_insert(pointer pos, Args &&...args) {
+    const size_type offset = pos - start_;
+    const size_type new_cap = __calc_new_capacity(capacity());
+    if (pos == finish_ && __try_extend_storage(new_cap)) {
+      __construct_a(allocator_, finish_, std::forward<Args>(args)...);
+      ++finish_;
+      return;
+    }
+    pointer new_start = allocator_.allocate(new_cap);
+    pointer new_finish;
+    try {
+      __construct_a(allocator_, new_start + offset,
+                    std::forward<Args>(args)...);
+      new_finish = __relocate_around_a(allocator_, start_, pos, finish_,
+                                       new_start, 1);
+    } catch (...) {
+      allocator_.deallocate(new_start, new_cap);
+      throw;
+    }
+    __adopt_storage(new_start, new_finish, new_cap);
+  }
+#endif
+
+  // アロケータが今の領域をその場で広げられる場合(arena_allocator で最後に
+  // 確保した領域など)は, 要素を移さずに容量だけを new_cap に増やす.
+  bool __try_extend_storage(size_type new_cap) {
+    return __try_extend_storage(
+        new_cap, typename is_monotonic_allocator<Allocator>::type());
+  }
+
+  bool __try_extend_storage(size_type new_cap, false_type) {
+    (void)new_cap;
+    return false;
+  }
+
+  bool __try_extend_storage(size_type new_cap, true_type) {
+    if (start_ == NULL || !allocator_.extend(start_, cap_, new_cap)) {
+      return false;
+    }
+    cap_ = new_cap;
+    end_of_storage_ = start_ + cap_;
+    return true;
   }
 
   inline size_type __calc_new_capacity(size_type current_capacity) {
@@ -397,6 +506,16 @@ class vector {
     return std::min(current_capacity * 2, max_size());
   }
 
+  // n 個の要素を追加する時の新しい容量.
+  // 1つずつ追加した時と同様に少なくとも現在の要素数の2倍に拡張する.
+  size_type __calc_new_capacity_for_insert(size_type n) {
+    if (max_size() - size() < n) {
+      throw std::length_error("vector::__calc_new_capacity_for_insert");
+    }
+    const size_type new_cap = size() + std::max(size(), n);
+    return (new_cap < size() || new_cap > max_size()) ? max_size() : new_cap;
+  }
+
   template <class InputIterator>
   void __assign_range(InputIterator first, InputIterator last,
                       std::input_iterator_tag) {
@@ -416,10 +535,10 @@ class vector {
                       std::forward_iterator_tag) {
     size_type new_size = std::distance(first, last);
     if (new_size > capacity()) {
-      __destroy(start_, finish_);
+      __destroy_a(allocator_, start_, finish_);
       __deallocate();
       __allocate(new_size);
-      __uninitialized_copy(first, last, start_);
+      __uninitialized_copy_a(allocator_, first, last, start_);
       finish_ = start_ + new_size;
     } else if (new_size <= size()) {
       __erase_at_end(std::copy(first, last, start_));
@@ -427,26 +546,52 @@ class vector {
       ForwardIterator mid = first;
       std::advance(mid, size());
       std::copy(first, mid, start_);
-      finish_ = __uninitialized_copy(mid, last, finish_);
+      finish_ = __uninitialized_copy_a(allocator_, mid, last, finish_);
     }
   }
 
   iterator __insert_n_val(iterator position, size_type n,
                           const value_type &val) {
-    vector<T> tmp_vec;
-    size_type new_size = size() + n;
-    tmp_vec.reserve(new_size);
-    iterator tmp_vec_it = tmp_vec.begin();
-    tmp_vec_it = std::copy(begin(), position, tmp_vec_it);
-    tmp_vec.finish_ += std::distance(begin(), position);
-    iterator first_inserted_element_it = tmp_vec_it;
-    std::fill_n(tmp_vec_it, n, val);
-    tmp_vec_it += n;
-    tmp_vec.finish_ += n;
-    std::copy(position, end(), tmp_vec_it);
-    tmp_vec.finish_ += std::distance(position, end());
-    swap(tmp_vec);
-    return first_inserted_element_it;
+    const size_type offset = position - begin();
+    if (n == 0) {
+      return position;
+    }
+    pointer pos = position.base();
+    if (size_type(end_of_storage_ - finish_) >= n) {
+      // 容量が足りている場合は再確保せずに後ろの要素を n 個ずらす.
+      // val が vector 内の要素を指している可能性があるのでコピーしておく.
+      const value_type val_copy(val);
+      pointer old_finish = finish_;
+      const size_type elems_after = old_finish - pos;
+      if (elems_after > n) {
+        finish_ = __uninitialized_move_a(allocator_, old_finish - n,
+                                         old_finish, old_finish);
+        __move_backward_within(pos, old_finish - n, old_finish);
+        std::fill(pos, pos + n, val_copy);
+      } else {
+        __uninitialized_fill_n_a(allocator_, old_finish, n - elems_after,
+                                 val_copy);
+        finish_ += n - elems_after;
+        finish_ = __uninitialized_move_a(allocator_, pos, old_finish, finish_);
+        std::fill(pos, old_finish, val_copy);
+      }
+    } else {
+      // val が vector 内の要素を指している可能性があるので,
+      // 既存の要素を移す前に新しい領域に値を埋める.
+      const size_type new_cap = __calc_new_capacity_for_insert(n);
+      pointer new_start = allocator_.allocate(new_cap);
+      pointer new_finish;
+      try {
+        __uninitialized_fill_n_a(allocator_, new_start + offset, n, val);
+        new_finish = __relocate_around_a(allocator_, start_, pos, finish_,
+                                         new_start, n);
+      } catch (...) {
+        allocator_.deallocate(new_start, new_cap);
+        throw;
+      }
+      __adopt_storage(new_start, new_finish, new_cap);
+    }
+    return begin() + offset;
   }
 
   template <class InputIterator>
@@ -462,21 +607,56 @@ class vector {
     }
   }
 
-  template <class InputIterator>
-  void __insert_range(iterator position, InputIterator first,
-                      InputIterator last, std::forward_iterator_tag) {
-    vector<T> tmp_vec;
-    size_type n = std::distance(first, last);
-    size_type new_size = size() + n;
-    tmp_vec.reserve(new_size);
-    iterator tmp_vec_it = tmp_vec.begin();
-    tmp_vec_it = std::copy(begin(), position, tmp_vec_it);
-    tmp_vec.finish_ += std::distance(begin(), position);
-    tmp_vec_it = std::copy(first, last, tmp_vec_it);
-    tmp_vec.finish_ += n;
-    std::copy(position, end(), tmp_vec_it);
-    tmp_vec.finish_ += std::distance(position, end());
-    swap(tmp_vec);
+  template <class ForwardIterator>
+  void __insert_range(iterator position, ForwardIterator first,
+                      ForwardIterator last, std::forward_iterator_tag) {
+    const size_type n = std::distance(first, last);
+    if (n == 0) {
+      return;
+    }
+    pointer pos = position.base();
+    if (size_type(end_of_storage_ - finish_) >= n) {
+      // 容量が足りている場合は再確保せずに後ろの要素を n 個ずらす.
+      pointer old_finish = finish_;
+      const size_type elems_after = old_finish - pos;
+      if (elems_after > n) {
+        finish_ = __uninitialized_move_a(allocator_, old_finish - n,
+                                         old_finish, old_finish);
+        __move_backward_within(pos, old_finish - n, old_finish);
+        std::copy(first, last, pos);
+      } else {
+        ForwardIterator mid = first;
+        std::advance(mid, elems_after);
+        finish_ = __uninitialized_copy_a(allocator_, mid, last, old_finish);
+        finish_ = __uninitialized_move_a(allocator_, pos, old_finish, finish_);
+        std::copy(first, mid, pos);
+      }
+    } else {
+      const size_type new_cap = __calc_new_capacity_for_insert(n);
+      const size_type offset = pos - start_;
+      pointer new_start = allocator_.allocate(new_cap);
+      pointer new_finish;
+      try {
+        __uninitialized_copy_a(allocator_, first, last, new_start + offset);
+        new_finish = __relocate_around_a(allocator_, start_, pos, finish_,
+                                         new_start, n);
+      } catch (...) {
+        allocator_.deallocate(new_start, new_cap);
+        throw;
+      }
+      __adopt_storage(new_start, new_finish, new_cap);
+    }
+  }
+
+  // 古い領域の要素を破棄して解放し, 新しく確保した領域に置き換える.
+  void __adopt_storage(pointer new_start, pointer new_finish,
+                       size_type new_cap) {
+    __destroy_a(allocator_, start_, finish_);
+    __deallocate();
+    start_ = new_start;
+    finish_ = new_finish;
+    cap_ = new_cap;
+    end_of_storage_ = start_ + cap_;
   }
 };
 
@@ -0,0 +1,159 @@
+#include "arena_allocator.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "map.hpp"
+#include "set.hpp"
+#include "vector.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+TEST(ArenaAllocator, AllocationsAreBumpedContiguously) {
+  ft::arena_allocator<int> alloc;
+
+  int *first = alloc.allocate(1);
+  int *second = alloc.allocate(3);
+  int *third = alloc.allocate(1);
+  EXPECT_EQ(second, first + 1);
+  EXPECT_EQ(third, second + 3);
+}
+
+TEST(ArenaAllocator, OnlyLastAllocationIsReclaimed) {
+  ft::arena_allocator<int> alloc;
+
+  int *first = alloc.allocate(2);
+  int *second = alloc.allocate(2);
+  alloc.deallocate(first, 2);
+  EXPECT_EQ(alloc.allocate(1), second + 2);
+  alloc.deallocate(second + 2, 1);
+  EXPECT_EQ(alloc.allocate(1), second + 2);
+}
+
+TEST(ArenaAllocator, ExtendsLastAllocationInPlace) {
+  ft::arena_allocator<int> alloc(4096);
+
+  int *first = alloc.allocate(4);
+  EXPECT_TRUE(alloc.extend(first, 4, 100));
+  int *second = alloc.allocate(1);
+  EXPECT_EQ(second, first + 100);
+  EXPECT_FALSE(alloc.extend(first, 100, 200));
+  // チャンクに入りきらない大きさには広げない.
+  EXPECT_FALSE(alloc.extend(second, 1, 100000));
+}
+
+TEST(ArenaAllocator, RespectsAlignmentAndLargeRequests) {
+  ft::arena_allocator<char> chars(1024);
+  ft::arena_allocator<double> doubles(chars);
+
+  chars.allocate(1);
+  double *d = doubles.allocate(1);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % sizeof(double), 0u);
+
+  // 今のチャンクより大きい要求は, それが入るチャンクを新しく作る.
+  char *large = chars.allocate(100000);
+  large[0] = 'a';
+  large[99999] = 'z';
+  EXPECT_EQ(large[99999], 'z');
+}
+
+TEST(ArenaAllocator, CopiesAndRebindsShareTheArena) {
+  typedef ft::arena_allocator<int> allocator_type;
+  allocator_type alloc;
+  allocator_type copy(alloc);
+  allocator_type assigned;
+  assigned = alloc;
+  ft::arena_allocator<long> rebound(alloc);
+  allocator_type other;
+
+  EXPECT_TRUE(alloc == copy);
+  EXPECT_TRUE(alloc == assigned);
+  EXPECT_TRUE(rebound == alloc);
+  EXPECT_TRUE(alloc != other);
+
+  int *p = alloc.allocate(1);
+  EXPECT_EQ(copy.allocate(1), p + 1);
+}
+
+TEST(ArenaAllocator, MapOfTrivialValues) {
+  typedef ft::arena_allocator<ft::pair<const int, int> > allocator_type;
+  typedef ft::map<int, int, std::less<int>, allocator_type> map_type;
+  std::map<int, int> expected;
+  map_type m;
+
+  srand(21);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 2000; ++i) {
+      const int key = rand() % 1000;
+      if (rand() % 3 == 0) {
+        EXPECT_EQ(m.erase(key), expected.erase(key));
+      } else {
+        m[key] = i;
+        expected[key] = i;
+      }
+    }
+    ASSERT_EQ(m.size(), expected.size());
+    std::map<int, int>::iterator expected_it = expected.begin();
+    for (map_type::iterator it = m.begin(); it != m.end();
+         ++it, ++expected_it) {
+      EXPECT_EQ(it->first, expected_it->first);
+      EXPECT_EQ(it->second, expected_it->second);
+    }
+    // ノードを辿らずに手放しても, 空の木としてそのまま使える.
+    m.clear();
+    expected.clear();
+    EXPECT_TRUE(m.begin() == m.end());
+  }
+}
+
+TEST(ArenaAllocator, MapOfStringsDestroysValues) {
+  typedef ft::arena_allocator<ft::pair<const int, std::string> >
+      allocator_type;
+  typedef ft::map<int, std::string, std::less<int>, allocator_type> map_type;
+
+  map_type kept;
+  {
+    map_type m;
+    for (int i = 0; i < 500; ++i) {
+      m[i] = std::string(static_cast<std::size_t>(i % 50 + 20), 'a');
+    }
+    map_type copy(m);
+    m.clear();
+    EXPECT_EQ(copy[499], std::string(69, 'a'));
+    kept.swap(copy);
+  }
+  EXPECT_EQ(kept.size(), 500u);
+  kept.erase(kept.begin(), kept.find(250));
+  EXPECT_EQ(kept.begin()->first, 250);
+}
+
+TEST(ArenaAllocator, VectorGrowsInPlace) {
+  typedef ft::vector<int, ft::arena_allocator<int> > vector_type;
+
+  vector_type v;
+  v.push_back(0);
+  const int *data = v.data();
+  for (int i = 1; i < 1000; ++i) {
+    v.push_back(i);
+  }
+  // 他に確保していなければ, 伸ばす度に同じ領域を広げるだけで済む.
+  EXPECT_EQ(v.data(), data);
+  EXPECT_TRUE(v.capacity() >= 1000u);
+
+  vector_type other(v.get_allocator());
+  other.push_back(1);
+  // 後ろに別の確保があると, 新しい領域に移す.
+  for (int i = 1000; i < 3000; ++i) {
+    v.push_back(i);
+  }
+  EXPECT_TRUE(v.data() != data);
+  for (int i = 0; i < 3000; ++i) {
+    EXPECT_EQ(v[i], i);
+  }
+  v.reserve(10000);
+  EXPECT_EQ(v[2999], 2999);
+}
@@ -0,0 +1,670 @@
+#include "btree.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arena_allocator.hpp"
+#include "btree_map.hpp"
+#include "btree_set.hpp"
+#include "functional.hpp"
+#include "node_pool_allocator.hpp"
+#include "set.hpp"
+#include "vector.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+// NodeSize を 0 にすると1つのノードに値を3つしか入れないので,
+// 少ない要素数でも分割, 併合, 借用が起こり木が高くなる.
+typedef ft::BTree<int, int, ft::Identity<int>, std::less<int>,
+                  std::allocator<int>, 0>
+    small_btree_type;
+typedef ft::BTree<int, int, ft::Identity<int>, std::less<int> > btree_type;
+
+template <class Tree>
+int checkBTreeNode(const Tree &tree, const typename Tree::node_type *node,
+                   const typename Tree::node_type *parent,
+                   typename Tree::size_type &count, std::vector<int> &values) {
+  EXPECT_TRUE(node->parent_ == parent);
+  EXPECT_TRUE(node->count_ > 0);
+  EXPECT_TRUE(node->count_ <= Tree::kNodeSlots);
+  count += node->count_;
+  if (node->leaf_) {
+    for (std::size_t i = 0; i < node->count_; ++i) {
+      values.push_back(*node->value(i));
+    }
+    return 1;
+  }
+  int depth = -1;
+  for (std::size_t i = 0; i <= node->count_; ++i) {
+    const typename Tree::node_type *child = node->child(i);
+    EXPECT_EQ(child->position_, i);
+    const int child_depth = checkBTreeNode(tree, child, node, count, values);
+    if (depth == -1) {
+      depth = child_depth;
+    }
+    // 全ての葉は同じ深さにある
+    EXPECT_EQ(child_depth, depth);
+    if (i < node->count_) {
+      values.push_back(*node->value(i));
+    }
+  }
+  return depth + 1;
+}
+
+// B 木の条件とリンクを確かめ, 中間順の値を返す.
+template <class Tree>
+std::vector<int> expectBTreeKeepsRules(const Tree &tree) {
+  std::vector<int> values;
+  if (tree.root_ == NULL) {
+    EXPECT_EQ(tree.size(), typename Tree::size_type(0));
+    EXPECT_TRUE(tree.leftmost_ == NULL);
+    EXPECT_TRUE(tree.rightmost_ == NULL);
+    return values;
+  }
+  typename Tree::size_type count = 0;
+  const int height = checkBTreeNode(tree, tree.root_, NULL, count, values);
+  EXPECT_EQ(count, tree.size());
+  EXPECT_EQ(static_cast<typename Tree::size_type>(height), tree.height());
+  for (std::size_t i = 1; i < values.size(); ++i) {
+    EXPECT_TRUE(values[i - 1] < values[i]);
+  }
+  const typename Tree::node_type *leftmost = tree.root_;
+  while (!leftmost->leaf_) {
+    leftmost = leftmost->child(0);
+  }
+  const typename Tree::node_type *rightmost = tree.root_;
+  while (!rightmost->leaf_) {
+    rightmost = rightmost->child(rightmost->count_);
+  }
+  EXPECT_TRUE(tree.leftmost_ == leftmost);
+  EXPECT_TRUE(tree.rightmost_ == rightmost);
+  return values;
+}
+
+template <class Tree>
+void expectBTreeEqualsSet(const Tree &tree, const std::set<int> &expected) {
+  const std::vector<int> values = expectBTreeKeepsRules(tree);
+  EXPECT_EQ(values.size(), expected.size());
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), expected.begin()));
+  EXPECT_TRUE(std::equal(tree.begin(), tree.end(), expected.begin()));
+  EXPECT_TRUE(std::equal(tree.rbegin(), tree.rend(), expected.rbegin()));
+}
+
+// コピーが指定回数を超えると例外を投げる値.
+struct BTreeThrowingValue {
+  static int copies_left;
+  int value;
+
+  BTreeThrowingValue(int v = 0) : value(v) {}
+
+  BTreeThrowingValue(const BTreeThrowingValue &other) : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("BTreeThrowingValue");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+  }
+
+  bool operator<(const BTreeThrowingValue &other) const {
+    return value < other.value;
+  }
+};
+
+int BTreeThrowingValue::copies_left = -1;
+
+}  // namespace
+
+TEST(BTree, NodeHoldsAsManyValuesAsFitInNodeSize) {
+  typedef ft::BTreeNode<int, 256> node_type;
+
+  EXPECT_EQ(node_type::kSlots, (256 - node_type::kHeaderSize) / sizeof(int));
+  EXPECT_TRUE(sizeof(node_type) <= 256 + sizeof(long double));
+  EXPECT_EQ(small_btree_type::kNodeSlots, std::size_t(3));
+}
+
+TEST(BTree, EmptyTreeDoesNotAllocate) {
+  small_btree_type tree;
+
+  EXPECT_TRUE(tree.root_ == NULL);
+  EXPECT_TRUE(tree.begin() == tree.end());
+  EXPECT_EQ(tree.height(), std::size_t(0));
+  EXPECT_TRUE(tree.find(1) == tree.end());
+  EXPECT_TRUE(tree.lower_bound(1) == tree.end());
+  EXPECT_EQ(tree.erase(1), std::size_t(0));
+}
+
+TEST(BTree, RandomInsertAndErase) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  std::srand(42);
+  for (int i = 0; i < 2000; ++i) {
+    const int key = std::rand() % 500;
+    const bool inserted = tree.insert_unique(key).second;
+    EXPECT_EQ(inserted, expected.insert(key).second);
+  }
+  expectBTreeEqualsSet(tree, expected);
+  EXPECT_TRUE(tree.height() > 3);
+
+  for (int i = 0; i < 2000; ++i) {
+    const int key = std::rand() % 500;
+    EXPECT_EQ(tree.erase(key), expected.erase(key));
+    if (i % 100 == 0) {
+      expectBTreeEqualsSet(tree, expected);
+    }
+  }
+  expectBTreeEqualsSet(tree, expected);
+
+  while (!expected.empty()) {
+    const int key = *expected.begin();
+    tree.erase(tree.find(key));
+    expected.erase(key);
+  }
+  expectBTreeEqualsSet(tree, expected);
+  EXPECT_TRUE(tree.root_ == NULL);
+}
+
+TEST(BTree, SortedInsertFillsNodes) {
+  btree_type tree;
+  const int n = 10000;
+
+  for (int i = 0; i < n; ++i) {
+    tree.insert_unique(tree.end(), i);
+  }
+  expectBTreeKeepsRules(tree);
+  // 末尾への挿入では左のノードがほぼ満杯のまま残る.
+  std::size_t leaves = 0;
+  for (const btree_type::node_type *node = tree.leftmost_;;) {
+    ++leaves;
+    if (node == tree.rightmost_) {
+      break;
+    }
+    btree_type::const_iterator it(node, node->count_ - 1);
+    ++it;
+    ++it;
+    node = it.node_;
+  }
+  EXPECT_TRUE(leaves * (btree_type::kNodeSlots - 2) <= std::size_t(n));
+
+  btree_type reversed;
+  for (int i = n - 1; i >= 0; --i) {
+    reversed.insert_unique(reversed.begin(), i);
+  }
+  expectBTreeKeepsRules(reversed);
+  EXPECT_TRUE(tree == reversed);
+}
+
+TEST(BTree, HintIsUsedOnlyWhenCorrect) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  for (int i = 0; i < 100; i += 2) {
+    tree.insert_unique(i);
+    expected.insert(i);
+  }
+  // 正しい hint, 誤った hint, 既にあるキー
+  small_btree_type::iterator it = tree.insert_unique(tree.find(10), 9);
+  EXPECT_EQ(*it, 9);
+  it = tree.insert_unique(tree.find(10), 51);
+  EXPECT_EQ(*it, 51);
+  it = tree.insert_unique(tree.begin(), 20);
+  EXPECT_EQ(*it, 20);
+  it = tree.insert_unique(tree.end(), -1);
+  EXPECT_EQ(*it, -1);
+  expected.insert(9);
+  expected.insert(51);
+  expected.insert(-1);
+  expectBTreeEqualsSet(tree, expected);
+
+  // 内部ノードの値を hint にする
+  small_btree_type::iterator root_value(tree.root_, 0);
+  const int before = *root_value - 1;
+  if (expected.count(before) == 0) {
+    tree.insert_unique(root_value, before);
+    expected.insert(before);
+  }
+  expectBTreeEqualsSet(tree, expected);
+}
+
+TEST(BTree, BoundsAndIteration) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  for (int i = 0; i < 300; ++i) {
+    tree.insert_unique(i * 3);
+    expected.insert(i * 3);
+  }
+  for (int key = -2; key < 905; ++key) {
+    small_btree_type::const_iterator lower = tree.lower_bound(key);
+    small_btree_type::const_iterator upper = tree.upper_bound(key);
+    std::set<int>::const_iterator expected_lower = expected.lower_bound(key);
+    std::set<int>::const_iterator expected_upper = expected.upper_bound(key);
+    EXPECT_EQ(lower == tree.end(), expected_lower == expected.end());
+    EXPECT_EQ(upper == tree.end(), expected_upper == expected.end());
+    if (lower != tree.end()) {
+      EXPECT_EQ(*lower, *expected_lower);
+    }
+    if (upper != tree.end()) {
+      EXPECT_EQ(*upper, *expected_upper);
+    }
+    EXPECT_EQ(tree.count(key), expected.count(key));
+    ft::pair<small_btree_type::iterator, small_btree_type::iterator> range =
+        tree.equal_range(key);
+    EXPECT_EQ(std::distance(range.first, range.second),
+              static_cast<std::ptrdiff_t>(expected.count(key)));
+  }
+
+  small_btree_type::iterator it = tree.end();
+  std::set<int>::reverse_iterator expected_it = expected.rbegin();
+  while (it != tree.begin()) {
+    --it;
+    EXPECT_EQ(*it, *expected_it);
+    ++expected_it;
+  }
+}
+
+TEST(BTree, EraseRange) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  for (int i = 0; i < 500; ++i) {
+    tree.insert_unique(i);
+    expected.insert(i);
+  }
+  tree.erase(tree.find(100), tree.find(400));
+  expected.erase(expected.find(100), expected.find(400));
+  expectBTreeEqualsSet(tree, expected);
+
+  tree.erase(tree.begin(), tree.find(450));
+  expected.erase(expected.begin(), expected.find(450));
+  expectBTreeEqualsSet(tree, expected);
+
+  tree.erase(tree.begin(), tree.end());
+  expectBTreeEqualsSet(tree, std::set<int>());
+
+  srand(11);
+  for (int i = 0; i < 1000; ++i) {
+    tree.insert_unique(rand() % 2000);
+  }
+  expected = std::set<int>(tree.begin(), tree.end());
+  for (int i = 0; i < 50; ++i) {
+    const int from = rand() % 2000;
+    const int to = from + rand() % 100;
+    tree.erase(tree.lower_bound(from), tree.lower_bound(to));
+    expected.erase(expected.lower_bound(from), expected.lower_bound(to));
+  }
+  expectBTreeEqualsSet(tree, expected);
+}
+
+// 併合や借用で値が移っても, 消した値の次の値の位置を返す.
+TEST(BTree, EraseAtReturnsNextValue) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  srand(5);
+  for (int i = 0; i < 600; ++i) {
+    const int value = rand() % 1000;
+    tree.insert_unique(value);
+    expected.insert(value);
+  }
+  while (!expected.empty()) {
+    std::set<int>::iterator victim = expected.begin();
+    std::advance(victim, rand() % expected.size());
+    small_btree_type::iterator it = tree.find(*victim);
+    small_btree_type::iterator next = tree.__erase_at(it.node_, it.position_);
+    expected.erase(victim++);
+    if (victim == expected.end()) {
+      EXPECT_TRUE(next == tree.end());
+    } else {
+      EXPECT_TRUE(next != tree.end());
+      EXPECT_EQ(*next, *victim);
+    }
+  }
+  EXPECT_TRUE(tree.root_ == NULL);
+}
+
+TEST(BTree, CopyAssignAndSwap) {
+  small_btree_type tree;
+  std::set<int> expected;
+
+  for (int i = 0; i < 200; ++i) {
+    tree.insert_unique(i * 7 % 200);
+    expected.insert(i * 7 % 200);
+  }
+  small_btree_type copy(tree);
+  expectBTreeEqualsSet(copy, expected);
+  EXPECT_TRUE(copy == tree);
+
+  small_btree_type assigned;
+  assigned.insert_unique(1000);
+  assigned = tree;
+  expectBTreeEqualsSet(assigned, expected);
+
+  small_btree_type other;
+  other.insert_unique(-1);
+  other.swap(copy);
+  expectBTreeEqualsSet(other, expected);
+  EXPECT_EQ(copy.size(), std::size_t(1));
+  EXPECT_TRUE(copy < other);
+
+  // コピー元を変えてもコピーは変わらない
+  tree.clear();
+  expectBTreeEqualsSet(assigned, expected);
+}
+
+TEST(BTree, ThrowingCopyLeavesTreeUnchanged) {
+  typedef ft::BTree<BTreeThrowingValue, BTreeThrowingValue,
+                    ft::Identity<BTreeThrowingValue>,
+                    std::less<BTreeThrowingValue>,
+                    std::allocator<BTreeThrowingValue>, 0>
+      tree_type;
+
+  tree_type tree;
+  for (int i = 0; i < 50; ++i) {
+    tree.insert_unique(BTreeThrowingValue(i * 2));
+  }
+
+  // 挿入する値のコピーで失敗しても, 分割した木はそのまま使える.
+  for (int i = 0; i < 50; ++i) {
+    BTreeThrowingValue::copies_left = 0;
+    EXPECT_THROW(tree.insert_unique(BTreeThrowingValue(i * 2 + 1)),
+                 std::runtime_error);
+    BTreeThrowingValue::copies_left = -1;
+  }
+  EXPECT_EQ(tree.size(), std::size_t(50));
+  int expected = 0;
+  for (tree_type::iterator it = tree.begin(); it != tree.end(); ++it) {
+    EXPECT_EQ((*it).value, expected);
+    expected += 2;
+  }
+
+  // コピーの途中で失敗したら, コピー先は空のまま.
+  tree_type copy;
+  BTreeThrowingValue::copies_left = 30;
+  EXPECT_THROW(copy = tree, std::runtime_error);
+  BTreeThrowingValue::copies_left = -1;
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(copy.begin() == copy.end());
+
+  // 空の木に最初の値を入れる時に失敗しても空のまま.
+  tree_type empty;
+  BTreeThrowingValue::copies_left = 0;
+  EXPECT_THROW(empty.insert_unique(BTreeThrowingValue(1)), std::runtime_error);
+  BTreeThrowingValue::copies_left = -1;
+  EXPECT_TRUE(empty.root_ == NULL);
+}
+
+TEST(BTreeMap, BasicOperations) {
+  typedef ft::btree_map<int, std::string> map_type;
+
+  map_type m;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 1000; ++i) {
+    const int key = (i * 37) % 1000;
+    m[key] = std::string(key % 7 + 1, 'a');
+    expected[key] = std::string(key % 7 + 1, 'a');
+  }
+  EXPECT_EQ(m.size(), expected.size());
+  std::map<int, std::string>::iterator expected_it = expected.begin();
+  for (map_type::iterator it = m.begin(); it != m.end(); ++it) {
+    EXPECT_EQ((*it).first, expected_it->first);
+    EXPECT_EQ((*it).second, expected_it->second);
+    ++expected_it;
+  }
+
+  EXPECT_EQ(m.at(10), std::string(4, 'a'));
+  EXPECT_THROW(m.at(1000), std::out_of_range);
+  EXPECT_FALSE(m.insert(map_type::value_type(10, "x")).second);
+  EXPECT_EQ(m[10], std::string(4, 'a'));
+  EXPECT_TRUE(m.insert_or_assign(10, std::string("x")).second == false);
+  EXPECT_EQ(m[10], "x");
+  EXPECT_TRUE(m.insert_or_assign(m.end(), 2000, std::string("y")) ==
+              m.find(2000));
+  EXPECT_EQ(m.erase(2000), std::size_t(1));
+
+  for (int i = 0; i < 1000; i += 2) {
+    m.erase(m.find(i));
+  }
+  EXPECT_EQ(m.size(), std::size_t(500));
+  EXPECT_EQ(m.count(2), std::size_t(0));
+  EXPECT_EQ(m.count(3), std::size_t(1));
+  EXPECT_EQ((*m.lower_bound(2)).first, 3);
+  EXPECT_EQ((*m.upper_bound(3)).first, 5);
+}
+
+#if __cplusplus >= 201103L
+TEST(BTreeMap, TryEmplaceAndEmplace) {
+  typedef ft::btree_map<std::string, std::string> map_type;
+
+  map_type m;
+  std::string value("value");
+  EXPECT_TRUE(m.try_emplace("key", std::move(value)).second);
+  EXPECT_TRUE(value.empty());
+  std::string other("other");
+  EXPECT_FALSE(m.try_emplace("key", std::move(other)).second);
+  EXPECT_EQ(other, "other");
+  EXPECT_TRUE(m.emplace("a", "b").second);
+  EXPECT_EQ(m.emplace_hint(m.end(), "z", "y")->second, "y");
+  EXPECT_EQ(m.size(), std::size_t(3));
+  EXPECT_EQ(m["key"], "value");
+}
+
+namespace {
+
+// コピーされた回数を数えるキー. ムーブは数えない.
+struct BTreeCountedKey {
+  static int copies;
+  int value;
+
+  BTreeCountedKey(int v = 0) : value(v) {}
+  BTreeCountedKey(const BTreeCountedKey &other) : value(other.value) {
+    ++copies;
+  }
+  BTreeCountedKey(BTreeCountedKey &&other) noexcept : value(other.value) {}
+  BTreeCountedKey &operator=(const BTreeCountedKey &other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+  BTreeCountedKey &operator=(BTreeCountedKey &&other) noexcept {
+    value = other.value;
+    return *this;
+  }
+
+  bool operator<(const BTreeCountedKey &other) const {
+    return value < other.value;
+  }
+};
+
+int BTreeCountedKey::copies = 0;
+
+}  // namespace
+
+// 分割, 併合, 借用で値をノードの間で移す時に, const なキーもコピーせずに
+// ムーブする. 範囲の削除もキーをコピーしない.
+TEST(BTreeMap, NodeShiftsMoveKeys) {
+  typedef ft::btree_map<BTreeCountedKey, int, std::less<BTreeCountedKey>,
+                        std::allocator<ft::pair<const BTreeCountedKey, int> >,
+                        0>
+      map_type;
+
+  map_type m;
+  BTreeCountedKey::copies = 0;
+  for (int i = 0; i < 500; ++i) {
+    m.try_emplace(BTreeCountedKey(i * 7 % 500), i);
+  }
+  for (int i = 0; i < 500; i += 2) {
+    m.erase(m.find(BTreeCountedKey(i)));
+  }
+  m.erase(m.begin(), m.find(BTreeCountedKey(251)));
+  EXPECT_EQ(BTreeCountedKey::copies, 0);
+  EXPECT_EQ(m.size(), std::size_t(125));
+  EXPECT_EQ((*m.begin()).first.value, 251);
+}
+
+TEST(BTreeMap, VectorGrowthMovesMaps) {
+  typedef ft::btree_map<std::string, int> map_type;
+  typedef ft::btree_set<int> set_type;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_constructible<set_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<set_type>::value);
+
+  ft::vector<map_type> maps(1);
+  maps[0]["key"] = 1;
+  const ft::pair<const std::string, int> *value = &*maps[0].begin();
+  for (int i = 0; i < 100; ++i) {
+    maps.push_back(map_type());
+  }
+  // 再確保でコピーされていればノードの中の値のアドレスが変わる
+  EXPECT_EQ(&*maps[0].begin(), value);
+}
+#endif
+
+TEST(BTreeMap, StringKeysUseBinarySearch) {
+  typedef ft::btree_map<std::string, int, ft::less<> > map_type;
+
+  map_type m;
+  std::map<std::string, int> expected;
+  for (int i = 0; i < 3000; ++i) {
+    std::string key(1, static_cast<char>('a' + i % 26));
+    key += std::string(i % 13, static_cast<char>('a' + i % 7));
+    m.insert(map_type::value_type(key, i));
+    expected.insert(std::make_pair(key, i));
+  }
+  EXPECT_EQ(m.size(), expected.size());
+  for (std::map<std::string, int>::iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    // 透過的な比較では const char* のまま探す
+    map_type::iterator found = m.find(it->first.c_str());
+    EXPECT_TRUE(found != m.end());
+    EXPECT_EQ((*found).second, it->second);
+  }
+}
+
+TEST(BTreeMap, ComparisonAndArenaAllocator) {
+  typedef ft::btree_map<int, int, std::less<int>,
+                        ft::arena_allocator<ft::pair<const int, int> >, 128>
+      map_type;
+
+  map_type lhs;
+  map_type rhs;
+  for (int i = 0; i < 500; ++i) {
+    lhs[i] = i;
+    rhs[i] = i;
+  }
+  EXPECT_TRUE(lhs == rhs);
+  rhs[499] = 500;
+  EXPECT_TRUE(lhs < rhs);
+  EXPECT_TRUE(lhs != rhs);
+  lhs.swap(rhs);
+  EXPECT_TRUE(lhs > rhs);
+  map_type copy(lhs);
+  EXPECT_TRUE(copy == lhs);
+  lhs.clear();
+  EXPECT_TRUE(lhs.empty());
+  EXPECT_EQ(copy.size(), std::size_t(500));
+}
+
+// 内部ノードも葉も作っては消すので, 状態を持つアロケータの pool や arena から
+// 確保した領域が木の寿命の間使えることを確かめる.
+TEST(BTreeMap, NodePoolAllocator) {
+  typedef ft::btree_map<int, int, std::less<int>,
+                        ft::node_pool_allocator<ft::pair<const int, int> >, 64>
+      map_type;
+
+  map_type m;
+  std::map<int, int> expected;
+  srand(7);
+  for (int i = 0; i < 5000; ++i) {
+    const int key = rand() % 4000;
+    m[key] = i;
+    expected[key] = i;
+  }
+  for (int i = 0; i < 4000; i += 3) {
+    EXPECT_EQ(m.erase(i), expected.erase(i));
+  }
+  map_type copy(m);
+  map_type other;
+  other[-1] = -1;
+  other.swap(m);
+  EXPECT_EQ(m.size(), std::size_t(1));
+  EXPECT_EQ(copy.size(), expected.size());
+  EXPECT_TRUE(copy == other);
+  std::map<int, int>::iterator expected_it = expected.begin();
+  for (map_type::iterator it = other.begin(); it != other.end(); ++it) {
+    EXPECT_EQ((*it).first, expected_it->first);
+    EXPECT_EQ((*it).second, expected_it->second);
+    ++expected_it;
+  }
+}
+
+namespace {
+
+template <class Set>
+void checkBTreeSetWithAllocator() {
+  Set s;
+  std::set<int> expected;
+  for (int i = 0; i < 5000; ++i) {
+    const int value = (i * 7919) % 5000;
+    s.insert(value);
+    expected.insert(value);
+  }
+  for (int i = 0; i < 5000; i += 2) {
+    s.erase(i);
+    expected.erase(i);
+  }
+  Set copy(s);
+  s.clear();
+  EXPECT_EQ(copy.size(), expected.size());
+  EXPECT_TRUE(std::equal(copy.begin(), copy.end(), expected.begin()));
+  for (int i = 0; i < 1000; ++i) {
+    s.insert(i);
+  }
+  EXPECT_EQ(s.size(), std::size_t(1000));
+}
+
+}  // namespace
+
+TEST(BTreeSet, PoolAndArenaAllocators) {
+  checkBTreeSetWithAllocator<
+      ft::btree_set<int, std::less<int>, ft::node_pool_allocator<int>, 64> >();
+  checkBTreeSetWithAllocator<
+      ft::btree_set<int, std::less<int>, ft::arena_allocator<int>, 64> >();
+}
+
+TEST(BTreeSet, BehavesLikeSet) {
+  typedef ft::btree_set<int> set_type;
+
+  const int data[] = {5, 3, 9, 1, 3, 7, 5};
+  set_type s(data, data + 7);
+  ft::set<int> expected(data, data + 7);
+  EXPECT_EQ(s.size(), expected.size());
+  EXPECT_TRUE(std::equal(s.begin(), s.end(), expected.begin()));
+  EXPECT_FALSE(s.insert(3).second);
+  EXPECT_EQ(*s.insert(s.end(), 10), 10);
+  EXPECT_EQ(s.erase(1), std::size_t(1));
+  s.erase(s.find(10));
+  EXPECT_EQ(*s.begin(), 3);
+  EXPECT_EQ(*s.rbegin(), 9);
+  EXPECT_TRUE(s.find(4) == s.end());
+  EXPECT_EQ(*s.lower_bound(4), 5);
+
+  set_type other;
+  other.insert(3);
+  EXPECT_TRUE(other < s);
+  std::swap(other, s);
+  EXPECT_EQ(s.size(), std::size_t(1));
+}
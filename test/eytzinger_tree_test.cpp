@@ -0,0 +1,212 @@
+#include "eytzinger_tree.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "map.hpp"
+#include "set.hpp"
+#include "vector.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+// コピーが指定回数を超えると例外を投げる値.
+struct EytzingerThrowingValue {
+  static int copies_left;
+  int value;
+
+  EytzingerThrowingValue(int v = 0) : value(v) {}
+
+  EytzingerThrowingValue(const EytzingerThrowingValue &other)
+      : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("EytzingerThrowingValue");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+  }
+
+  EytzingerThrowingValue &operator=(const EytzingerThrowingValue &other) {
+    value = other.value;
+    return *this;
+  }
+
+  bool operator<(const EytzingerThrowingValue &other) const {
+    return value < other.value;
+  }
+};
+
+int EytzingerThrowingValue::copies_left = -1;
+
+}  // namespace
+
+TEST(EytzingerTree, LayoutIsBreadthFirst) {
+  ft::set<int> s;
+  for (int i = 1; i <= 10; ++i) {
+    s.insert(i);
+  }
+  ft::set<int>::frozen_type frozen = s.freeze();
+
+  const int expected[] = {7, 4, 9, 2, 6, 8, 10, 1, 3, 5};
+  EXPECT_EQ(frozen.size(), std::size_t(10));
+  EXPECT_TRUE(std::equal(frozen.values_, frozen.values_ + 10, expected));
+  EXPECT_TRUE(std::equal(frozen.begin(), frozen.end(), s.begin()));
+  EXPECT_TRUE(std::equal(frozen.rbegin(), frozen.rend(), s.rbegin()));
+}
+
+TEST(EytzingerTree, BoundsMatchSet) {
+  for (int n = 0; n < 70; ++n) {
+    ft::set<int> s;
+    for (int i = 0; i < n; ++i) {
+      s.insert(i * 2);
+    }
+    const ft::set<int>::frozen_type frozen = s.freeze();
+    EXPECT_EQ(frozen.size(), s.size());
+    EXPECT_EQ(frozen.empty(), s.empty());
+    EXPECT_TRUE(std::equal(frozen.begin(), frozen.end(), s.begin()));
+    for (int key = -1; key <= n * 2 + 1; ++key) {
+      const ft::set<int>::frozen_type::const_iterator lower =
+          frozen.lower_bound(key);
+      const ft::set<int>::frozen_type::const_iterator upper =
+          frozen.upper_bound(key);
+      EXPECT_EQ(lower == frozen.end(), s.lower_bound(key) == s.end());
+      EXPECT_EQ(upper == frozen.end(), s.upper_bound(key) == s.end());
+      if (lower != frozen.end()) {
+        EXPECT_EQ(*lower, *s.lower_bound(key));
+      }
+      if (upper != frozen.end()) {
+        EXPECT_EQ(*upper, *s.upper_bound(key));
+      }
+      EXPECT_EQ(frozen.count(key), s.count(key));
+      EXPECT_TRUE((frozen.find(key) == frozen.end()) == (s.count(key) == 0));
+      EXPECT_TRUE(frozen.equal_range(key).first == lower);
+      EXPECT_TRUE(frozen.equal_range(key).second == upper);
+    }
+  }
+}
+
+TEST(EytzingerTree, MapSnapshotIsIndependent) {
+  ft::map<std::string, int> m;
+  for (int i = 0; i < 200; ++i) {
+    m[std::string(1, static_cast<char>('a' + i % 26)) +
+      std::string(i / 26, 'z')] = i;
+  }
+  const ft::map<std::string, int>::frozen_type frozen = m.freeze();
+  m.clear();
+  m["new"] = 1;
+
+  EXPECT_EQ(frozen.size(), std::size_t(200));
+  EXPECT_EQ(frozen.find("a")->second, 0);
+  EXPECT_EQ(frozen.find("czz")->second, 54);
+  EXPECT_TRUE(frozen.find("new") == frozen.end());
+  EXPECT_EQ(frozen.lower_bound("b")->first, "b");
+  EXPECT_EQ(frozen.upper_bound("b")->first, "bz");
+  std::string prev;
+  for (ft::map<std::string, int>::frozen_type::const_iterator it =
+           frozen.begin();
+       it != frozen.end(); ++it) {
+    EXPECT_TRUE(prev < it->first);
+    prev = it->first;
+  }
+}
+
+namespace {
+
+// 先頭の文字だけで std::string と比べるキー. std::string には変換出来ない.
+struct EytzingerInitial {
+  char c;
+};
+
+bool operator<(const std::string &lhs, const EytzingerInitial &rhs) {
+  return lhs[0] < rhs.c;
+}
+
+bool operator<(const EytzingerInitial &lhs, const std::string &rhs) {
+  return lhs.c < rhs[0];
+}
+
+}  // namespace
+
+TEST(EytzingerTree, TransparentLookup) {
+  typedef ft::map<std::string, int, ft::less<> > map_type;
+  map_type m;
+  for (int i = 0; i < 26; i += 2) {
+    m[std::string(1, static_cast<char>('a' + i))] = i;
+  }
+  const map_type::frozen_type frozen = m.freeze();
+
+  const EytzingerInitial c = {'c'};
+  const EytzingerInitial d = {'d'};
+  EXPECT_EQ(frozen.find(c)->second, 2);
+  EXPECT_TRUE(frozen.find(d) == frozen.end());
+  EXPECT_EQ(frozen.count(c), std::size_t(1));
+  EXPECT_EQ(frozen.count(d), std::size_t(0));
+  EXPECT_EQ(frozen.lower_bound(d)->first, "e");
+  EXPECT_EQ(frozen.upper_bound(c)->first, "e");
+  EXPECT_TRUE(frozen.equal_range(c).first == frozen.find("c"));
+  EXPECT_TRUE(frozen.equal_range(c).second == frozen.find("e"));
+  EXPECT_EQ(frozen.find("g")->second, 6);
+}
+
+TEST(EytzingerTree, CopyAssignAndSwap) {
+  ft::map<int, int> m;
+  for (int i = 0; i < 100; ++i) {
+    m[i] = i * i;
+  }
+  ft::map<int, int>::frozen_type frozen = m.freeze();
+  ft::map<int, int>::frozen_type copy(frozen);
+  EXPECT_TRUE(copy == frozen);
+  EXPECT_EQ(copy.find(9)->second, 81);
+
+  ft::map<int, int>::frozen_type empty;
+  EXPECT_TRUE(empty.begin() == empty.end());
+  EXPECT_TRUE(empty.find(1) == empty.end());
+  EXPECT_TRUE(empty < frozen);
+  empty = frozen;
+  EXPECT_TRUE(empty == frozen);
+  copy.swap(empty);
+  EXPECT_EQ(copy.size(), std::size_t(100));
+
+  m[100] = 0;
+  ft::map<int, int>::frozen_type larger = m.freeze();
+  EXPECT_TRUE(frozen != larger);
+  EXPECT_TRUE(frozen < larger);
+}
+
+TEST(EytzingerTree, ThrowingCopyDuringFreezeReleasesValues) {
+  ft::set<EytzingerThrowingValue> s;
+  for (int i = 0; i < 50; ++i) {
+    s.insert(EytzingerThrowingValue(i));
+  }
+  EytzingerThrowingValue::copies_left = 20;
+  EXPECT_THROW(s.freeze(), std::runtime_error);
+  EytzingerThrowingValue::copies_left = -1;
+  EXPECT_EQ(s.freeze().size(), std::size_t(50));
+}
+
+#if __cplusplus >= 201103L
+TEST(EytzingerTree, VectorGrowthMovesSnapshots) {
+  typedef ft::map<std::string, int>::frozen_type frozen_type;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<frozen_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<frozen_type>::value);
+
+  ft::map<std::string, int> m;
+  m["key"] = 1;
+  ft::vector<frozen_type> snapshots;
+  snapshots.push_back(m.freeze());
+  const ft::pair<const std::string, int> *values = snapshots[0].values_;
+  for (int i = 0; i < 100; ++i) {
+    snapshots.push_back(frozen_type());
+  }
+  // 再確保でコピーされていれば値の配列のアドレスが変わる
+  EXPECT_EQ(snapshots[0].values_, values);
+}
+#endif
@@ -0,0 +1,432 @@
+#include "flat_map.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "arena_allocator.hpp"
+#include "flat_set.hpp"
+#include "flat_tree.hpp"
+#include "set.hpp"
+#include "vector.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+typedef ft::flat_map<int, std::string> flat_pair_map_type;
+typedef ft::flat_map<int, std::string, std::less<int>,
+                     std::allocator<ft::pair<int, std::string> >,
+                     ft::flat_map_split_storage_policy>
+    flat_split_map_type;
+
+// 比較の回数を数える比較関数.
+struct FlatCountingLess {
+  static long comparisons;
+
+  bool operator()(int lhs, int rhs) const {
+    ++comparisons;
+    return lhs < rhs;
+  }
+};
+
+long FlatCountingLess::comparisons = 0;
+
+// コピーが指定回数を超えると例外を投げる値.
+struct FlatThrowingValue {
+  static int copies_left;
+  int value;
+
+  FlatThrowingValue(int v = 0) : value(v) {}
+
+  FlatThrowingValue(const FlatThrowingValue &other) : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("FlatThrowingValue");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+  }
+
+  FlatThrowingValue &operator=(const FlatThrowingValue &other) {
+    value = other.value;
+    return *this;
+  }
+
+  bool operator<(const FlatThrowingValue &other) const {
+    return value < other.value;
+  }
+};
+
+int FlatThrowingValue::copies_left = -1;
+
+// 比較が指定回数を超えると例外を投げる比較関数.
+struct FlatThrowingLess {
+  static int compares_left;
+
+  bool operator()(int lhs, int rhs) const {
+    if (compares_left == 0) {
+      throw std::runtime_error("FlatThrowingLess");
+    }
+    if (compares_left > 0) {
+      --compares_left;
+    }
+    return lhs < rhs;
+  }
+};
+
+int FlatThrowingLess::compares_left = -1;
+
+// 整列の確認, 整列, 併合のどこで比較が例外を投げても元のままになることを,
+// 投げるまでの比較の回数を1回ずつ増やして確かめる.
+template <class Container, class InputIt>
+void expectThrowingCompareLeavesTreeUnchanged(const Container &original,
+                                              InputIt first, InputIt last,
+                                              std::size_t inserted_size) {
+  for (int limit = 0;; ++limit) {
+    Container c(original);
+    FlatThrowingLess::compares_left = limit;
+    try {
+      c.insert(first, last);
+    } catch (const std::runtime_error &) {
+      FlatThrowingLess::compares_left = -1;
+      EXPECT_TRUE(c == original);
+      continue;
+    }
+    FlatThrowingLess::compares_left = -1;
+    EXPECT_EQ(c.size(), inserted_size);
+    break;
+  }
+}
+
+template <class Map>
+void expectFlatMapEqualsMap(const Map &m,
+                            const std::map<int, std::string> &expected) {
+  EXPECT_EQ(m.size(), expected.size());
+  std::map<int, std::string>::const_iterator expected_it = expected.begin();
+  for (typename Map::const_iterator it = m.begin(); it != m.end(); ++it) {
+    EXPECT_EQ((*it).first, expected_it->first);
+    EXPECT_EQ((*it).second, expected_it->second);
+    ++expected_it;
+  }
+  std::map<int, std::string>::const_reverse_iterator expected_rit =
+      expected.rbegin();
+  for (typename Map::const_reverse_iterator it = m.rbegin(); it != m.rend();
+       ++it) {
+    EXPECT_EQ(it->first, expected_rit->first);
+    ++expected_rit;
+  }
+}
+
+template <class Map>
+void expectFlatMapBasicOperations() {
+  Map m;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 1000; ++i) {
+    const int key = (i * 37) % 1000;
+    m[key] = std::string(key % 7 + 1, 'a');
+    expected[key] = std::string(key % 7 + 1, 'a');
+  }
+  expectFlatMapEqualsMap(m, expected);
+
+  EXPECT_EQ(m.at(10), std::string(4, 'a'));
+  EXPECT_THROW(m.at(1000), std::out_of_range);
+  EXPECT_FALSE(m.insert(typename Map::value_type(10, "x")).second);
+  EXPECT_EQ(m[10], std::string(4, 'a'));
+  EXPECT_TRUE(m.insert_or_assign(10, std::string("x")).second == false);
+  EXPECT_EQ(m[10], "x");
+  EXPECT_TRUE(m.insert_or_assign(m.end(), 2000, std::string("y")) ==
+              m.find(2000));
+  EXPECT_EQ(m.erase(2000), std::size_t(1));
+  EXPECT_EQ(m.erase(2000), std::size_t(0));
+
+  for (int i = 0; i < 1000; i += 2) {
+    m.erase(m.find(i));
+  }
+  EXPECT_EQ(m.size(), std::size_t(500));
+  EXPECT_EQ(m.count(2), std::size_t(0));
+  EXPECT_EQ(m.count(3), std::size_t(1));
+  EXPECT_EQ((*m.lower_bound(2)).first, 3);
+  EXPECT_EQ((*m.upper_bound(3)).first, 5);
+  EXPECT_TRUE(m.upper_bound(999) == m.end());
+  EXPECT_TRUE(m.equal_range(4).first == m.equal_range(4).second);
+  EXPECT_EQ(m.equal_range(5).second - m.equal_range(5).first, 1);
+  m.erase(m.begin(), m.find(501));
+  EXPECT_EQ((*m.begin()).first, 501);
+  EXPECT_EQ(m.size(), std::size_t(250));
+}
+
+// 重複を含む整列していない範囲を, 既存の要素がある map に入れる.
+template <class Map>
+void expectFlatMapBulkInsertKeepsFirst() {
+  Map m;
+  std::map<int, std::string> expected;
+  for (int i = 0; i < 100; i += 3) {
+    m[i] = "old";
+    expected[i] = "old";
+  }
+  std::vector<ft::pair<int, std::string> > values;
+  std::map<int, std::string> first_values;
+  for (int i = 0; i < 500; ++i) {
+    const int key = (i * 7919) % 150;
+    const std::string value(1, static_cast<char>('a' + i % 26));
+    values.push_back(ft::make_pair(key, value));
+    expected.insert(std::make_pair(key, value));
+    first_values.insert(std::make_pair(key, value));
+  }
+  m.insert(values.begin(), values.end());
+  expectFlatMapEqualsMap(m, expected);
+
+  // 範囲のコンストラクタも同じ結果になる.
+  Map constructed(values.begin(), values.end());
+  expectFlatMapEqualsMap(constructed, first_values);
+}
+
+}  // namespace
+
+TEST(FlatTree, BranchlessBoundsMatchStd) {
+  typedef ft::FlatTree<int, int, ft::Identity<int>, std::less<int>,
+                       ft::flat_vector_storage<int, ft::Identity<int>,
+                                               std::allocator<int> > >
+      tree_type;
+
+  for (int n = 0; n < 40; ++n) {
+    std::vector<int> keys;
+    tree_type tree;
+    for (int i = 0; i < n; ++i) {
+      keys.push_back(i * 2);
+      tree.insert_unique(i * 2);
+    }
+    for (int key = -1; key <= n * 2 + 1; ++key) {
+      EXPECT_EQ(tree.__lower_bound_index(key),
+                std::size_t(std::lower_bound(keys.begin(), keys.end(), key) -
+                            keys.begin()));
+      EXPECT_EQ(tree.__upper_bound_index(key),
+                std::size_t(std::upper_bound(keys.begin(), keys.end(), key) -
+                            keys.begin()));
+    }
+  }
+}
+
+TEST(FlatTree, SortedRangeIsAppendedInLinearTime) {
+  typedef ft::flat_set<int, FlatCountingLess> set_type;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 10000; ++i) {
+    keys.push_back(i);
+  }
+  FlatCountingLess::comparisons = 0;
+  set_type s(keys.begin(), keys.end());
+  EXPECT_EQ(s.size(), keys.size());
+  // 整列済みかを確かめるだけなので, 比較は要素数より少ない.
+  EXPECT_TRUE(FlatCountingLess::comparisons < 10000);
+
+  // 既存の要素より後ろの整列済みの範囲も同じ.
+  std::vector<int> more;
+  for (int i = 10000; i < 20000; ++i) {
+    more.push_back(i);
+  }
+  FlatCountingLess::comparisons = 0;
+  s.insert(more.begin(), more.end());
+  EXPECT_TRUE(FlatCountingLess::comparisons <= 10000);
+  EXPECT_EQ(s.size(), std::size_t(20000));
+
+  // hint が正しければ1つずつの挿入も探索しない.
+  set_type hinted;
+  FlatCountingLess::comparisons = 0;
+  for (int i = 0; i < 1000; ++i) {
+    hinted.insert(hinted.end(), i);
+  }
+  EXPECT_TRUE(FlatCountingLess::comparisons < 2000);
+  EXPECT_TRUE(std::equal(hinted.begin(), hinted.end(), keys.begin()));
+}
+
+TEST(FlatTree, ThrowingCopyInBulkInsertLeavesTreeUnchanged) {
+  typedef ft::flat_set<FlatThrowingValue> set_type;
+
+  set_type s;
+  for (int i = 0; i < 50; ++i) {
+    s.insert(FlatThrowingValue(i * 2));
+  }
+  std::vector<FlatThrowingValue> values;
+  for (int i = 0; i < 50; ++i) {
+    values.push_back(FlatThrowingValue(i * 2 + 1));
+  }
+  FlatThrowingValue::copies_left = 20;
+  EXPECT_THROW(s.insert(values.begin(), values.end()), std::runtime_error);
+  FlatThrowingValue::copies_left = -1;
+  EXPECT_EQ(s.size(), std::size_t(50));
+  int expected = 0;
+  for (set_type::iterator it = s.begin(); it != s.end(); ++it) {
+    EXPECT_EQ((*it).value, expected);
+    expected += 2;
+  }
+}
+
+TEST(FlatTree, ThrowingCompareInBulkInsertLeavesTreeUnchanged) {
+  typedef ft::flat_set<int, FlatThrowingLess> set_type;
+  typedef ft::flat_map<int, std::string, FlatThrowingLess,
+                       std::allocator<ft::pair<int, std::string> >,
+                       ft::flat_map_split_storage_policy>
+      split_map_type;
+
+  set_type s;
+  split_map_type m;
+  for (int i = 0; i < 50; ++i) {
+    s.insert(i * 2);
+    m.insert(split_map_type::value_type(i * 2, std::string(i, 'a')));
+  }
+  // 0 から 119 までを並べ替えた範囲. 100 未満の偶数は既にある.
+  std::vector<int> keys;
+  std::vector<split_map_type::value_type> values;
+  for (int i = 0; i < 120; ++i) {
+    keys.push_back(i * 37 % 120);
+    values.push_back(split_map_type::value_type(i * 37 % 120, "new"));
+  }
+  expectThrowingCompareLeavesTreeUnchanged(s, keys.begin(), keys.end(), 120);
+  expectThrowingCompareLeavesTreeUnchanged(m, values.begin(), values.end(),
+                                           120);
+}
+
+TEST(FlatMap, BasicOperations) {
+  expectFlatMapBasicOperations<flat_pair_map_type>();
+  expectFlatMapBasicOperations<flat_split_map_type>();
+}
+
+TEST(FlatMap, BulkInsertSortsAndKeepsFirst) {
+  expectFlatMapBulkInsertKeepsFirst<flat_pair_map_type>();
+  expectFlatMapBulkInsertKeepsFirst<flat_split_map_type>();
+}
+
+TEST(FlatMap, SplitStorageReferences) {
+  flat_split_map_type m;
+  for (int i = 0; i < 10; ++i) {
+    m.insert(flat_split_map_type::value_type(i, std::string(i, 'a')));
+  }
+  flat_split_map_type::iterator it = m.find(3);
+  it->second = "three";
+  (*(it + 1)).second += "!";
+  EXPECT_EQ(m[3], "three");
+  EXPECT_EQ(m[4], "aaaa!");
+  EXPECT_EQ(m.rbegin()->first, 9);
+  EXPECT_EQ(it[2].first, 5);
+
+  // 参照から要素のコピーを作れる.
+  flat_split_map_type::value_type copied = *it;
+  copied.second = "copied";
+  EXPECT_EQ(m[3], "three");
+
+  // 別の flat_map の範囲からも入れられる.
+  flat_pair_map_type pair_map(m.begin(), m.end());
+  EXPECT_EQ(pair_map.size(), m.size());
+  EXPECT_EQ(pair_map[3], "three");
+  flat_split_map_type copy(m);
+  EXPECT_TRUE(copy == m);
+  copy[9] = "z";
+  EXPECT_TRUE(m < copy);
+}
+
+#if __cplusplus >= 201103L
+TEST(FlatMap, TryEmplaceAndEmplace) {
+  typedef ft::flat_map<std::string, std::string> map_type;
+
+  map_type m;
+  std::string value("value");
+  EXPECT_TRUE(m.try_emplace("key", std::move(value)).second);
+  EXPECT_TRUE(value.empty());
+  std::string other("other");
+  EXPECT_FALSE(m.try_emplace("key", std::move(other)).second);
+  EXPECT_EQ(other, "other");
+  EXPECT_TRUE(m.emplace("a", "b").second);
+  EXPECT_EQ(m.emplace_hint(m.end(), "z", "y")->second, "y");
+  EXPECT_EQ(m.size(), std::size_t(3));
+  EXPECT_EQ(m["key"], "value");
+
+  flat_split_map_type split;
+  EXPECT_TRUE(split.try_emplace(1, 3, 'c').second);
+  EXPECT_EQ(split[1], "ccc");
+  flat_split_map_type moved(std::move(split));
+  EXPECT_EQ(moved[1], "ccc");
+}
+
+TEST(FlatMap, VectorGrowthMovesMaps) {
+  typedef ft::flat_set<int> set_type;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<flat_pair_map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<flat_pair_map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_constructible<flat_split_map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<flat_split_map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_constructible<set_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<set_type>::value);
+
+  ft::vector<flat_pair_map_type> pair_maps(1);
+  pair_maps[0][1] = "one";
+  const ft::pair<int, std::string> *value = &*pair_maps[0].begin();
+  ft::vector<flat_split_map_type> split_maps(1);
+  split_maps[0][1] = "one";
+  const std::string *mapped = &(*split_maps[0].begin()).second;
+  for (int i = 0; i < 100; ++i) {
+    pair_maps.push_back(flat_pair_map_type());
+    split_maps.push_back(flat_split_map_type());
+  }
+  // 再確保でコピーされていれば要素の配列のアドレスが変わる
+  EXPECT_EQ(&*pair_maps[0].begin(), value);
+  EXPECT_EQ(&(*split_maps[0].begin()).second, mapped);
+}
+#endif
+
+TEST(FlatMap, ComparisonAndArenaAllocator) {
+  typedef ft::flat_map<int, int, std::less<int>,
+                       ft::arena_allocator<ft::pair<int, int> > >
+      map_type;
+
+  map_type lhs;
+  map_type rhs;
+  lhs.reserve(500);
+  EXPECT_TRUE(lhs.capacity() >= 500);
+  for (int i = 0; i < 500; ++i) {
+    lhs[i] = i;
+    rhs[i] = i;
+  }
+  EXPECT_TRUE(lhs == rhs);
+  rhs[499] = 500;
+  EXPECT_TRUE(lhs < rhs);
+  EXPECT_TRUE(lhs != rhs);
+  lhs.swap(rhs);
+  EXPECT_TRUE(lhs > rhs);
+  map_type copy(lhs);
+  EXPECT_TRUE(copy == lhs);
+  lhs.clear();
+  EXPECT_TRUE(lhs.empty());
+  EXPECT_EQ(copy.size(), std::size_t(500));
+}
+
+TEST(FlatSet, BehavesLikeSet) {
+  typedef ft::flat_set<int> set_type;
+
+  const int data[] = {5, 3, 9, 1, 3, 7, 5};
+  set_type s(data, data + 7);
+  ft::set<int> expected(data, data + 7);
+  EXPECT_EQ(s.size(), expected.size());
+  EXPECT_TRUE(std::equal(s.begin(), s.end(), expected.begin()));
+  EXPECT_FALSE(s.insert(3).second);
+  EXPECT_EQ(*s.insert(s.end(), 10), 10);
+  EXPECT_EQ(*s.insert(s.begin(), 4), 4);
+  EXPECT_EQ(s.erase(1), std::size_t(1));
+  s.erase(s.find(10));
+  EXPECT_EQ(*s.begin(), 3);
+  EXPECT_EQ(*s.rbegin(), 9);
+  EXPECT_TRUE(s.find(6) == s.end());
+  EXPECT_EQ(*s.lower_bound(6), 7);
+
+  set_type other;
+  other.insert(3);
+  EXPECT_TRUE(other < s);
+  std::swap(other, s);
+  EXPECT_EQ(s.size(), std::size_t(1));
+}
@@ -0,0 +1,128 @@
+#include "fork_join.hpp"
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <vector>
+
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+// 同時に動いているタスクの数とその最大値を数える.
+struct ConcurrencyCounter {
+  pthread_mutex_t mutex;
+  int running;
+  int peak;
+
+  ConcurrencyCounter() : running(0), peak(0) {
+    pthread_mutex_init(&mutex, NULL);
+  }
+
+  ~ConcurrencyCounter() {
+    pthread_mutex_destroy(&mutex);
+  }
+
+  void enter() {
+    pthread_mutex_lock(&mutex);
+    ++running;
+    if (running > peak) {
+      peak = running;
+    }
+    pthread_mutex_unlock(&mutex);
+  }
+
+  void leave() {
+    pthread_mutex_lock(&mutex);
+    --running;
+    pthread_mutex_unlock(&mutex);
+  }
+};
+
+// [first, last) の和を, 分けられるだけ分けて求める.
+struct RangeSum {
+  const ft::fork_join_executor *executor;
+  ConcurrencyCounter *counter;
+  const std::vector<long> *values;
+  std::size_t first;
+  std::size_t last;
+  long sum;
+
+  RangeSum(const ft::fork_join_executor *e, ConcurrencyCounter *c,
+           const std::vector<long> *v, std::size_t f, std::size_t l)
+      : executor(e), counter(c), values(v), first(f), last(l), sum(0) {}
+
+  void operator()() {
+    if (last - first <= executor->grain_size()) {
+      counter->enter();
+      for (std::size_t i = first; i < last; ++i) {
+        sum += (*values)[i];
+      }
+      counter->leave();
+      return;
+    }
+    const std::size_t mid = first + (last - first) / 2;
+    RangeSum left(executor, counter, values, first, mid);
+    RangeSum right(executor, counter, values, mid, last);
+    executor->fork_join(left, right);
+    sum = left.sum + right.sum;
+  }
+};
+
+struct RecordThread {
+  pthread_t thread;
+
+  void operator()() {
+    thread = pthread_self();
+  }
+};
+
+}  // namespace
+
+TEST(ForkJoinExecutor, ParametersAreAtLeastOne) {
+  ft::fork_join_executor executor(0, 0);
+  EXPECT_EQ(executor.thread_count(), 1u);
+  EXPECT_EQ(executor.grain_size(), 1u);
+  EXPECT_TRUE(ft::fork_join_executor::hardware_concurrency() >= 1u);
+}
+
+TEST(ForkJoinExecutor, SingleThreadRunsInline) {
+  ft::fork_join_executor executor(1);
+  RecordThread task1;
+  RecordThread task2;
+  executor.fork_join(task1, task2);
+  EXPECT_TRUE(pthread_equal(task1.thread, pthread_self()));
+  EXPECT_TRUE(pthread_equal(task2.thread, pthread_self()));
+}
+
+TEST(ForkJoinExecutor, SecondTaskRunsOnCaller) {
+  ft::fork_join_executor executor(2);
+  RecordThread task1;
+  RecordThread task2;
+  executor.fork_join(task1, task2);
+  EXPECT_FALSE(pthread_equal(task1.thread, pthread_self()));
+  EXPECT_TRUE(pthread_equal(task2.thread, pthread_self()));
+}
+
+TEST(ForkJoinExecutor, NestedForksStayWithinThreadCount) {
+  std::vector<long> values;
+  long expected = 0;
+  for (long i = 0; i < 100000; ++i) {
+    values.push_back(i * 7 % 1000);
+    expected += i * 7 % 1000;
+  }
+  const unsigned int thread_counts[] = {1, 2, 3, 8};
+  for (std::size_t i = 0; i < sizeof(thread_counts) / sizeof(unsigned int);
+       ++i) {
+    ft::fork_join_executor executor(thread_counts[i], 100);
+    ConcurrencyCounter counter;
+    RangeSum task(&executor, &counter, &values, 0, values.size());
+    task();
+    EXPECT_EQ(task.sum, expected);
+    EXPECT_TRUE(counter.peak <= static_cast<int>(thread_counts[i]));
+  }
+}
@@ -0,0 +1,121 @@
+#include "interval_map.hpp"
+
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+typedef ft::interval_map<int, int> interval_map_type;
+typedef std::map<std::pair<int, int>, int> expected_map_type;
+
+// 全ての区間を調べて [lo, hi) と重なるものを前から順に集める.
+std::vector<std::pair<int, int> > scanOverlapping(
+    const expected_map_type &expected, int lo, int hi) {
+  std::vector<std::pair<int, int> > result;
+  for (expected_map_type::const_iterator it = expected.begin();
+       it != expected.end(); ++it) {
+    if (it->first.first < hi && lo < it->first.second) {
+      result.push_back(it->first);
+    }
+  }
+  return result;
+}
+
+void expectOverlappingMatches(const interval_map_type &intervals,
+                              const expected_map_type &expected, int lo,
+                              int hi) {
+  std::vector<std::pair<int, int> > scanned =
+      scanOverlapping(expected, lo, hi);
+  std::vector<interval_map_type::const_iterator> found;
+  intervals.overlapping(lo, hi, std::back_inserter(found));
+  ASSERT_EQ(found.size(), scanned.size());
+  for (std::size_t i = 0; i < found.size(); ++i) {
+    EXPECT_EQ(found[i]->first.first, scanned[i].first);
+    EXPECT_EQ(found[i]->first.second, scanned[i].second);
+  }
+
+  interval_map_type::const_iterator first =
+      intervals.find_overlapping(lo, hi);
+  if (scanned.empty()) {
+    EXPECT_TRUE(first == intervals.end());
+  } else {
+    ASSERT_TRUE(first != intervals.end());
+    EXPECT_EQ(first->first.first, scanned[0].first);
+    EXPECT_EQ(first->first.second, scanned[0].second);
+  }
+}
+
+}  // namespace
+
+TEST(IntervalMap, InsertFindAndErase) {
+  interval_map_type intervals;
+  EXPECT_TRUE(intervals.empty());
+  EXPECT_TRUE(intervals.insert(10, 20, 1).second);
+  EXPECT_TRUE(intervals.insert(10, 15, 2).second);
+  EXPECT_TRUE(intervals.insert(5, 30, 3).second);
+  EXPECT_FALSE(intervals.insert(10, 20, 4).second);
+  EXPECT_EQ(intervals.size(), 3u);
+
+  interval_map_type::iterator it = intervals.begin();
+  EXPECT_EQ(it->second, 3);
+  ++it;
+  EXPECT_EQ(it->second, 2);
+  ++it;
+  EXPECT_EQ(it->second, 1);
+
+  EXPECT_EQ(intervals.find(ft::make_pair(10, 20))->second, 1);
+  EXPECT_EQ(intervals.erase(ft::make_pair(5, 30)), 1u);
+  EXPECT_EQ(intervals.find_overlapping(0, 11)->second, 2);
+  EXPECT_TRUE(intervals.find_overlapping(20, 40) == intervals.end());
+  EXPECT_TRUE(intervals.find_overlapping(0, 10) == intervals.end());
+
+  intervals.find_overlapping(16, 17)->second = 7;
+  EXPECT_EQ(intervals.find(ft::make_pair(10, 20))->second, 7);
+}
+
+TEST(IntervalMap, OverlappingMatchesLinearScan) {
+  interval_map_type intervals;
+  expected_map_type expected;
+  srand(17);
+  for (int i = 0; i < 3000; ++i) {
+    const int lo = rand() % 1000;
+    const int hi = lo + 1 + rand() % 50;
+    if (rand() % 4 == 0 && !expected.empty()) {
+      expected_map_type::iterator target = expected.lower_bound(
+          std::make_pair(lo, 0));
+      if (target == expected.end()) {
+        target = expected.begin();
+      }
+      EXPECT_EQ(intervals.erase(
+                    ft::make_pair(target->first.first, target->first.second)),
+                1u);
+      expected.erase(target);
+    } else {
+      intervals.insert(lo, hi, i);
+      expected.insert(std::make_pair(std::make_pair(lo, hi), i));
+    }
+    if (i % 100 == 0) {
+      expectOverlappingMatches(intervals, expected, lo, hi);
+    }
+  }
+  ASSERT_EQ(intervals.size(), expected.size());
+  for (int lo = -20; lo < 1100; lo += 13) {
+    expectOverlappingMatches(intervals, expected, lo, lo + 1);
+    expectOverlappingMatches(intervals, expected, lo, lo + 40);
+  }
+
+  interval_map_type copy(intervals);
+  expectOverlappingMatches(copy, expected, 300, 400);
+  interval_map_type other;
+  other.swap(copy);
+  expectOverlappingMatches(other, expected, 0, 1000);
+  EXPECT_TRUE(copy.find_overlapping(0, 1000) == copy.end());
+}
@@ -6,7 +6,7 @@
 #include <iostream>
 #include <iterator>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
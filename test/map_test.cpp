@@ -9,11 +9,15 @@
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <set>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "pair.hpp"
-#if __cplusplus >= 201103L
+#include "vector.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -35,6 +39,33 @@ TEST(Map, DefaultConstructor) {
   EXPECT_EQ(m.begin(), m.end());
 }
 
+TEST(Map, EmptyMapDoesNotAllocate) {
+  typedef int key_type;
+  typedef int mapped_type;
+  typedef ft::pair<const key_type, mapped_type> value_type;
+  typedef ft::test::CountingAllocator<value_type> allocator_type;
+  typedef ft::map<key_type, mapped_type, std::less<key_type>, allocator_type>
+      map_type;
+
+  ft::test::allocation_count() = 0;
+  map_type m;
+  map_type copy(m);
+  map_type assigned;
+  assigned = m;
+  m.swap(copy);
+  m.clear();
+  EXPECT_EQ(ft::test::allocation_count(), 0u);
+  EXPECT_EQ(m.begin(), m.end());
+  EXPECT_EQ(m.find(1), m.end());
+  EXPECT_EQ(m.lower_bound(1), m.end());
+
+  m.insert(value_type(1, 1));
+  EXPECT_EQ(ft::test::allocation_count(), 1u);
+  m.erase(1);
+  EXPECT_EQ(m.begin(), m.end());
+  EXPECT_TRUE(m.empty());
+}
+
 TEST(Map, ConstructorWithCompareMethod_CustomizableComparison) {
   typedef std::string key_type;
   typedef int mapped_type;
@@ -739,4 +770,523 @@ TEST(Map, MapOfMap) {
   EXPECT_EQ(mm["third"]["one"], 1);
   EXPECT_EQ(mm["third"]["two"], 2);
   EXPECT_EQ(mm["third"]["one hundred"], 100);
-}
\ No newline at end of file
+}
+
+namespace {
+
+// 文字列の長さで比較する. 長さ (std::size_t) のままでも探索出来る.
+struct LengthLess {
+  typedef void is_transparent;
+
+  bool operator()(const std::string &lhs, const std::string &rhs) const {
+    return lhs.size() < rhs.size();
+  }
+  bool operator()(const std::string &lhs, std::size_t rhs) const {
+    return lhs.size() < rhs;
+  }
+  bool operator()(std::size_t lhs, const std::string &rhs) const {
+    return lhs < rhs.size();
+  }
+};
+
+}  // namespace
+
+TEST(MapTransparent, LookupWithConstCharPointer) {
+  typedef ft::map<std::string, int, ft::less<> > map_type;
+  map_type m;
+  m["apple"] = 1;
+  m["banana"] = 2;
+  m["cherry"] = 3;
+  const map_type &const_m = m;
+  const char *banana = "banana";
+
+  EXPECT_EQ(m.find(banana)->second, 2);
+  EXPECT_EQ(const_m.find(banana)->second, 2);
+  EXPECT_TRUE(m.find("durian") == m.end());
+  EXPECT_EQ(m.count("apple"), 1u);
+  EXPECT_EQ(m.count("apricot"), 0u);
+  EXPECT_EQ(m.lower_bound("b")->first, "banana");
+  EXPECT_EQ(const_m.lower_bound("b")->first, "banana");
+  EXPECT_EQ(m.upper_bound(banana)->first, "cherry");
+  EXPECT_EQ(const_m.upper_bound(banana)->first, "cherry");
+  ft::pair<map_type::iterator, map_type::iterator> range =
+      m.equal_range(banana);
+  EXPECT_EQ(range.first->first, "banana");
+  EXPECT_EQ(range.second->first, "cherry");
+  ft::pair<map_type::const_iterator, map_type::const_iterator> const_range =
+      const_m.equal_range("c");
+  EXPECT_TRUE(const_range.first == const_range.second);
+  EXPECT_EQ(const_range.first->first, "cherry");
+}
+
+TEST(MapTransparent, LookupWithTypeNotConvertibleToKey) {
+  typedef ft::map<std::string, int, LengthLess> map_type;
+  map_type m;
+  m["a"] = 1;
+  m["bbb"] = 3;
+  m["ccccc"] = 5;
+
+  EXPECT_EQ(m.find(static_cast<std::size_t>(3))->second, 3);
+  EXPECT_TRUE(m.find(static_cast<std::size_t>(2)) == m.end());
+  EXPECT_EQ(m.count(static_cast<std::size_t>(5)), 1u);
+  EXPECT_EQ(m.lower_bound(static_cast<std::size_t>(2))->first, "bbb");
+  EXPECT_EQ(m.upper_bound(static_cast<std::size_t>(3))->first, "ccccc");
+  EXPECT_EQ(m.equal_range(static_cast<std::size_t>(1)).first->first, "a");
+  // key_type での探索はこれまで通り
+  EXPECT_EQ(m.find("xyz")->second, 3);
+}
+
+namespace {
+
+// コピーされた回数を数える値
+struct CopyCountingValue {
+  static int copy_count;
+  int value_;
+
+  CopyCountingValue(int value = 0) : value_(value) {}
+  CopyCountingValue(const CopyCountingValue &other) : value_(other.value_) {
+    ++copy_count;
+  }
+  CopyCountingValue &operator=(const CopyCountingValue &other) {
+    value_ = other.value_;
+    return *this;
+  }
+};
+
+int CopyCountingValue::copy_count = 0;
+
+}  // namespace
+
+TEST(MapInPlace, OperatorBracketDoesNotCopyMappedValue) {
+  ft::map<int, CopyCountingValue> m;
+
+  CopyCountingValue::copy_count = 0;
+  for (int i = 0; i < 100; ++i) {
+    m[i].value_ = i;
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(m[i].value_, i);
+  }
+  EXPECT_EQ(CopyCountingValue::copy_count, 0);
+  EXPECT_EQ(m.size(), 100u);
+}
+
+TEST(MapInPlace, InsertCopiesValueOnce) {
+  typedef ft::map<int, CopyCountingValue> map_type;
+  map_type m;
+  const map_type::value_type value(1, CopyCountingValue(1));
+
+  CopyCountingValue::copy_count = 0;
+  m.insert(value);
+  EXPECT_EQ(CopyCountingValue::copy_count, 1);
+  m.insert(value);
+  EXPECT_EQ(CopyCountingValue::copy_count, 1);
+  m.insert(m.end(), map_type::value_type(2, CopyCountingValue(2)));
+  EXPECT_EQ(m.size(), 2u);
+}
+
+TEST(MapInPlace, InsertOrAssign) {
+  typedef ft::map<std::string, std::string> map_type;
+  map_type m;
+
+  ft::pair<map_type::iterator, bool> res = m.insert_or_assign("a", "first");
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first->second, "first");
+  res = m.insert_or_assign("a", "second");
+  EXPECT_FALSE(res.second);
+  EXPECT_EQ(res.first->second, "second");
+  EXPECT_EQ(m.size(), 1u);
+
+  map_type::iterator it = m.insert_or_assign(m.end(), "b", "third");
+  EXPECT_EQ(it->first, "b");
+  EXPECT_EQ(it->second, "third");
+  it = m.insert_or_assign(m.begin(), "b", "fourth");
+  EXPECT_EQ(it->second, "fourth");
+  EXPECT_EQ(m.size(), 2u);
+}
+
+TEST(MapOrderStatistic, NthRankAndCountRange) {
+  typedef ft::map<std::string, int, std::less<std::string>,
+                  std::allocator<ft::pair<const std::string, int> >,
+                  ft::rbtree_order_statistic_node_policy<> >
+      map_type;
+  map_type m;
+  m["delta"] = 4;
+  m["alpha"] = 1;
+  m["echo"] = 5;
+  m["charlie"] = 3;
+  m["bravo"] = 2;
+  const map_type &const_m = m;
+
+  EXPECT_EQ(m.nth(0)->first, "alpha");
+  EXPECT_EQ(const_m.nth(3)->second, 4);
+  EXPECT_TRUE(m.nth(5) == m.end());
+  EXPECT_EQ(m.rank("charlie"), 2u);
+  EXPECT_EQ(m.rank("c"), 2u);
+  EXPECT_EQ(m.rank("zulu"), 5u);
+  EXPECT_EQ(m.count_range("b", "d"), 2u);
+  EXPECT_EQ(m.count_range("d", "b"), 0u);
+  EXPECT_EQ(m.index_of(m.find("echo")), 4u);
+
+  m.erase("bravo");
+  EXPECT_EQ(m.nth(1)->first, "charlie");
+  EXPECT_EQ(m.rank("echo"), 3u);
+}
+
+namespace {
+
+// 値の合計.
+struct MappedSum {
+  typedef long result_type;
+
+  static result_type identity() {
+    return 0;
+  }
+  static result_type value(const ft::pair<const int, int>& v) {
+    return v.second;
+  }
+  static result_type combine(result_type lhs, result_type rhs) {
+    return lhs + rhs;
+  }
+};
+
+// キーを中間順に繋げた文字列. 結合の順序を確かめるのに使う.
+struct KeyConcat {
+  typedef std::string result_type;
+
+  static result_type identity() {
+    return "";
+  }
+  static result_type value(const ft::pair<const char, int>& v) {
+    return std::string(1, v.first);
+  }
+  static result_type combine(const result_type& lhs, const result_type& rhs) {
+    return lhs + rhs;
+  }
+};
+
+}  // namespace
+
+TEST(MapAggregate, RangeSumMatchesLinearScan) {
+  typedef ft::map<int, int, std::less<int>,
+                  std::allocator<ft::pair<const int, int> >,
+                  ft::rbtree_augmented_node_policy<MappedSum> >
+      map_type;
+  map_type m;
+  std::map<int, int> expected;
+  srand(23);
+  for (int i = 0; i < 2000; ++i) {
+    const int key = rand() % 500;
+    const int value = rand() % 100;
+    if (rand() % 3 == 0) {
+      m.erase(key);
+      expected.erase(key);
+    } else if (rand() % 2 == 0) {
+      m.insert_or_assign(key, value);
+      expected[key] = value;
+    } else {
+      // operator[] で書き換えた後は refresh() で集計値を直す.
+      m[key] += value;
+      m.refresh(m.find(key));
+      expected[key] += value;
+    }
+  }
+  for (int lo = -5; lo < 510; lo += 17) {
+    for (int hi = lo - 10; hi < 520; hi += 41) {
+      long sum = 0;
+      for (std::map<int, int>::iterator it = expected.lower_bound(lo);
+           lo < hi && it != expected.end() && it->first < hi; ++it) {
+        sum += it->second;
+      }
+      EXPECT_EQ(m.range_aggregate(lo, hi), sum);
+    }
+  }
+}
+
+TEST(MapAggregate, CombinesInKeyOrder) {
+  typedef ft::map<char, int, std::less<char>,
+                  std::allocator<ft::pair<const char, int> >,
+                  ft::rbtree_augmented_node_policy<
+                      KeyConcat, ft::rbtree_order_statistic_node_policy<> > >
+      map_type;
+  map_type m;
+  const std::string letters = "qwertyuiopasdfghjklzxcvbnm";
+  for (std::size_t i = 0; i < letters.size(); ++i) {
+    m[letters[i]] = static_cast<int>(i);
+  }
+  EXPECT_EQ(m.range_aggregate('a', '{'), "abcdefghijklmnopqrstuvwxyz");
+  EXPECT_EQ(m.range_aggregate('d', 'k'), "defghij");
+  EXPECT_EQ(m.range_aggregate('k', 'd'), "");
+  m.erase('e');
+  EXPECT_EQ(m.range_aggregate('d', 'k'), "dfghij");
+  EXPECT_EQ(m.nth(4)->first, 'f');
+  EXPECT_EQ(m.rank('k'), 9u);
+}
+
+TEST(MapSetOperations, UniteKeepsOwnValues) {
+  typedef ft::map<int, int, std::less<int>,
+                  std::allocator<ft::pair<const int, int> >,
+                  ft::rbtree_augmented_node_policy<MappedSum> >
+      map_type;
+  map_type m;
+  map_type other;
+  for (int i = 0; i < 200; ++i) {
+    m[i * 2] = 1;
+    other[i * 5] = 100;
+  }
+
+  map_type subtracted(m);
+  subtracted.subtract(other);
+  EXPECT_EQ(subtracted.size(), 160u);
+  EXPECT_EQ(subtracted.range_aggregate(0, 1000), 160);
+
+  map_type intersected(other);
+  intersected.intersect(m);
+  EXPECT_EQ(intersected.size(), 40u);
+  EXPECT_EQ(intersected.range_aggregate(0, 1000), 4000);
+
+  m.unite(other);
+  EXPECT_TRUE(other.empty());
+  EXPECT_EQ(m.size(), 360u);
+  EXPECT_EQ(m[10], 1);
+  EXPECT_EQ(m[15], 100);
+  EXPECT_EQ(m.range_aggregate(0, 1000), 200 + 160 * 100);
+  EXPECT_EQ(m.range_aggregate(100, 200), 50 + 10 * 100);
+}
+
+TEST(MapBatchedLookup, MatchesSingleLookups) {
+  typedef ft::map<int, int> map_type;
+  map_type m;
+  for (int i = 0; i < 1000; ++i) {
+    m[i * 2] = i;
+  }
+  // 同時に進める探索の数で割り切れない数のキーで探す.
+  std::vector<int> keys;
+  for (int i = 0; i < 1003; ++i) {
+    keys.push_back((i * 7919) % 2003 - 1);
+  }
+
+  std::vector<map_type::iterator> found(keys.size());
+  EXPECT_TRUE(m.find_many(keys.begin(), keys.end(), found.begin()) ==
+              found.end());
+  const map_type &cm = m;
+  map_type::const_iterator lower[1003];
+  EXPECT_TRUE(cm.lower_bound_many(keys.begin(), keys.end(), lower) ==
+              lower + 1003);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(found[i] == m.find(keys[i]));
+    EXPECT_TRUE(lower[i] == cm.lower_bound(keys[i]));
+  }
+
+  // find_many が返すイテレータで値を書き換えられる.
+  const int key = 10;
+  m.find_many(&key, &key + 1, found.begin());
+  found[0]->second = -1;
+  EXPECT_EQ(m[10], -1);
+
+  map_type empty;
+  EXPECT_TRUE(empty.find_many(keys.begin(), keys.begin() + 20,
+                              found.begin()) == found.begin() + 20);
+  EXPECT_TRUE(found[19] == empty.end());
+  EXPECT_TRUE(m.lower_bound_many(keys.begin(), keys.begin(), found.begin()) ==
+              found.begin());
+}
+
+#if __cplusplus >= 201103L
+TEST(MapInPlace, TryEmplace) {
+  typedef ft::map<std::string, std::string> map_type;
+  map_type m;
+
+  ft::pair<map_type::iterator, bool> res = m.try_emplace("a", 3, 'x');
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first->second, "xxx");
+
+  // キーが既にある場合は引数をムーブしない
+  std::string value("not moved");
+  res = m.try_emplace("a", std::move(value));
+  EXPECT_FALSE(res.second);
+  EXPECT_EQ(res.first->second, "xxx");
+  EXPECT_EQ(value, "not moved");
+
+  std::string key("b");
+  res = m.try_emplace(std::move(key));
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first->first, "b");
+  EXPECT_EQ(res.first->second, "");
+
+  map_type::iterator it = m.try_emplace(m.end(), "c", "hint");
+  EXPECT_EQ(it->second, "hint");
+  it = m.try_emplace(m.begin(), "c", "ignored");
+  EXPECT_EQ(it->second, "hint");
+  EXPECT_EQ(m.size(), 3u);
+}
+
+TEST(MapInPlace, InsertOrAssignMovesOnlyOnce) {
+  typedef ft::map<int, std::string> map_type;
+  map_type m;
+  std::string value(100, 'v');
+
+  ft::pair<map_type::iterator, bool> res =
+      m.insert_or_assign(1, std::move(value));
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first->second, std::string(100, 'v'));
+
+  std::string other(50, 'o');
+  map_type::iterator it = m.insert_or_assign(m.end(), 1, std::move(other));
+  EXPECT_EQ(it->second, std::string(50, 'o'));
+  EXPECT_EQ(m.size(), 1u);
+}
+
+TEST(MapInPlace, InsertOrAssignHintMovesKey) {
+  typedef ft::map<std::string, std::string> map_type;
+  map_type m;
+  m["a"] = "1";
+
+  std::string key(100, 'k');
+  map_type::iterator it = m.insert_or_assign(m.end(), std::move(key), "2");
+  EXPECT_EQ(it->first, std::string(100, 'k'));
+  EXPECT_EQ(it->second, "2");
+
+  // キーが既にある場合はキーをムーブしない
+  std::string same(100, 'k');
+  it = m.insert_or_assign(m.begin(), std::move(same), "3");
+  EXPECT_EQ(it->second, "3");
+  EXPECT_EQ(same, std::string(100, 'k'));
+  EXPECT_EQ(m.size(), 2u);
+}
+
+namespace {
+
+// 生きているオブジェクトの数を数える値
+struct MapLiveValue {
+  static int live;
+
+  MapLiveValue() {
+    ++live;
+  }
+  MapLiveValue(const MapLiveValue &) {
+    ++live;
+  }
+  MapLiveValue &operator=(const MapLiveValue &) {
+    return *this;
+  }
+  ~MapLiveValue() {
+    --live;
+  }
+};
+
+int MapLiveValue::live = 0;
+
+// countdown 回目の比較で例外を投げる比較関数
+struct MapThrowingLess {
+  static int countdown;
+
+  bool operator()(int lhs, int rhs) const {
+    if (countdown >= 0 && countdown-- == 0) {
+      throw std::runtime_error("compare");
+    }
+    return lhs < rhs;
+  }
+};
+
+int MapThrowingLess::countdown = -1;
+
+}  // namespace
+
+TEST(MapInPlace, TryEmplaceFreesNodeWhenCompareThrows) {
+  typedef ft::map<int, MapLiveValue, MapThrowingLess> map_type;
+  {
+    map_type m;
+    for (int i = 0; i < 32; i += 2) {
+      m.try_emplace(i);
+    }
+    // 探索中と, ノードを作った後に左右を決める時の全ての比較で投げさせる
+    for (int countdown = 0; countdown < 16; ++countdown) {
+      MapThrowingLess::countdown = countdown;
+      try {
+        m.try_emplace(m.end(), 31);
+        m.try_emplace(15);
+      } catch (const std::runtime_error &) {
+      }
+      MapThrowingLess::countdown = -1;
+      EXPECT_EQ(MapLiveValue::live, static_cast<int>(m.size()));
+      m.erase(31);
+      m.erase(15);
+    }
+  }
+  EXPECT_EQ(MapLiveValue::live, 0);
+}
+
+TEST(MapMove, MoveConstructorKeepsNodes) {
+  ft::map<std::string, std::string> src;
+  src["one"] = "1";
+  src["two"] = "2";
+  src["three"] = "3";
+  ft::map<std::string, std::string>::iterator it = src.find("two");
+
+  ft::map<std::string, std::string> dst(std::move(src));
+  EXPECT_EQ(dst.size(), 3u);
+  EXPECT_TRUE(src.empty());
+  // ノードは付け替えられるだけなのでイテレータは有効なまま
+  EXPECT_TRUE(it == dst.find("two"));
+
+  src["four"] = "4";
+  EXPECT_EQ(src.size(), 1u);
+}
+
+TEST(MapMove, VectorGrowthMovesMaps) {
+  typedef ft::map<std::string, int> map_type;
+  EXPECT_TRUE(std::is_nothrow_move_constructible<map_type>::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<map_type>::value);
+
+  ft::vector<map_type> maps(1);
+  maps[0]["key"] = 1;
+  const ft::pair<const std::string, int>* node_value = &*maps[0].begin();
+  for (int i = 0; i < 100; ++i) {
+    maps.push_back(map_type());
+  }
+  // 再確保でコピーされていればノードのアドレスが変わる
+  EXPECT_EQ(&*maps[0].begin(), node_value);
+}
+
+TEST(MapMove, MoveAssignment) {
+  ft::map<std::string, int> src;
+  ft::map<std::string, int> dst;
+  for (int i = 0; i < 100; ++i) {
+    src[std::to_string(i)] = i;
+  }
+  dst["old"] = -1;
+
+  dst = std::move(src);
+  EXPECT_EQ(dst.size(), 100u);
+  EXPECT_EQ(dst.count("old"), 0u);
+  EXPECT_EQ(dst["42"], 42);
+  EXPECT_TRUE(src.empty());
+}
+
+TEST(MapMove, InsertRvalueAndEmplace) {
+  typedef ft::map<std::string, std::string> map_type;
+  map_type m;
+  std::string key(100, 'k');
+  std::string value(100, 'v');
+
+  ft::pair<map_type::iterator, bool> res =
+      m.insert(map_type::value_type(key, std::move(value)));
+  EXPECT_TRUE(res.second);
+  EXPECT_EQ(res.first->second, std::string(100, 'v'));
+
+  res = m.emplace(key, "duplicated");
+  EXPECT_FALSE(res.second);
+  EXPECT_EQ(res.first->second, std::string(100, 'v'));
+
+  res = m.emplace("a", "b");
+  EXPECT_TRUE(res.second);
+  map_type::iterator it = m.emplace_hint(m.end(), "z", "y");
+  EXPECT_EQ(it->first, "z");
+
+  std::string moved_key("moved");
+  m[std::move(moved_key)] = "value";
+  EXPECT_EQ(m["moved"], "value");
+  EXPECT_EQ(m.size(), 4u);
+}
+#endif
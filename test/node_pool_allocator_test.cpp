@@ -0,0 +1,157 @@
+#include "node_pool_allocator.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+
+#include "map.hpp"
+#include "set.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+
+namespace {
+
+struct PoolTestNode {
+  PoolTestNode *left;
+  PoolTestNode *right;
+  int value;
+};
+
+}  // namespace
+
+TEST(NodePoolAllocator, FreedSlotIsReused) {
+  ft::node_pool_allocator<PoolTestNode> alloc;
+
+  PoolTestNode *first = alloc.allocate(1);
+  PoolTestNode *second = alloc.allocate(1);
+  alloc.deallocate(first, 1);
+  PoolTestNode *third = alloc.allocate(1);
+  EXPECT_EQ(third, first);
+  alloc.deallocate(second, 1);
+  alloc.deallocate(third, 1);
+}
+
+TEST(NodePoolAllocator, SlotsAreCarvedContiguously) {
+  ft::node_pool_allocator<PoolTestNode> alloc;
+
+  PoolTestNode *nodes[8];
+  for (int i = 0; i < 8; ++i) {
+    nodes[i] = alloc.allocate(1);
+  }
+  for (int i = 1; i < 8; ++i) {
+    EXPECT_EQ(nodes[i], nodes[i - 1] + 1);
+  }
+  for (int i = 0; i < 8; ++i) {
+    alloc.deallocate(nodes[i], 1);
+  }
+}
+
+TEST(NodePoolAllocator, CopiesShareThePool) {
+  typedef ft::node_pool_allocator<PoolTestNode> allocator_type;
+  allocator_type alloc;
+  allocator_type copy(alloc);
+  allocator_type assigned;
+  assigned = alloc;
+  allocator_type other;
+
+  EXPECT_TRUE(alloc == copy);
+  EXPECT_TRUE(alloc == assigned);
+  EXPECT_TRUE(alloc != other);
+
+  PoolTestNode *node = alloc.allocate(1);
+  copy.deallocate(node, 1);
+  EXPECT_EQ(assigned.allocate(1), node);
+  assigned.deallocate(node, 1);
+}
+
+TEST(NodePoolAllocator, RebindSharesThePool) {
+  typedef ft::node_pool_allocator<PoolTestNode> allocator_type;
+  typedef ft::node_pool_allocator<int> rebound_type;
+  allocator_type alloc;
+  rebound_type rebound(alloc);
+  allocator_type back(rebound);
+
+  EXPECT_TRUE(back == alloc);
+  EXPECT_TRUE(allocator_type(rebound_type(alloc)) == alloc);
+  EXPECT_TRUE(allocator_type(rebound_type(allocator_type())) != alloc);
+
+  PoolTestNode *node = back.allocate(1);
+  alloc.deallocate(node, 1);
+  EXPECT_EQ(alloc.allocate(1), node);
+  alloc.deallocate(node, 1);
+
+  // rebind して捨てたアロケータで確保した領域も元のアロケータで使い続けられる.
+  int *value = rebound_type(alloc).allocate(1);
+  *value = 42;
+  PoolTestNode *other = alloc.allocate(1);
+  EXPECT_EQ(*value, 42);
+  alloc.deallocate(other, 1);
+  rebound_type(alloc).deallocate(value, 1);
+}
+
+TEST(NodePoolAllocator, ArrayAllocationAndConstruct) {
+  ft::node_pool_allocator<std::string> alloc;
+
+  std::string *strings = alloc.allocate(3);
+  for (int i = 0; i < 3; ++i) {
+    alloc.construct(strings + i, std::string(static_cast<std::size_t>(i), 'x'));
+  }
+  EXPECT_EQ(strings[2], "xx");
+  for (int i = 0; i < 3; ++i) {
+    alloc.destroy(strings + i);
+  }
+  alloc.deallocate(strings, 3);
+}
+
+TEST(NodePoolAllocator, MapInsertAndErase) {
+  typedef ft::node_pool_allocator<ft::pair<const int, std::string> >
+      allocator_type;
+  typedef ft::map<int, std::string, std::less<int>, allocator_type> map_type;
+  std::map<int, std::string> expected;
+  map_type m;
+
+  srand(42);
+  for (int i = 0; i < 3000; ++i) {
+    const int key = rand() % 1000;
+    if (rand() % 3 == 0) {
+      EXPECT_EQ(m.erase(key), expected.erase(key));
+    } else {
+      m[key] = std::string(static_cast<std::size_t>(key % 20), 'a');
+      expected[key] = std::string(static_cast<std::size_t>(key % 20), 'a');
+    }
+  }
+  ASSERT_EQ(m.size(), expected.size());
+  std::map<int, std::string>::iterator expected_it = expected.begin();
+  for (map_type::iterator it = m.begin(); it != m.end(); ++it, ++expected_it) {
+    EXPECT_EQ(it->first, expected_it->first);
+    EXPECT_EQ(it->second, expected_it->second);
+  }
+}
+
+TEST(NodePoolAllocator, SetCopySwapAndDestroy) {
+  typedef ft::set<int, std::less<int>, ft::node_pool_allocator<int> > set_type;
+
+  set_type kept;
+  {
+    set_type a;
+    set_type b;
+    for (int i = 0; i < 100; ++i) {
+      a.insert(i);
+      b.insert(i + 1000);
+    }
+    set_type copy(a);
+    // ノードごとアロケータも入れ替わるので, a と b が先に破棄されても良い.
+    kept.swap(b);
+    a.swap(copy);
+    a.erase(50);
+    EXPECT_EQ(copy.size(), 100u);
+  }
+  EXPECT_EQ(kept.size(), 100u);
+  EXPECT_EQ(*kept.begin(), 1000);
+  kept.insert(1);
+  EXPECT_EQ(*kept.begin(), 1);
+}
@@ -6,7 +6,7 @@
 #include <iostream>
 #include <iterator>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -122,4 +122,16 @@ TEST(MakePair, MakePair) {
 
   EXPECT_EQ(student1.first, "Jun");
   EXPECT_EQ(student1.second, 20);
-}
\ No newline at end of file
+}
+
+#if __cplusplus >= 201103L
+TEST(PairMove, NoexceptFollowsMembers) {
+  EXPECT_TRUE((std::is_nothrow_move_constructible<
+               ft::pair<std::string, int> >::value));
+  EXPECT_TRUE(
+      (std::is_nothrow_move_assignable<ft::pair<std::string, int> >::value));
+  // const なキーはムーブできずコピーになるので noexcept にはならない
+  EXPECT_FALSE((std::is_nothrow_move_constructible<
+                ft::pair<const std::string, int> >::value));
+}
+#endif
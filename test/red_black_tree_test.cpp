@@ -13,11 +13,14 @@
 #include <iostream>
 #include <iterator>
 #include <set>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "map.hpp"
 #include "pair.hpp"
-#if __cplusplus >= 201103L
+#include "set.hpp"
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -31,29 +34,30 @@ bool __are_keys_equal(const key_type &key1, const key_type &key2) {
 }
 
 // テスト用の関数. 色の修正や木の回転などを行わない挿入.
+// 葉は NULL にし, 根の親は end_node にする.
 template <class Key, class Value, typename KeyOfValue, typename Compare>
 typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *
 insertNodeWithoutFixup(
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *
         *root,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node,
+        *end_node,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
         *new_node) {
   typedef typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
       node_type;
 
-  if (*root == nil_node) {
+  if (*root == NULL) {
     *root = new_node;
-    new_node->parent_ = nil_node;
-    new_node->left_ = nil_node;
-    new_node->right_ = nil_node;
+    new_node->set_parent(end_node);
+    new_node->left_ = NULL;
+    new_node->right_ = NULL;
     return new_node;
   }
 
-  node_type *parent = nil_node;
+  node_type *parent = end_node;
   node_type *node = *root;
-  while (node != nil_node) {
+  while (node != NULL) {
     if (__are_keys_equal<Key, Compare>(KeyOfValue()(new_node->value_),
                                        KeyOfValue()(node->value_))) {
       exit(1);
@@ -66,9 +70,9 @@ insertNodeWithoutFixup(
       node = node->right_;
     }
   }
-  new_node->parent_ = parent;
-  new_node->left_ = nil_node;
-  new_node->right_ = nil_node;
+  new_node->set_parent(parent);
+  new_node->left_ = NULL;
+  new_node->right_ = NULL;
   if (Compare()(KeyOfValue()(new_node->value_), KeyOfValue()(parent->value_))) {
     parent->left_ = new_node;
   } else {
@@ -83,30 +87,33 @@ insertNodeWithoutFixup(
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *
         *root,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node,
+        *end_node,
     Value value,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type::Color
         color) {
   typedef typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
       node_type;
   node_type *new_node = new node_type(value);
-  new_node->color_ = color;
-  insertNodeWithoutFixup<Key, Value, KeyOfValue, Compare>(root, nil_node,
+  new_node->set_color(color);
+  insertNodeWithoutFixup<Key, Value, KeyOfValue, Compare>(root, end_node,
                                                           new_node);
   return new_node;
 }
 
+// 葉(NULL)は黒として扱う.
+template <class Node>
+bool isBlackNode(const Node *node) {
+  return node == NULL || node->color() == Node::BLACK;
+}
+
 template <class Key, class Value, typename KeyOfValue, typename Compare>
 void expectAllRedNodeHasTwoBlackChild(
-    typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *node,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node);
+        *node);
 
 template <class Key, class Value, typename KeyOfValue, typename Compare>
 int expectAllPathesAreSameBlackNodeCount(
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *node,
-    typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node,
     int black_count = 0);
 
 // テスト用の関数. 赤黒木のルールを守っているか確かめる.
@@ -129,15 +136,17 @@ void expectRedBlackTreeKeepRules(
       node_type;
 
   // 2. 根は黒である. (たまにこの条件は省かれる)
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);
 
   // 3. 葉(NIL)は全て黒である. 葉は全て根と同じ色である.
-  EXPECT_EQ(rb_tree.nil_node_->color_, node_type::BLACK);
-  EXPECT_EQ(rb_tree.root_->color_, rb_tree.nil_node_->color_);
+  //    葉は NULL で表されていて, isBlackNode() で黒として扱う.
+  EXPECT_TRUE(isBlackNode<node_type>(NULL));
+  EXPECT_EQ(rb_tree.end_node_->color(), node_type::BLACK);
+  EXPECT_EQ(rb_tree.root_->parent(), rb_tree.end_node_);
 
   // 4. 赤のノードは黒ノードを2つ子に持つ.
   expectAllRedNodeHasTwoBlackChild<Key, Value, KeyOfValue, Compare>(
-      rb_tree.root_, rb_tree.nil_node_);
+      rb_tree.root_);
 
   // 5. 任意のノードについて,
   //    そのノードから子孫の葉までの道に含まれる黒ノードの数は,
@@ -146,57 +155,80 @@ void expectRedBlackTreeKeepRules(
   //    「根から葉までの道に含まれる黒いノードの数は、葉によらず一定である」
   //    と言い換えることができる)
   expectAllPathesAreSameBlackNodeCount<Key, Value, KeyOfValue, Compare>(
-      rb_tree.root_, rb_tree.nil_node_);
+      rb_tree.root_);
 }
 
 template <class Key, class Value, class KeyOfValue, typename Compare>
 void expectAllRedNodeHasTwoBlackChild(
-    typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *node,
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node) {
+        *node) {
   typedef typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
       node_type;
 
-  if (node == nil_node) {
+  if (node == NULL) {
     return;
   }
-  if (node->color_ == node_type::RED) {
-    EXPECT_EQ(node->left_->color_, node_type::BLACK);
-    EXPECT_EQ(node->right_->color_, node_type::BLACK);
+  if (node->color() == node_type::RED) {
+    EXPECT_TRUE(isBlackNode(node->left_));
+    EXPECT_TRUE(isBlackNode(node->right_));
   }
-  expectAllRedNodeHasTwoBlackChild<Key, Value, KeyOfValue, Compare>(node->left_,
-                                                                    nil_node);
   expectAllRedNodeHasTwoBlackChild<Key, Value, KeyOfValue, Compare>(
-      node->right_, nil_node);
+      node->left_);
+  expectAllRedNodeHasTwoBlackChild<Key, Value, KeyOfValue, Compare>(
+      node->right_);
 }
 
 template <class Key, class Value, typename KeyOfValue, typename Compare>
 int expectAllPathesAreSameBlackNodeCount(
     typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type *node,
-    typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
-        *nil_node,
     int black_count) {
   typedef typename ft::RedBlackTree<Key, Value, KeyOfValue, Compare>::node_type
       node_type;
 
-  if (node == nil_node) {
+  if (node == NULL) {
     return black_count;
   }
-  if (node->color_ == node_type::BLACK) {
+  if (node->color() == node_type::BLACK) {
     black_count++;
   }
   int left_count =
       expectAllPathesAreSameBlackNodeCount<Key, Value, KeyOfValue, Compare>(
-          node->left_, nil_node, black_count);
+          node->left_, black_count);
   int right_count =
       expectAllPathesAreSameBlackNodeCount<Key, Value, KeyOfValue, Compare>(
-          node->right_, nil_node, black_count);
+          node->right_, black_count);
   EXPECT_EQ(left_count, right_count);
   return left_count;
 }
 
 }  // namespace
 
+TEST(RBTNode, ColorIsPackedIntoParentPointer) {
+  typedef ft::RBTNode<int> node_type;
+
+  // ポインタ3つ + int が, パディング込みでポインタ4つ分に収まる.
+  EXPECT_EQ(sizeof(node_type), 4 * sizeof(void *));
+
+  node_type parent(1);
+  node_type child(2);
+  EXPECT_EQ(child.color(), node_type::BLACK);
+  EXPECT_TRUE(child.parent() == NULL);
+
+  child.set_color(node_type::RED);
+  child.set_parent(&parent);
+  EXPECT_EQ(child.parent(), &parent);
+  EXPECT_EQ(child.color(), node_type::RED);
+
+  child.set_color(node_type::BLACK);
+  EXPECT_EQ(child.parent(), &parent);
+  EXPECT_EQ(child.color(), node_type::BLACK);
+
+  child.set_color(node_type::RED);
+  child.set_parent(NULL);
+  EXPECT_TRUE(child.parent() == NULL);
+  EXPECT_EQ(child.color(), node_type::RED);
+}
+
 TEST(RedBlackTree, BasicOperations) {
   typedef std::string key_type;
   typedef int mapped_type;
@@ -304,7 +336,7 @@ TEST(get_next_node, DeleteNodeDuringIteration) {
   }
   const node_type *node = ft::find_minimum_node(rb_tree.root_);  // begin
   int i = 0;
-  while (!node->is_nil_node_) {
+  while (node != rb_tree.end_node_) {
     EXPECT_EQ(node->value_.first, i);
     if (i == 1) {
       // 2をスキップする
@@ -364,7 +396,7 @@ TEST(get_prev_node, DeleteNodeDuringIteration) {
   }
   const node_type *node = ft::find_maximum_node(rb_tree.root_);  // rbegin
   int i = 4;
-  while (!node->is_nil_node_) {
+  while (node != rb_tree.end_node_) {
     EXPECT_EQ(node->value_.first, i);
     if (i == 2) {
       // 1をスキップする
@@ -424,7 +456,7 @@ TEST(RedBlackTree, CopyConstructor) {
   const tree_type::node_type *n2 = ft::find_minimum_node(t2.root_);
   const tree_type::node_type *n3 = ft::find_minimum_node(t3.root_);
   const tree_type::node_type *n4 = ft::find_minimum_node(t4.root_);
-  while (!n1->is_nil_node_) {
+  while (n1 != t1.end_node_) {
     EXPECT_EQ(n1->value_.first, n2->value_.first);
     EXPECT_EQ(n1->value_.second, n2->value_.second);
     EXPECT_NE(n1, n2);
@@ -527,6 +559,84 @@ TEST(ConstructorWithRange, RangeIsZero) {
   EXPECT_EQ(rb_tree.begin(), rb_tree.end());
 }
 
+TEST(ConstructorWithRange, SortedRangeIsBuiltBalanced) {
+  typedef int key_type;
+  typedef int mapped_type;
+  typedef ft::pair<const key_type, mapped_type> pair_type;
+  typedef ft::RedBlackTree<key_type, pair_type, ft::Select1st<pair_type> >
+      tree_type;
+  typedef std::vector<pair_type> pair_vector_type;
+
+  for (int n = 1; n <= 130; ++n) {
+    pair_vector_type vec;
+    for (int i = 0; i < n; ++i) {
+      vec.push_back(pair_type(i * 2, i));
+    }
+    tree_type rb_tree(vec.begin(), vec.end());
+
+    ASSERT_EQ(rb_tree.size(), tree_type::size_type(n));
+    expectRedBlackTreeKeepRules(rb_tree);
+    // 高さは ceil(log2(n + 1)) になる
+    int min_height = 0;
+    while ((1 << min_height) < n + 1) {
+      ++min_height;
+    }
+    EXPECT_EQ(rb_tree.get_height(), min_height);
+
+    tree_type::iterator it = rb_tree.begin();
+    for (int i = 0; i < n; ++i, ++it) {
+      EXPECT_EQ(it->first, i * 2);
+    }
+    EXPECT_EQ(it, rb_tree.end());
+    for (int i = 0; i < n; ++i) {
+      --it;
+    }
+    EXPECT_EQ(it, rb_tree.begin());
+
+    rb_tree.insert_unique(pair_type(-1, 0));
+    rb_tree.erase(n / 2 * 2);
+    expectRedBlackTreeKeepRules(rb_tree);
+    EXPECT_EQ(rb_tree.begin()->first, -1);
+  }
+}
+
+TEST(InsertRange, UnsortedOrDuplicatedRangeFallsBack) {
+  typedef int key_type;
+  typedef int mapped_type;
+  typedef ft::pair<const key_type, mapped_type> pair_type;
+  typedef ft::RedBlackTree<key_type, pair_type, ft::Select1st<pair_type> >
+      tree_type;
+  typedef std::vector<pair_type> pair_vector_type;
+
+  pair_vector_type unsorted;
+  unsorted.push_back(pair_type(3, 0));
+  unsorted.push_back(pair_type(1, 0));
+  unsorted.push_back(pair_type(2, 0));
+  tree_type unsorted_tree(unsorted.begin(), unsorted.end());
+  EXPECT_EQ(unsorted_tree.size(), tree_type::size_type(3));
+  EXPECT_EQ(unsorted_tree.begin()->first, 1);
+  expectRedBlackTreeKeepRules(unsorted_tree);
+
+  // 同じキーが続く場合は最初の要素だけが入る
+  pair_vector_type duplicated;
+  duplicated.push_back(pair_type(1, 1));
+  duplicated.push_back(pair_type(1, 2));
+  duplicated.push_back(pair_type(2, 3));
+  tree_type duplicated_tree(duplicated.begin(), duplicated.end());
+  EXPECT_EQ(duplicated_tree.size(), tree_type::size_type(2));
+  EXPECT_EQ(duplicated_tree.begin()->second, 1);
+  expectRedBlackTreeKeepRules(duplicated_tree);
+
+  // 空でない木へのソート済み範囲の挿入
+  pair_vector_type sorted;
+  for (int i = 0; i < 10; ++i) {
+    sorted.push_back(pair_type(i, i));
+  }
+  unsorted_tree.insert_range_unique(sorted.begin(), sorted.end());
+  EXPECT_EQ(unsorted_tree.size(), tree_type::size_type(10));
+  expectRedBlackTreeKeepRules(unsorted_tree);
+}
+
 // insert_unique
 
 TEST(insert_unique, Random1000) {
@@ -589,41 +699,41 @@ TEST(insert_unique, UncleIsRedLeft) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(4, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(4, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 10);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *left_subtree = rb_tree.root_->left_;
   ASSERT_EQ(left_subtree->value_.first, 5);
-  ASSERT_EQ(left_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(left_subtree->color(), node_type::BLACK);
   ASSERT_EQ(left_subtree->right_->value_.first, 7);
-  ASSERT_EQ(left_subtree->right_->color_, node_type::RED);
+  ASSERT_EQ(left_subtree->right_->color(), node_type::RED);
   ASSERT_EQ(left_subtree->left_->value_.first, 4);
-  ASSERT_EQ(left_subtree->left_->color_, node_type::RED);
+  ASSERT_EQ(left_subtree->left_->color(), node_type::RED);
 
   rb_tree.insert_unique(pair_type(3, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 10);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   left_subtree = rb_tree.root_->left_;
   EXPECT_EQ(left_subtree->value_.first, 5);
-  EXPECT_EQ(left_subtree->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->color(), node_type::RED);
   EXPECT_EQ(left_subtree->right_->value_.first, 7);
-  EXPECT_EQ(left_subtree->right_->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->right_->color(), node_type::BLACK);
   EXPECT_EQ(left_subtree->left_->value_.first, 4);
-  EXPECT_EQ(left_subtree->left_->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->left_->color(), node_type::BLACK);
   EXPECT_EQ(left_subtree->left_->left_->value_.first, 3);
-  EXPECT_EQ(left_subtree->left_->left_->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->left_->left_->color(), node_type::RED);
 }
 
 TEST(insert_unique, UncleIsRedRight) {
@@ -648,41 +758,41 @@ TEST(insert_unique, UncleIsRedRight) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(12, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(12, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 5);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *right_subtree = rb_tree.root_->right_;
   ASSERT_EQ(right_subtree->value_.first, 10);
-  ASSERT_EQ(right_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(right_subtree->color(), node_type::BLACK);
   ASSERT_EQ(right_subtree->left_->value_.first, 7);
-  ASSERT_EQ(right_subtree->left_->color_, node_type::RED);
+  ASSERT_EQ(right_subtree->left_->color(), node_type::RED);
   ASSERT_EQ(right_subtree->right_->value_.first, 12);
-  ASSERT_EQ(right_subtree->right_->color_, node_type::RED);
+  ASSERT_EQ(right_subtree->right_->color(), node_type::RED);
 
   rb_tree.insert_unique(pair_type(15, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 5);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   right_subtree = rb_tree.root_->right_;
   EXPECT_EQ(right_subtree->value_.first, 10);
-  EXPECT_EQ(right_subtree->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->color(), node_type::RED);
   EXPECT_EQ(right_subtree->left_->value_.first, 7);
-  EXPECT_EQ(right_subtree->left_->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->left_->color(), node_type::BLACK);
   EXPECT_EQ(right_subtree->right_->value_.first, 12);
-  EXPECT_EQ(right_subtree->right_->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->right_->color(), node_type::BLACK);
   EXPECT_EQ(right_subtree->right_->right_->value_.first, 15);
-  EXPECT_EQ(right_subtree->right_->right_->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->right_->right_->color(), node_type::RED);
 }
 
 TEST(insert_unique, UncleIsBlackAndNewNodeIsLeftLeft) {
@@ -713,41 +823,41 @@ TEST(insert_unique, UncleIsBlackAndNewNodeIsLeftLeft) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(3, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(3, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 10);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *left_subtree = rb_tree.root_->left_;
   ASSERT_EQ(left_subtree->value_.first, 5);
-  ASSERT_EQ(left_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(left_subtree->color(), node_type::BLACK);
   ASSERT_EQ(left_subtree->left_->value_.first, 3);
-  ASSERT_EQ(left_subtree->left_->color_, node_type::RED);
+  ASSERT_EQ(left_subtree->left_->color(), node_type::RED);
   ASSERT_EQ(left_subtree->right_->value_.first, 7);
-  ASSERT_EQ(left_subtree->right_->color_, node_type::BLACK);
+  ASSERT_EQ(left_subtree->right_->color(), node_type::BLACK);
 
   rb_tree.insert_unique(pair_type(1, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 10);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   left_subtree = rb_tree.root_->left_;
   EXPECT_EQ(left_subtree->value_.first, 3);
-  EXPECT_EQ(left_subtree->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->color(), node_type::BLACK);
   EXPECT_EQ(left_subtree->left_->value_.first, 1);
-  EXPECT_EQ(left_subtree->left_->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->left_->color(), node_type::RED);
   EXPECT_EQ(left_subtree->right_->value_.first, 5);
-  EXPECT_EQ(left_subtree->right_->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->right_->color(), node_type::RED);
   EXPECT_EQ(left_subtree->right_->right_->value_.first, 7);
-  EXPECT_EQ(left_subtree->right_->right_->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->right_->right_->color(), node_type::BLACK);
 }
 
 TEST(insert_unique, UncleIsBlackAndNewNodeIsRightRight) {
@@ -778,41 +888,41 @@ TEST(insert_unique, UncleIsBlackAndNewNodeIsRightRight) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(1, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(1, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(3, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(3, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 1);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *right_subtree = rb_tree.root_->right_;
   ASSERT_EQ(right_subtree->value_.first, 5);
-  ASSERT_EQ(right_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(right_subtree->color(), node_type::BLACK);
   ASSERT_EQ(right_subtree->left_->value_.first, 3);
-  ASSERT_EQ(right_subtree->left_->color_, node_type::BLACK);
+  ASSERT_EQ(right_subtree->left_->color(), node_type::BLACK);
   ASSERT_EQ(right_subtree->right_->value_.first, 7);
-  ASSERT_EQ(right_subtree->right_->color_, node_type::RED);
+  ASSERT_EQ(right_subtree->right_->color(), node_type::RED);
 
   rb_tree.insert_unique(pair_type(10, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 1);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   right_subtree = rb_tree.root_->right_;
   EXPECT_EQ(right_subtree->value_.first, 7);
-  EXPECT_EQ(right_subtree->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->color(), node_type::BLACK);
   EXPECT_EQ(right_subtree->right_->value_.first, 10);
-  EXPECT_EQ(right_subtree->right_->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->right_->color(), node_type::RED);
   EXPECT_EQ(right_subtree->left_->value_.first, 5);
-  EXPECT_EQ(right_subtree->left_->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->left_->color(), node_type::RED);
   EXPECT_EQ(right_subtree->left_->left_->value_.first, 3);
-  EXPECT_EQ(right_subtree->left_->left_->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->left_->left_->color(), node_type::BLACK);
 }
 
 TEST(insert_unique, UncleIsBlackAndNewNodeIsLeftRight) {
@@ -842,41 +952,41 @@ TEST(insert_unique, UncleIsBlackAndNewNodeIsLeftRight) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(3, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(3, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 10);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *left_subtree = rb_tree.root_->left_;
   ASSERT_EQ(left_subtree->value_.first, 5);
-  ASSERT_EQ(left_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(left_subtree->color(), node_type::BLACK);
   ASSERT_EQ(left_subtree->left_->value_.first, 3);
-  ASSERT_EQ(left_subtree->left_->color_, node_type::RED);
+  ASSERT_EQ(left_subtree->left_->color(), node_type::RED);
   ASSERT_EQ(left_subtree->right_->value_.first, 7);
-  ASSERT_EQ(left_subtree->right_->color_, node_type::BLACK);
+  ASSERT_EQ(left_subtree->right_->color(), node_type::BLACK);
 
   rb_tree.insert_unique(pair_type(4, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 10);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   left_subtree = rb_tree.root_->left_;
   EXPECT_EQ(left_subtree->value_.first, 4);
-  EXPECT_EQ(left_subtree->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->color(), node_type::BLACK);
   EXPECT_EQ(left_subtree->left_->value_.first, 3);
-  EXPECT_EQ(left_subtree->left_->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->left_->color(), node_type::RED);
   EXPECT_EQ(left_subtree->right_->value_.first, 5);
-  EXPECT_EQ(left_subtree->right_->color_, node_type::RED);
+  EXPECT_EQ(left_subtree->right_->color(), node_type::RED);
   EXPECT_EQ(left_subtree->right_->right_->value_.first, 7);
-  EXPECT_EQ(left_subtree->right_->right_->color_, node_type::BLACK);
+  EXPECT_EQ(left_subtree->right_->right_->color(), node_type::BLACK);
 }
 
 TEST(insert_unique, UncleIsBlackAndNewNodeIsRightleft) {
@@ -906,41 +1016,41 @@ TEST(insert_unique, UncleIsBlackAndNewNodeIsRightleft) {
 
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(1, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(1, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(3, 0), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(3, 0), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 0), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 0), node_type::RED);
 
   // これがおかしいということはテストの入力がおかしいので, プログラムを終了
   ASSERT_EQ(rb_tree.root_->value_.first, 1);
-  ASSERT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  ASSERT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   node_type *right_subtree = rb_tree.root_->right_;
   ASSERT_EQ(right_subtree->value_.first, 5);
-  ASSERT_EQ(right_subtree->color_, node_type::BLACK);
+  ASSERT_EQ(right_subtree->color(), node_type::BLACK);
   ASSERT_EQ(right_subtree->left_->value_.first, 3);
-  ASSERT_EQ(right_subtree->left_->color_, node_type::BLACK);
+  ASSERT_EQ(right_subtree->left_->color(), node_type::BLACK);
   ASSERT_EQ(right_subtree->right_->value_.first, 7);
-  ASSERT_EQ(right_subtree->right_->color_, node_type::RED);
+  ASSERT_EQ(right_subtree->right_->color(), node_type::RED);
 
   rb_tree.insert_unique(pair_type(6, 0));
 
   EXPECT_EQ(rb_tree.root_->value_.first, 1);
-  EXPECT_EQ(rb_tree.root_->color_, node_type::BLACK);  // 根は黒
+  EXPECT_EQ(rb_tree.root_->color(), node_type::BLACK);  // 根は黒
   right_subtree = rb_tree.root_->right_;
   EXPECT_EQ(right_subtree->value_.first, 6);
-  EXPECT_EQ(right_subtree->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->color(), node_type::BLACK);
   EXPECT_EQ(right_subtree->right_->value_.first, 7);
-  EXPECT_EQ(right_subtree->right_->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->right_->color(), node_type::RED);
   EXPECT_EQ(right_subtree->left_->value_.first, 5);
-  EXPECT_EQ(right_subtree->left_->color_, node_type::RED);
+  EXPECT_EQ(right_subtree->left_->color(), node_type::RED);
   EXPECT_EQ(right_subtree->left_->left_->value_.first, 3);
-  EXPECT_EQ(right_subtree->left_->left_->color_, node_type::BLACK);
+  EXPECT_EQ(right_subtree->left_->left_->color(), node_type::BLACK);
 }
 
 TEST(search_key_node, BasicOperations) {
@@ -1128,34 +1238,34 @@ TEST(DeleteLeft, TargetNodesBrotherIsRed) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 10), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 10), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 5), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 5), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 7), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 7), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(15, 15), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(15, 15), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(12, 12), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(12, 12), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(17, 17), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(17, 17), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(22, 22), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(22, 22), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::BLACK);
 
   rb_tree.erase(5);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1187,22 +1297,22 @@ TEST(DeleteLeft, TargetNodeAndBrotherAreBlack) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 5), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 5), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(3, 3), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(3, 3), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(4, 4), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(4, 4), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 7), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 7), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(6, 6), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(6, 6), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(8, 8), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(8, 8), node_type::BLACK);
 
   rb_tree.erase(3);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1245,28 +1355,28 @@ TEST(DeleteLeft,
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 10), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 10), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 5), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 5), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 7), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 7), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(15, 15), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(15, 15), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(12, 12), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(12, 12), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(18, 18), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(18, 18), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::BLACK);
 
   rb_tree.erase(5);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1307,46 +1417,46 @@ TEST(DeleteLeft, TargetNodesdBrotherIsBlackAndBrothersRightChildIsRed) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 10), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 10), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(5, 5), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(5, 5), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 7), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 7), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(6, 6), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(6, 6), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(8, 8), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(8, 8), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(15, 15), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(15, 15), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(13, 13), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(13, 13), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(18, 18), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(18, 18), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(40, 40), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(40, 40), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(35, 35), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(35, 35), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(45, 45), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(45, 45), node_type::RED);
 
   rb_tree.erase(5);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1388,34 +1498,34 @@ TEST(DeleteRight, TargetNodesBrotherIsRed) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(50, 50), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(50, 50), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(75, 75), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(75, 75), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(80, 80), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(80, 80), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(15, 15), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(15, 15), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(22, 22), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(22, 22), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(27, 27), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(27, 27), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(35, 35), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(35, 35), node_type::BLACK);
 
   rb_tree.erase(75);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1449,22 +1559,22 @@ TEST(DeleteRight, TargetNodeAndBrotherAreBlack) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(50, 50), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(50, 50), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(75, 75), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(75, 75), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(80, 80), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(80, 80), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 10), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 10), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::BLACK);
 
   rb_tree.erase(75);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1508,28 +1618,28 @@ TEST(DeleteRight,
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(50, 50), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(50, 50), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(60, 60), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(60, 60), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(55, 55), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(55, 55), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(27, 27), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(27, 27), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(40, 40), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(40, 40), node_type::BLACK);
 
   rb_tree.erase(60);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -1571,46 +1681,46 @@ TEST(DeleteRight, TargetNodesdBrotherIsBlackAndBrothersRightChildIsRed) {
   tree_type rb_tree;
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(50, 50), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(50, 50), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(60, 60), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(60, 60), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(55, 55), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(55, 55), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(52, 52), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(52, 52), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(57, 57), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(57, 57), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(25, 25), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(25, 25), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(30, 30), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(30, 30), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(20, 20), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(20, 20), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(10, 10), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(10, 10), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(22, 22), node_type::BLACK);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(22, 22), node_type::BLACK);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(7, 7), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(7, 7), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(12, 12), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(12, 12), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(21, 21), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(21, 21), node_type::RED);
   insertNodeWithoutFixup<key_type, pair_type, ft::Select1st<pair_type>,
                          std::less<key_type> >(
-      &rb_tree.root_, rb_tree.nil_node_, pair_type(23, 23), node_type::RED);
+      &rb_tree.root_, rb_tree.end_node_, pair_type(23, 23), node_type::RED);
 
   rb_tree.erase(60);
   expectRedBlackTreeKeepRules(rb_tree);
@@ -2504,7 +2614,7 @@ TEST(EraseKey, TreeHasTargetKeyNode) {
 
   tree_type::size_type result = rb_tree.erase("A");
   EXPECT_EQ(result, tree_type::size_type(1));
-  EXPECT_EQ(rb_tree.search_key_node("A")->is_nil_node_, true);
+  EXPECT_TRUE(rb_tree.search_key_node("A") == NULL);
 }
 
 TEST(EraseKey, TreeHasNoTargetKeyNode) {
@@ -2524,7 +2634,7 @@ TEST(EraseKey, TreeHasNoTargetKeyNode) {
 
   tree_type::size_type result = rb_tree.erase("B");
   EXPECT_EQ(result, tree_type::size_type(0));
-  EXPECT_EQ(rb_tree.search_key_node("B")->is_nil_node_, true);
+  EXPECT_TRUE(rb_tree.search_key_node("B") == NULL);
 }
 
 TEST(Swap, SwapAndDeleteTheOtherOne) {
@@ -2957,4 +3067,912 @@ TEST(RedBlackTree, InsertManyElements) {
     EXPECT_EQ((*it).first, i);
     EXPECT_EQ((*it).second, i);
   }
-}
\ No newline at end of file
+}
+namespace {
+
+// 比較の回数を数える比較関数
+struct CountingLess {
+  static int count;
+
+  bool operator()(int lhs, int rhs) const {
+    ++count;
+    return lhs < rhs;
+  }
+};
+
+int CountingLess::count = 0;
+
+// 三方比較の回数を数える比較関数
+struct CountingThreeWayLess {
+  static int count;
+
+  bool operator()(int lhs, int rhs) const {
+    return lhs < rhs;
+  }
+};
+
+int CountingThreeWayLess::count = 0;
+
+}  // namespace
+
+namespace ft {
+
+template <>
+struct three_way_compare_traits<CountingThreeWayLess, int> : public true_type {
+  static int compare(const CountingThreeWayLess &comp, int lhs, int rhs) {
+    (void)comp;
+    ++CountingThreeWayLess::count;
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+  }
+};
+
+}  // namespace ft
+
+TEST(SearchKeyNode, ComparesOncePerLevel) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingLess> tree_type;
+
+  tree_type rb_tree;
+  const int max_size = 1000;
+  for (int i = 0; i < max_size; ++i) {
+    rb_tree.insert_unique((i * 7919) % max_size);
+  }
+  const int height = rb_tree.get_height();
+
+  for (int i = -1; i <= max_size; ++i) {
+    CountingLess::count = 0;
+    tree_type::node_type *node = rb_tree.search_key_node(i);
+    EXPECT_TRUE(CountingLess::count <= height + 1);
+    if (0 <= i && i < max_size) {
+      ASSERT_TRUE(node != NULL);
+      EXPECT_EQ(node->value_, i);
+    } else {
+      EXPECT_TRUE(node == NULL);
+    }
+  }
+
+  // 既にあるキーの挿入も各段で1回と最後の1回だけ比較する
+  for (int i = 0; i < max_size; ++i) {
+    CountingLess::count = 0;
+    EXPECT_FALSE(rb_tree.insert_unique(i).second);
+    EXPECT_TRUE(CountingLess::count <= height + 1);
+  }
+  EXPECT_EQ(rb_tree.size(), static_cast<tree_type::size_type>(max_size));
+  expectRedBlackTreeKeepRules(rb_tree);
+}
+
+TEST(SearchKeyNode, UsesThreeWayCompareTraits) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingThreeWayLess>
+      tree_type;
+
+  tree_type rb_tree;
+  const int max_size = 1000;
+  for (int i = 0; i < max_size; ++i) {
+    rb_tree.insert_unique((i * 7919) % max_size);
+  }
+  const int height = rb_tree.get_height();
+
+  for (int i = -1; i <= max_size; ++i) {
+    CountingThreeWayLess::count = 0;
+    tree_type::node_type *node = rb_tree.search_key_node(i);
+    EXPECT_TRUE(CountingThreeWayLess::count <= height);
+    if (0 <= i && i < max_size) {
+      ASSERT_TRUE(node != NULL);
+      EXPECT_EQ(node->value_, i);
+    } else {
+      EXPECT_TRUE(node == NULL);
+    }
+  }
+  for (int i = 0; i < max_size; ++i) {
+    EXPECT_FALSE(rb_tree.insert_unique(i).second);
+  }
+  EXPECT_EQ(rb_tree.size(), static_cast<tree_type::size_type>(max_size));
+  expectRedBlackTreeKeepRules(rb_tree);
+}
+
+// 無いキーの挿入は lower_bound と同じ経路を降りるので,
+// 比較の回数は段数と最後に直前のノードと比べる1回だけになる.
+TEST(InsertUnique, ComparesOncePerLevel) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingLess> tree_type;
+
+  tree_type rb_tree;
+  const int max_size = 1000;
+  for (int i = 0; i < max_size; ++i) {
+    rb_tree.insert_unique((i * 7919) % max_size * 2);
+  }
+
+  // 奇数のキーは必ず直前のノードを持つ
+  for (int i = 0; i < max_size - 1; ++i) {
+    const int key = (i * 7919) % (max_size - 1) * 2 + 1;
+    CountingLess::count = 0;
+    rb_tree.lower_bound(key);
+    const int levels = CountingLess::count;
+    CountingLess::count = 0;
+    EXPECT_TRUE(rb_tree.insert_unique(key).second);
+    EXPECT_EQ(CountingLess::count, levels + 1);
+  }
+  EXPECT_EQ(rb_tree.size(),
+            static_cast<tree_type::size_type>(max_size * 2 - 1));
+  expectRedBlackTreeKeepRules(rb_tree);
+}
+
+TEST(InsertUnique, ComparesOncePerLevelWithThreeWayCompare) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingThreeWayLess>
+      tree_type;
+
+  tree_type rb_tree;
+  const int max_size = 1000;
+  for (int i = 0; i < max_size; ++i) {
+    rb_tree.insert_unique((i * 7919) % max_size * 2);
+  }
+
+  for (int i = 0; i < max_size; ++i) {
+    const int key = (i * 7919) % max_size * 2 + 1;
+    CountingThreeWayLess::count = 0;
+    rb_tree.search_key_node(key);
+    const int levels = CountingThreeWayLess::count;
+    CountingThreeWayLess::count = 0;
+    EXPECT_TRUE(rb_tree.insert_unique(key).second);
+    EXPECT_EQ(CountingThreeWayLess::count, levels);
+  }
+  EXPECT_EQ(rb_tree.size(), static_cast<tree_type::size_type>(max_size * 2));
+  expectRedBlackTreeKeepRules(rb_tree);
+}
+
+TEST(SearchKeyNode, StringKeys) {
+  typedef ft::RedBlackTree<std::string, std::string, ft::Identity<std::string>,
+                           std::greater<std::string> >
+      tree_type;
+
+  tree_type rb_tree;
+  const char *words[] = {"pear", "apple", "fig", "banana", "cherry", "apple"};
+  for (std::size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+    rb_tree.insert_unique(words[i]);
+  }
+  EXPECT_EQ(rb_tree.size(), 5u);
+  EXPECT_EQ(*rb_tree.begin(), "pear");
+  EXPECT_TRUE(rb_tree.search_key_node("fig") != NULL);
+  EXPECT_TRUE(rb_tree.search_key_node("grape") == NULL);
+  EXPECT_TRUE(rb_tree.search_key_node("") == NULL);
+  expectRedBlackTreeKeepRules(rb_tree);
+}
+
+namespace {
+
+// コピーされた回数を数えるキー
+struct CopyCountingKey {
+  static int copy_count;
+  int value_;
+
+  CopyCountingKey(int value = 0) : value_(value) {}
+  CopyCountingKey(const CopyCountingKey &other) : value_(other.value_) {
+    ++copy_count;
+  }
+  CopyCountingKey &operator=(const CopyCountingKey &other) {
+    value_ = other.value_;
+    ++copy_count;
+    return *this;
+  }
+
+  bool operator<(const CopyCountingKey &other) const {
+    return value_ < other.value_;
+  }
+};
+
+int CopyCountingKey::copy_count = 0;
+
+}  // namespace
+
+TEST(RedBlackTree, LookupDoesNotCopyKeys) {
+  typedef ft::pair<const CopyCountingKey, int> pair_type;
+  typedef ft::RedBlackTree<CopyCountingKey, pair_type,
+                           ft::Select1st<pair_type> >
+      tree_type;
+
+  tree_type rb_tree;
+  for (int i = 0; i < 100; ++i) {
+    rb_tree.insert_unique(pair_type(CopyCountingKey(i * 2), i));
+  }
+
+  CopyCountingKey::copy_count = 0;
+  for (int i = -1; i <= 200; ++i) {
+    const CopyCountingKey key(i);
+    rb_tree.search_key_node(key);
+    rb_tree.lower_bound(key);
+    rb_tree.upper_bound(key);
+    rb_tree.equal_range(key);
+    rb_tree.count(key);
+  }
+  EXPECT_EQ(CopyCountingKey::copy_count, 0);
+}
+
+namespace {
+
+template <class Tree>
+void expectEdgeNodesAreCached(const Tree &rb_tree) {
+  if (rb_tree.root_ == NULL) {
+    EXPECT_EQ(rb_tree.begin_node_, rb_tree.end_node_);
+    EXPECT_EQ(rb_tree.rightmost_node_, rb_tree.end_node_);
+  } else {
+    EXPECT_EQ(rb_tree.begin_node_, ft::find_minimum_node(rb_tree.root_));
+    EXPECT_EQ(rb_tree.rightmost_node_, ft::find_maximum_node(rb_tree.root_));
+  }
+}
+
+}  // namespace
+
+TEST(InsertWithHint, AppendAtEndComparesOnce) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingLess> tree_type;
+
+  tree_type rb_tree;
+  for (int i = 0; i < 1000; ++i) {
+    CountingLess::count = 0;
+    tree_type::iterator it = rb_tree.insert_unique(rb_tree.end(), i);
+    // 空の木では比較しない. それ以外は rightmost_node_ との1回だけ
+    EXPECT_EQ(CountingLess::count, i == 0 ? 0 : 1);
+    EXPECT_EQ(*it, i);
+    EXPECT_EQ(rb_tree.rightmost_node_, it.node_);
+  }
+  for (int i = -1; i >= -1000; --i) {
+    CountingLess::count = 0;
+    tree_type::iterator it = rb_tree.insert_unique(rb_tree.begin(), i);
+    EXPECT_EQ(CountingLess::count, 1);
+    EXPECT_EQ(*it, i);
+  }
+  EXPECT_EQ(rb_tree.size(), 2000u);
+  expectRedBlackTreeKeepRules(rb_tree);
+  expectEdgeNodesAreCached(rb_tree);
+}
+
+TEST(InsertWithHint, NextToHintSkipsDescent) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, CountingLess> tree_type;
+
+  tree_type rb_tree;
+  for (int i = 0; i < 1000; ++i) {
+    rb_tree.insert_unique(i * 2);
+  }
+  for (int i = 0; i < 999; ++i) {
+    const int key = (i * 7919) % 999 * 2 + 1;
+    tree_type::iterator hint = rb_tree.upper_bound(key);
+    CountingLess::count = 0;
+    if (i % 2 == 0) {
+      // key < hint と prev < key の2回
+      EXPECT_EQ(*rb_tree.insert_unique(hint, key), key);
+      EXPECT_EQ(CountingLess::count, 2);
+    } else {
+      // key < hint, hint < key, key < next の3回
+      --hint;
+      EXPECT_EQ(*rb_tree.insert_unique(hint, key), key);
+      EXPECT_EQ(CountingLess::count, 3);
+    }
+  }
+  EXPECT_EQ(rb_tree.size(), 1999u);
+  expectRedBlackTreeKeepRules(rb_tree);
+  expectEdgeNodesAreCached(rb_tree);
+}
+
+TEST(InsertWithHint, RandomHintsKeepOrderAndEdges) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int> > tree_type;
+
+  tree_type rb_tree;
+  std::set<int> expected;
+  srand(7);
+  for (int i = 0; i < 5000; ++i) {
+    const int key = rand() % 2000;
+    tree_type::iterator hint = rb_tree.lower_bound(rand() % 2000);
+    if (rand() % 4 == 0) {
+      rb_tree.erase(key);
+      expected.erase(key);
+    } else {
+      tree_type::iterator it = rb_tree.insert_unique(hint, key);
+      EXPECT_EQ(*it, key);
+      expected.insert(key);
+    }
+    expectEdgeNodesAreCached(rb_tree);
+  }
+  ASSERT_EQ(rb_tree.size(), expected.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), rb_tree.begin()));
+  expectRedBlackTreeKeepRules(rb_tree);
+
+  tree_type copy(rb_tree);
+  expectEdgeNodesAreCached(copy);
+  rb_tree.clear();
+  expectEdgeNodesAreCached(rb_tree);
+  rb_tree.swap(copy);
+  expectEdgeNodesAreCached(rb_tree);
+  expectEdgeNodesAreCached(copy);
+}
+
+namespace {
+
+// 中間順のリンクが木の形から求めた前後のノードと一致しているか確かめる.
+template <class Tree>
+void expectThreadsMatchTree(const Tree &rb_tree) {
+  typedef typename Tree::node_type node_type;
+
+  const node_type *end_node = rb_tree.end_node_;
+  const node_type *node = rb_tree.begin_node_;
+  EXPECT_EQ(end_node->next_, node);
+  EXPECT_EQ(end_node->prev_, rb_tree.rightmost_node_);
+  for (; node != end_node; node = node->next_) {
+    EXPECT_EQ(node->next_, ft::get_next_node(node));
+    EXPECT_EQ(node->prev_, ft::get_prev_node(node));
+  }
+}
+
+}  // namespace
+
+TEST(ThreadedNodePolicy, DefaultNodeHasNoExtraLinks) {
+  EXPECT_EQ(sizeof(ft::RBTNode<void *>), 4 * sizeof(void *));
+  EXPECT_EQ(sizeof(ft::RBTNode<void *, ft::rbtree_threaded_node_policy>),
+            6 * sizeof(void *));
+}
+
+TEST(ThreadedNodePolicy, LinksFollowInsertAndErase) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int>,
+                           std::allocator<int>,
+                           ft::rbtree_threaded_node_policy>
+      tree_type;
+
+  tree_type rb_tree;
+  std::set<int> expected;
+  expectThreadsMatchTree(rb_tree);
+  srand(11);
+  for (int i = 0; i < 5000; ++i) {
+    const int key = rand() % 1000;
+    if (rand() % 3 == 0) {
+      EXPECT_EQ(rb_tree.erase(key), expected.erase(key));
+    } else if (rand() % 2 == 0) {
+      rb_tree.insert_unique(rb_tree.lower_bound(rand() % 1000), key);
+      expected.insert(key);
+    } else {
+      rb_tree.insert_unique(key);
+      expected.insert(key);
+    }
+    if (i % 500 == 0) {
+      expectThreadsMatchTree(rb_tree);
+    }
+  }
+  expectThreadsMatchTree(rb_tree);
+  ASSERT_EQ(rb_tree.size(), expected.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), rb_tree.begin()));
+  EXPECT_TRUE(
+      std::equal(expected.rbegin(), expected.rend(), rb_tree.rbegin()));
+
+  rb_tree.erase(rb_tree.begin(), rb_tree.end());
+  EXPECT_TRUE(rb_tree.empty());
+  expectThreadsMatchTree(rb_tree);
+}
+
+TEST(ThreadedNodePolicy, LinksFollowCopySwapAndBuild) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int>,
+                           std::allocator<int>,
+                           ft::rbtree_threaded_node_policy>
+      tree_type;
+
+  std::vector<int> sorted;
+  for (int i = 0; i < 300; ++i) {
+    sorted.push_back(i * 2);
+  }
+  // 昇順の範囲からはまとめて木を組み立てる.
+  tree_type built(sorted.begin(), sorted.end());
+  expectThreadsMatchTree(built);
+  EXPECT_TRUE(std::equal(sorted.begin(), sorted.end(), built.begin()));
+
+  tree_type copy(built);
+  expectThreadsMatchTree(copy);
+  copy.insert_unique(1);
+  expectThreadsMatchTree(copy);
+
+  tree_type other;
+  other.insert_unique(-1);
+  other.swap(copy);
+  expectThreadsMatchTree(copy);
+  expectThreadsMatchTree(other);
+  EXPECT_EQ(*copy.begin(), -1);
+  EXPECT_EQ(*--copy.end(), -1);
+  EXPECT_EQ(*++other.begin(), 1);
+
+  other.clear();
+  expectThreadsMatchTree(other);
+  other.insert_unique(5);
+  expectThreadsMatchTree(other);
+  other = built;
+  expectThreadsMatchTree(other);
+  EXPECT_EQ(other.size(), built.size());
+}
+
+TEST(ThreadedNodePolicy, MapAndSet) {
+  typedef ft::map<int, std::string, std::less<int>,
+                  std::allocator<ft::pair<const int, std::string> >,
+                  ft::rbtree_threaded_node_policy>
+      map_type;
+  typedef ft::set<int, std::less<int>, std::allocator<int>,
+                  ft::rbtree_threaded_node_policy>
+      set_type;
+
+  map_type m;
+  set_type s;
+  std::set<int> expected;
+  srand(3);
+  for (int i = 0; i < 2000; ++i) {
+    const int key = rand() % 500;
+    if (rand() % 3 == 0) {
+      m.erase(key);
+      s.erase(key);
+      expected.erase(key);
+    } else {
+      m[key] = std::string(static_cast<std::size_t>(key % 7), 'x');
+      s.insert(key);
+      expected.insert(key);
+    }
+  }
+  ASSERT_EQ(m.size(), expected.size());
+  ASSERT_EQ(s.size(), expected.size());
+  std::set<int>::reverse_iterator expected_it = expected.rbegin();
+  for (map_type::reverse_iterator it = m.rbegin(); it != m.rend();
+       ++it, ++expected_it) {
+    EXPECT_EQ(it->first, *expected_it);
+  }
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), s.begin()));
+
+  map_type copy(m);
+  EXPECT_TRUE(copy == m);
+  set_type set_copy;
+  set_copy = s;
+  EXPECT_FALSE(set_copy < s);
+}
+
+namespace {
+
+// 各ノードの size_ が部分木のノード数と一致しているか確かめ, ノード数を返す.
+template <class Node>
+std::size_t expectSubtreeSizes(const Node *node) {
+  if (node == NULL) {
+    return 0;
+  }
+  const std::size_t size =
+      1 + expectSubtreeSizes(node->left_) + expectSubtreeSizes(node->right_);
+  EXPECT_EQ(node->size_, size);
+  return size;
+}
+
+template <class Tree>
+void expectOrderStatistics(const Tree &rb_tree, const std::set<int> &expected) {
+  using std::distance;
+
+  ASSERT_EQ(expectSubtreeSizes(rb_tree.root_), expected.size());
+  std::size_t index = 0;
+  for (std::set<int>::const_iterator it = expected.begin();
+       it != expected.end(); ++it, ++index) {
+    typename Tree::const_iterator found = rb_tree.nth(index);
+    EXPECT_EQ(*found, *it);
+    EXPECT_EQ(rb_tree.index_of(found), index);
+    EXPECT_EQ(rb_tree.rank(*it), index);
+    EXPECT_EQ(distance(rb_tree.begin(), found),
+              static_cast<std::ptrdiff_t>(index));
+  }
+  EXPECT_TRUE(rb_tree.nth(expected.size()) == rb_tree.end());
+  EXPECT_EQ(rb_tree.index_of(rb_tree.end()), expected.size());
+  EXPECT_EQ(distance(rb_tree.end(), rb_tree.begin()),
+            -static_cast<std::ptrdiff_t>(expected.size()));
+}
+
+}  // namespace
+
+TEST(OrderStatisticNodePolicy, SizesFollowInsertAndErase) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int>,
+                           std::allocator<int>,
+                           ft::rbtree_order_statistic_node_policy<> >
+      tree_type;
+
+  tree_type rb_tree;
+  std::set<int> expected;
+  srand(5);
+  for (int i = 0; i < 3000; ++i) {
+    const int key = rand() % 1000;
+    if (rand() % 3 == 0) {
+      EXPECT_EQ(rb_tree.erase(key), expected.erase(key));
+    } else if (rand() % 2 == 0) {
+      rb_tree.insert_unique(rb_tree.lower_bound(rand() % 1000), key);
+      expected.insert(key);
+    } else {
+      rb_tree.insert_unique(key);
+      expected.insert(key);
+    }
+    if (i % 300 == 0) {
+      expectOrderStatistics(rb_tree, expected);
+    }
+  }
+  expectOrderStatistics(rb_tree, expected);
+
+  for (int lo = -10; lo < 1010; lo += 37) {
+    for (int hi = lo - 50; hi < 1010; hi += 101) {
+      const std::size_t count =
+          lo < hi ? std::distance(expected.lower_bound(lo),
+                                  expected.lower_bound(hi))
+                  : 0;
+      EXPECT_EQ(rb_tree.count_range(lo, hi), count);
+    }
+  }
+}
+
+TEST(OrderStatisticNodePolicy, CombinesWithThreadedLinks) {
+  typedef ft::RedBlackTree<
+      int, int, ft::Identity<int>, std::less<int>, std::allocator<int>,
+      ft::rbtree_order_statistic_node_policy<ft::rbtree_threaded_node_policy> >
+      tree_type;
+
+  std::vector<int> sorted;
+  std::set<int> expected;
+  for (int i = 0; i < 500; ++i) {
+    sorted.push_back(i * 3);
+    expected.insert(i * 3);
+  }
+  tree_type built(sorted.begin(), sorted.end());
+  expectOrderStatistics(built, expected);
+  expectThreadsMatchTree(built);
+
+  tree_type copy(built);
+  for (int i = 0; i < 500; i += 2) {
+    copy.erase(i * 3);
+    expected.erase(i * 3);
+    copy.insert_unique(i * 3 + 1);
+    expected.insert(i * 3 + 1);
+  }
+  expectOrderStatistics(copy, expected);
+  expectThreadsMatchTree(copy);
+
+  tree_type other;
+  other.swap(copy);
+  expectOrderStatistics(other, expected);
+  EXPECT_EQ(copy.index_of(copy.end()), 0u);
+  EXPECT_EQ(sizeof(tree_type::node_type), 7 * sizeof(void *));
+}
+
+namespace {
+
+std::set<int> makeRandomKeys(std::size_t count, int range) {
+  std::set<int> keys;
+  while (keys.size() < count) {
+    keys.insert(rand() % range);
+  }
+  return keys;
+}
+
+template <class Tree>
+void expectTreeHasKeys(Tree &rb_tree, const std::set<int> &expected) {
+  ASSERT_EQ(rb_tree.size(), expected.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), rb_tree.begin()));
+  expectEdgeNodesAreCached(rb_tree);
+  if (rb_tree.root_ == NULL) {
+    EXPECT_EQ(rb_tree.end_node_->left_, rb_tree.root_);
+  } else {
+    expectRedBlackTreeKeepRules(rb_tree);
+  }
+}
+
+}  // namespace
+
+TEST(SetOperations, MatchStdAlgorithms) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int> >
+      tree_type;
+
+  // 要素数の偏りが大きい組と, 同じくらいの組の両方を試す.
+  const std::size_t sizes[][2] = {{0, 0},   {0, 50},    {50, 0},
+                                  {1, 1},   {1, 1000},  {1000, 1},
+                                  {3, 800}, {800, 800}, {500, 30}};
+  srand(18);
+  for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+    const std::set<int> keys1 = makeRandomKeys(sizes[i][0], 2000);
+    const std::set<int> keys2 = makeRandomKeys(sizes[i][1], 2000);
+
+    std::set<int> expected;
+    std::set_union(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                   std::inserter(expected, expected.end()));
+    tree_type united(keys1.begin(), keys1.end());
+    tree_type other(keys2.begin(), keys2.end());
+    united.union_unique(other);
+    expectTreeHasKeys(united, expected);
+    expectTreeHasKeys(other, std::set<int>());
+    // 空になった木にもそのまま挿入できる.
+    other.insert_unique(1);
+    EXPECT_EQ(*other.begin(), 1);
+
+    expected.clear();
+    std::set_intersection(keys1.begin(), keys1.end(), keys2.begin(),
+                          keys2.end(), std::inserter(expected, expected.end()));
+    tree_type intersected(keys1.begin(), keys1.end());
+    intersected.intersect_unique(tree_type(keys2.begin(), keys2.end()));
+    expectTreeHasKeys(intersected, expected);
+
+    expected.clear();
+    std::set_difference(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                        std::inserter(expected, expected.end()));
+    tree_type subtracted(keys1.begin(), keys1.end());
+    subtracted.subtract_unique(tree_type(keys2.begin(), keys2.end()));
+    expectTreeHasKeys(subtracted, expected);
+  }
+}
+
+TEST(SetOperations, TreesBuiltByInsertAndErase) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int> >
+      tree_type;
+
+  // 挿入と削除で作った, 赤いノードを多く含む木でも黒高さを正しく扱う.
+  srand(81);
+  for (int round = 0; round < 20; ++round) {
+    tree_type tree1;
+    tree_type tree2;
+    std::set<int> keys1;
+    std::set<int> keys2;
+    const int range = 100 + round * 50;
+    for (int i = 0; i < range; ++i) {
+      const int key = rand() % range;
+      if (rand() % 4 == 0) {
+        tree1.erase(key);
+        keys1.erase(key);
+      } else {
+        tree1.insert_unique(key);
+        keys1.insert(key);
+      }
+      if (rand() % (round % 5 + 1) == 0) {
+        tree2.insert_unique(key + 1);
+        keys2.insert(key + 1);
+      }
+    }
+    tree_type copy1(tree1);
+    tree_type copy2(tree2);
+
+    std::set<int> expected;
+    std::set_intersection(keys1.begin(), keys1.end(), keys2.begin(),
+                          keys2.end(), std::inserter(expected, expected.end()));
+    copy1.intersect_unique(tree2);
+    expectTreeHasKeys(copy1, expected);
+
+    expected.clear();
+    std::set_difference(keys2.begin(), keys2.end(), keys1.begin(), keys1.end(),
+                        std::inserter(expected, expected.end()));
+    copy2.subtract_unique(tree1);
+    expectTreeHasKeys(copy2, expected);
+
+    expected.clear();
+    std::set_union(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                   std::inserter(expected, expected.end()));
+    tree1.union_unique(tree2);
+    expectTreeHasKeys(tree1, expected);
+    tree1.subtract_unique(tree1);
+    expectTreeHasKeys(tree1, std::set<int>());
+  }
+}
+
+TEST(SetOperations, KeepNodePolicyLinks) {
+  typedef ft::RedBlackTree<
+      int, int, ft::Identity<int>, std::less<int>, std::allocator<int>,
+      ft::rbtree_order_statistic_node_policy<ft::rbtree_threaded_node_policy> >
+      tree_type;
+
+  srand(7);
+  const std::set<int> keys1 = makeRandomKeys(600, 3000);
+  const std::set<int> keys2 = makeRandomKeys(40, 3000);
+
+  std::set<int> expected;
+  std::set_union(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                 std::inserter(expected, expected.end()));
+  tree_type united(keys1.begin(), keys1.end());
+  tree_type other(keys2.begin(), keys2.end());
+  united.union_unique(other);
+  expectOrderStatistics(united, expected);
+  expectThreadsMatchTree(united);
+  expectThreadsMatchTree(other);
+
+  expected.clear();
+  std::set_intersection(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                        std::inserter(expected, expected.end()));
+  tree_type intersected(keys2.begin(), keys2.end());
+  intersected.intersect_unique(tree_type(keys1.begin(), keys1.end()));
+  expectOrderStatistics(intersected, expected);
+  expectThreadsMatchTree(intersected);
+
+  expected.clear();
+  std::set_difference(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                      std::inserter(expected, expected.end()));
+  tree_type subtracted(keys1.begin(), keys1.end());
+  subtracted.subtract_unique(tree_type(keys2.begin(), keys2.end()));
+  expectOrderStatistics(subtracted, expected);
+  expectThreadsMatchTree(subtracted);
+}
+
+TEST(ParallelSetOperations, MatchStdAlgorithms) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int> >
+      tree_type;
+
+  // grain_size を小さくして, 細かく分けた場合も試す.
+  const ft::fork_join_executor fine_executor(4, 1);
+  const ft::fork_join_executor coarse_executor(3, 16);
+  const ft::fork_join_executor *executors[] = {&fine_executor,
+                                               &coarse_executor};
+  const std::size_t sizes[][2] = {{3000, 2000}, {5000, 50}, {40, 4000}};
+  srand(19);
+  for (std::size_t e = 0; e < 2; ++e) {
+    for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+      const std::set<int> keys1 = makeRandomKeys(sizes[i][0], 10000);
+      const std::set<int> keys2 = makeRandomKeys(sizes[i][1], 10000);
+
+      std::set<int> expected;
+      std::set_union(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+                     std::inserter(expected, expected.end()));
+      tree_type united(keys1.begin(), keys1.end());
+      tree_type other(keys2.begin(), keys2.end());
+      united.union_unique(other, *executors[e]);
+      expectTreeHasKeys(united, expected);
+      expectTreeHasKeys(other, std::set<int>());
+
+      expected.clear();
+      std::set_intersection(keys1.begin(), keys1.end(), keys2.begin(),
+                            keys2.end(),
+                            std::inserter(expected, expected.end()));
+      tree_type intersected(keys1.begin(), keys1.end());
+      intersected.intersect_unique(tree_type(keys2.begin(), keys2.end()),
+                                   *executors[e]);
+      expectTreeHasKeys(intersected, expected);
+
+      expected.clear();
+      std::set_difference(keys1.begin(), keys1.end(), keys2.begin(),
+                          keys2.end(), std::inserter(expected, expected.end()));
+      tree_type subtracted(keys1.begin(), keys1.end());
+      subtracted.subtract_unique(tree_type(keys2.begin(), keys2.end()),
+                                 *executors[e]);
+      expectTreeHasKeys(subtracted, expected);
+    }
+  }
+}
+
+TEST(ParallelSetOperations, InsertRangeAndNodePolicies) {
+  typedef ft::RedBlackTree<
+      int, int, ft::Identity<int>, std::less<int>, std::allocator<int>,
+      ft::rbtree_order_statistic_node_policy<ft::rbtree_threaded_node_policy> >
+      tree_type;
+
+  const ft::fork_join_executor executor(4, 1);
+  srand(91);
+  std::vector<int> values;
+  std::set<int> expected;
+  tree_type rb_tree;
+  for (int i = 0; i < 2000; ++i) {
+    const int key = rand() % 5000;
+    rb_tree.insert_unique(key);
+    expected.insert(key);
+    values.push_back(rand() % 5000);
+  }
+  // 整列していない範囲も, 重複を含む範囲もそのまま渡せる.
+  rb_tree.insert_range_unique(values.begin(), values.end(), executor);
+  expected.insert(values.begin(), values.end());
+  expectOrderStatistics(rb_tree, expected);
+  expectThreadsMatchTree(rb_tree);
+
+  const tree_type other(values.begin(), values.begin() + 1000);
+  rb_tree.subtract_unique(other, executor);
+  for (std::vector<int>::iterator it = values.begin();
+       it != values.begin() + 1000; ++it) {
+    expected.erase(*it);
+  }
+  expectOrderStatistics(rb_tree, expected);
+  expectThreadsMatchTree(rb_tree);
+}
+
+namespace {
+
+// 指定回数を超えてコピーされると例外を投げるキー.
+struct ThrowingCopyKey {
+  static int copies_left;
+  int value;
+
+  ThrowingCopyKey(int v = 0) : value(v) {}
+
+  ThrowingCopyKey(const ThrowingCopyKey &other) : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("ThrowingCopyKey");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+  }
+
+  bool operator<(const ThrowingCopyKey &other) const {
+    return value < other.value;
+  }
+};
+
+int ThrowingCopyKey::copies_left = -1;
+
+template <class Tree>
+std::set<const void *> collectValueAddresses(const Tree &rb_tree) {
+  std::set<const void *> addresses;
+  for (typename Tree::const_iterator it = rb_tree.begin(); it != rb_tree.end();
+       ++it) {
+    addresses.insert(&*it);
+  }
+  return addresses;
+}
+
+}  // namespace
+
+TEST(CopyTree, AssignmentReusesNodes) {
+  typedef ft::RedBlackTree<int, int, ft::Identity<int>, std::less<int> >
+      tree_type;
+
+  std::set<int> keys;
+  tree_type rb_tree;
+  tree_type other;
+  for (int i = 0; i < 500; ++i) {
+    rb_tree.insert_unique(i * 2);
+    other.insert_unique(i * 3 + 1);
+    keys.insert(i * 3 + 1);
+  }
+  const std::set<const void *> addresses = collectValueAddresses(rb_tree);
+  rb_tree = other;
+  EXPECT_TRUE(collectValueAddresses(rb_tree) == addresses);
+  expectTreeHasKeys(rb_tree, keys);
+
+  // 足りない分は新しく確保し, 余った分は解放する.
+  for (int i = 0; i < 100; ++i) {
+    other.insert_unique(i * 3 + 2);
+    keys.insert(i * 3 + 2);
+  }
+  rb_tree = other;
+  expectTreeHasKeys(rb_tree, keys);
+  const tree_type small(keys.begin(), keys.find(31));
+  rb_tree = small;
+  expectTreeHasKeys(rb_tree, std::set<int>(keys.begin(), keys.find(31)));
+  rb_tree = tree_type();
+  expectTreeHasKeys(rb_tree, std::set<int>());
+}
+
+TEST(CopyTree, ThrowingCopyLeavesEmptyTree) {
+  typedef ft::RedBlackTree<ThrowingCopyKey, ThrowingCopyKey,
+                           ft::Identity<ThrowingCopyKey>,
+                           std::less<ThrowingCopyKey> >
+      tree_type;
+
+  ThrowingCopyKey::copies_left = -1;
+  tree_type rb_tree;
+  tree_type other;
+  for (int i = 0; i < 100; ++i) {
+    rb_tree.insert_unique(ThrowingCopyKey(i));
+    other.insert_unique(ThrowingCopyKey(i + 1000));
+  }
+
+  ThrowingCopyKey::copies_left = 50;
+  EXPECT_THROW(rb_tree = other, std::runtime_error);
+  ThrowingCopyKey::copies_left = -1;
+  EXPECT_EQ(rb_tree.size(), 0u);
+  EXPECT_TRUE(rb_tree.begin() == rb_tree.end());
+  rb_tree.insert_unique(ThrowingCopyKey(7));
+  EXPECT_EQ(rb_tree.begin()->value, 7);
+
+  ThrowingCopyKey::copies_left = 30;
+  EXPECT_THROW(tree_type copy(other), std::runtime_error);
+  ThrowingCopyKey::copies_left = -1;
+  EXPECT_EQ(other.size(), 100u);
+}
+
+TEST(CopyTree, AssignmentKeepsNodePolicyLinks) {
+  typedef ft::RedBlackTree<
+      int, int, ft::Identity<int>, std::less<int>, std::allocator<int>,
+      ft::rbtree_order_statistic_node_policy<ft::rbtree_threaded_node_policy> >
+      tree_type;
+
+  std::set<int> keys;
+  tree_type rb_tree;
+  tree_type other;
+  srand(20);
+  for (int i = 0; i < 800; ++i) {
+    rb_tree.insert_unique(rand() % 2000);
+    const int key = rand() % 2000;
+    other.insert_unique(key);
+    keys.insert(key);
+  }
+  rb_tree = other;
+  expectOrderStatistics(rb_tree, keys);
+  expectThreadsMatchTree(rb_tree);
+}
@@ -8,10 +8,13 @@
 #include <iostream>
 #include <iterator>
 #include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
+#include "node_pool_allocator.hpp"
 #include "pair.hpp"
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -609,4 +612,223 @@ TEST(Set, MyOriginalClass) {
   EXPECT_TRUE(students.find(bob) == students.end());
   EXPECT_TRUE(students.find(chris) == students.end());
   EXPECT_TRUE(students.find(pika) != students.end());
-}
\ No newline at end of file
+}
+namespace {
+
+// Student を id で比較する. id だけでも探索出来る.
+struct StudentIdLess {
+  typedef void is_transparent;
+
+  bool operator()(const ft::test::Student &lhs,
+                  const ft::test::Student &rhs) const {
+    return lhs.id_ < rhs.id_;
+  }
+  bool operator()(const ft::test::Student &lhs, uint64_t rhs) const {
+    return lhs.id_ < rhs;
+  }
+  bool operator()(uint64_t lhs, const ft::test::Student &rhs) const {
+    return lhs < rhs.id_;
+  }
+};
+
+}  // namespace
+
+TEST(SetTransparent, LookupById) {
+  typedef ft::set<ft::test::Student, StudentIdLess> set_type;
+  set_type s;
+  const ft::test::Student alice("alice", 20);
+  const ft::test::Student bob("bob", 21);
+  s.insert(alice);
+  s.insert(bob);
+  const set_type &const_s = s;
+
+  EXPECT_EQ(s.find(alice.id_)->name_, "alice");
+  EXPECT_EQ(const_s.find(bob.id_)->name_, "bob");
+  EXPECT_TRUE(s.find(ft::test::generate_hash("carol")) == s.end());
+  EXPECT_EQ(s.count(bob.id_), 1u);
+  EXPECT_TRUE(s.lower_bound(alice.id_) == s.find(alice));
+  EXPECT_TRUE(const_s.upper_bound(alice.id_) == const_s.upper_bound(alice));
+  ft::pair<set_type::iterator, set_type::iterator> range =
+      s.equal_range(bob.id_);
+  EXPECT_EQ(range.first->name_, "bob");
+  EXPECT_TRUE(range.second == s.upper_bound(bob));
+}
+
+TEST(SetTransparent, LessVoid) {
+  typedef ft::set<std::string, ft::less<> > set_type;
+  set_type s;
+  s.insert("b");
+  s.insert("a");
+  s.insert("c");
+
+  EXPECT_EQ(*s.begin(), "a");
+  EXPECT_EQ(*s.find("b"), "b");
+  EXPECT_EQ(s.count("d"), 0u);
+  EXPECT_EQ(*s.upper_bound("a"), "b");
+  EXPECT_TRUE(s.lower_bound("d") == s.end());
+}
+
+TEST(SetOrderStatistic, NthRankAndCountRange) {
+  typedef ft::set<int, std::less<int>, std::allocator<int>,
+                  ft::rbtree_order_statistic_node_policy<> >
+      set_type;
+  set_type s;
+  for (int i = 0; i < 100; ++i) {
+    s.insert(i * 10);
+  }
+
+  EXPECT_EQ(*s.nth(42), 420);
+  EXPECT_EQ(s.rank(420), 42u);
+  EXPECT_EQ(s.rank(425), 43u);
+  EXPECT_EQ(s.count_range(100, 200), 10u);
+  EXPECT_EQ(s.count_range(105, 106), 0u);
+  EXPECT_EQ(s.index_of(s.end()), 100u);
+
+  s.erase(s.begin(), s.nth(50));
+  EXPECT_EQ(*s.nth(0), 500);
+  EXPECT_EQ(s.rank(1000), 50u);
+}
+
+TEST(SetOperations, UniteIntersectSubtract) {
+  typedef ft::set<int> set_type;
+  set_type s;
+  set_type other;
+  for (int i = 0; i < 100; ++i) {
+    s.insert(i * 2);
+    other.insert(i * 3);
+  }
+
+  set_type united(s);
+  set_type moved(other);
+  united.unite(moved);
+  EXPECT_EQ(united.size(), 166u);
+  EXPECT_TRUE(moved.empty());
+  EXPECT_TRUE(moved.begin() == moved.end());
+
+  set_type intersected(s);
+  intersected.intersect(other);
+  EXPECT_EQ(intersected.size(), 34u);
+  for (set_type::iterator it = intersected.begin(); it != intersected.end();
+       ++it) {
+    EXPECT_EQ(*it % 6, 0);
+  }
+
+  set_type subtracted(s);
+  subtracted.subtract(other);
+  EXPECT_EQ(subtracted.size(), 66u);
+  EXPECT_EQ(subtracted.count(6), 0u);
+  EXPECT_EQ(subtracted.count(4), 1u);
+  EXPECT_EQ(*subtracted.rbegin(), 196);
+
+  set_type empty;
+  subtracted.intersect(empty);
+  EXPECT_TRUE(subtracted.empty());
+}
+
+TEST(SetOperations, DifferentAllocatorsFallBackToCopy) {
+  typedef ft::set<int, std::less<int>, ft::node_pool_allocator<int> > set_type;
+  set_type s;
+  set_type other;
+  for (int i = 0; i < 50; ++i) {
+    s.insert(i);
+    other.insert(i + 25);
+  }
+
+  // プールが別なのでノードは付け替えずにコピーする.
+  s.unite(other);
+  EXPECT_EQ(s.size(), 75u);
+  EXPECT_EQ(*s.rbegin(), 74);
+  EXPECT_TRUE(other.empty());
+  other.insert(3);
+  EXPECT_EQ(other.size(), 1u);
+}
+
+TEST(SetOperations, ParallelWithExecutor) {
+  typedef ft::set<int> set_type;
+  const ft::fork_join_executor executor(4, 8);
+  std::vector<int> values;
+  for (int i = 0; i < 3000; ++i) {
+    values.push_back((i * 7919) % 3000);
+  }
+
+  set_type s;
+  s.insert(values.begin(), values.end(), executor);
+  EXPECT_EQ(s.size(), 3000u);
+  EXPECT_EQ(*s.begin(), 0);
+  EXPECT_EQ(*s.rbegin(), 2999);
+
+  set_type odd;
+  for (int i = 1; i < 6000; i += 2) {
+    odd.insert(i);
+  }
+  set_type intersected(s);
+  intersected.intersect(odd, executor);
+  EXPECT_EQ(intersected.size(), 1500u);
+  s.subtract(odd, executor);
+  EXPECT_EQ(s.size(), 1500u);
+  EXPECT_EQ(*s.rbegin(), 2998);
+  s.unite(odd, executor);
+  EXPECT_EQ(s.size(), 4500u);
+  EXPECT_TRUE(odd.empty());
+}
+
+TEST(SetBatchedLookup, MatchesSingleLookups) {
+  typedef ft::set<std::string> set_type;
+  set_type s;
+  std::vector<std::string> keys;
+  for (int i = 0; i < 300; ++i) {
+    std::ostringstream oss;
+    oss << i;
+    keys.push_back(oss.str());
+    if (i % 3 == 0) {
+      s.insert(oss.str());
+    }
+  }
+
+  std::vector<set_type::iterator> found;
+  std::vector<set_type::iterator> lower;
+  s.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+  s.lower_bound_many(keys.begin(), keys.end(), std::back_inserter(lower));
+  EXPECT_EQ(found.size(), keys.size());
+  EXPECT_EQ(lower.size(), keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(found[i] == s.find(keys[i]));
+    EXPECT_TRUE(lower[i] == s.lower_bound(keys[i]));
+  }
+}
+
+#if __cplusplus >= 201103L
+TEST(SetMove, MoveIsNoexcept) {
+  EXPECT_TRUE(std::is_nothrow_move_constructible<ft::set<std::string> >::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<ft::set<std::string> >::value);
+}
+
+TEST(SetMove, MoveConstructorAndAssignment) {
+  ft::set<std::string> src;
+  src.insert("a");
+  src.insert("b");
+  ft::set<std::string>::iterator it = src.find("b");
+
+  ft::set<std::string> dst(std::move(src));
+  EXPECT_EQ(dst.size(), 2u);
+  EXPECT_TRUE(src.empty());
+  EXPECT_TRUE(it == dst.find("b"));
+
+  src.insert("c");
+  dst = std::move(src);
+  EXPECT_EQ(dst.size(), 1u);
+  EXPECT_EQ(*dst.begin(), "c");
+}
+
+TEST(SetMove, InsertRvalueAndEmplace) {
+  ft::set<std::string> s;
+  std::string value(100, 'x');
+
+  EXPECT_TRUE(s.insert(std::move(value)).second);
+  EXPECT_FALSE(s.emplace(100, 'x').second);
+  EXPECT_TRUE(s.emplace(3, 'a').second);
+  EXPECT_EQ(*s.emplace_hint(s.begin(), "0"), "0");
+  EXPECT_EQ(s.size(), 3u);
+  EXPECT_EQ(*s.begin(), "0");
+}
+#endif
@@ -0,0 +1,365 @@
+#include "small_vector.hpp"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
+#include <gtest/gtest.h>
+#else
+#include "testlib/testlib.hpp"
+#endif
+#include "utils/my_allocator.hpp"
+
+namespace {
+
+template <class SmallVector>
+void expect_sequence(const SmallVector& vec, int first, int count) {
+  ASSERT_EQ(vec.size(), static_cast<std::size_t>(count));
+  for (int i = 0; i < count; ++i) {
+    EXPECT_EQ(vec[i], first + i);
+  }
+}
+
+// 生きているオブジェクトの数を数え, 指定回数コピーすると例外を投げる型
+struct SmallVectorLiveCounter {
+  static int live;
+  static int copies_left;
+  int value;
+
+  SmallVectorLiveCounter(int v = 0) : value(v) {
+    ++live;
+  }
+
+  SmallVectorLiveCounter(const SmallVectorLiveCounter& other)
+      : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("SmallVectorLiveCounter");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+    ++live;
+  }
+
+  SmallVectorLiveCounter& operator=(const SmallVectorLiveCounter& other) {
+    value = other.value;
+    return *this;
+  }
+
+  ~SmallVectorLiveCounter() {
+    --live;
+  }
+};
+
+int SmallVectorLiveCounter::live = 0;
+int SmallVectorLiveCounter::copies_left = -1;
+
+// 確保した id ごとに解放されていない領域の数を数えるアロケータ.
+// id が異なるアロケータは等しくないので, 別の id で解放すると数が合わなくなる.
+template <class T>
+struct SmallVectorTaggedAllocator : public std::allocator<T> {
+  static int outstanding[2];
+  int id;
+
+  template <class U>
+  struct rebind {
+    typedef SmallVectorTaggedAllocator<U> other;
+  };
+
+  explicit SmallVectorTaggedAllocator(int i = 0) : id(i) {}
+
+  template <class U>
+  SmallVectorTaggedAllocator(const SmallVectorTaggedAllocator<U>& other)
+      : std::allocator<T>(), id(other.id) {}
+
+  T* allocate(std::size_t n) {
+    ++outstanding[id];
+    return std::allocator<T>::allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    --outstanding[id];
+    std::allocator<T>::deallocate(p, n);
+  }
+};
+
+template <class T>
+int SmallVectorTaggedAllocator<T>::outstanding[2] = {0, 0};
+
+}  // namespace
+
+TEST(SmallVector, DefaultConstructorUsesInlineStorage) {
+  ft::small_vector<int, 8> vec;
+
+  EXPECT_TRUE(vec.empty());
+  EXPECT_EQ(vec.size(), 0u);
+  EXPECT_EQ(vec.capacity(), 8u);
+  EXPECT_TRUE(vec.is_inline());
+}
+
+TEST(SmallVector, PushBackWithinInlineCapacity) {
+  ft::small_vector<int, 8> vec;
+
+  for (int i = 0; i < 8; ++i) {
+    vec.push_back(i);
+  }
+  EXPECT_TRUE(vec.is_inline());
+  EXPECT_EQ(vec.capacity(), 8u);
+  expect_sequence(vec, 0, 8);
+}
+
+TEST(SmallVector, PushBackSpillsToHeap) {
+  ft::small_vector<int, 8> vec;
+
+  for (int i = 0; i < 100; ++i) {
+    vec.push_back(i);
+  }
+  EXPECT_FALSE(vec.is_inline());
+  EXPECT_TRUE(vec.capacity() >= 100u);
+  expect_sequence(vec, 0, 100);
+}
+
+TEST(SmallVector, PushBackElementOfItselfWhenFull) {
+  ft::small_vector<std::string, 2> vec;
+
+  vec.push_back("first");
+  vec.push_back(vec[0]);
+  vec.push_back(vec[1]);
+  EXPECT_EQ(vec.size(), 3u);
+  EXPECT_EQ(vec[2], "first");
+}
+
+TEST(SmallVector, SizeConstructorAndRangeConstructor) {
+  ft::small_vector<std::string, 4> small(3, "abc");
+  EXPECT_TRUE(small.is_inline());
+  EXPECT_EQ(small.size(), 3u);
+  EXPECT_EQ(small[2], "abc");
+
+  std::vector<int> src;
+  for (int i = 0; i < 10; ++i) {
+    src.push_back(i);
+  }
+  ft::small_vector<int, 4> large(src.begin(), src.end());
+  EXPECT_FALSE(large.is_inline());
+  expect_sequence(large, 0, 10);
+}
+
+TEST(SmallVector, InsertAndEraseInline) {
+  ft::small_vector<std::string, 8> vec;
+  vec.push_back("a");
+  vec.push_back("d");
+
+  vec.insert(vec.begin() + 1, "c");
+  vec.insert(vec.begin() + 1, "b");
+  vec.insert(vec.end(), 2, "e");
+  EXPECT_TRUE(vec.is_inline());
+  ASSERT_EQ(vec.size(), 6u);
+  EXPECT_EQ(vec[0], "a");
+  EXPECT_EQ(vec[1], "b");
+  EXPECT_EQ(vec[2], "c");
+  EXPECT_EQ(vec[3], "d");
+  EXPECT_EQ(vec[5], "e");
+
+  vec.erase(vec.begin());
+  vec.erase(vec.begin() + 2, vec.end());
+  ASSERT_EQ(vec.size(), 2u);
+  EXPECT_EQ(vec[0], "b");
+  EXPECT_EQ(vec[1], "c");
+}
+
+TEST(SmallVector, InsertRangeSpillsToHeap) {
+  ft::small_vector<int, 4> vec;
+  vec.push_back(0);
+  vec.push_back(9);
+  std::vector<int> src;
+  for (int i = 1; i < 9; ++i) {
+    src.push_back(i);
+  }
+
+  vec.insert(vec.begin() + 1, src.begin(), src.end());
+  EXPECT_FALSE(vec.is_inline());
+  expect_sequence(vec, 0, 10);
+
+  vec.insert(vec.begin() + 5, 20, vec[0]);
+  EXPECT_EQ(vec.size(), 30u);
+  EXPECT_EQ(vec[4], 4);
+  EXPECT_EQ(vec[5], 0);
+  EXPECT_EQ(vec[24], 0);
+  EXPECT_EQ(vec[25], 5);
+}
+
+TEST(SmallVector, ResizeAndClear) {
+  ft::small_vector<int, 4> vec;
+
+  vec.resize(3, 7);
+  EXPECT_TRUE(vec.is_inline());
+  EXPECT_EQ(vec[2], 7);
+  vec.resize(10);
+  EXPECT_FALSE(vec.is_inline());
+  EXPECT_EQ(vec[9], 0);
+  vec.resize(2);
+  EXPECT_EQ(vec.size(), 2u);
+  vec.clear();
+  EXPECT_TRUE(vec.empty());
+}
+
+TEST(SmallVector, CopyAndAssign) {
+  ft::small_vector<std::string, 4> inline_vec(2, "inline");
+  ft::small_vector<std::string, 4> heap_vec(10, "heap");
+
+  ft::small_vector<std::string, 4> copy_inline(inline_vec);
+  ft::small_vector<std::string, 4> copy_heap(heap_vec);
+  EXPECT_TRUE(copy_inline.is_inline());
+  EXPECT_TRUE(copy_inline == inline_vec);
+  EXPECT_FALSE(copy_heap.is_inline());
+  EXPECT_TRUE(copy_heap == heap_vec);
+
+  copy_inline = heap_vec;
+  EXPECT_TRUE(copy_inline == heap_vec);
+  copy_heap = inline_vec;
+  EXPECT_TRUE(copy_heap == inline_vec);
+
+  copy_heap.assign(3, "assigned");
+  EXPECT_EQ(copy_heap.size(), 3u);
+  EXPECT_EQ(copy_heap[2], "assigned");
+}
+
+TEST(SmallVector, Swap) {
+  ft::small_vector<int, 4> inline_vec(2, 1);
+  ft::small_vector<int, 4> heap_vec(10, 2);
+  ft::small_vector<int, 4> other_heap_vec(20, 3);
+  const int* heap_data = heap_vec.data();
+
+  heap_vec.swap(other_heap_vec);
+  EXPECT_EQ(other_heap_vec.data(), heap_data);
+  EXPECT_EQ(heap_vec.size(), 20u);
+
+  inline_vec.swap(heap_vec);
+  EXPECT_EQ(inline_vec.size(), 20u);
+  EXPECT_EQ(inline_vec[19], 3);
+  EXPECT_EQ(heap_vec.size(), 2u);
+  EXPECT_EQ(heap_vec[1], 1);
+}
+
+TEST(SmallVector, IteratorsAndAccess) {
+  ft::small_vector<int, 4> vec;
+  for (int i = 0; i < 6; ++i) {
+    vec.push_back(i);
+  }
+
+  int expected = 0;
+  for (ft::small_vector<int, 4>::const_iterator it = vec.begin();
+       it != vec.end(); ++it) {
+    EXPECT_EQ(*it, expected++);
+  }
+  expected = 5;
+  for (ft::small_vector<int, 4>::reverse_iterator it = vec.rbegin();
+       it != vec.rend(); ++it) {
+    EXPECT_EQ(*it, expected--);
+  }
+  EXPECT_EQ(vec.front(), 0);
+  EXPECT_EQ(vec.back(), 5);
+  EXPECT_EQ(vec.at(3), 3);
+  EXPECT_THROW(vec.at(6), std::out_of_range);
+  vec.pop_back();
+  EXPECT_EQ(vec.back(), 4);
+}
+
+TEST(SmallVector, ComparisonOperators) {
+  ft::small_vector<int, 4> a(3, 1);
+  ft::small_vector<int, 4> b(3, 1);
+  ft::small_vector<int, 4> c(5, 1);
+
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != b);
+  EXPECT_TRUE(a < c);
+  EXPECT_TRUE(a <= c);
+  EXPECT_TRUE(c > a);
+  EXPECT_TRUE(c >= a);
+}
+
+TEST(SmallVector, AllocatorIsUsedOnlyAfterSpill) {
+  typedef ft::test::MyAllocator<int> allocator_type;
+  ft::small_vector<int, 4, allocator_type> vec;
+
+  for (int i = 0; i < 50; ++i) {
+    vec.push_back(i);
+  }
+  EXPECT_FALSE(vec.is_inline());
+  expect_sequence(vec, 0, 50);
+}
+
+#if __cplusplus >= 201103L
+TEST(SmallVector, MoveConstructor) {
+  ft::small_vector<std::string, 4> inline_vec(2, "inline");
+  ft::small_vector<std::string, 4> heap_vec(10, "heap");
+  const std::string* heap_data = heap_vec.data();
+
+  ft::small_vector<std::string, 4> moved_inline(std::move(inline_vec));
+  EXPECT_TRUE(moved_inline.is_inline());
+  EXPECT_EQ(moved_inline[1], "inline");
+  EXPECT_TRUE(inline_vec.empty());
+
+  ft::small_vector<std::string, 4> moved_heap(std::move(heap_vec));
+  EXPECT_EQ(moved_heap.data(), heap_data);
+  EXPECT_TRUE(heap_vec.empty());
+  EXPECT_TRUE(heap_vec.is_inline());
+
+  heap_vec = std::move(moved_heap);
+  EXPECT_EQ(heap_vec.data(), heap_data);
+  heap_vec.emplace_back(3, 'x');
+  heap_vec.emplace(heap_vec.begin(), "front");
+  EXPECT_EQ(heap_vec.front(), "front");
+  EXPECT_EQ(heap_vec.back(), "xxx");
+}
+
+TEST(SmallVector, MoveAssignmentTakesAllocatorWithBuffer) {
+  typedef SmallVectorTaggedAllocator<int> allocator_type;
+  typedef ft::small_vector<int, 2, allocator_type> vector_type;
+  {
+    vector_type src(allocator_type(1));
+    vector_type dst(allocator_type(0));
+    for (int i = 0; i < 10; ++i) {
+      src.push_back(i);
+      dst.push_back(i);
+    }
+    dst = std::move(src);
+    EXPECT_EQ(dst.get_allocator().id, 1);
+    expect_sequence(dst, 0, 10);
+  }
+  // 奪った領域は確保したアロケータで解放されている
+  EXPECT_EQ(allocator_type::outstanding[0], 0);
+  EXPECT_EQ(allocator_type::outstanding[1], 0);
+}
+
+TEST(SmallVector, EmplaceDestroysOnlyConstructedWhenCopyThrows) {
+  typedef SmallVectorLiveCounter value_type;
+  value_type::live = 0;
+  value_type::copies_left = -1;
+  {
+    ft::small_vector<value_type, 4> vec;
+    for (int i = 0; i < 4; ++i) {
+      vec.push_back(value_type(i));
+    }
+    const value_type value(100);
+
+    // 新しい要素の構築で例外が発生する
+    value_type::copies_left = 0;
+    EXPECT_THROW(vec.emplace(vec.begin() + 1, value), std::runtime_error);
+    EXPECT_EQ(value_type::live, 5);
+
+    // 後半の要素を移す途中で例外が発生する
+    value_type::copies_left = 1 + 1 + 1;
+    EXPECT_THROW(vec.emplace(vec.begin() + 1, value), std::runtime_error);
+    value_type::copies_left = -1;
+    EXPECT_EQ(value_type::live, 5);
+    ASSERT_EQ(vec.size(), 4u);
+    EXPECT_TRUE(vec.is_inline());
+    EXPECT_EQ(vec[3].value, 3);
+  }
+  EXPECT_EQ(value_type::live, 0);
+}
+#endif
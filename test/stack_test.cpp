@@ -6,9 +6,10 @@
 #include <iostream>
 #include <iterator>
 #include <stack>
+#include <string>
 #include <vector>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -184,4 +185,30 @@ TEST(Stack, OperatorGreaterThanOrEqual) {
   EXPECT_TRUE(stack1 >= stack2);
 }
 
+#if __cplusplus >= 201103L
+TEST(StackMove, PushRvalueAndEmplace) {
+  ft::stack<std::string> st;
+  std::string value(100, 'a');
+
+  st.push(std::move(value));
+  st.emplace(3, 'b');
+  EXPECT_EQ(st.size(), 2u);
+  EXPECT_EQ(st.top(), "bbb");
+
+  ft::stack<std::string> moved(std::move(st));
+  EXPECT_EQ(moved.size(), 2u);
+  EXPECT_TRUE(st.empty());
+  moved.pop();
+  EXPECT_EQ(moved.top(), std::string(100, 'a'));
+
+  st = std::move(moved);
+  EXPECT_EQ(st.size(), 1u);
+}
+
+TEST(StackMove, NoexceptFollowsContainer) {
+  EXPECT_TRUE(std::is_nothrow_move_constructible<ft::stack<int> >::value);
+  EXPECT_TRUE(std::is_nothrow_move_assignable<ft::stack<int> >::value);
+}
+#endif
+
 }  // namespace
\ No newline at end of file
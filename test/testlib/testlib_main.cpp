@@ -1,7 +1,7 @@
 #include <iostream>
 #include <vector>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -12,11 +12,19 @@ testf_func_vec_type testf_functions;
 
 /***** Include all the files that use GoogleTest to test *****/
 
+#include "arena_allocator_test.cpp"
+#include "btree_test.cpp"
+#include "eytzinger_tree_test.cpp"
+#include "flat_map_test.cpp"
+#include "fork_join_test.cpp"
+#include "interval_map_test.cpp"
 #include "lexicographical_compare_test.cpp"
 #include "map_test.cpp"
+#include "node_pool_allocator_test.cpp"
 #include "pair_test.cpp"
 #include "red_black_tree_test.cpp"
 #include "set_test.cpp"
+#include "small_vector_test.cpp"
 #include "stack_test.cpp"
 #include "type_traits_test.cpp"
 #include "vector_test.cpp"
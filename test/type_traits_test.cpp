@@ -4,7 +4,7 @@
 
 #include <stdint.h>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -165,4 +165,39 @@ TEST(IsSame, TwoAreSame) {
 TEST(IsSame, TwoAreNotSame) {
   EXPECT_FALSE((ft::is_same<int, unsigned int>::value));
   EXPECT_FALSE((ft::is_same<char, int>::value));
-}
\ No newline at end of file
+}
+
+struct MyTrivialStruct {
+  int i;
+  char c[16];
+};
+
+struct MyNonTrivialStruct {
+  MyNonTrivialStruct() {}
+  MyNonTrivialStruct(const MyNonTrivialStruct&) {}
+  ~MyNonTrivialStruct() {}
+};
+
+TEST(IsTriviallyCopyable, TriviallyCopyable) {
+  EXPECT_TRUE(ft::is_trivially_copyable<int>::value);
+  EXPECT_TRUE(ft::is_trivially_copyable<double>::value);
+  EXPECT_TRUE(ft::is_trivially_copyable<char*>::value);
+  EXPECT_TRUE(ft::is_trivially_copyable<MyStruct>::value);
+  EXPECT_TRUE(ft::is_trivially_copyable<MyTrivialStruct>::value);
+}
+
+TEST(IsTriviallyCopyable, NotTriviallyCopyable) {
+  EXPECT_FALSE(ft::is_trivially_copyable<std::string>::value);
+  EXPECT_FALSE(ft::is_trivially_copyable<MyNonTrivialStruct>::value);
+}
+
+TEST(IsTriviallyDestructible, TriviallyDestructible) {
+  EXPECT_TRUE(ft::is_trivially_destructible<int>::value);
+  EXPECT_TRUE(ft::is_trivially_destructible<MyStruct>::value);
+  EXPECT_TRUE(ft::is_trivially_destructible<MyTrivialStruct>::value);
+}
+
+TEST(IsTriviallyDestructible, NotTriviallyDestructible) {
+  EXPECT_FALSE(ft::is_trivially_destructible<std::string>::value);
+  EXPECT_FALSE(ft::is_trivially_destructible<MyNonTrivialStruct>::value);
+}
@@ -84,6 +84,56 @@ bool operator!=(const MyAllocator<T1>& lhs, const MyAllocator<T2>& rhs) {
   return !(lhs == rhs);
 }
 
+// allocate() が呼ばれた回数を数えるアロケータ.
+// rebind した型同士でも同じカウンタを使う.
+inline std::size_t& allocation_count() {
+  static std::size_t count = 0;
+  return count;
+}
+
+template <class T>
+struct CountingAllocator : public std::allocator<T> {
+  typedef std::allocator<T> base_type;
+  typedef typename base_type::pointer pointer;
+  typedef typename base_type::size_type size_type;
+
+  template <class U>
+  struct rebind {
+    typedef CountingAllocator<U> other;
+  };
+
+  CountingAllocator() {}
+
+  CountingAllocator(const CountingAllocator& other) : base_type(other) {}
+
+  template <class U>
+  CountingAllocator(const CountingAllocator<U>& other) {
+    (void)other;
+  }
+
+  ~CountingAllocator() {}
+
+  pointer allocate(size_type n, const void* hint = 0) {
+    (void)hint;
+    ++allocation_count();
+    return base_type::allocate(n);
+  }
+};
+
+template <class T1, class T2>
+bool operator==(const CountingAllocator<T1>& lhs,
+                const CountingAllocator<T2>& rhs) {
+  (void)lhs;
+  (void)rhs;
+  return true;
+}
+
+template <class T1, class T2>
+bool operator!=(const CountingAllocator<T1>& lhs,
+                const CountingAllocator<T2>& rhs) {
+  return !(lhs == rhs);
+}
+
 }  // namespace test
 }  // namespace ft
 #endif
\ No newline at end of file
@@ -2,13 +2,16 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <sstream>
+#include <string>
 #include <vector>
 
-#if __cplusplus >= 201103L
+#if __cplusplus >= 201103L && !defined(FT_USE_TESTLIB)
 #include <gtest/gtest.h>
 #else
 #include "testlib/testlib.hpp"
@@ -57,6 +60,31 @@ TEST(Vector, DefaultConstructor) {
   expect_same_data_in_vector(stl_vec, ft_vec);
 }
 
+TEST(Vector, EmptyVectorDoesNotAllocate) {
+  typedef int value_type;
+  typedef ft::test::CountingAllocator<value_type> allocator_type;
+  typedef ft::vector<value_type, allocator_type> ft_vec_type;
+
+  ft::test::allocation_count() = 0;
+  ft_vec_type default_vec;
+  ft_vec_type alloc_vec = ft_vec_type(allocator_type());
+  ft_vec_type zero_vec(0, 1);
+  ft_vec_type range_vec(default_vec.begin(), default_vec.end());
+  ft_vec_type copy_vec(default_vec);
+  EXPECT_EQ(ft::test::allocation_count(), 0u);
+  EXPECT_EQ(default_vec.capacity(), 0u);
+  EXPECT_TRUE(default_vec.data() == NULL);
+  EXPECT_TRUE(default_vec.begin() == default_vec.end());
+
+  default_vec.swap(copy_vec);
+  default_vec.clear();
+  EXPECT_EQ(ft::test::allocation_count(), 0u);
+
+  default_vec.push_back(42);
+  EXPECT_EQ(ft::test::allocation_count(), 1u);
+  EXPECT_EQ(default_vec.front(), 42);
+}
+
 TEST(Vector, ConstructorWithValue) {
   typedef int value_type;
   typedef std::vector<value_type> stl_vec_type;
@@ -1620,3 +1648,480 @@ TEST(Vector2D, TestVectorWith2Dimensions) {
     std::cout << std::endl;
   }
 }
+
+namespace {
+
+struct PodBuffer {
+  int idx;
+  char buff[32];
+};
+
+bool operator==(const PodBuffer& lhs, const PodBuffer& rhs) {
+  return lhs.idx == rhs.idx && std::memcmp(lhs.buff, rhs.buff, 32) == 0;
+}
+
+PodBuffer make_pod_buffer(int idx) {
+  PodBuffer buf;
+  buf.idx = idx;
+  std::memset(buf.buff, 'a' + idx % 26, sizeof(buf.buff));
+  return buf;
+}
+
+}  // namespace
+
+TEST(VectorTrivialType, GrowInsertEraseKeepValues) {
+  std::vector<PodBuffer> stl_vec;
+  ft::vector<PodBuffer> ft_vec;
+
+  for (int i = 0; i < 100; ++i) {
+    stl_vec.push_back(make_pod_buffer(i));
+    ft_vec.push_back(make_pod_buffer(i));
+  }
+  stl_vec.insert(stl_vec.begin() + 10, 5, make_pod_buffer(-1));
+  ft_vec.insert(ft_vec.begin() + 10, 5, make_pod_buffer(-1));
+  std::vector<PodBuffer> stl_src(stl_vec.begin(), stl_vec.begin() + 20);
+  ft::vector<PodBuffer> ft_src(ft_vec.begin(), ft_vec.begin() + 20);
+  stl_vec.insert(stl_vec.begin() + 50, stl_src.begin(), stl_src.end());
+  ft_vec.insert(ft_vec.begin() + 50, ft_src.begin(), ft_src.end());
+  stl_vec.erase(stl_vec.begin() + 3);
+  ft_vec.erase(ft_vec.begin() + 3);
+  stl_vec.erase(stl_vec.begin() + 20, stl_vec.begin() + 40);
+  ft_vec.erase(ft_vec.begin() + 20, ft_vec.begin() + 40);
+
+  ASSERT_EQ(stl_vec.size(), ft_vec.size());
+  for (size_t i = 0; i < stl_vec.size(); ++i) {
+    EXPECT_TRUE(stl_vec[i] == ft_vec[i]);
+  }
+
+  ft::vector<PodBuffer> ft_vec_copy(ft_vec);
+  for (size_t i = 0; i < stl_vec.size(); ++i) {
+    EXPECT_TRUE(stl_vec[i] == ft_vec_copy[i]);
+  }
+}
+
+TEST(VectorNonTrivialType, GrowInsertEraseKeepValues) {
+  std::vector<std::string> stl_vec;
+  ft::vector<std::string> ft_vec;
+
+  for (int i = 0; i < 100; ++i) {
+    std::stringstream ss;
+    ss << "string number " << i;
+    stl_vec.push_back(ss.str());
+    ft_vec.push_back(ss.str());
+  }
+  stl_vec.insert(stl_vec.begin() + 10, 5, "inserted");
+  ft_vec.insert(ft_vec.begin() + 10, 5, "inserted");
+  std::vector<std::string> stl_src(stl_vec.begin(), stl_vec.begin() + 20);
+  ft::vector<std::string> ft_src(ft_vec.begin(), ft_vec.begin() + 20);
+  stl_vec.insert(stl_vec.begin() + 50, stl_src.begin(), stl_src.end());
+  ft_vec.insert(ft_vec.begin() + 50, ft_src.begin(), ft_src.end());
+  stl_vec.erase(stl_vec.begin() + 3);
+  ft_vec.erase(ft_vec.begin() + 3);
+  stl_vec.erase(stl_vec.begin() + 20, stl_vec.begin() + 40);
+  ft_vec.erase(ft_vec.begin() + 20, ft_vec.begin() + 40);
+
+  expect_same_data_in_vector(stl_vec, ft_vec);
+}
+
+TEST(VectorInsert, InsertWithinCapacityDoesNotReallocate) {
+  std::vector<std::string> stl_vec;
+  ft::vector<std::string> ft_vec;
+  ft_vec.reserve(100);
+
+  for (int i = 0; i < 10; ++i) {
+    std::stringstream ss;
+    ss << i;
+    stl_vec.push_back(ss.str());
+    ft_vec.push_back(ss.str());
+  }
+  const std::string* data_before = ft_vec.data();
+
+  // 挿入位置より後ろの要素数が挿入数より多い場合
+  stl_vec.insert(stl_vec.begin() + 2, 3, "a");
+  ft_vec.insert(ft_vec.begin() + 2, 3, "a");
+  expect_same_data_in_vector(stl_vec, ft_vec);
+  // 挿入位置より後ろの要素数が挿入数以下の場合
+  stl_vec.insert(stl_vec.end() - 2, 5, "b");
+  ft_vec.insert(ft_vec.end() - 2, 5, "b");
+  expect_same_data_in_vector(stl_vec, ft_vec);
+  // 1要素の挿入. 挿入する値が vector 内の要素を指している場合
+  stl_vec.insert(stl_vec.begin(), stl_vec.back());
+  ft_vec.insert(ft_vec.begin(), ft_vec.back());
+  expect_same_data_in_vector(stl_vec, ft_vec);
+
+  std::vector<std::string> src;
+  src.push_back("x");
+  src.push_back("y");
+  src.push_back("z");
+  stl_vec.insert(stl_vec.begin() + 5, src.begin(), src.end());
+  ft_vec.insert(ft_vec.begin() + 5, src.begin(), src.end());
+  expect_same_data_in_vector(stl_vec, ft_vec);
+  stl_vec.insert(stl_vec.end() - 1, src.begin(), src.end());
+  ft_vec.insert(ft_vec.end() - 1, src.begin(), src.end());
+  expect_same_data_in_vector(stl_vec, ft_vec);
+
+  EXPECT_EQ(ft_vec.data(), data_before);
+  EXPECT_EQ(ft_vec.capacity(), 100u);
+}
+
+TEST(VectorInsert, InsertOverCapacityGrowsGeometrically) {
+  ft::vector<int> ft_vec;
+
+  ft_vec.insert(ft_vec.begin(), 10, 1);
+  EXPECT_EQ(ft_vec.capacity(), 10u);
+  ft_vec.insert(ft_vec.begin() + 5, 1, 2);
+  EXPECT_EQ(ft_vec.capacity(), 20u);
+  ft_vec.insert(ft_vec.begin() + 5, 100, 3);
+  EXPECT_EQ(ft_vec.capacity(), 111u);
+  EXPECT_EQ(ft_vec.size(), 111u);
+  EXPECT_EQ(ft_vec[4], 1);
+  EXPECT_EQ(ft_vec[5], 3);
+  EXPECT_EQ(ft_vec[104], 3);
+  EXPECT_EQ(ft_vec[105], 2);
+  EXPECT_EQ(ft_vec[106], 1);
+}
+
+namespace {
+
+// コピーされた回数を数え, 指定回数を超えてコピーされると例外を投げる型
+struct CopyCounter {
+  static int copy_count;
+  static int throw_after;
+  int value;
+
+  CopyCounter(int v = 0) : value(v) {}
+
+  CopyCounter(const CopyCounter& other) : value(other.value) {
+    if (throw_after >= 0 && copy_count >= throw_after) {
+      throw std::runtime_error("CopyCounter");
+    }
+    ++copy_count;
+  }
+
+  CopyCounter& operator=(const CopyCounter& other) {
+    value = other.value;
+    return *this;
+  }
+};
+
+int CopyCounter::copy_count = 0;
+int CopyCounter::throw_after = -1;
+
+}  // namespace
+
+TEST(VectorRelocation, PushBackCopiesEachElementOncePerReallocation) {
+  CopyCounter::copy_count = 0;
+  CopyCounter::throw_after = -1;
+  ft::vector<CopyCounter> ft_vec;
+
+  for (int i = 0; i < 16; ++i) {
+    ft_vec.push_back(CopyCounter(i));
+  }
+  // push_back で16回 + 容量 1, 2, 4, 8 からの再確保で 1 + 2 + 4 + 8 回
+  EXPECT_EQ(CopyCounter::copy_count, 16 + 15);
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(ft_vec[i].value, i);
+  }
+}
+
+TEST(VectorRelocation, PushBackElementOfItselfWhenFull) {
+  ft::vector<std::string> ft_vec;
+
+  ft_vec.push_back("first");
+  ft_vec.push_back(ft_vec[0]);
+  ft_vec.push_back(ft_vec[1]);
+  EXPECT_EQ(ft_vec.size(), 3u);
+  EXPECT_EQ(ft_vec[2], "first");
+}
+
+TEST(VectorRelocation, ReserveKeepsVectorUnchangedWhenCopyThrows) {
+  CopyCounter::copy_count = 0;
+  CopyCounter::throw_after = -1;
+  ft::vector<CopyCounter> ft_vec;
+  for (int i = 0; i < 8; ++i) {
+    ft_vec.push_back(CopyCounter(i));
+  }
+  const CopyCounter* data_before = ft_vec.data();
+
+  CopyCounter::copy_count = 0;
+  CopyCounter::throw_after = 4;
+  EXPECT_THROW(ft_vec.reserve(100), std::runtime_error);
+  CopyCounter::throw_after = -1;
+
+  EXPECT_EQ(ft_vec.data(), data_before);
+  EXPECT_EQ(ft_vec.capacity(), 8u);
+  ASSERT_EQ(ft_vec.size(), 8u);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(ft_vec[i].value, i);
+  }
+}
+
+namespace {
+
+// 生きているオブジェクトの数を数え, 指定回数コピーすると例外を投げる型
+struct LiveCounter {
+  static int live;
+  static int copies_left;
+  int value;
+
+  LiveCounter(int v = 0) : value(v) {
+    ++live;
+  }
+
+  LiveCounter(const LiveCounter& other) : value(other.value) {
+    if (copies_left == 0) {
+      throw std::runtime_error("LiveCounter");
+    }
+    if (copies_left > 0) {
+      --copies_left;
+    }
+    ++live;
+  }
+
+  LiveCounter& operator=(const LiveCounter& other) {
+    value = other.value;
+    return *this;
+  }
+
+  ~LiveCounter() {
+    --live;
+  }
+};
+
+int LiveCounter::live = 0;
+int LiveCounter::copies_left = -1;
+
+}  // namespace
+
+TEST(VectorRelocation, InsertNDestroysOnlyConstructedWhenCopyThrows) {
+  LiveCounter::live = 0;
+  LiveCounter::copies_left = -1;
+  {
+    ft::vector<LiveCounter> ft_vec;
+    ft_vec.reserve(8);
+    for (int i = 0; i < 8; ++i) {
+      ft_vec.push_back(LiveCounter(i));
+    }
+    EXPECT_EQ(LiveCounter::live, 8);
+
+    // 再確保した領域に5個を埋める途中で例外が発生する
+    LiveCounter::copies_left = 3;
+    EXPECT_THROW(ft_vec.insert(ft_vec.begin() + 2, 5, LiveCounter(100)),
+                 std::runtime_error);
+    EXPECT_EQ(LiveCounter::live, 8);
+
+    // 値を埋めた後, 後半の要素を移す途中で例外が発生する
+    LiveCounter::copies_left = 5 + 4;
+    EXPECT_THROW(ft_vec.insert(ft_vec.begin() + 2, 5, LiveCounter(100)),
+                 std::runtime_error);
+    LiveCounter::copies_left = -1;
+    EXPECT_EQ(LiveCounter::live, 8);
+    ASSERT_EQ(ft_vec.size(), 8u);
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(ft_vec[i].value, i);
+    }
+  }
+  EXPECT_EQ(LiveCounter::live, 0);
+}
+
+TEST(VectorRelocation, GrowthUsesContainerAllocator) {
+  typedef ft::test::MyAllocator<int> allocator_type;
+  ft::vector<int, allocator_type> ft_vec;
+
+  for (int i = 0; i < 100; ++i) {
+    ft_vec.push_back(i);
+  }
+  ft_vec.reserve(500);
+  ft_vec.insert(ft_vec.begin() + 50, 1000, 1);
+  ft_vec.resize(2000, 2);
+  EXPECT_EQ(ft_vec.size(), 2000u);
+  EXPECT_EQ(ft_vec[49], 49);
+  EXPECT_EQ(ft_vec[50], 1);
+  EXPECT_EQ(ft_vec[1050], 50);
+  EXPECT_EQ(ft_vec[1999], 2);
+}
+
+#if __cplusplus >= 201103L
+namespace {
+
+// コピーとムーブの回数を数える型. NoexceptMove でムーブの noexcept を切り替える
+template <bool NoexceptMove>
+struct MoveCounter {
+  static int copy_count;
+  static int move_count;
+  int value;
+
+  MoveCounter(int v = 0) : value(v) {}
+
+  MoveCounter(const MoveCounter& other) : value(other.value) {
+    ++copy_count;
+  }
+
+  MoveCounter(MoveCounter&& other) noexcept(NoexceptMove)
+      : value(other.value) {
+    other.value = -1;
+    ++move_count;
+  }
+
+  MoveCounter& operator=(const MoveCounter& other) {
+    value = other.value;
+    ++copy_count;
+    return *this;
+  }
+
+  MoveCounter& operator=(MoveCounter&& other) noexcept(NoexceptMove) {
+    value = other.value;
+    other.value = -1;
+    ++move_count;
+    return *this;
+  }
+
+  static void reset() {
+    copy_count = 0;
+    move_count = 0;
+  }
+};
+
+template <bool NoexceptMove>
+int MoveCounter<NoexceptMove>::copy_count = 0;
+template <bool NoexceptMove>
+int MoveCounter<NoexceptMove>::move_count = 0;
+
+}  // namespace
+
+TEST(VectorMove, EmplaceDestroysOnlyConstructedWhenCopyThrows) {
+  LiveCounter::live = 0;
+  LiveCounter::copies_left = -1;
+  {
+    ft::vector<LiveCounter> ft_vec;
+    ft_vec.reserve(4);
+    for (int i = 0; i < 4; ++i) {
+      ft_vec.push_back(LiveCounter(i));
+    }
+    const LiveCounter value(100);
+
+    // 新しい要素の構築で例外が発生する
+    LiveCounter::copies_left = 0;
+    EXPECT_THROW(ft_vec.emplace(ft_vec.begin() + 1, value),
+                 std::runtime_error);
+    EXPECT_EQ(LiveCounter::live, 5);
+
+    // 前半の要素を移した後, 後半の要素を移す途中で例外が発生する
+    LiveCounter::copies_left = 1 + 1 + 1;
+    EXPECT_THROW(ft_vec.emplace(ft_vec.begin() + 1, value),
+                 std::runtime_error);
+    LiveCounter::copies_left = -1;
+    EXPECT_EQ(LiveCounter::live, 5);
+    ASSERT_EQ(ft_vec.size(), 4u);
+    EXPECT_EQ(ft_vec[3].value, 3);
+  }
+  EXPECT_EQ(LiveCounter::live, 0);
+}
+
+TEST(VectorMove, MoveConstructorStealsStorage) {
+  ft::vector<std::string> src(10, "long string which is not in SSO buffer");
+  const std::string* data = src.data();
+
+  ft::vector<std::string> dst(std::move(src));
+  EXPECT_EQ(dst.data(), data);
+  EXPECT_EQ(dst.size(), 10u);
+  EXPECT_EQ(src.size(), 0u);
+  EXPECT_EQ(src.capacity(), 0u);
+
+  src.push_back("reuse");
+  EXPECT_EQ(src[0], "reuse");
+}
+
+TEST(VectorMove, MoveAssignmentStealsStorage) {
+  ft::vector<std::string> src(10, "abc");
+  ft::vector<std::string> dst(3, "def");
+  const std::string* data = src.data();
+
+  dst = std::move(src);
+  EXPECT_EQ(dst.data(), data);
+  EXPECT_EQ(dst.size(), 10u);
+  EXPECT_EQ(dst[9], "abc");
+  EXPECT_EQ(src.size(), 0u);
+}
+
+TEST(VectorMove, GrowthMovesNoexceptMovableElements) {
+  typedef MoveCounter<true> value_type;
+  value_type::reset();
+  ft::vector<value_type> ft_vec;
+
+  for (int i = 0; i < 16; ++i) {
+    ft_vec.push_back(value_type(i));
+  }
+  // push_back で16回 + 容量 1, 2, 4, 8 からの再確保で 1 + 2 + 4 + 8 回
+  EXPECT_EQ(value_type::copy_count, 0);
+  EXPECT_EQ(value_type::move_count, 16 + 15);
+  for (int i = 0; i < 16; ++i) {
+    EXPECT_EQ(ft_vec[i].value, i);
+  }
+}
+
+TEST(VectorMove, GrowthCopiesWhenMoveMayThrow) {
+  typedef MoveCounter<false> value_type;
+  value_type::reset();
+  ft::vector<value_type> ft_vec;
+
+  for (int i = 0; i < 16; ++i) {
+    ft_vec.push_back(value_type(i));
+  }
+  // 強い例外保証のために再確保時はコピーする
+  EXPECT_EQ(value_type::move_count, 16);
+  EXPECT_EQ(value_type::copy_count, 15);
+}
+
+TEST(VectorMove, InsertAndEraseMoveElements) {
+  typedef MoveCounter<true> value_type;
+  ft::vector<value_type> ft_vec;
+  ft_vec.reserve(20);
+  for (int i = 0; i < 10; ++i) {
+    ft_vec.push_back(value_type(i));
+  }
+
+  value_type::reset();
+  ft_vec.insert(ft_vec.begin(), 2, value_type(100));
+  ft_vec.erase(ft_vec.begin() + 1);
+  // 値のコピーを取る1回と挿入する2要素の分だけコピーし, 既存の要素はムーブする
+  EXPECT_EQ(value_type::copy_count, 3);
+  ASSERT_EQ(ft_vec.size(), 11u);
+  EXPECT_EQ(ft_vec[0].value, 100);
+  EXPECT_EQ(ft_vec[1].value, 0);
+  EXPECT_EQ(ft_vec[10].value, 9);
+}
+
+TEST(VectorMove, EmplaceConstructsInPlace) {
+  ft::vector<std::string> ft_vec;
+
+  ft_vec.emplace_back(3, 'a');
+  ft_vec.emplace_back("ccc");
+  ft_vec.emplace(ft_vec.begin() + 1, 3, 'b');
+  ft_vec.emplace(ft_vec.end(), "ddd");
+  ft_vec.insert(ft_vec.begin(), std::string("000"));
+  ft_vec.emplace(ft_vec.begin() + 2, ft_vec[0]);
+
+  ASSERT_EQ(ft_vec.size(), 6u);
+  EXPECT_EQ(ft_vec[0], "000");
+  EXPECT_EQ(ft_vec[1], "aaa");
+  EXPECT_EQ(ft_vec[2], "000");
+  EXPECT_EQ(ft_vec[3], "bbb");
+  EXPECT_EQ(ft_vec[4], "ccc");
+  EXPECT_EQ(ft_vec[5], "ddd");
+}
+
+TEST(VectorMove, MoveOnlyType) {
+  ft::vector<std::unique_ptr<int> > ft_vec;
+
+  for (int i = 0; i < 10; ++i) {
+    ft_vec.push_back(std::unique_ptr<int>(new int(i)));
+  }
+  ft_vec.emplace(ft_vec.begin(), new int(-1));
+  ft_vec.erase(ft_vec.begin() + 1);
+  ASSERT_EQ(ft_vec.size(), 10u);
+  EXPECT_EQ(*ft_vec[0], -1);
+  EXPECT_EQ(*ft_vec[1], 1);
+  EXPECT_EQ(*ft_vec[9], 9);
+}
+#endif